@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#ifdef __GNUC__
+#include <pthread.h>
+
+/* Worker threads of the parallel front end each allocate from their own
+ * current arena; only the list of all arenas is shared */
+static pthread_mutex_t arena_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread Arena *arena_current_arena = NULL;
+#else
+static Arena *arena_current_arena = NULL;
+#endif
+
+static Arena *arena_list_head = NULL;
+static Arena *arena_list_tail = NULL;
+static int arena_declaration_count = 0;
+
+/* One-element arrays whose sizeof gives the node size in bytes.  Cminor's
+ * sizeof counts array elements instead, so the JVM-hosted compiler reports
+ * one unit per node. */
+static Expression arena_probe_expression[1];
+static ExpressionList arena_probe_expression_list[1];
+static Statement arena_probe_statement[1];
+static StatementList arena_probe_statement_list[1];
+static Declaration arena_probe_declaration[1];
+static DeclarationList arena_probe_declaration_list[1];
+static ParameterList arena_probe_parameter_list[1];
+static ArgumentList arena_probe_argument_list[1];
+static FunctionDeclaration arena_probe_function_declaration[1];
+static AttributeSpecifier arena_probe_attribute_specifier[1];
+static ParsedType arena_probe_parsed_type[1];
+static TypeSpecifier arena_probe_type_specifier[1];
+
+Arena *arena_create(const char *name)
+{
+    Arena *arena = (Arena *)calloc(1, sizeof(Arena));
+    arena->name = strdup(name ? name : "(unnamed)");
+    arena->node_counts = (int *)calloc(ARENA_KIND_COUNT, sizeof(int));
+    arena->node_bytes = (int *)calloc(ARENA_KIND_COUNT, sizeof(int));
+    arena->block_counts = (int *)calloc(ARENA_KIND_COUNT, sizeof(int));
+    arena->next = NULL;
+#ifdef __GNUC__
+    pthread_mutex_lock(&arena_list_lock);
+#endif
+    if (arena_list_tail)
+    {
+        arena_list_tail->next = arena;
+    }
+    else
+    {
+        arena_list_head = arena;
+    }
+    arena_list_tail = arena;
+#ifdef __GNUC__
+    pthread_mutex_unlock(&arena_list_lock);
+#endif
+    return arena;
+}
+
+Arena *arena_set_current(Arena *arena)
+{
+    Arena *previous = arena_current_arena;
+    arena_current_arena = arena;
+    return previous;
+}
+
+Arena *arena_current()
+{
+    if (!arena_current_arena)
+    {
+        arena_current_arena = arena_create("default");
+    }
+    return arena_current_arena;
+}
+
+/* Blocks start small so a short translation unit does not reserve full
+ * blocks of every kind, and double up to ARENA_BLOCK_NODES. */
+static int arena_next_block_size(Arena *arena, ArenaKind kind)
+{
+    int size = ARENA_FIRST_BLOCK_NODES;
+    for (int i = 0; i < arena->block_counts[kind] && size < ARENA_BLOCK_NODES; ++i)
+    {
+        size = size * 2;
+    }
+    arena->block_counts[kind] = arena->block_counts[kind] + 1;
+    return size;
+}
+
+/* Account for one node of the given size */
+static void arena_note(Arena *arena, ArenaKind kind, int size)
+{
+    arena->node_counts[kind] = arena->node_counts[kind] + 1;
+    arena->node_bytes[kind] = arena->node_bytes[kind] + size;
+}
+
+Expression *arena_new_expression()
+{
+    Arena *arena = arena_current();
+    if (arena->expressions_used == arena->expressions_capacity)
+    {
+        arena->expressions_capacity = arena_next_block_size(arena, ARENA_KIND_EXPRESSION);
+        arena->expressions =
+            (Expression *)calloc(arena->expressions_capacity, sizeof(Expression));
+        arena->expressions_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_EXPRESSION, (int)sizeof arena_probe_expression);
+    Expression *node = &arena->expressions[arena->expressions_used];
+    arena->expressions_used = arena->expressions_used + 1;
+    return node;
+}
+
+ExpressionList *arena_new_expression_list()
+{
+    Arena *arena = arena_current();
+    if (arena->expression_lists_used == arena->expression_lists_capacity)
+    {
+        arena->expression_lists_capacity = arena_next_block_size(arena, ARENA_KIND_EXPRESSION_LIST);
+        arena->expression_lists =
+            (ExpressionList *)calloc(arena->expression_lists_capacity, sizeof(ExpressionList));
+        arena->expression_lists_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_EXPRESSION_LIST, (int)sizeof arena_probe_expression_list);
+    ExpressionList *node = &arena->expression_lists[arena->expression_lists_used];
+    arena->expression_lists_used = arena->expression_lists_used + 1;
+    return node;
+}
+
+Statement *arena_new_statement()
+{
+    Arena *arena = arena_current();
+    if (arena->statements_used == arena->statements_capacity)
+    {
+        arena->statements_capacity = arena_next_block_size(arena, ARENA_KIND_STATEMENT);
+        arena->statements =
+            (Statement *)calloc(arena->statements_capacity, sizeof(Statement));
+        arena->statements_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_STATEMENT, (int)sizeof arena_probe_statement);
+    Statement *node = &arena->statements[arena->statements_used];
+    arena->statements_used = arena->statements_used + 1;
+    return node;
+}
+
+StatementList *arena_new_statement_list()
+{
+    Arena *arena = arena_current();
+    if (arena->statement_lists_used == arena->statement_lists_capacity)
+    {
+        arena->statement_lists_capacity = arena_next_block_size(arena, ARENA_KIND_STATEMENT_LIST);
+        arena->statement_lists =
+            (StatementList *)calloc(arena->statement_lists_capacity, sizeof(StatementList));
+        arena->statement_lists_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_STATEMENT_LIST, (int)sizeof arena_probe_statement_list);
+    StatementList *node = &arena->statement_lists[arena->statement_lists_used];
+    arena->statement_lists_used = arena->statement_lists_used + 1;
+    return node;
+}
+
+Declaration *arena_new_declaration()
+{
+    Arena *arena = arena_current();
+    if (arena->declarations_used == arena->declarations_capacity)
+    {
+        arena->declarations_capacity = arena_next_block_size(arena, ARENA_KIND_DECLARATION);
+        arena->declarations =
+            (Declaration *)calloc(arena->declarations_capacity, sizeof(Declaration));
+        arena->declarations_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_DECLARATION, (int)sizeof arena_probe_declaration);
+    Declaration *node = &arena->declarations[arena->declarations_used];
+    arena->declarations_used = arena->declarations_used + 1;
+#ifdef __GNUC__
+    node->id = __atomic_fetch_add(&arena_declaration_count, 1, __ATOMIC_RELAXED);
+#else
+    node->id = arena_declaration_count;
+    arena_declaration_count = arena_declaration_count + 1;
+#endif
+    return node;
+}
+
+DeclarationList *arena_new_declaration_list()
+{
+    Arena *arena = arena_current();
+    if (arena->declaration_lists_used == arena->declaration_lists_capacity)
+    {
+        arena->declaration_lists_capacity =
+            arena_next_block_size(arena, ARENA_KIND_DECLARATION_LIST);
+        arena->declaration_lists =
+            (DeclarationList *)calloc(arena->declaration_lists_capacity, sizeof(DeclarationList));
+        arena->declaration_lists_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_DECLARATION_LIST, (int)sizeof arena_probe_declaration_list);
+    DeclarationList *node = &arena->declaration_lists[arena->declaration_lists_used];
+    arena->declaration_lists_used = arena->declaration_lists_used + 1;
+    return node;
+}
+
+ParameterList *arena_new_parameter_list()
+{
+    Arena *arena = arena_current();
+    if (arena->parameter_lists_used == arena->parameter_lists_capacity)
+    {
+        arena->parameter_lists_capacity = arena_next_block_size(arena, ARENA_KIND_PARAMETER_LIST);
+        arena->parameter_lists =
+            (ParameterList *)calloc(arena->parameter_lists_capacity, sizeof(ParameterList));
+        arena->parameter_lists_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_PARAMETER_LIST, (int)sizeof arena_probe_parameter_list);
+    ParameterList *node = &arena->parameter_lists[arena->parameter_lists_used];
+    arena->parameter_lists_used = arena->parameter_lists_used + 1;
+    return node;
+}
+
+ArgumentList *arena_new_argument_list()
+{
+    Arena *arena = arena_current();
+    if (arena->argument_lists_used == arena->argument_lists_capacity)
+    {
+        arena->argument_lists_capacity = arena_next_block_size(arena, ARENA_KIND_ARGUMENT_LIST);
+        arena->argument_lists =
+            (ArgumentList *)calloc(arena->argument_lists_capacity, sizeof(ArgumentList));
+        arena->argument_lists_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_ARGUMENT_LIST, (int)sizeof arena_probe_argument_list);
+    ArgumentList *node = &arena->argument_lists[arena->argument_lists_used];
+    arena->argument_lists_used = arena->argument_lists_used + 1;
+    return node;
+}
+
+FunctionDeclaration *arena_new_function_declaration()
+{
+    Arena *arena = arena_current();
+    if (arena->function_declarations_used == arena->function_declarations_capacity)
+    {
+        arena->function_declarations_capacity =
+            arena_next_block_size(arena, ARENA_KIND_FUNCTION_DECLARATION);
+        arena->function_declarations =
+            (FunctionDeclaration *)calloc(arena->function_declarations_capacity,
+                                          sizeof(FunctionDeclaration));
+        arena->function_declarations_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_FUNCTION_DECLARATION,
+               (int)sizeof arena_probe_function_declaration);
+    FunctionDeclaration *node = &arena->function_declarations[arena->function_declarations_used];
+    arena->function_declarations_used = arena->function_declarations_used + 1;
+    return node;
+}
+
+AttributeSpecifier *arena_new_attribute()
+{
+    Arena *arena = arena_current();
+    if (arena->attributes_used == arena->attributes_capacity)
+    {
+        arena->attributes_capacity = arena_next_block_size(arena, ARENA_KIND_ATTRIBUTE);
+        arena->attributes =
+            (AttributeSpecifier *)calloc(arena->attributes_capacity, sizeof(AttributeSpecifier));
+        arena->attributes_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_ATTRIBUTE, (int)sizeof arena_probe_attribute_specifier);
+    AttributeSpecifier *node = &arena->attributes[arena->attributes_used];
+    arena->attributes_used = arena->attributes_used + 1;
+    return node;
+}
+
+ParsedType *arena_new_parsed_type()
+{
+    Arena *arena = arena_current();
+    if (arena->parsed_types_used == arena->parsed_types_capacity)
+    {
+        arena->parsed_types_capacity = arena_next_block_size(arena, ARENA_KIND_PARSED_TYPE);
+        arena->parsed_types =
+            (ParsedType *)calloc(arena->parsed_types_capacity, sizeof(ParsedType));
+        arena->parsed_types_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_PARSED_TYPE, (int)sizeof arena_probe_parsed_type);
+    ParsedType *node = &arena->parsed_types[arena->parsed_types_used];
+    arena->parsed_types_used = arena->parsed_types_used + 1;
+    return node;
+}
+
+TypeSpecifier *arena_new_type_specifier()
+{
+    Arena *arena = arena_current();
+    if (arena->type_specifiers_used == arena->type_specifiers_capacity)
+    {
+        arena->type_specifiers_capacity = arena_next_block_size(arena, ARENA_KIND_TYPE_SPECIFIER);
+        arena->type_specifiers =
+            (TypeSpecifier *)calloc(arena->type_specifiers_capacity, sizeof(TypeSpecifier));
+        arena->type_specifiers_used = 0;
+    }
+    arena_note(arena, ARENA_KIND_TYPE_SPECIFIER, (int)sizeof arena_probe_type_specifier);
+    TypeSpecifier *node = &arena->type_specifiers[arena->type_specifiers_used];
+    arena->type_specifiers_used = arena->type_specifiers_used + 1;
+    return node;
+}
+
+static const char *arena_kind_name(ArenaKind kind)
+{
+    switch (kind)
+    {
+    case ARENA_KIND_EXPRESSION:
+        return "Expression";
+    case ARENA_KIND_EXPRESSION_LIST:
+        return "ExpressionList";
+    case ARENA_KIND_STATEMENT:
+        return "Statement";
+    case ARENA_KIND_STATEMENT_LIST:
+        return "StatementList";
+    case ARENA_KIND_DECLARATION:
+        return "Declaration";
+    case ARENA_KIND_DECLARATION_LIST:
+        return "DeclarationList";
+    case ARENA_KIND_PARAMETER_LIST:
+        return "ParameterList";
+    case ARENA_KIND_ARGUMENT_LIST:
+        return "ArgumentList";
+    case ARENA_KIND_FUNCTION_DECLARATION:
+        return "FunctionDeclaration";
+    case ARENA_KIND_ATTRIBUTE:
+        return "AttributeSpecifier";
+    case ARENA_KIND_PARSED_TYPE:
+        return "ParsedType";
+    case ARENA_KIND_TYPE_SPECIFIER:
+        return "TypeSpecifier";
+    default:
+        return "?";
+    }
+}
+
+void arena_print_stats()
+{
+    int total_bytes = 0;
+    int total_nodes = 0;
+    int total_blocks = 0;
+    for (Arena *arena = arena_list_head; arena; arena = arena->next)
+    {
+        int arena_bytes = 0;
+        int arena_nodes = 0;
+        for (int kind = 0; kind < ARENA_KIND_COUNT; ++kind)
+        {
+            arena_bytes = arena_bytes + arena->node_bytes[kind];
+            arena_nodes = arena_nodes + arena->node_counts[kind];
+        }
+        if (arena_nodes == 0)
+        {
+            continue;
+        }
+        fprintf(stderr, "arena: %s: %d nodes, %d bytes\n", arena->name, arena_nodes, arena_bytes);
+        for (int kind = 0; kind < ARENA_KIND_COUNT; ++kind)
+        {
+            if (arena->node_counts[kind] == 0)
+            {
+                continue;
+            }
+            fprintf(stderr, "arena:   %s: %d nodes, %d bytes, %d blocks\n",
+                    arena_kind_name((ArenaKind)kind), arena->node_counts[kind],
+                    arena->node_bytes[kind], arena->block_counts[kind]);
+            total_blocks = total_blocks + arena->block_counts[kind];
+        }
+        total_bytes = total_bytes + arena_bytes;
+        total_nodes = total_nodes + arena_nodes;
+    }
+    fprintf(stderr, "arena: total: %d nodes, %d bytes in %d blocks\n", total_nodes, total_bytes,
+            total_blocks);
+}
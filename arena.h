@@ -0,0 +1,124 @@
+#pragma once
+
+/*
+ * arena.h - Bump allocation for AST, ParsedType and TypeSpecifier nodes
+ *
+ * The parser and the type builders create many small nodes that live
+ * until the process exits.  Instead of one calloc per node, each node
+ * kind is carved out of calloc'd blocks that grow from
+ * ARENA_FIRST_BLOCK_NODES to ARENA_BLOCK_NODES entries.
+ * Blocks are typed (one array per kind) rather than raw bytes so the
+ * allocator also works when the compiler itself runs on the JVM, where
+ * a struct cannot live inside a byte buffer.
+ *
+ * Nodes are allocated from the current arena.  The compiler switches to
+ * a per-translation-unit arena while a source file is parsed and checked,
+ * and to the long-lived header arena while a header is parsed into the
+ * HeaderStore.  Arenas are never released: the AST is needed by code
+ * generation, which runs after every translation unit has been parsed.
+ *
+ * In the native build the current arena is per thread, so the workers of
+ * the parallel front end (-j N) never share an arena; each header they
+ * parse gets an arena of its own instead of the shared header arena.
+ */
+
+#include "ast.h"
+
+typedef enum
+{
+    ARENA_KIND_EXPRESSION,
+    ARENA_KIND_EXPRESSION_LIST,
+    ARENA_KIND_STATEMENT,
+    ARENA_KIND_STATEMENT_LIST,
+    ARENA_KIND_DECLARATION,
+    ARENA_KIND_DECLARATION_LIST,
+    ARENA_KIND_PARAMETER_LIST,
+    ARENA_KIND_ARGUMENT_LIST,
+    ARENA_KIND_FUNCTION_DECLARATION,
+    ARENA_KIND_ATTRIBUTE,
+    ARENA_KIND_PARSED_TYPE,
+    ARENA_KIND_TYPE_SPECIFIER,
+    ARENA_KIND_COUNT
+} ArenaKind;
+
+enum
+{
+    ARENA_FIRST_BLOCK_NODES = 16,
+    ARENA_BLOCK_NODES = 1024
+};
+
+typedef struct Arena_tag
+{
+    char *name;
+
+    /* Current block and its fill level, per node kind */
+    Expression *expressions;
+    int expressions_used;
+    int expressions_capacity;
+    ExpressionList *expression_lists;
+    int expression_lists_used;
+    int expression_lists_capacity;
+    Statement *statements;
+    int statements_used;
+    int statements_capacity;
+    StatementList *statement_lists;
+    int statement_lists_used;
+    int statement_lists_capacity;
+    Declaration *declarations;
+    int declarations_used;
+    int declarations_capacity;
+    DeclarationList *declaration_lists;
+    int declaration_lists_used;
+    int declaration_lists_capacity;
+    ParameterList *parameter_lists;
+    int parameter_lists_used;
+    int parameter_lists_capacity;
+    ArgumentList *argument_lists;
+    int argument_lists_used;
+    int argument_lists_capacity;
+    FunctionDeclaration *function_declarations;
+    int function_declarations_used;
+    int function_declarations_capacity;
+    AttributeSpecifier *attributes;
+    int attributes_used;
+    int attributes_capacity;
+    ParsedType *parsed_types;
+    int parsed_types_used;
+    int parsed_types_capacity;
+    TypeSpecifier *type_specifiers;
+    int type_specifiers_used;
+    int type_specifiers_capacity;
+
+    /* Statistics, indexed by ArenaKind */
+    int *node_counts;
+    int *node_bytes;
+    int *block_counts;
+
+    struct Arena_tag *next; /* All arenas, in creation order */
+} Arena;
+
+/* Create an arena. It is added to the list walked by arena_print_stats(). */
+Arena *arena_create(const char *name);
+
+/* Make arena the target of node allocation. Returns the previous arena. */
+Arena *arena_set_current(Arena *arena);
+
+/* Arena used by the node allocators (a default arena is created on demand) */
+Arena *arena_current();
+
+/* Zero-initialized nodes from the current arena */
+Expression *arena_new_expression();
+ExpressionList *arena_new_expression_list();
+Statement *arena_new_statement();
+StatementList *arena_new_statement_list();
+Declaration *arena_new_declaration();
+DeclarationList *arena_new_declaration_list();
+ParameterList *arena_new_parameter_list();
+ArgumentList *arena_new_argument_list();
+FunctionDeclaration *arena_new_function_declaration();
+AttributeSpecifier *arena_new_attribute();
+ParsedType *arena_new_parsed_type();
+TypeSpecifier *arena_new_type_specifier();
+
+/* Report nodes, bytes and blocks per kind for every arena to stderr */
+void arena_print_stats();
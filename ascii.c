@@ -1,5 +1,25 @@
 #include "ascii.h"
 
+/* Indexed by the unsigned byte value; see ASCII_CLASS_* in ascii.h */
+const unsigned char ascii_class_table[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 0, 0, 0, 0, 0, 0,
+    0, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 0, 0, 0, 0, 8,
+    0, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
 int ascii_is_ascii(char c)
 {
     int uc = c & 0xFF;
@@ -8,26 +28,25 @@ int ascii_is_ascii(char c)
 
 int ascii_is_space(char c)
 {
-    return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
-           c == '\v' || c == '\f';
+    return (ascii_class_table[c & 0xFF] & ASCII_CLASS_SPACE) != 0;
 }
 
 int ascii_is_digit(char c)
 {
-    return c >= '0' && c <= '9';
+    return (ascii_class_table[c & 0xFF] & ASCII_CLASS_DIGIT) != 0;
 }
 
 int ascii_is_alpha(char c)
 {
-    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+    return (ascii_class_table[c & 0xFF] & ASCII_CLASS_ALPHA) != 0;
 }
 
 int ascii_is_alnum(char c)
 {
-    return ascii_is_alpha(c) || ascii_is_digit(c);
+    return (ascii_class_table[c & 0xFF] & (ASCII_CLASS_ALPHA | ASCII_CLASS_DIGIT)) != 0;
 }
 
 int ascii_is_identchar(char c)
 {
-    return ascii_is_alnum(c) || c == '_';
+    return (ascii_class_table[c & 0xFF] & ASCII_CLASS_IDENT) != 0;
 }
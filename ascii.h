@@ -1,5 +1,17 @@
 #pragma once
 
+/* Character classes for bytes 0..255; bytes >= 128 belong to no class.
+ * Hot scanning loops test ascii_class_table[c & 0xFF] directly. */
+enum
+{
+    ASCII_CLASS_SPACE = 1,
+    ASCII_CLASS_DIGIT = 2,
+    ASCII_CLASS_ALPHA = 4,
+    ASCII_CLASS_IDENT = 8
+};
+
+extern const unsigned char ascii_class_table[256];
+
 int ascii_is_ascii(char c);
 int ascii_is_space(char c);
 int ascii_is_digit(char c);
@@ -30,6 +30,9 @@ typedef struct Declaration_tag
     bool needs_heap_lift; /* True if address is taken (&var) - variable must be boxed on heap */
     bool is_static;       /* static variable -> private in JVM */
     bool is_extern;       /* extern declaration -> no field generation, just reference */
+    bool is_scalar_ptr;   /* Set during code generation: pointer kept as (base, offset) locals */
+    bool is_file_scope;   /* Set during semantic analysis: file-scope variable (static field) */
+    int id;               /* Unique per Declaration, for code generation's side tables */
 } Declaration;
 
 typedef struct ParameterList_tag
@@ -88,6 +91,7 @@ typedef struct FunctionDeclaration_tag
     char *source_path; /* Path of the translation unit where this declaration appears */
     int index;         /* Set during code generation (0 during parsing) */
     int varargs_index; /* Local variable index for __varargs array (variadic functions only) */
+    int function_entry; /* Set during code generation: position in the class's function table */
 } FunctionDeclaration;
 
 /* ============================================================
@@ -324,6 +328,8 @@ struct Statement_tag
 {
     StatementType type;
     int line_number;
+    int code_size;  /* Set during code generation: bytes emitted for this statement */
+    int outline_id; /* Set during code generation: outlined region (0 = generated in place) */
     union
     {
         Expression *expression_s;
@@ -0,0 +1,12 @@
+# Setup shared by the benchmark scripts, sourced after CODEGEN is set:
+# makes CODEGEN an absolute path, sets REPO to the checkout the script
+# belongs to and WORK to a scratch directory that is removed on exit.
+
+case "$CODEGEN" in
+/*) ;;
+*) CODEGEN="$(pwd)/$CODEGEN" ;;
+esac
+REPO="$(cd "$(dirname "$0")/.." && pwd)"
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
@@ -0,0 +1,77 @@
+#!/bin/sh
+# Header cache benchmark: one source file that includes many large headers
+# (comments, typedefs, macros, enums and prototypes, which emit no classes),
+# so that the run is dominated by reading and parsing the headers.  It is
+# compiled without the header cache, with an empty cache (cold: every
+# header is parsed and stored) and with the cache filled by the cold run
+# (warm: every header is loaded).  Each case is run several times and the
+# best time is reported.
+#
+# usage: bench/header_cache.sh [codegen] [runs] [headers] [entries-per-header]
+
+CODEGEN=${1:-./codegen}
+RUNS=${2:-5}
+HEADERS=${3:-200}
+ENTRIES=${4:-50}
+
+. "$(dirname "$0")/common.sh"
+
+m="$WORK/cache_main.c"
+: > "$m"
+h=0
+while [ $h -lt $HEADERS ]; do
+    f="$WORK/cache_$h.h"
+    echo "#pragma once" > "$f"
+    d=0
+    while [ $d -lt $ENTRIES ]; do
+        echo "/* Entry $d of header $h: a typedef, a constant, an enum and two prototypes */" >> "$f"
+        echo "typedef unsigned long U${h}_${d};" >> "$f"
+        echo "#define LIMIT_${h}_${d} (($d + 1) * 16)" >> "$f"
+        echo "enum E${h}_${d} { E${h}_${d}_A, E${h}_${d}_B = $((d * 4 + 8)), E${h}_${d}_C };" >> "$f"
+        echo "int f${h}_${d}(U${h}_${d} x, const char *name, int *values, int count);" >> "$f"
+        echo "extern const char *n${h}_${d}(enum E${h}_${d} e, U${h}_${d} *out);" >> "$f"
+        d=$((d + 1))
+    done
+    echo "#include \"cache_$h.h\"" >> "$m"
+    h=$((h + 1))
+done
+echo "int main() { return E0_0_C; }" >> "$m"
+
+echo "headers: $HEADERS, entries per header: $ENTRIES, $(cat "$WORK"/cache_*.h | wc -c) bytes"
+cd "$WORK" || exit 1
+
+# best_time <label> <clear cache before each run> [codegen options]
+best_time() {
+    label=$1
+    clear=$2
+    shift 2
+    best=
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        rm -rf out && mkdir out
+        if [ "$clear" = yes ]; then
+            rm -rf cache
+        fi
+        start=$(date +%s%N)
+        (cd out && "$CODEGEN" "$@" ../cache_main.c > ../codegen.log 2>&1)
+        status=$?
+        end=$(date +%s%N)
+        if [ $status -ne 0 ]; then
+            tail -5 codegen.log
+            echo "codegen failed (exit $status)"
+            exit $status
+        fi
+        ms=$(((end - start) / 1000000))
+        if [ -z "$best" ] || [ $ms -lt "$best" ]; then
+            best=$ms
+        fi
+        i=$((i + 1))
+    done
+    echo "$label: $best ms"
+    grep '^header cache:' codegen.log
+}
+
+best_time "no cache" no
+best_time "cold cache" yes --header-cache="$WORK/cache" --cache-stats
+best_time "warm cache" no --header-cache="$WORK/cache" --cache-stats
+echo "cache entries: $(ls cache | wc -l), $(cat cache/* | wc -c) bytes"
@@ -0,0 +1,64 @@
+#!/bin/sh
+# Header lookup stress benchmark: one source file that includes many
+# headers, each with many declarations, so that every identifier in the
+# source is resolved against a large HeaderIndex.  The declarations are
+# typedefs, extern variables and prototypes, which emit no classes of
+# their own, so the time is spent in parsing and name resolution.
+#
+# usage: bench/header_stress.sh [codegen] [headers] [decls-per-header]
+
+CODEGEN=${1:-./codegen}
+HEADERS=${2:-500}
+DECLS=${3:-200}
+
+. "$(dirname "$0")/common.sh"
+
+PER_KIND=$((DECLS / 4))
+h=0
+while [ $h -lt $HEADERS ]; do
+    f="$WORK/stress_$h.h"
+    echo "#pragma once" > "$f"
+    d=0
+    while [ $d -lt $PER_KIND ]; do
+        echo "typedef int T${h}_${d};" >> "$f"
+        echo "typedef T${h}_${d} *P${h}_${d};" >> "$f"
+        echo "extern int v${h}_${d};" >> "$f"
+        echo "int f${h}_${d}(T${h}_${d} x);" >> "$f"
+        d=$((d + 1))
+    done
+    h=$((h + 1))
+done
+
+m="$WORK/stress_main.c"
+: > "$m"
+h=0
+while [ $h -lt $HEADERS ]; do
+    echo "#include \"stress_$h.h\"" >> "$m"
+    h=$((h + 1))
+done
+last=$((HEADERS - 1))
+echo "int main()" >> "$m"
+echo "{" >> "$m"
+echo "    int sum = 0;" >> "$m"
+d=0
+while [ $d -lt $PER_KIND ]; do
+    echo "    T${last}_${d} t$d = $d;" >> "$m"
+    echo "    T0_${d} u$d = t$d;" >> "$m"
+    echo "    sum = sum + t$d + u$d;" >> "$m"
+    d=$((d + 1))
+done
+echo "    return sum;" >> "$m"
+echo "}" >> "$m"
+
+echo "headers: $HEADERS, declarations per header: $DECLS"
+cd "$WORK" || exit 1
+start=$(date +%s%N)
+"$CODEGEN" stress_main.c > codegen.log 2>&1
+status=$?
+end=$(date +%s%N)
+if [ $status -ne 0 ]; then
+    tail -5 codegen.log
+    echo "codegen failed (exit $status)"
+    exit $status
+fi
+echo "compile time: $(((end - start) / 1000000)) ms"
@@ -0,0 +1,61 @@
+#!/bin/sh
+# Incremental build benchmark: compiles a copy of codegen's sources with
+# --incremental after no change, after an edit to one source and after an
+# edit to a header, and checks each time that the class files hash the same
+# as a clean build of the same tree.  Each case is timed once, after the
+# clean build of the tree it compiles.
+#
+# usage: bench/incremental.sh [codegen]
+
+CODEGEN=${1:-./codegen}
+
+. "$(dirname "$0")/common.sh"
+
+mkdir "$WORK/src" "$WORK/clean" "$WORK/incremental"
+cp "$REPO"/*.c "$REPO"/*.h "$WORK/src/"
+
+# run <label> <output dir> [codegen options]
+run() {
+    label=$1
+    dir=$2
+    shift 2
+    start=$(date +%s%N)
+    (cd "$dir" && "$CODEGEN" "$@" "$WORK/src/codegen.c" > "$WORK/codegen.log" 2>&1)
+    status=$?
+    end=$(date +%s%N)
+    if [ $status -ne 0 ]; then
+        tail -5 "$WORK/codegen.log"
+        echo "codegen failed (exit $status)"
+        exit $status
+    fi
+    summary=$(grep '^incremental: [0-9]' "$WORK/codegen.log")
+    echo "$label: $(((end - start) / 1000000)) ms${summary:+ ($summary)}"
+}
+
+class_hashes() {
+    (cd "$1" && find . -name '*.class' | LC_ALL=C sort | xargs cksum)
+}
+
+# case <label>: clean build, then incremental build, of the current tree
+case_run() {
+    rm -rf "$WORK/clean" && mkdir "$WORK/clean"
+    run "  clean" "$WORK/clean"
+    run "  $1" "$WORK/incremental" --incremental
+    if [ "$(class_hashes "$WORK/clean")" = "$(class_hashes "$WORK/incremental")" ]; then
+        echo "  classes identical to the clean build"
+    else
+        echo "  classes DIFFER from the clean build"
+        exit 1
+    fi
+}
+
+echo "first build"
+case_run "incremental (no manifest)"
+echo "no change"
+case_run "incremental"
+echo "one source edited (peephole.c)"
+echo "/* edited */" >> "$WORK/src/peephole.c"
+case_run "incremental"
+echo "one header edited (name_map.h)"
+echo "/* edited */" >> "$WORK/src/name_map.h"
+case_run "incremental"
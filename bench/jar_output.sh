@@ -0,0 +1,62 @@
+#!/bin/sh
+# Jar output benchmark: packages codegen itself the way the jar targets
+# used to, class files into a directory, hashed with find | sha256sum and
+# repackaged with the JDK jar tool, and then with -o, which writes the
+# jar directly.  Checks that both jars hold the same class files.
+#
+# The compiler is either a codegen executable or a codegen .jar, which is
+# run with java -jar as in `make jar1`.  Without a jar tool on the PATH
+# the repackaging step is left out of the first timing.
+#
+# usage: bench/jar_output.sh [codegen | codegen.jar]
+
+CODEGEN=${1:-./codegen}
+
+. "$(dirname "$0")/common.sh"
+
+mkdir "$WORK/out" "$WORK/direct"
+
+compile() {
+    case "$CODEGEN" in
+    *.jar) java -jar "$CODEGEN" "$@" ;;
+    *) "$CODEGEN" "$@" ;;
+    esac
+}
+
+start=$(date +%s%N)
+(cd "$WORK/out" && compile "$REPO/codegen.c" > "$WORK/codegen.log" 2>&1) || {
+    tail -5 "$WORK/codegen.log"
+    echo "codegen failed"
+    exit 1
+}
+(cd "$WORK/out" && find . -type f -name '*.class' -print0 | LC_ALL=C sort -z | xargs -0 sha256sum | sha256sum > /dev/null)
+if command -v jar > /dev/null 2>&1; then
+    jar --create --file "$WORK/repackaged.jar" --main-class codegen -C "$WORK/out" .
+    packaged="class files, hash, jar tool"
+else
+    packaged="class files, hash (no jar tool found)"
+fi
+end=$(date +%s%N)
+echo "classes written: $(ls "$WORK/out" | wc -l)"
+echo "$packaged: $(((end - start) / 1000000)) ms"
+
+start=$(date +%s%N)
+(cd "$WORK/direct" && compile -o codegen.jar "$REPO/codegen.c" > "$WORK/codegen.log" 2>&1) || {
+    tail -5 "$WORK/codegen.log"
+    echo "codegen -o failed"
+    exit 1
+}
+sha256sum "$WORK/direct/codegen.jar" > /dev/null
+end=$(date +%s%N)
+echo "-o codegen.jar: $(((end - start) / 1000000)) ms"
+
+if command -v unzip > /dev/null 2>&1; then
+    mkdir "$WORK/unpacked"
+    (cd "$WORK/unpacked" && unzip -q "$WORK/direct/codegen.jar" && rm -r META-INF)
+    if diff -r "$WORK/out" "$WORK/unpacked" > /dev/null; then
+        echo "jar contents: identical"
+    else
+        echo "jar contents: DIFFERENT"
+        exit 1
+    fi
+fi
@@ -0,0 +1,93 @@
+/*
+ * Lexer microbenchmark: runs the preprocessor/scanner over each source
+ * file given on the command line until end of input and reports the
+ * token count, time per pass and throughput.  Headers are not expanded by #include,
+ * so pass every file of the source set (the Makefile passes the sources
+ * and headers of codegen itself).
+ *
+ * usage: bench/lexer_bench [-n passes] file...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../arena.h"
+#include "../compiler.h"
+#include "../scanner.h"
+#include "../util.h"
+
+static long bytes_per_pass;
+
+static long lex_file(CompilerContext *ctx, const char *path)
+{
+    unsigned char *bytes = NULL;
+    int size = 0;
+    if (!cs_read_file_bytes(path, &bytes, &size))
+    {
+        fprintf(stderr, "error: file not found: %s\n", path);
+        exit(1);
+    }
+
+    bytes_per_pass += size;
+
+    TranslationUnit *tu = tu_create(ctx, path);
+    CS_ScannerConfig config = {
+        .source_path = path,
+        .input_bytes = bytes,
+        .input_size = size,
+        .tu = tu,
+    };
+    Scanner *scanner = cs_create_scanner(&config);
+
+    long tokens = 0;
+    YYSTYPE value;
+    YYLTYPE location;
+    while (yylex(&value, &location, scanner) > 0)
+    {
+        tokens++;
+    }
+
+    cs_delete_scanner(scanner);
+    free(bytes);
+    return tokens;
+}
+
+int main(int argc, char **argv)
+{
+    int passes = 10;
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-n") == 0)
+    {
+        passes = atoi(argv[2]);
+        first = 3;
+    }
+    if (first >= argc || passes <= 0)
+    {
+        fprintf(stderr, "usage: %s [-n passes] file...\n", argv[0]);
+        return 1;
+    }
+
+    CompilerContext *ctx = compiler_context_create();
+    arena_set_current(arena_create("lexer_bench"));
+
+    long tokens = 0;
+    clock_t start = clock();
+    for (int pass = 0; pass < passes; pass++)
+    {
+        tokens = 0;
+        bytes_per_pass = 0;
+        for (int i = first; i < argc; i++)
+        {
+            tokens += lex_file(ctx, argv[i]);
+        }
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("files: %d, tokens per pass: %ld, passes: %d\n", argc - first, tokens, passes);
+    printf("time per pass: %.2f ms (%.1f ns/token)\n", seconds * 1000.0 / passes,
+           seconds * 1e9 / ((double)tokens * passes));
+    printf("throughput: %.1f MB/s\n", (double)bytes_per_pass * passes / seconds / 1e6);
+    return 0;
+}
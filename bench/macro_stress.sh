@@ -0,0 +1,58 @@
+#!/bin/sh
+# Macro expansion stress benchmark: one source file with many invocations
+# of nested function-like macros (and object-like macros in their
+# arguments), spread over functions of a hundred invocations each so that
+# no method gets too large.  The time is dominated by preprocessing.
+#
+# usage: bench/macro_stress.sh [codegen] [invocations]
+
+CODEGEN=${1:-./codegen}
+INVOCATIONS=${2:-10000}
+
+. "$(dirname "$0")/common.sh"
+
+m="$WORK/macro_main.c"
+cat > "$m" <<'HDR'
+#define ADD(a, b) ((a) + (b))
+#define SUM(a, b) ((a) + (b))
+#define MUL(a, b) ((a) * (b))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define CLAMP(x, lo, hi) ((x) < (lo) ? (lo) : MIN(x, hi))
+#define MIX(x, y) SUM(MUL(x, 3), CLAMP(y, LOW, HIGH))
+#define LOW 0
+#define HIGH 1000
+HDR
+
+PER_FUNCTION=100
+FUNCTIONS=$(((INVOCATIONS + PER_FUNCTION - 1) / PER_FUNCTION))
+f=0
+while [ $f -lt $FUNCTIONS ]; do
+    echo "int mix_$f(int x, int y)" >> "$m"
+    echo "{" >> "$m"
+    echo "    int s = 0;" >> "$m"
+    i=0
+    while [ $i -lt $PER_FUNCTION ]; do
+        echo "    s = ADD(s, MIX(x + $i, y));" >> "$m"
+        i=$((i + 1))
+    done
+    echo "    return s;" >> "$m"
+    echo "}" >> "$m"
+    f=$((f + 1))
+done
+echo "int main()" >> "$m"
+echo "{" >> "$m"
+echo "    return mix_0(1, 2) > 0 ? 0 : 1;" >> "$m"
+echo "}" >> "$m"
+
+echo "function-like macro invocations: $((FUNCTIONS * PER_FUNCTION))"
+cd "$WORK" || exit 1
+start=$(date +%s%N)
+"$CODEGEN" macro_main.c > codegen.log 2>&1
+status=$?
+end=$(date +%s%N)
+if [ $status -ne 0 ]; then
+    tail -5 codegen.log
+    echo "codegen failed (exit $status)"
+    exit $status
+fi
+echo "compile time: $(((end - start) / 1000000)) ms"
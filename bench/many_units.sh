@@ -0,0 +1,60 @@
+#!/bin/sh
+# Translation unit scalability benchmark: a main source that includes the
+# headers of many tiny translation units, each of which is compiled and
+# gets a class of its own.  Every unit also includes one shared header.
+# The time goes to the driver's per-file bookkeeping (source queue,
+# compiled list, file store, generated classes) as much as to parsing, so
+# it should grow linearly with the number of units.
+#
+# usage: bench/many_units.sh [codegen] [units]
+
+CODEGEN=${1:-./codegen}
+UNITS=${2:-1000}
+
+. "$(dirname "$0")/common.sh"
+
+mkdir "$WORK/src" "$WORK/out"
+
+cat > "$WORK/src/common.h" <<EOF
+#pragma once
+typedef int unit_value;
+EOF
+
+m="$WORK/src/main.c"
+: > "$m"
+u=0
+while [ $u -lt $UNITS ]; do
+    cat > "$WORK/src/unit_$u.h" <<EOF
+#pragma once
+#include "common.h"
+unit_value unit_$u(unit_value x);
+EOF
+    cat > "$WORK/src/unit_$u.c" <<EOF
+#include "unit_$u.h"
+unit_value unit_$u(unit_value x)
+{
+    return x + $u;
+}
+EOF
+    echo "#include \"unit_$u.h\"" >> "$m"
+    u=$((u + 1))
+done
+last=$((UNITS - 1))
+echo "int main()" >> "$m"
+echo "{" >> "$m"
+echo "    return unit_0(0) + unit_$last(0);" >> "$m"
+echo "}" >> "$m"
+
+echo "translation units: $((UNITS + 1))"
+cd "$WORK/out" || exit 1
+start=$(date +%s%N)
+"$CODEGEN" ../src/main.c > codegen.log 2>&1
+status=$?
+end=$(date +%s%N)
+if [ $status -ne 0 ]; then
+    tail -5 codegen.log
+    echo "codegen failed (exit $status)"
+    exit $status
+fi
+echo "classes written: $(ls *.class | wc -l)"
+echo "compile time: $(((end - start) / 1000000)) ms"
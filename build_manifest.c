@@ -0,0 +1,560 @@
+/*
+ * build_manifest.c - Build manifest for --incremental
+ *
+ * The manifest is a text file, one record per line; paths come last so
+ * that they may contain spaces:
+ *
+ *   csua-manifest <version>
+ *   fingerprint <compiler and options>
+ *   source <embedded> <size> <hash> <hash2> <path>     starts a TU
+ *   include <embedded> <path>
+ *   header <embedded> <size> <hash> <hash2> <path>
+ *   class <name>
+ *   ptr <one 0/1 digit per pointer class>
+ *   end                                               ends the TU
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "build_manifest.h"
+#include "ast.h"
+#include "compiler.h"
+#include "embedded_data.h"
+#include "synthetic_codegen.h"
+#include "util.h"
+
+#ifdef __GNUC__
+#include <pthread.h>
+
+/* Guards the memoized file hashes */
+static pthread_mutex_t hash_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+enum
+{
+    /* Bump whenever the manifest layout changes */
+    BUILD_MANIFEST_VERSION = 1
+};
+
+#define MANIFEST_FILE ".csua-manifest"
+
+/* Path -> contents of every file hashed so far; size -1 when it could not be read */
+static CS_PathMap *hashed_files = NULL;
+
+static ManifestInput *input_create(const char *path, bool is_embedded)
+{
+    ManifestInput *input = (ManifestInput *)calloc(1, sizeof(ManifestInput));
+    input->path = strdup(path);
+    input->is_embedded = is_embedded;
+    input->size = -1;
+    return input;
+}
+
+static void input_set_contents(ManifestInput *input, const unsigned char *bytes, int size)
+{
+    input->size = size;
+    input->hash = cs_content_hash(bytes, size);
+    input->hash2 = cs_content_hash2(bytes, size);
+}
+
+static bool input_same_contents(ManifestInput *a, ManifestInput *b)
+{
+    return a->size >= 0 && a->size == b->size && a->hash == b->hash && a->hash2 == b->hash2;
+}
+
+static void read_contents(ManifestInput *input)
+{
+    if (input->is_embedded)
+    {
+        const char *name = strrchr(input->path, '/');
+        name = name ? name + 1 : input->path;
+        const EmbeddedFile *embedded = embedded_find(name);
+        if (embedded)
+        {
+            input_set_contents(input, embedded->data, embedded->size);
+        }
+        return;
+    }
+    unsigned char *bytes = NULL;
+    int size = 0;
+    if (cs_read_file_bytes(input->path, &bytes, &size))
+    {
+        input_set_contents(input, bytes, size);
+        free(bytes);
+    }
+}
+
+static ManifestInput *find_hashed_file(const char *path, bool is_embedded)
+{
+    if (!hashed_files)
+    {
+        hashed_files = cs_path_map_create();
+    }
+    return (ManifestInput *)cs_path_map_get(hashed_files, path, is_embedded);
+}
+
+/* The memoized contents of path; each file is hashed at most once per run.
+ * The file is read outside hash_mutex so that workers read in parallel; when
+ * two of them race on the same file the first one to finish is kept. */
+static ManifestInput *hashed_file(const char *path, bool is_embedded)
+{
+#ifdef __GNUC__
+    pthread_mutex_lock(&hash_mutex);
+#endif
+    ManifestInput *input = find_hashed_file(path, is_embedded);
+#ifdef __GNUC__
+    pthread_mutex_unlock(&hash_mutex);
+#endif
+    if (input)
+        return input;
+
+    ManifestInput *fresh = input_create(path, is_embedded);
+    read_contents(fresh);
+
+#ifdef __GNUC__
+    pthread_mutex_lock(&hash_mutex);
+#endif
+    input = find_hashed_file(path, is_embedded);
+    if (!input)
+    {
+        cs_path_map_set(hashed_files, path, is_embedded, fresh);
+        input = fresh;
+    }
+#ifdef __GNUC__
+    pthread_mutex_unlock(&hash_mutex);
+#endif
+    if (input != fresh)
+    {
+        free(fresh->path);
+        free(fresh);
+    }
+    return input;
+}
+
+static void append_input(ManifestInput **first, ManifestInput **last, ManifestInput *input)
+{
+    if (*last)
+    {
+        (*last)->next = input;
+    }
+    else
+    {
+        *first = input;
+    }
+    *last = input;
+}
+
+BuildManifest *build_manifest_create(const char *fingerprint)
+{
+    BuildManifest *manifest = (BuildManifest *)calloc(1, sizeof(BuildManifest));
+    manifest->fingerprint = strdup(fingerprint);
+    manifest->sources = cs_path_map_create();
+    return manifest;
+}
+
+ManifestEntry *build_manifest_find(BuildManifest *manifest, const char *path, bool is_embedded)
+{
+    if (!manifest)
+        return NULL;
+    return (ManifestEntry *)cs_path_map_get(manifest->sources, path, is_embedded);
+}
+
+ManifestEntry *manifest_entry_create(const char *path, bool is_embedded,
+                                     const unsigned char *bytes, int size)
+{
+    ManifestEntry *entry = (ManifestEntry *)calloc(1, sizeof(ManifestEntry));
+    entry->source = input_create(path, is_embedded);
+    if (bytes)
+    {
+        input_set_contents(entry->source, bytes, size);
+    }
+    return entry;
+}
+
+void build_manifest_append(BuildManifest *manifest, ManifestEntry *entry)
+{
+    entry->next = NULL;
+    if (manifest->last)
+    {
+        manifest->last->next = entry;
+    }
+    else
+    {
+        manifest->entries = entry;
+    }
+    manifest->last = entry;
+    /* The first entry of a source is the one found */
+    if (!cs_path_map_get(manifest->sources, entry->source->path, entry->source->is_embedded))
+    {
+        cs_path_map_set(manifest->sources, entry->source->path, entry->source->is_embedded, entry);
+    }
+    if (entry->reused)
+    {
+        manifest->reused_count = manifest->reused_count + 1;
+    }
+    else
+    {
+        manifest->rebuilt_count = manifest->rebuilt_count + 1;
+    }
+}
+
+void manifest_entry_add_include(ManifestEntry *entry, const char *path, bool is_embedded)
+{
+    ManifestInput *first = entry->includes;
+    ManifestInput *last = entry->includes_last;
+    append_input(&first, &last, input_create(path, is_embedded));
+    entry->includes = first;
+    entry->includes_last = last;
+}
+
+void manifest_entry_add_header(ManifestEntry *entry, const char *path, bool is_embedded)
+{
+    ManifestInput *current = hashed_file(path, is_embedded);
+    ManifestInput *header = input_create(path, is_embedded);
+    header->size = current->size;
+    header->hash = current->hash;
+    header->hash2 = current->hash2;
+
+    ManifestInput *first = entry->headers;
+    ManifestInput *last = entry->headers_last;
+    append_input(&first, &last, header);
+    entry->headers = first;
+    entry->headers_last = last;
+}
+
+void manifest_entry_add_class(ManifestEntry *entry, const char *class_name)
+{
+    ManifestInput *first = entry->classes;
+    ManifestInput *last = entry->classes_last;
+    append_input(&first, &last, input_create(class_name, false));
+    entry->classes = first;
+    entry->classes_last = last;
+}
+
+void manifest_entry_copy_outputs(ManifestEntry *entry, ManifestEntry *previous)
+{
+    for (ManifestInput *cls = previous->classes; cls; cls = cls->next)
+    {
+        manifest_entry_add_class(entry, cls->path);
+    }
+    if (previous->ptr_used)
+    {
+        entry->ptr_used = (bool *)calloc(PTR_TYPE_COUNT, sizeof(bool));
+        for (int i = 0; i < PTR_TYPE_COUNT; i++)
+        {
+            entry->ptr_used[i] = previous->ptr_used[i];
+        }
+    }
+}
+
+static bool class_file_exists(const char *class_name)
+{
+    int len = strlen(class_name);
+    char *file = (char *)calloc(len + 7, sizeof(char));
+    strcpy(file, class_name);
+    strcpy(file + len, ".class");
+    FILE *fp = fopen(file, "rb");
+    free(file);
+    if (!fp)
+        return false;
+    fclose(fp);
+    return true;
+}
+
+bool manifest_entry_is_up_to_date(ManifestEntry *entry, ManifestEntry *previous)
+{
+    if (!previous || !input_same_contents(entry->source, previous->source))
+        return false;
+    for (ManifestInput *header = previous->headers; header; header = header->next)
+    {
+        if (!input_same_contents(hashed_file(header->path, header->is_embedded), header))
+            return false;
+    }
+    for (ManifestInput *cls = previous->classes; cls; cls = cls->next)
+    {
+        if (!class_file_exists(cls->path))
+            return false;
+    }
+    return true;
+}
+
+/* The manifest text being built; written with a single fwrite, as the
+ * self-hosted runtime's fprintf only prints to the standard streams */
+typedef struct ManifestWriter_tag
+{
+    char *data;
+    int size;
+    int capacity;
+} ManifestWriter;
+
+static void put_text(ManifestWriter *w, const char *text)
+{
+    int len = strlen(text);
+    if (w->size + len >= w->capacity)
+    {
+        int capacity = w->capacity * 2;
+        while (w->size + len >= capacity)
+        {
+            capacity = capacity * 2;
+        }
+        char *data = (char *)calloc(capacity, sizeof(char));
+        for (int i = 0; i < w->size; i++)
+        {
+            data[i] = w->data[i];
+        }
+        free(w->data);
+        w->data = data;
+        w->capacity = capacity;
+    }
+    for (int i = 0; i < len; i++)
+    {
+        w->data[w->size + i] = text[i];
+    }
+    w->size = w->size + len;
+}
+
+/* value followed by separator */
+static void put_field(ManifestWriter *w, int value, const char *separator)
+{
+    char *text = (char *)calloc(16, sizeof(char));
+    snprintf(text, 16, "%d", value);
+    put_text(w, text);
+    put_text(w, separator);
+    free(text);
+}
+
+static void put_line(ManifestWriter *w, const char *tag, const char *rest)
+{
+    put_text(w, tag);
+    put_text(w, " ");
+    put_text(w, rest);
+    put_text(w, "\n");
+}
+
+static void put_input(ManifestWriter *w, const char *tag, ManifestInput *input)
+{
+    put_text(w, tag);
+    put_text(w, " ");
+    put_field(w, input->is_embedded ? 1 : 0, " ");
+    put_field(w, input->size, " ");
+    put_field(w, (int)input->hash, " ");
+    put_field(w, (int)input->hash2, " ");
+    put_text(w, input->path);
+    put_text(w, "\n");
+}
+
+bool build_manifest_write(BuildManifest *manifest)
+{
+    ManifestWriter w;
+    w.capacity = 4096;
+    w.data = (char *)calloc(w.capacity, sizeof(char));
+    w.size = 0;
+
+    put_text(&w, "csua-manifest ");
+    put_field(&w, BUILD_MANIFEST_VERSION, "\n");
+    put_line(&w, "fingerprint", manifest->fingerprint);
+    char *bits = (char *)calloc(PTR_TYPE_COUNT + 1, sizeof(char));
+    for (ManifestEntry *entry = manifest->entries; entry; entry = entry->next)
+    {
+        put_input(&w, "source", entry->source);
+        for (ManifestInput *include = entry->includes; include; include = include->next)
+        {
+            put_text(&w, "include ");
+            put_field(&w, include->is_embedded ? 1 : 0, " ");
+            put_text(&w, include->path);
+            put_text(&w, "\n");
+        }
+        for (ManifestInput *header = entry->headers; header; header = header->next)
+        {
+            put_input(&w, "header", header);
+        }
+        for (ManifestInput *cls = entry->classes; cls; cls = cls->next)
+        {
+            put_line(&w, "class", cls->path);
+        }
+        for (int i = 0; i < PTR_TYPE_COUNT; i++)
+        {
+            bits[i] = entry->ptr_used && entry->ptr_used[i] ? '1' : '0';
+        }
+        put_line(&w, "ptr", bits);
+        put_text(&w, "end\n");
+    }
+    free(bits);
+
+    FILE *fp = fopen(MANIFEST_FILE, "wb");
+    bool ok = fp != NULL;
+    if (fp)
+    {
+        int written = fwrite(w.data, 1, w.size, fp);
+        ok = written == w.size;
+        fclose(fp);
+    }
+    free(w.data);
+    return ok;
+}
+
+/* One line of the manifest being read */
+typedef struct ManifestLine_tag
+{
+    char *text;   /* The whole line (owned) */
+    char *cursor; /* Next field */
+    bool ok;      /* False once a field failed to parse */
+} ManifestLine;
+
+/* Read the next line of data into line; false at the end */
+static bool next_line(const unsigned char *data, int size, int *pos, ManifestLine *line)
+{
+    int start = *pos;
+    if (start >= size)
+        return false;
+    int end = start;
+    while (end < size && data[end] != '\n')
+    {
+        end++;
+    }
+    line->text = (char *)calloc(end - start + 1, sizeof(char));
+    for (int i = start; i < end; i++)
+    {
+        line->text[i - start] = (char)data[i];
+    }
+    line->cursor = line->text;
+    line->ok = true;
+    *pos = end + 1;
+    return true;
+}
+
+/* Take the tag word off the line; true if it is tag */
+static bool line_tag(ManifestLine *line, const char *tag)
+{
+    int len = strlen(tag);
+    if (strncmp(line->text, tag, len) != 0 || (line->text[len] != ' ' && line->text[len] != '\0'))
+        return false;
+    line->cursor = line->text + len;
+    if (line->cursor[0] == ' ')
+    {
+        line->cursor = line->cursor + 1;
+    }
+    return true;
+}
+
+static int line_int(ManifestLine *line)
+{
+    char *end = NULL;
+    long value = strtol(line->cursor, &end, 10);
+    if (end == line->cursor || (end[0] != ' ' && end[0] != '\0'))
+    {
+        line->ok = false;
+        return 0;
+    }
+    line->cursor = end[0] == ' ' ? end + 1 : end;
+    return (int)value;
+}
+
+/* "<embedded> <size> <hash> <hash2> <path>" */
+static ManifestInput *line_input(ManifestLine *line)
+{
+    bool is_embedded = line_int(line) != 0;
+    int size = line_int(line);
+    int hash = line_int(line);
+    int hash2 = line_int(line);
+    ManifestInput *input = input_create(line->cursor, is_embedded);
+    input->size = size;
+    input->hash = (uint32_t)hash;
+    input->hash2 = (uint32_t)hash2;
+    return input;
+}
+
+/* Apply one line to entry; false if it does not belong in an entry */
+static bool read_entry_line(ManifestEntry *entry, ManifestLine *line)
+{
+    if (line_tag(line, "include"))
+    {
+        bool is_embedded = line_int(line) != 0;
+        manifest_entry_add_include(entry, line->cursor, is_embedded);
+        return true;
+    }
+    if (line_tag(line, "header"))
+    {
+        ManifestInput *first = entry->headers;
+        ManifestInput *last = entry->headers_last;
+        append_input(&first, &last, line_input(line));
+        entry->headers = first;
+        entry->headers_last = last;
+        return true;
+    }
+    if (line_tag(line, "class"))
+    {
+        manifest_entry_add_class(entry, line->cursor);
+        return true;
+    }
+    if (line_tag(line, "ptr"))
+    {
+        if ((int)strlen(line->cursor) != PTR_TYPE_COUNT)
+            return false;
+        entry->ptr_used = (bool *)calloc(PTR_TYPE_COUNT, sizeof(bool));
+        for (int i = 0; i < PTR_TYPE_COUNT; i++)
+        {
+            entry->ptr_used[i] = line->cursor[i] == '1';
+        }
+        return true;
+    }
+    return false;
+}
+
+BuildManifest *build_manifest_load(const char *fingerprint)
+{
+    unsigned char *data = NULL;
+    int size = 0;
+    if (!cs_read_file_bytes(MANIFEST_FILE, &data, &size))
+        return NULL;
+
+    BuildManifest *manifest = build_manifest_create(fingerprint);
+    ManifestEntry *entry = NULL;
+    bool ok = true;
+    int pos = 0;
+    int line_number = 0;
+    ManifestLine line;
+    while (ok && next_line(data, size, &pos, &line))
+    {
+        line_number++;
+        if (line_number == 1)
+        {
+            ok = line_tag(&line, "csua-manifest") && line_int(&line) == BUILD_MANIFEST_VERSION;
+        }
+        else if (line_number == 2)
+        {
+            ok = line_tag(&line, "fingerprint") && strcmp(line.cursor, fingerprint) == 0;
+        }
+        else if (!entry)
+        {
+            ok = line_tag(&line, "source");
+            if (ok)
+            {
+                entry = (ManifestEntry *)calloc(1, sizeof(ManifestEntry));
+                entry->source = line_input(&line);
+            }
+        }
+        else if (line_tag(&line, "end"))
+        {
+            build_manifest_append(manifest, entry);
+            entry = NULL;
+        }
+        else
+        {
+            ok = read_entry_line(entry, &line);
+        }
+        ok = ok && line.ok;
+        free(line.text);
+    }
+    free(data);
+
+    /* A manifest cut short or with a bad line is ignored as a whole */
+    if (!ok || entry || line_number < 2)
+        return NULL;
+    manifest->reused_count = 0;
+    manifest->rebuilt_count = 0;
+    return manifest;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+/*
+ * build_manifest.h - Build manifest for --incremental
+ *
+ * The manifest (.csua-manifest) is written next to the class files after
+ * a successful build.  It records the compiler and the options that change
+ * the output, and for each translation unit in compile order: the size and
+ * hashes of the source, the #include list the scanner found in it, the
+ * size and hashes of every header visible to it, the class files its code
+ * generation wrote and the pointer classes it used.
+ *
+ * A translation unit is up to date when its source and all its recorded
+ * headers hash as before and all its recorded class files still exist.
+ * The front end then skips its parse, mean_check and code generation but
+ * still parses (or takes from the header cache) the headers it includes,
+ * so every other TU sees the same declarations as in a clean build.
+ *
+ * Sources and file hashes are looked up by path in a CS_PathMap.  File
+ * hashes are memoized for the whole run; workers of the parallel front
+ * end may hash files concurrently.
+ */
+
+#include "cminor_base.h"
+
+/* A file and its contents */
+typedef struct ManifestInput_tag
+{
+    char *path;
+    bool is_embedded;
+    int size;
+    uint32_t hash;
+    uint32_t hash2;
+    struct ManifestInput_tag *next;
+} ManifestInput;
+
+/* One translation unit */
+typedef struct ManifestEntry_tag
+{
+    ManifestInput *source;
+    ManifestInput *includes;      /* #include list of the source, in source order (size and hashes unused) */
+    ManifestInput *includes_last;
+    ManifestInput *headers;       /* Headers visible to the TU */
+    ManifestInput *headers_last;
+    ManifestInput *classes;       /* Class files written for the TU (path only) */
+    ManifestInput *classes_last;
+    bool *ptr_used;               /* Pointer classes its code uses (PTR_TYPE_COUNT entries, NULL = none) */
+    bool reused;                  /* Up to date: taken over from the previous manifest */
+    struct ManifestEntry_tag *next;
+} ManifestEntry;
+
+typedef struct BuildManifest_tag
+{
+    char *fingerprint; /* Compiler identity and output options */
+    ManifestEntry *entries;
+    ManifestEntry *last;
+    struct CS_PathMap_tag *sources; /* Source path -> its first entry */
+    int reused_count;
+    int rebuilt_count;
+} BuildManifest;
+
+BuildManifest *build_manifest_create(const char *fingerprint);
+
+/* Read the manifest of the previous build.  NULL when there is none, it
+ * cannot be read or it was written by another compiler or with other options. */
+BuildManifest *build_manifest_load(const char *fingerprint);
+
+/* Write the manifest; false if the file cannot be written */
+bool build_manifest_write(BuildManifest *manifest);
+
+ManifestEntry *build_manifest_find(BuildManifest *manifest, const char *path, bool is_embedded);
+
+/* Entry for a source whose contents are bytes/size; not yet in any manifest */
+ManifestEntry *manifest_entry_create(const char *path, bool is_embedded,
+                                     const unsigned char *bytes, int size);
+
+/* Append entry to manifest (entries stay in compile order) */
+void build_manifest_append(BuildManifest *manifest, ManifestEntry *entry);
+
+void manifest_entry_add_include(ManifestEntry *entry, const char *path, bool is_embedded);
+
+/* Record a visible header with its current contents */
+void manifest_entry_add_header(ManifestEntry *entry, const char *path, bool is_embedded);
+
+void manifest_entry_add_class(ManifestEntry *entry, const char *class_name);
+
+/* Take over the class files and pointer usage recorded in previous */
+void manifest_entry_copy_outputs(ManifestEntry *entry, ManifestEntry *previous);
+
+/* True when previous describes entry's source and its headers and
+ * class files are unchanged */
+bool manifest_entry_is_up_to_date(ManifestEntry *entry, ManifestEntry *previous);
@@ -52,10 +52,15 @@ static bool cfg_is_conditional_branch(CF_Opcode op)
     }
 }
 
+static bool cfg_is_switch(CF_Opcode op)
+{
+    return op == CF_TABLESWITCH || op == CF_LOOKUPSWITCH;
+}
+
 static bool cfg_is_control_transfer(CF_Opcode op)
 {
     return cfg_is_return_or_throw(op) || cfg_is_unconditional_branch(op) ||
-           cfg_is_conditional_branch(op);
+           cfg_is_conditional_branch(op) || cfg_is_switch(op);
 }
 
 static bool cfg_read_s2(const uint8_t *code, int pos, int size, int16_t *out)
@@ -127,6 +132,111 @@ static bool cfg_decode_branch_target(const BytecodeInstr *instr,
     return true;
 }
 
+int cfg_instr_length(const uint8_t *code, int code_size, int pc)
+{
+    if (!code || pc < 0 || pc >= code_size)
+    {
+        return 0;
+    }
+
+    int op = code[pc];
+    if (op == CF_TABLESWITCH || op == CF_LOOKUPSWITCH)
+    {
+        /* Operands start at the next 4-byte boundary */
+        int pos = pc + 1 + (3 - pc % 4);
+        int32_t a = 0;
+        int32_t b = 0;
+        if (!cfg_read_s4(code, pos + 4, code_size, &a))
+        {
+            return 0;
+        }
+        if (op == CF_LOOKUPSWITCH)
+        {
+            return pos + 8 + 8 * a - pc;
+        }
+        if (!cfg_read_s4(code, pos + 8, code_size, &b))
+        {
+            return 0;
+        }
+        return pos + 12 + 4 * (b - a + 1) - pc;
+    }
+    if (op == CF_WIDE)
+    {
+        if (pc + 1 >= code_size)
+        {
+            return 0;
+        }
+        return code[pc + 1] == CF_IINC ? 6 : 4;
+    }
+
+    if (op == CF_BIPUSH || op == CF_LDC || op == CF_NEWARRAY || op == CF_RET ||
+        (op >= CF_ILOAD && op <= CF_ALOAD) || (op >= CF_ISTORE && op <= CF_ASTORE))
+    {
+        return 2;
+    }
+    if (op == CF_SIPUSH || op == CF_LDC_W || op == CF_LDC2_W || op == CF_IINC ||
+        (op >= CF_IFEQ && op <= CF_JSR) || (op >= CF_GETSTATIC && op <= CF_INVOKESTATIC) ||
+        op == CF_NEW || op == CF_ANEWARRAY || op == CF_CHECKCAST ||
+        op == CF_INSTANCEOF || op == CF_IFNULL || op == CF_IFNONNULL)
+    {
+        return 3;
+    }
+    if (op == CF_MULTIANEWARRAY)
+    {
+        return 4;
+    }
+    if (op == CF_INVOKEINTERFACE || op == CF_INVOKEDYNAMIC || op == CF_GOTO_W ||
+        op == CF_JSR_W)
+    {
+        return 5;
+    }
+    if (op > CF_JSR_W)
+    {
+        return 0;
+    }
+    return 1;
+}
+
+int cfg_switch_targets(const uint8_t *code, int code_size, int pc, int **targets)
+{
+    *targets = NULL;
+    int length = cfg_instr_length(code, code_size, pc);
+    if (length == 0 || (code[pc] != CF_TABLESWITCH && code[pc] != CF_LOOKUPSWITCH))
+    {
+        return 0;
+    }
+
+    int pos = pc + 1 + (3 - pc % 4);
+    int count = 1;
+    int first = pos + 12;
+    int stride = 4;
+    int32_t a = 0;
+    int32_t b = 0;
+    cfg_read_s4(code, pos + 4, code_size, &a);
+    if (code[pc] == CF_LOOKUPSWITCH)
+    {
+        count += a;
+        stride = 8;
+    }
+    else
+    {
+        cfg_read_s4(code, pos + 8, code_size, &b);
+        count += b - a + 1;
+    }
+
+    int *result = (int *)calloc(count, sizeof(int));
+    int32_t offset = 0;
+    cfg_read_s4(code, pos, code_size, &offset);
+    result[0] = pc + offset;
+    for (int i = 1; i < count; ++i)
+    {
+        cfg_read_s4(code, first + (i - 1) * stride, code_size, &offset);
+        result[i] = pc + offset;
+    }
+    *targets = result;
+    return count;
+}
+
 static int cfg_find_instr_index(const BytecodeInstr *instrs, int count,
                                 int pc)
 {
@@ -152,6 +262,21 @@ static int cfg_find_instr_index(const BytecodeInstr *instrs, int count,
     return -1;
 }
 
+static void cfg_mark_target(CFG_Info *cfg, const BytecodeInstr *instrs,
+                            int instr_count, int target)
+{
+    int idx = cfg_find_instr_index(instrs, instr_count, target);
+    if (idx >= 0)
+    {
+        cfg->is_block_start[idx] = true;
+        cfg->is_branch_target[idx] = true;
+    }
+    else
+    {
+        fprintf(stderr, "cfg: missing branch target pc %d\n", target);
+    }
+}
+
 CFG_Info cfg_build(const BytecodeInstr *instrs, int instr_count,
                    const uint8_t *code, int code_size,
                    const CF_ExceptionEntry *exceptions,
@@ -236,6 +361,21 @@ CFG_Info cfg_build(const BytecodeInstr *instrs, int instr_count,
                         instr->pc);
             }
         }
+        else if (cfg_is_switch(instr->opcode))
+        {
+            int *targets = NULL;
+            int target_count = cfg_switch_targets(code, code_size, instr->pc, &targets);
+            for (int t = 0; t < target_count; ++t)
+            {
+                cfg_mark_target(&cfg, instrs, instr_count, targets[t]);
+            }
+            if (target_count > 0)
+            {
+                cfg.succ_pc0[i] = targets[0];
+                succ_count++;
+            }
+            free(targets);
+        }
         else if (!cfg_is_return_or_throw(instr->opcode))
         {
             if (i + 1 < instr_count)
@@ -282,5 +422,16 @@ void cfg_free(CFG_Info *cfg)
         return;
     }
 
-    (void)cfg;
+    free(cfg->is_block_start);
+    free(cfg->is_branch_target);
+    free(cfg->is_handler_entry);
+    free(cfg->succ_count);
+    free(cfg->succ_pc0);
+    free(cfg->succ_pc1);
+    cfg->is_block_start = NULL;
+    cfg->is_branch_target = NULL;
+    cfg->is_handler_entry = NULL;
+    cfg->succ_count = NULL;
+    cfg->succ_pc0 = NULL;
+    cfg->succ_pc1 = NULL;
 }
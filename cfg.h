@@ -21,3 +21,11 @@ CFG_Info cfg_build(const BytecodeInstr *instrs, int instr_count,
                    int exception_count);
 
 void cfg_free(CFG_Info *cfg);
+
+/* Length in bytes of the instruction at pc (including wide and switch
+ * padding), or 0 if it cannot be decoded */
+int cfg_instr_length(const uint8_t *code, int code_size, int pc);
+
+/* Decode the absolute targets of the tableswitch/lookupswitch at pc into a
+ * newly allocated array: default first, then one per case. Returns the count. */
+int cfg_switch_targets(const uint8_t *code, int code_size, int pc, int **targets);
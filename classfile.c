@@ -178,6 +178,116 @@ static int encode_mutf8(const uint8_t *src, int src_len, uint8_t *dst)
     return j;
 }
 
+/* ============================================================
+ * Constant Pool Hash Index
+ * ============================================================ */
+
+/* Final avalanche so that small component indices spread over buckets */
+static uint32_t cp_hash_finish(uint32_t h)
+{
+    h = h ^ (h >> 15);
+    h = h * 0x2C1B3C6DU;
+    h = h ^ (h >> 12);
+    return h;
+}
+
+static uint32_t cp_hash_bytes(const uint8_t *bytes, int len)
+{
+    uint32_t h = (uint32_t)CP_TAG_UTF8;
+    for (int i = 0; i < len; i++)
+    {
+        h = h * 31U + bytes[i];
+    }
+    return cp_hash_finish(h);
+}
+
+static uint32_t cp_hash_pair(CF_ConstantTag tag, int first, int second)
+{
+    uint32_t h = ((uint32_t)first << 16) | (uint32_t)second;
+    h = h ^ ((uint32_t)tag * 0x01000193U);
+    return cp_hash_finish(h);
+}
+
+/* Component indices of a non-Utf8 indexed entry; false if not indexed */
+static bool cp_entry_pair(const CF_ConstantEntry *e, int *first, int *second)
+{
+    switch (e->tag)
+    {
+    case CP_TAG_CLASS:
+    case CP_TAG_STRING:
+        *first = e->u.index;
+        *second = 0;
+        return true;
+    case CP_TAG_NAME_AND_TYPE:
+        *first = e->u.name_and_type.name_index;
+        *second = e->u.name_and_type.descriptor_index;
+        return true;
+    case CP_TAG_FIELDREF:
+    case CP_TAG_METHODREF:
+        *first = e->u.ref.class_index;
+        *second = e->u.ref.name_and_type_index;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void cp_index_link(CF_ConstantPool *cp, int idx, uint32_t hash)
+{
+    int bucket = (int)(hash & (uint32_t)cp->index_mask);
+    cp->index_next[idx] = cp->index_heads[bucket];
+    cp->index_heads[bucket] = idx;
+}
+
+/* Re-create the index for the current capacity (one bucket per two slots) */
+static void cp_index_rebuild(CF_ConstantPool *cp)
+{
+    int bucket_count = cp->capacity * 2;
+    if (cp->index_heads)
+    {
+        free(cp->index_heads);
+    }
+    if (cp->index_next)
+    {
+        free(cp->index_next);
+    }
+    cp->index_heads = (int *)calloc(bucket_count, sizeof(int));
+    cp->index_next = (int *)calloc(cp->capacity, sizeof(int));
+    cp->index_mask = bucket_count - 1;
+
+    for (int i = 1; i < cp->count; ++i)
+    {
+        CF_ConstantEntry *e = &cp->entries[i];
+        int first = 0;
+        int second = 0;
+        if (e->tag == CP_TAG_UTF8)
+        {
+            cp_index_link(cp, i, cp_hash_bytes(e->u.utf8.bytes, e->u.utf8.length));
+        }
+        else if (cp_entry_pair(e, &first, &second))
+        {
+            cp_index_link(cp, i, cp_hash_pair(e->tag, first, second));
+        }
+    }
+}
+
+static int cp_index_find_pair(CF_ConstantPool *cp, CF_ConstantTag tag,
+                              int first, int second, uint32_t hash)
+{
+    int bucket = (int)(hash & (uint32_t)cp->index_mask);
+    for (int i = cp->index_heads[bucket]; i != 0; i = cp->index_next[i])
+    {
+        CF_ConstantEntry *e = &cp->entries[i];
+        int a = 0;
+        int b = 0;
+        if (e->tag == tag && cp_entry_pair(e, &a, &b) && a == first && b == second)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
 /* ============================================================
  * Constant Pool Operations
  * ============================================================ */
@@ -188,6 +298,7 @@ CF_ConstantPool *cf_cp_create()
     cp->capacity = 64;
     cp->entries = (CF_ConstantEntry *)calloc(cp->capacity, sizeof(CF_ConstantEntry));
     cp->count = 1; /* Index 0 is unused in constant pool */
+    cp_index_rebuild(cp);
     return cp;
 }
 
@@ -208,6 +319,17 @@ void cf_cp_free(CF_ConstantPool *cp)
     free(cp->entries);
     cp->entries = NULL;
     cp->count = 0;
+
+    if (cp->index_heads != NULL)
+    {
+        free(cp->index_heads);
+        cp->index_heads = NULL;
+    }
+    if (cp->index_next != NULL)
+    {
+        free(cp->index_next);
+        cp->index_next = NULL;
+    }
 }
 
 static int cf_cp_alloc(CF_ConstantPool *cp, int slots)
@@ -222,6 +344,7 @@ static int cf_cp_alloc(CF_ConstantPool *cp, int slots)
             new_entries[i] = cp->entries[i];
         }
         cp->entries = new_entries;
+        cp_index_rebuild(cp);
     }
     uint16_t idx = cp->count;
     cp->count = (uint16_t)(cp->count + slots);
@@ -239,15 +362,17 @@ static bool bytes_equal(const uint8_t *a, const uint8_t *b, int len)
     return true;
 }
 
-static uint16_t cf_cp_find_utf8_bytes(CF_ConstantPool *cp, const uint8_t *bytes, int len)
+static uint16_t cf_cp_find_utf8_hashed(CF_ConstantPool *cp, const uint8_t *bytes, int len,
+                                       uint32_t hash)
 {
-    for (uint16_t i = 1; i < cp->count; ++i)
+    int bucket = (int)(hash & (uint32_t)cp->index_mask);
+    for (int i = cp->index_heads[bucket]; i != 0; i = cp->index_next[i])
     {
         if (cp->entries[i].tag == CP_TAG_UTF8 &&
             cp->entries[i].u.utf8.length == len &&
             bytes_equal(cp->entries[i].u.utf8.bytes, bytes, len))
         {
-            return i;
+            return (uint16_t)i;
         }
     }
     return 0;
@@ -256,29 +381,52 @@ static uint16_t cf_cp_find_utf8_bytes(CF_ConstantPool *cp, const uint8_t *bytes,
 int cf_cp_find_utf8(CF_ConstantPool *cp, const char *str)
 {
     int len = strlen(str);
-    return cf_cp_find_utf8_bytes(cp, (const uint8_t *)str, len);
+    const uint8_t *bytes = (const uint8_t *)str;
+    return cf_cp_find_utf8_hashed(cp, bytes, len, cp_hash_bytes(bytes, len));
 }
 
 /* Add UTF-8 string with explicit length, encoding to MUTF-8 */
 int cf_cp_add_utf8_len(CF_ConstantPool *cp, const uint8_t *data, int len)
 {
-    /* Encode to MUTF-8 */
+    /* Fast path: when MUTF-8 leaves the input unchanged (plain ASCII and
+     * most UTF-8), look up the raw bytes and only copy on insertion. */
     int mutf8_len = mutf8_encoded_len(data, len);
-    uint8_t *mutf8_buf = (uint8_t *)calloc(mutf8_len, sizeof(uint8_t));
-    encode_mutf8(data, len, mutf8_buf);
+    const uint8_t *key = data;
+    uint8_t *mutf8_buf = NULL;
+    if (mutf8_len != len)
+    {
+        mutf8_buf = (uint8_t *)calloc(mutf8_len, sizeof(uint8_t));
+        encode_mutf8(data, len, mutf8_buf);
+        key = mutf8_buf;
+    }
 
     /* Check for existing entry */
-    int existing = cf_cp_find_utf8_bytes(cp, mutf8_buf, mutf8_len);
+    uint32_t hash = cp_hash_bytes(key, mutf8_len);
+    int existing = cf_cp_find_utf8_hashed(cp, key, mutf8_len, hash);
     if (existing != 0)
     {
+        if (mutf8_buf != NULL)
+        {
+            free(mutf8_buf);
+        }
         return existing;
     }
 
+    if (mutf8_buf == NULL)
+    {
+        mutf8_buf = (uint8_t *)calloc(mutf8_len, sizeof(uint8_t));
+        if (mutf8_len > 0)
+        {
+            memcpy(mutf8_buf, data, mutf8_len);
+        }
+    }
+
     int idx = cf_cp_alloc(cp, 1);
     CF_ConstantEntry *e = &cp->entries[idx];
     e->tag = CP_TAG_UTF8;
     e->u.utf8.length = (uint16_t)mutf8_len;
     e->u.utf8.bytes = mutf8_buf;
+    cp_index_link(cp, idx, hash);
     return idx;
 }
 
@@ -328,45 +476,53 @@ int cf_cp_add_double(CF_ConstantPool *cp, double value)
     return idx;
 }
 
-int cf_cp_add_class(CF_ConstantPool *cp, const char *name)
+/* Add a Class/String/NameAndType/ref entry unless an identical one exists */
+static int cf_cp_add_pair(CF_ConstantPool *cp, CF_ConstantTag tag, int first, int second)
 {
-    int name_index = cf_cp_add_utf8(cp, name);
-
-    /* Check for existing class entry with same name */
-    for (int i = 1; i < cp->count; ++i)
+    uint32_t hash = cp_hash_pair(tag, first, second);
+    int existing = cp_index_find_pair(cp, tag, first, second, hash);
+    if (existing != 0)
     {
-        if (cp->entries[i].tag == CP_TAG_CLASS &&
-            cp->entries[i].u.index == name_index)
-        {
-            return i;
-        }
+        return existing;
     }
 
     int idx = cf_cp_alloc(cp, 1);
     CF_ConstantEntry *e = &cp->entries[idx];
-    e->tag = CP_TAG_CLASS;
-    e->u.index = (uint16_t)name_index;
+    e->tag = tag;
+    if (tag == CP_TAG_NAME_AND_TYPE)
+    {
+        e->u.name_and_type.name_index = (uint16_t)first;
+        e->u.name_and_type.descriptor_index = (uint16_t)second;
+    }
+    else if (tag == CP_TAG_FIELDREF || tag == CP_TAG_METHODREF)
+    {
+        e->u.ref.class_index = (uint16_t)first;
+        e->u.ref.name_and_type_index = (uint16_t)second;
+    }
+    else
+    {
+        e->u.index = (uint16_t)first;
+    }
+    cp_index_link(cp, idx, hash);
     return idx;
 }
 
+int cf_cp_add_class(CF_ConstantPool *cp, const char *name)
+{
+    int name_index = cf_cp_add_utf8(cp, name);
+    return cf_cp_add_pair(cp, CP_TAG_CLASS, name_index, 0);
+}
+
 int cf_cp_add_string(CF_ConstantPool *cp, const char *str)
 {
     int utf8_index = cf_cp_add_utf8(cp, str);
-    int idx = cf_cp_alloc(cp, 1);
-    CF_ConstantEntry *e = &cp->entries[idx];
-    e->tag = CP_TAG_STRING;
-    e->u.index = (uint16_t)utf8_index;
-    return idx;
+    return cf_cp_add_pair(cp, CP_TAG_STRING, utf8_index, 0);
 }
 
 int cf_cp_add_string_len(CF_ConstantPool *cp, const uint8_t *data, int len)
 {
     int utf8_index = cf_cp_add_utf8_len(cp, data, len);
-    int idx = cf_cp_alloc(cp, 1);
-    CF_ConstantEntry *e = &cp->entries[idx];
-    e->tag = CP_TAG_STRING;
-    e->u.index = (uint16_t)utf8_index;
-    return idx;
+    return cf_cp_add_pair(cp, CP_TAG_STRING, utf8_index, 0);
 }
 
 int cf_cp_add_name_and_type(CF_ConstantPool *cp,
@@ -374,24 +530,7 @@ int cf_cp_add_name_and_type(CF_ConstantPool *cp,
 {
     int name_idx = cf_cp_add_utf8(cp, name);
     int desc_idx = cf_cp_add_utf8(cp, descriptor);
-
-    /* Check for existing */
-    for (int i = 1; i < cp->count; ++i)
-    {
-        if (cp->entries[i].tag == CP_TAG_NAME_AND_TYPE &&
-            cp->entries[i].u.name_and_type.name_index == name_idx &&
-            cp->entries[i].u.name_and_type.descriptor_index == desc_idx)
-        {
-            return i;
-        }
-    }
-
-    int idx = cf_cp_alloc(cp, 1);
-    CF_ConstantEntry *e = &cp->entries[idx];
-    e->tag = CP_TAG_NAME_AND_TYPE;
-    e->u.name_and_type.name_index = (uint16_t)name_idx;
-    e->u.name_and_type.descriptor_index = (uint16_t)desc_idx;
-    return idx;
+    return cf_cp_add_pair(cp, CP_TAG_NAME_AND_TYPE, name_idx, desc_idx);
 }
 
 int cf_cp_add_fieldref(CF_ConstantPool *cp,
@@ -401,13 +540,7 @@ int cf_cp_add_fieldref(CF_ConstantPool *cp,
 {
     int class_idx = cf_cp_add_class(cp, class_name);
     int nat_idx = cf_cp_add_name_and_type(cp, field_name, descriptor);
-
-    int idx = cf_cp_alloc(cp, 1);
-    CF_ConstantEntry *e = &cp->entries[idx];
-    e->tag = CP_TAG_FIELDREF;
-    e->u.ref.class_index = (uint16_t)class_idx;
-    e->u.ref.name_and_type_index = (uint16_t)nat_idx;
-    return idx;
+    return cf_cp_add_pair(cp, CP_TAG_FIELDREF, class_idx, nat_idx);
 }
 
 int cf_cp_add_methodref(CF_ConstantPool *cp,
@@ -417,13 +550,7 @@ int cf_cp_add_methodref(CF_ConstantPool *cp,
 {
     int class_idx = cf_cp_add_class(cp, class_name);
     int nat_idx = cf_cp_add_name_and_type(cp, method_name, descriptor);
-
-    int idx = cf_cp_alloc(cp, 1);
-    CF_ConstantEntry *e = &cp->entries[idx];
-    e->tag = CP_TAG_METHODREF;
-    e->u.ref.class_index = (uint16_t)class_idx;
-    e->u.ref.name_and_type_index = (uint16_t)nat_idx;
-    return idx;
+    return cf_cp_add_pair(cp, CP_TAG_METHODREF, class_idx, nat_idx);
 }
 
 /* ============================================================
@@ -1208,11 +1335,25 @@ int cf_write_to_buffer(CF_ClassFile *cf, uint8_t **buffer)
     return w.size;
 }
 
+/* Set before code generation starts, so workers only read it */
+static JarWriter *output_jar = NULL;
+
+void cf_set_output_jar(JarWriter *jar)
+{
+    output_jar = jar;
+}
+
 bool cf_write_to_file(CF_ClassFile *cf, const char *filename)
 {
     uint8_t *buffer = NULL;
     int size = cf_write_to_buffer(cf, &buffer);
 
+    if (output_jar)
+    {
+        jar_writer_add(output_jar, filename, buffer, size);
+        return true;
+    }
+
     FILE *fp = fopen(filename, "wb");
     if (fp == NULL)
     {
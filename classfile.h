@@ -10,6 +10,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "jar_writer.h"
+
 /*
  * Constant Pool Tags (JVM Spec §4.4)
  */
@@ -118,12 +120,21 @@ typedef struct CF_ConstantEntry_tag
 
 /*
  * Constant Pool Builder
+ *
+ * Deduplicated entries (Utf8, Class, String, NameAndType, Fieldref,
+ * Methodref) are also kept in a chained hash index so lookups do not
+ * scan the pool. Chains are threaded through index_next, which is
+ * parallel to entries; index 0 terminates a chain.
  */
 typedef struct CF_ConstantPool_tag
 {
     CF_ConstantEntry *entries;
     uint16_t count;
     uint16_t capacity;
+
+    int *index_heads; /* Bucket heads (index_mask + 1 buckets) */
+    int *index_next;  /* Next entry in the same bucket (capacity slots) */
+    int index_mask;
 } CF_ConstantPool;
 
 /*
@@ -410,9 +421,12 @@ void cf_builder_set_source_file(CF_Builder *builder, const char *source_file);
 /* Write class file to buffer, returns total size */
 int cf_write_to_buffer(CF_ClassFile *cf, uint8_t **buffer);
 
-/* Write class file to file */
+/* Write class file to file, or add it to the output jar under that name */
 bool cf_write_to_file(CF_ClassFile *cf, const char *filename);
 
+/* -o: send the class files of cf_write_to_file to jar (NULL: to files) */
+void cf_set_output_jar(JarWriter *jar);
+
 /* ============================================================
  * Descriptor Utilities
  * ============================================================ */
@@ -6,6 +6,7 @@
  */
 
 #include "cminor_type.h"
+#include "arena.h"
 #include "create.h"
 #include "parsed_type.h"
 #include "header_store.h"
@@ -943,7 +944,7 @@ void cs_type_to_string(TypeSpecifier *type, char *buffer, int buffer_size)
 
 static TypeSpecifier *cs_allocate_type_specifier()
 {
-    TypeSpecifier *ts = (TypeSpecifier *)calloc(1, sizeof(TypeSpecifier));
+    TypeSpecifier *ts = arena_new_type_specifier();
     ts->kind = CS_TYPE_BASIC;
     ts->child = NULL;
     ts->is_typedef = false;
@@ -61,6 +61,8 @@ CodeBuilder *codebuilder_create(ConstantPoolBuilder *cp, MethodCode *method,
     if (!is_static && class_name)
     {
         CB_VerificationType this_type = cb_type_object(class_name);
+        cb_frame_reserve_locals(builder->frame, local_index + 1);
+        cb_frame_reserve_locals(builder->initial_frame, local_index + 1);
         builder->frame->locals[local_index] = this_type;
         builder->initial_frame->locals[local_index] = this_type;
         ++local_index;
@@ -70,12 +72,15 @@ CodeBuilder *codebuilder_create(ConstantPoolBuilder *cp, MethodCode *method,
     for (ParameterList *p = params; p && !p->is_ellipsis; p = p->next)
     {
         CB_VerificationType param_type = cb_type_from_c_type(p->type);
+        int param_slots = cb_type_slots(&param_type);
+        cb_frame_reserve_locals(builder->frame, local_index + param_slots);
+        cb_frame_reserve_locals(builder->initial_frame, local_index + param_slots);
         builder->frame->locals[local_index] = param_type;
         builder->initial_frame->locals[local_index] = param_type;
         ++local_index;
 
         /* Long and double take two slots */
-        if (cb_type_slots(&param_type) == 2)
+        if (param_slots == 2)
         {
             builder->frame->locals[local_index] = cb_type_top();
             builder->initial_frame->locals[local_index] = cb_type_top();
@@ -98,14 +103,8 @@ void codebuilder_destroy(CodeBuilder *builder)
     }
 
     /* Free owned frames */
-    if (builder->frame)
-    {
-        free(builder->frame);
-    }
-    if (builder->initial_frame)
-    {
-        free(builder->initial_frame);
-    }
+    cb_free_frame(builder->frame);
+    cb_free_frame(builder->initial_frame);
 
     if (builder->branch_targets)
     {
@@ -126,7 +125,7 @@ void codebuilder_destroy(CodeBuilder *builder)
                 }
                 if (!already_freed)
                 {
-                    free(builder->branch_targets[i].frame);
+                    cb_free_frame(builder->branch_targets[i].frame);
                 }
             }
         }
@@ -140,9 +139,14 @@ void codebuilder_destroy(CodeBuilder *builder)
         {
             if (builder->labels[i])
             {
-                if (builder->labels[i]->frame)
+                cb_free_frame(builder->labels[i]->frame);
+                for (int j = 0; j < builder->labels[i]->jump_source_count; ++j)
+                {
+                    cb_free_frame(builder->labels[i]->jump_sources[j].frame);
+                }
+                if (builder->labels[i]->jump_sources)
                 {
-                    free(builder->labels[i]->frame);
+                    free(builder->labels[i]->jump_sources);
                 }
                 free(builder->labels[i]);
             }
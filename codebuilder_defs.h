@@ -35,16 +35,24 @@ typedef struct CB_VerificationType_tag
 /*
  * Frame State - complete type state at a bytecode offset
  * Tracks all locals and stack types at a specific program point
+ *
+ * Slot arrays grow on demand. *_used is the high-water mark of slots that
+ * may hold a non-TOP type; every slot at or above it reads as TOP, so
+ * copies only need to cover [0, *_used).
  */
 typedef struct CB_Frame_tag
 {
-    /* Local variable types (dynamically allocated) */
+    /* Local variable types (grown by cb_frame_reserve_locals) */
     CB_VerificationType *locals;
     int locals_count;
+    int locals_used;
+    int locals_capacity;
 
-    /* Operand stack types (dynamically allocated) */
+    /* Operand stack types (grown by cb_frame_reserve_stack) */
     CB_VerificationType *stack;
     int stack_count;
+    int stack_used;
+    int stack_capacity;
 } CB_Frame;
 
 /*
@@ -30,23 +30,96 @@ CB_Frame *cb_create_frame()
         exit(1);
     }
 
-    /* Allocate locals and stack arrays */
-    frame->locals = (CB_VerificationType *)calloc(CB_MAX_LOCALS, sizeof(CB_VerificationType));
-    frame->stack = (CB_VerificationType *)calloc(CB_MAX_STACK, sizeof(CB_VerificationType));
-
+    /* Slot arrays are allocated lazily by cb_frame_reserve_* */
+    frame->locals = NULL;
     frame->locals_count = 0;
+    frame->locals_used = 0;
+    frame->locals_capacity = 0;
+
+    frame->stack = NULL;
     frame->stack_count = 0;
+    frame->stack_used = 0;
+    frame->stack_capacity = 0;
+    return frame;
+}
 
-    /* Initialize all slots to TOP (calloc already sets to 0 = CF_VERIFICATION_TOP) */
-    for (int i = 0; i < CB_MAX_LOCALS; ++i)
+void cb_free_frame(CB_Frame *frame)
+{
+    if (!frame)
+    {
+        return;
+    }
+    if (frame->locals)
     {
-        frame->locals[i].tag = CF_VERIFICATION_TOP;
+        free(frame->locals);
     }
-    for (int i = 0; i < CB_MAX_STACK; ++i)
+    if (frame->stack)
     {
-        frame->stack[i].tag = CF_VERIFICATION_TOP;
+        free(frame->stack);
+    }
+    free(frame);
+}
+
+/* Reallocate a slot array, keeping [0, used) and setting the rest to TOP */
+static CB_VerificationType *cb_grow_slots(CB_VerificationType *slots, int used, int new_capacity)
+{
+    /* Manual reallocation (realloc not supported in Cminor) */
+    CB_VerificationType *grown = (CB_VerificationType *)calloc(new_capacity, sizeof(CB_VerificationType));
+    if (!grown)
+    {
+        fprintf(stderr, "cb_grow_slots: calloc failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < used; ++i)
+    {
+        grown[i] = slots[i];
+    }
+    for (int i = used; i < new_capacity; ++i)
+    {
+        grown[i].tag = CF_VERIFICATION_TOP;
+    }
+    if (slots)
+    {
+        free(slots);
+    }
+    return grown;
+}
+
+/* Make slots [0, count) addressable and include them in the high-water mark */
+void cb_frame_reserve_locals(CB_Frame *frame, int count)
+{
+    if (count > frame->locals_capacity)
+    {
+        int new_capacity = frame->locals_capacity * 2;
+        if (new_capacity < count)
+        {
+            new_capacity = count;
+        }
+        frame->locals = cb_grow_slots(frame->locals, frame->locals_used, new_capacity);
+        frame->locals_capacity = new_capacity;
+    }
+    if (count > frame->locals_used)
+    {
+        frame->locals_used = count;
+    }
+}
+
+void cb_frame_reserve_stack(CB_Frame *frame, int count)
+{
+    if (count > frame->stack_capacity)
+    {
+        int new_capacity = frame->stack_capacity * 2;
+        if (new_capacity < count)
+        {
+            new_capacity = count;
+        }
+        frame->stack = cb_grow_slots(frame->stack, frame->stack_used, new_capacity);
+        frame->stack_capacity = new_capacity;
+    }
+    if (count > frame->stack_used)
+    {
+        frame->stack_used = count;
     }
-    return frame;
 }
 
 void cb_copy_frame(CB_Frame *dest, const CB_Frame *src)
@@ -57,19 +130,34 @@ void cb_copy_frame(CB_Frame *dest, const CB_Frame *src)
         exit(1);
     }
 
+    cb_frame_reserve_locals(dest, src->locals_used);
+    cb_frame_reserve_stack(dest, src->stack_used);
+
     /* Deep copy: copy counts */
     dest->locals_count = src->locals_count;
     dest->stack_count = src->stack_count;
 
-    /* Deep copy: copy array contents (not pointers) */
-    for (int i = 0; i < CB_MAX_LOCALS; ++i)
+    /* Deep copy up to the source high-water mark; everything above it is
+     * TOP in src, so dest only needs its own stale slots cleared. */
+    for (int i = 0; i < src->locals_used; ++i)
     {
         dest->locals[i] = src->locals[i];
     }
-    for (int i = 0; i < CB_MAX_STACK; ++i)
+    for (int i = src->locals_used; i < dest->locals_used; ++i)
+    {
+        dest->locals[i] = cb_type_top();
+    }
+    dest->locals_used = src->locals_used;
+
+    for (int i = 0; i < src->stack_used; ++i)
     {
         dest->stack[i] = src->stack[i];
     }
+    for (int i = src->stack_used; i < dest->stack_used; ++i)
+    {
+        dest->stack[i] = cb_type_top();
+    }
+    dest->stack_used = src->stack_used;
 }
 
 static int cb_effective_locals_count(CB_Frame *frame)
@@ -306,7 +394,7 @@ void cb_merge_frame(CB_Frame *dest, const CB_Frame *src)
 #endif
                 dest->locals[i] = cb_type_top();
             }
-            if (i + 1 < CB_MAX_LOCALS)
+            if (i + 1 < dest->locals_used)
             {
                 dest->locals[i + 1] = cb_type_top();
             }
@@ -370,7 +458,7 @@ void cb_merge_frame(CB_Frame *dest, const CB_Frame *src)
             {
                 dest->stack[i] = cb_type_top();
             }
-            if (i + 1 < CB_MAX_STACK)
+            if (i + 1 < dest->stack_used)
             {
                 dest->stack[i + 1] = cb_type_top();
             }
@@ -452,6 +540,7 @@ void cb_push(CodeBuilder *builder, CB_VerificationType type)
         return;
     }
 
+    cb_frame_reserve_stack(builder->frame, builder->frame->stack_count + 1);
     builder->frame->stack[builder->frame->stack_count++] = type;
 
     /* For long/double, push TOP as second slot */
@@ -462,6 +551,7 @@ void cb_push(CodeBuilder *builder, CB_VerificationType type)
             fprintf(stderr, "codebuilder: stack overflow (second slot)\n");
             return;
         }
+        cb_frame_reserve_stack(builder->frame, builder->frame->stack_count + 1);
         builder->frame->stack[builder->frame->stack_count++] = cb_type_top();
     }
 
@@ -524,6 +614,7 @@ void cb_set_stack_depth(CodeBuilder *builder, int depth)
         depth = CB_MAX_STACK;
     }
 
+    cb_frame_reserve_stack(builder->frame, depth);
     builder->frame->stack_count = (uint16_t)depth;
     cb_update_max_stack(builder);
 }
@@ -586,10 +677,7 @@ void codebuilder_restore_stack(CodeBuilder *builder, CodebuilderStackMark mark)
 
     codebuilder_restore_frame_safe(builder, mark.frame);
     /* Free the frame owned by the mark */
-    if (mark.frame)
-    {
-        free(mark.frame);
-    }
+    cb_free_frame(mark.frame);
 }
 
 /* ============================================================
@@ -661,6 +749,7 @@ int codebuilder_allocate_local(CodeBuilder *builder, CB_VerificationType type)
     }
 
     /* Set type at allocated slot */
+    cb_frame_reserve_locals(builder->frame, index + slots);
     builder->frame->locals[index] = type;
     builder->frame->locals_count += slots;
 
@@ -702,10 +791,11 @@ void codebuilder_set_local(CodeBuilder *builder, int index, CB_VerificationType
         return;
     }
 
+    int slots = cb_type_slots(&type);
+    cb_frame_reserve_locals(builder->frame, index + slots);
     builder->frame->locals[index] = type;
 
     /* Update locals_count if needed */
-    int slots = cb_type_slots(&type);
     int end_index = index + slots;
     if (end_index > builder->frame->locals_count)
     {
@@ -734,8 +824,9 @@ void codebuilder_set_param(CodeBuilder *builder, int index, CB_VerificationType
     /* Also update initial_frame for correct StackMapTable generation */
     if (index < CB_MAX_LOCALS)
     {
-        builder->initial_frame->locals[index] = type;
         int slots = cb_type_slots(&type);
+        cb_frame_reserve_locals(builder->initial_frame, index + slots);
+        builder->initial_frame->locals[index] = type;
         int end_index = index + slots;
         if (end_index > builder->initial_frame->locals_count)
         {
@@ -750,7 +841,7 @@ void codebuilder_set_param(CodeBuilder *builder, int index, CB_VerificationType
 
 CB_VerificationType codebuilder_get_local(CodeBuilder *builder, int index)
 {
-    if (!builder || index >= CB_MAX_LOCALS)
+    if (!builder || index >= builder->frame->locals_used)
     {
         return cb_type_top();
     }
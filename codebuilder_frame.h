@@ -16,6 +16,9 @@ void cb_set_stack_depth(CodeBuilder *builder, int depth);
 
 /* Frame operations */
 CB_Frame *cb_create_frame();
+void cb_free_frame(CB_Frame *frame);
+void cb_frame_reserve_locals(CB_Frame *frame, int count);
+void cb_frame_reserve_stack(CB_Frame *frame, int count);
 void cb_copy_frame(CB_Frame *dest, const CB_Frame *src);
 void cb_merge_frame(CB_Frame *dest, const CB_Frame *src);
 
@@ -113,6 +113,7 @@ void codebuilder_record_exception_handler(CodeBuilder *builder, int handler_pc,
 
     /* Exception handlers start with the initial locals and exception on stack */
     cb_copy_frame(target->frame, builder->initial_frame);
+    cb_frame_reserve_stack(target->frame, 1);
     target->frame->stack_count = 1;
     target->frame->stack[0] = cb_type_object(exception_class ? exception_class
                                                              : "Ljava/lang/Throwable;");
@@ -185,6 +185,14 @@ void codebuilder_build_dup_x2(CodeBuilder *builder)
     classfile_opcode_emit_dup_x2(builder->method);
     CB_VerificationType value1 = cb_pop(builder);
     CB_VerificationType value2 = cb_pop(builder);
+    if (cb_type_slots(&value2) == 2)
+    {
+        cb_push(builder, value1);
+        cb_push(builder, value2);
+        cb_push(builder, value1);
+        return;
+    }
+
     CB_VerificationType value3 = cb_pop(builder);
     cb_push(builder, value1);
     cb_push(builder, value3);
@@ -423,6 +423,18 @@ void cg_emit_ptr_store_subscript(CodegenVisitor *cg, TypeSpecifier *ptr_type)
     cg_emit_astore_for_type(cg->builder, type_idx);
 }
 
+void cg_emit_ptr_element_load(CodegenVisitor *cg, TypeSpecifier *ptr_type)
+{
+    /* Stack: [base, index] -> [base[index]] (no wrapper involved) */
+    cg_emit_aload_for_type(cg->builder, cg_ptr_type_index(ptr_type));
+}
+
+void cg_emit_ptr_element_store(CodegenVisitor *cg, TypeSpecifier *ptr_type)
+{
+    /* Stack: [base, index, value] -> [] (no wrapper involved) */
+    cg_emit_astore_for_type(cg->builder, cg_ptr_type_index(ptr_type));
+}
+
 void cg_emit_ptr_get_base(CodegenVisitor *cg, TypeSpecifier *ptr_type)
 {
     PtrTypeIndex type_idx = cg_ptr_type_index(ptr_type);
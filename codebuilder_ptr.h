@@ -42,6 +42,12 @@ void cg_emit_ptr_subscript(CodegenVisitor *cg, TypeSpecifier *ptr_type);
 /* Emit ptr store subscript: (PtrWrapper, int_index, element_value) -> void */
 void cg_emit_ptr_store_subscript(CodegenVisitor *cg, TypeSpecifier *ptr_type);
 
+/* Emit element load from a split pointer: (base_array, index) -> element_value */
+void cg_emit_ptr_element_load(CodegenVisitor *cg, TypeSpecifier *ptr_type);
+
+/* Emit element store to a split pointer: (base_array, index, element_value) -> void */
+void cg_emit_ptr_element_store(CodegenVisitor *cg, TypeSpecifier *ptr_type);
+
 /* Emit getfield for ptr.base: (PtrWrapper) -> base_array */
 void cg_emit_ptr_get_base(CodegenVisitor *cg, TypeSpecifier *ptr_type);
 
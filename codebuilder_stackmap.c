@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "codebuilder_stackmap.h"
+#include "codebuilder_frame.h"
 #include "codebuilder_types.h"
 
 /* ============================================================
@@ -164,12 +165,24 @@ static int count_effective_slots(CB_Frame *frame)
     return count;
 }
 
+/* Slots above a frame's high-water mark are TOP */
+static CB_VerificationType frame_local_at(CB_Frame *frame, int index)
+{
+    if (index >= frame->locals_used)
+    {
+        return cb_type_top();
+    }
+    return frame->locals[index];
+}
+
 /* Check if two frames have the same locals */
 static bool frames_locals_equal(CB_Frame *a, CB_Frame *b, int count)
 {
     for (int i = 0; i < count; ++i)
     {
-        if (!cb_type_equals(&a->locals[i], &b->locals[i]))
+        CB_VerificationType a_slot = frame_local_at(a, i);
+        CB_VerificationType b_slot = frame_local_at(b, i);
+        if (!cb_type_equals(&a_slot, &b_slot))
         {
             return false;
         }
@@ -389,7 +402,7 @@ CF_StackMapFrame *codebuilder_generate_stackmap(CodeBuilder *builder,
             /* Free skipped entry's frame to prevent leak */
             if (target->frame)
             {
-                free(target->frame);
+                cb_free_frame(target->frame);
                 target->frame = NULL;
             }
             continue;
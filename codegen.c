@@ -4,7 +4,9 @@
 
 #include "classfile.h"
 #include "constant_pool.h"
+#include "arena.h"
 #include "ast.h"
+#include "build_manifest.h"
 #include "compiler.h"
 #include "scanner.h" /* For Scanner struct definition (Cminor requires visible struct) */
 #include "executable.h"
@@ -19,7 +21,9 @@
 #include "codebuilder_ptr.h"
 #include "codegenvisitor.h"
 #include "cminor_type.h"
+#include "header_cache.h"
 #include "header_store.h"
+#include "intern.h"
 #include "stackmap.h"
 #include "method_code.h"
 #include "classfile_opcode.h"
@@ -27,9 +31,15 @@
 #include "codegen_constants.h"
 #include "codegen_jvm_types.h"
 #include "codegen_symbols.h"
+#include "codegen_outline.h"
 #include "codegenvisitor_util.h"
+#include "peephole.h"
 #include "util.h"
 
+#ifdef __GNUC__
+#include <pthread.h>
+#endif
+
 enum
 {
     OUTPUT_PATH_MAX = 4096
@@ -102,12 +112,11 @@ static CS_Function *find_function_entry(CodegenVisitor *cgen,
         return NULL;
     }
 
-    for (int i = 0; i < cgen->function_count; ++i)
+    /* function_entry was recorded when the class's methods were registered */
+    int entry = func->function_entry;
+    if (entry < cgen->function_count && cgen->functions[entry].constant_pool_index == func->index)
     {
-        if (cgen->functions[i].constant_pool_index == func->index)
-        {
-            return &cgen->functions[i];
-        }
+        return &cgen->functions[entry];
     }
 
     return NULL;
@@ -169,6 +178,68 @@ static void finalize_function(CodegenVisitor *cgen, CS_Function *info)
     }
 }
 
+enum
+{
+    OUTLINE_MAX_ATTEMPTS = 8 /* Generations of one method while outlining it */
+};
+
+/* Generate a C function (region_id 0) or the helper of an outlined region.
+ * While the code is over the method size limit, regions of it are outlined
+ * and it is generated again. */
+static void generate_method(CodegenVisitor *cgen, FunctionDeclaration *func, int region_id)
+{
+    /* Heap-lifted parameters are moved to new slots by each generation */
+    int param_count = 0;
+    for (ParameterList *p = func->param; p; p = p->next)
+    {
+        param_count++;
+    }
+    int *param_index = (int *)calloc(param_count + 1, sizeof(int));
+    int k = 0;
+    for (ParameterList *p = func->param; p; p = p->next, k++)
+    {
+        param_index[k] = p->decl ? p->decl->index : -1;
+    }
+
+    for (int attempt = 1;; attempt++)
+    {
+        k = 0;
+        for (ParameterList *p = func->param; p; p = p->next, k++)
+        {
+            if (p->decl)
+            {
+                p->decl->index = param_index[k];
+            }
+        }
+
+        code_output_reset_method(cgen->output);
+        codegen_outline_begin_method(cgen, func, region_id);
+        codegen_traverse_stmt(func->body, cgen);
+
+        int size = method_code_size(code_output_method(cgen->output));
+        if (attempt == OUTLINE_MAX_ATTEMPTS || !codegen_outline_plan(cgen, size))
+        {
+            break;
+        }
+    }
+    free(param_index);
+
+    codegen_finish_function(cgen);
+    cgen->outline_current = 0;
+
+    int code_size = method_code_size(code_output_method(cgen->output));
+    if (code_size > CG_OUTLINE_MAX_METHOD_LIMIT)
+    {
+        fprintf(stderr, "codegen: method %s is %d bytes, over the class file limit of %d\n",
+                func->name, code_size, CG_OUTLINE_MAX_METHOD_LIMIT);
+        exit(1);
+    }
+
+    CS_Function *info = region_id == 0 ? find_function_entry(cgen, func)
+                                       : codegen_outline_add_function(cgen, region_id);
+    finalize_function(cgen, info);
+}
+
 /* Threshold for splitting <clinit> method (60KB, leaving margin for JVM 64KB limit) */
 enum
 {
@@ -176,6 +247,17 @@ enum
     CLINIT_PART_NAME_MAX = 64
 };
 
+/* <clinit> parts are also kept under the method size limit */
+static int clinit_size_threshold(CodegenVisitor *cgen)
+{
+    int threshold = cgen->method_limit - cgen->method_limit / 16;
+    if (threshold > CLINIT_SIZE_THRESHOLD)
+    {
+        threshold = CLINIT_SIZE_THRESHOLD;
+    }
+    return threshold;
+}
+
 /* Forward declarations for split support */
 static void save_clinit_part(CodegenVisitor *cgen, CS_Executable *exec);
 static int generate_array_init_with_split(CodegenVisitor *cgen, Declaration *decl,
@@ -288,10 +370,21 @@ static char *make_clinit_part_name(int part_index)
     return name;
 }
 
+/* <clinit> code has no branches, so the peephole pass can rewrite it
+ * without the jump resolution and frames a function goes through */
+static void optimize_clinit_code(CodegenVisitor *cgen)
+{
+    if (cgen->peephole_enabled)
+    {
+        cgen->peephole_bytes_removed += peephole_optimize(cgen);
+    }
+}
+
 /* Save current clinit code as a helper part and reset for next part */
 static void save_clinit_part(CodegenVisitor *cgen, CS_Executable *exec)
 {
     codebuilder_build_return(cgen->builder);
+    optimize_clinit_code(cgen);
     MethodCode *mc = code_output_method(cgen->output);
     int code_size = method_code_size(mc);
 
@@ -379,12 +472,12 @@ static int generate_array_init_with_split(CodegenVisitor *cgen, Declaration *dec
     int idx = start_idx;
     for (; p; p = p->next, idx++)
     {
-        /* Check if we need to split (every 100 elements to avoid too frequent checks) */
-        if (idx > start_idx && (idx - start_idx) % 100 == 0)
+        /* Check if we need to split (each element, parts stay under the method limit) */
+        if (idx > start_idx)
         {
             MethodCode *mc_check = code_output_method(cgen->output);
             int current_size = method_code_size(mc_check);
-            if (current_size > CLINIT_SIZE_THRESHOLD)
+            if (current_size > clinit_size_threshold(cgen))
             {
                 /* Need to split - save current part and return continuation index */
                 save_clinit_part(cgen, exec);
@@ -436,6 +529,349 @@ static int generate_array_init_with_split(CodegenVisitor *cgen, Declaration *dec
     return -1;
 }
 
+/* Constant integer arrays are packed into CONSTANT_String data (one
+ * ISO-8859-1 char per byte, big-endian elements) and decoded in <clinit>
+ * with String.getBytes and a ByteBuffer view, instead of a getstatic/index/
+ * value/store sequence per element. Smaller arrays keep the per-element
+ * path, which is shorter for them. */
+enum
+{
+    PACKED_ARRAY_MIN_ELEMENTS = 16,
+    PACKED_CHUNK_MAX_UTF8 = 65000 /* A CONSTANT_Utf8 holds at most 65535 bytes */
+};
+
+typedef struct PackedValue_tag
+{
+    bool ok;
+    long value;
+} PackedValue;
+
+/* Truncate value to a signed integer of the given width */
+static long packed_wrap(long value, int bits)
+{
+    long range = 1L << bits;
+    value = value & (range - 1);
+    if (value >= range / 2)
+    {
+        value -= range;
+    }
+    return value;
+}
+
+/* Value of a constant integer initializer element, as the JVM computes it */
+static PackedValue packed_constant(Expression *expr)
+{
+    PackedValue result;
+    result.ok = false;
+    result.value = 0;
+    if (!expr)
+    {
+        return result;
+    }
+
+    switch (expr->kind)
+    {
+    case INT_EXPRESSION:
+    case UINT_EXPRESSION:
+        result.ok = true;
+        result.value = expr->u.int_value;
+        return result;
+    case LONG_EXPRESSION:
+    case ULONG_EXPRESSION:
+        result.ok = true;
+        result.value = expr->u.long_value;
+        return result;
+    case BOOL_EXPRESSION:
+        result.ok = true;
+        result.value = expr->u.bool_value ? 1 : 0;
+        return result;
+    case IDENTIFIER_EXPRESSION:
+        if (expr->u.identifier.is_enum_member && expr->u.identifier.u.enum_member)
+        {
+            result.ok = true;
+            result.value = expr->u.identifier.u.enum_member->value;
+        }
+        return result;
+    case PLUS_EXPRESSION:
+        return packed_constant(expr->u.plus_expression);
+    case MINUS_EXPRESSION:
+    case BIT_NOT_EXPRESSION:
+        if (expr->kind == MINUS_EXPRESSION)
+        {
+            result = packed_constant(expr->u.minus_expression);
+            result.value = -result.value;
+        }
+        else
+        {
+            result = packed_constant(expr->u.bit_not_expression);
+            result.value = ~result.value;
+        }
+        if (!expr->type || !cs_type_is_long_exact(expr->type))
+        {
+            result.value = packed_wrap(result.value, 32);
+        }
+        return result;
+    case CAST_EXPRESSION:
+        result = packed_constant(expr->u.cast_expression.expr);
+        switch (expr->u.cast_expression.ctype)
+        {
+        case CS_CHAR_TO_INT:
+        case CS_SHORT_TO_INT:
+        case CS_INT_TO_LONG:
+            break;
+        case CS_UCHAR_TO_INT:
+            result.value = result.value & 0xFF;
+            break;
+        case CS_USHORT_TO_INT:
+            result.value = result.value & 0xFFFF;
+            break;
+        case CS_UINT_TO_ULONG:
+            result.value = result.value & 0xFFFFFFFFL;
+            break;
+        case CS_INT_TO_CHAR:
+            result.value = packed_wrap(result.value, 8);
+            break;
+        case CS_INT_TO_SHORT:
+            result.value = packed_wrap(result.value, 16);
+            break;
+        case CS_LONG_TO_INT:
+            result.value = packed_wrap(result.value, 32);
+            break;
+        default:
+            /* Floating-point conversions */
+            result.ok = false;
+            break;
+        }
+        return result;
+    case TYPE_CAST_EXPRESSION:
+    {
+        TypeSpecifier *type = expr->u.type_cast_expression.type;
+        result = packed_constant(expr->u.type_cast_expression.expr);
+        if (!type)
+        {
+            result.ok = false;
+        }
+        else if (cs_type_is_char_exact(type))
+        {
+            result.value = cs_type_is_unsigned(type) ? (result.value & 0xFF)
+                                                     : packed_wrap(result.value, 8);
+        }
+        else if (cs_type_is_short_exact(type))
+        {
+            result.value = cs_type_is_unsigned(type) ? (result.value & 0xFFFF)
+                                                     : packed_wrap(result.value, 16);
+        }
+        else if (cs_type_is_int_exact(type) || cs_type_is_enum(type))
+        {
+            result.value = packed_wrap(result.value, 32);
+        }
+        else if (!cs_type_is_long_exact(type))
+        {
+            result.ok = false;
+        }
+        return result;
+    }
+    default:
+        return result;
+    }
+}
+
+/* Bytes per element of an array that can be packed, or 0 */
+static int packed_element_size(TypeSpecifier *elem_type)
+{
+    if (cs_type_is_char_exact(elem_type))
+    {
+        return 1;
+    }
+    if (cs_type_is_short_exact(elem_type))
+    {
+        return 2;
+    }
+    if (cs_type_is_int_exact(elem_type) || cs_type_is_enum(elem_type))
+    {
+        return 4;
+    }
+    if (cs_type_is_long_exact(elem_type))
+    {
+        return 8;
+    }
+    return 0;
+}
+
+/* Bytes of the CONSTANT_Utf8 encoding of an ISO-8859-1 char */
+static int packed_utf8_length(int byte)
+{
+    return (byte == 0 || byte >= 0x80) ? 2 : 1;
+}
+
+/* Push the bytes [begin, end) of data as a byte[] */
+static void emit_packed_bytes(CodegenVisitor *cgen, const uint8_t *data, int begin, int end)
+{
+    ConstantPoolBuilder *cp = code_output_cp(cgen->output);
+
+    /* UTF-8 of the ISO-8859-1 chars; the constant pool stores NUL as C0 80 */
+    char *utf8 = (char *)calloc((end - begin) * 2 + 1, sizeof(char));
+    int len = 0;
+    for (int i = begin; i < end; i++)
+    {
+        int byte = data[i];
+        if (byte < 0x80)
+        {
+            utf8[len++] = (char)byte;
+        }
+        else
+        {
+            utf8[len++] = (char)(0xC0 | (byte >> 6));
+            utf8[len++] = (char)(0x80 | (byte & 0x3F));
+        }
+    }
+    int string_idx = cp_builder_add_string_len(cp, utf8, len);
+    free(utf8);
+
+    int charset_idx = cp_builder_add_fieldref(cp, "java/nio/charset/StandardCharsets", "ISO_8859_1",
+                                              "Ljava/nio/charset/Charset;");
+    int getbytes_idx = cp_builder_add_methodref(cp, "java/lang/String", "getBytes",
+                                                "(Ljava/nio/charset/Charset;)[B");
+    codebuilder_build_ldc(cgen->builder, string_idx, CF_VAL_OBJECT);
+    codebuilder_build_getstatic(cgen->builder, charset_idx);
+    codebuilder_build_invokevirtual(cgen->builder, getbytes_idx);
+}
+
+/* Copy the elements [first, first + count) of the decoded chunk on the stack
+ * into the array field */
+static void emit_packed_copy(CodegenVisitor *cgen, int field_idx, int elem_size, int first, int count)
+{
+    ConstantPoolBuilder *cp = code_output_cp(cgen->output);
+    if (elem_size == 1)
+    {
+        /* System.arraycopy(bytes, 0, field, first, count) */
+        int arraycopy_idx = cp_builder_add_methodref(cp, "java/lang/System", "arraycopy",
+                                                     "(Ljava/lang/Object;ILjava/lang/Object;II)V");
+        codebuilder_build_iconst(cgen->builder, 0);
+        codebuilder_build_getstatic(cgen->builder, field_idx);
+        codebuilder_build_iconst(cgen->builder, first);
+        codebuilder_build_iconst(cgen->builder, count);
+        codebuilder_build_invokestatic(cgen->builder, arraycopy_idx);
+        return;
+    }
+
+    /* ByteBuffer.wrap(bytes).asIntBuffer().get(field, first, count) */
+    const char *view = elem_size == 2   ? "asShortBuffer"
+                       : elem_size == 4 ? "asIntBuffer"
+                                        : "asLongBuffer";
+    const char *view_desc = elem_size == 2   ? "()Ljava/nio/ShortBuffer;"
+                            : elem_size == 4 ? "()Ljava/nio/IntBuffer;"
+                                             : "()Ljava/nio/LongBuffer;";
+    const char *buffer_class = elem_size == 2   ? "java/nio/ShortBuffer"
+                               : elem_size == 4 ? "java/nio/IntBuffer"
+                                                : "java/nio/LongBuffer";
+    const char *get_desc = elem_size == 2   ? "([SII)Ljava/nio/ShortBuffer;"
+                           : elem_size == 4 ? "([III)Ljava/nio/IntBuffer;"
+                                            : "([JII)Ljava/nio/LongBuffer;";
+    int wrap_idx = cp_builder_add_methodref(cp, "java/nio/ByteBuffer", "wrap",
+                                            "([B)Ljava/nio/ByteBuffer;");
+    int view_idx = cp_builder_add_methodref(cp, "java/nio/ByteBuffer", view, view_desc);
+    int get_idx = cp_builder_add_methodref(cp, buffer_class, "get", get_desc);
+    codebuilder_build_invokestatic(cgen->builder, wrap_idx);
+    codebuilder_build_invokevirtual(cgen->builder, view_idx);
+    codebuilder_build_getstatic(cgen->builder, field_idx);
+    codebuilder_build_iconst(cgen->builder, first);
+    codebuilder_build_iconst(cgen->builder, count);
+    codebuilder_build_invokevirtual(cgen->builder, get_idx);
+    codebuilder_build_pop(cgen->builder);
+}
+
+/* Initialize a constant integer array from packed string data.
+ * Returns false (emitting nothing) when the initializer does not qualify. */
+static bool generate_packed_array_init(CodegenVisitor *cgen, Declaration *decl, CS_Executable *exec)
+{
+    Expression *init = decl->initializer;
+    TypeSpecifier *elem_type = cs_type_child(decl->type);
+    int elem_size = packed_element_size(elem_type);
+    if (elem_size == 0)
+    {
+        return false;
+    }
+
+    int elem_count = 0;
+    for (ExpressionList *p = init->u.initializer_list; p; p = p->next)
+    {
+        elem_count++;
+    }
+    if (elem_count < PACKED_ARRAY_MIN_ELEMENTS)
+    {
+        return false;
+    }
+
+    /* Big-endian element bytes, as ByteBuffer reads them */
+    uint8_t *data = (uint8_t *)calloc(elem_count * elem_size, sizeof(uint8_t));
+    int pos = 0;
+    for (ExpressionList *p = init->u.initializer_list; p; p = p->next)
+    {
+        PackedValue v = packed_constant(p->expression);
+        if (!v.ok)
+        {
+            free(data);
+            return false;
+        }
+        for (int shift = (elem_size - 1) * 8; shift >= 0; shift -= 8)
+        {
+            data[pos++] = (uint8_t)((v.value >> shift) & 0xFF);
+        }
+    }
+
+    int declared_len = array_length_from_type(decl->type);
+    int array_len = declared_len > 0 ? declared_len : elem_count;
+    int field_idx = cg_find_or_add_field(cgen, decl);
+
+    /* Chunks of whole elements whose string fits a CONSTANT_Utf8 */
+    int first = 0;
+    while (first < elem_count)
+    {
+        int last = first;
+        int utf8_len = 0;
+        while (last < elem_count)
+        {
+            int elem_len = 0;
+            for (int b = 0; b < elem_size; b++)
+            {
+                elem_len += packed_utf8_length(data[last * elem_size + b]);
+            }
+            if (utf8_len + elem_len > PACKED_CHUNK_MAX_UTF8)
+            {
+                break;
+            }
+            utf8_len += elem_len;
+            last++;
+        }
+
+        if (method_code_size(code_output_method(cgen->output)) > clinit_size_threshold(cgen))
+        {
+            save_clinit_part(cgen, exec);
+        }
+
+        if (first == 0 && last == elem_count && elem_size == 1 && array_len == elem_count)
+        {
+            /* The decoded bytes are the array itself */
+            emit_packed_bytes(cgen, data, 0, elem_count);
+            codebuilder_build_putstatic(cgen->builder, field_idx);
+            break;
+        }
+        if (first == 0)
+        {
+            codebuilder_build_iconst(cgen->builder, array_len);
+            codebuilder_build_newarray(cgen->builder, newarray_type_code(elem_type));
+            codebuilder_build_putstatic(cgen->builder, field_idx);
+        }
+        emit_packed_bytes(cgen, data, first * elem_size, last * elem_size);
+        emit_packed_copy(cgen, field_idx, elem_size, first, last - first);
+        first = last;
+    }
+
+    free(data);
+    return true;
+}
+
 static void generate_clinit_code(CodegenVisitor *cgen, CS_Executable *exec)
 {
     /* Initialize parts */
@@ -460,6 +896,12 @@ static void generate_clinit_code(CodegenVisitor *cgen, CS_Executable *exec)
         }
     }
 
+    /* Pooled string literals are filled in <clinit> */
+    if (exec->string_literal_count > 0)
+    {
+        needs_clinit = true;
+    }
+
     /* Check if any function has cminor::clinit attribute */
     FileDecl *file_decl = cgen->compiler->current_file_decl;
     if (file_decl)
@@ -486,6 +928,36 @@ static void generate_clinit_code(CodegenVisitor *cgen, CS_Executable *exec)
     code_output_reset_method(cgen->output);
     codegen_begin_function(cgen, NULL);
 
+    /* Fill the string literal pool first so every function, including the
+     * cminor::clinit ones called below, sees initialized literals */
+    if (exec->string_literal_count > 0)
+    {
+        ConstantPoolBuilder *cp = code_output_cp(cgen->output);
+        int utf8_field_idx = cp_builder_add_fieldref(
+            cp, "java/nio/charset/StandardCharsets", "UTF_8",
+            "Ljava/nio/charset/Charset;");
+        int getbytes_idx = cp_builder_add_methodref(
+            cp, "java/lang/String", "getBytes",
+            "(Ljava/nio/charset/Charset;)[B");
+
+        for (int i = 0; i < exec->string_literal_count; i++)
+        {
+            MethodCode *mc_check = code_output_method(cgen->output);
+            if (method_code_size(mc_check) > clinit_size_threshold(cgen))
+            {
+                save_clinit_part(cgen, exec);
+            }
+
+            CG_StringLiteral *lit = &exec->string_literals[i];
+            int field_idx = cp_builder_add_fieldref(cp, cgen->current_class_name,
+                                                    lit->field_name, "[B");
+            codebuilder_build_ldc(cgen->builder, lit->string_index, CF_VAL_OBJECT);
+            codebuilder_build_getstatic(cgen->builder, utf8_field_idx);
+            codebuilder_build_invokevirtual(cgen->builder, getbytes_idx);
+            codebuilder_build_putstatic(cgen->builder, field_idx);
+        }
+    }
+
     /* Generate initialization code for each static field */
     for (int i = 0; i < cgen->static_field_count; i++)
     {
@@ -510,12 +982,17 @@ static void generate_clinit_code(CodegenVisitor *cgen, CS_Executable *exec)
             /* Check if we need to split before this field (code size approaching limit) */
             MethodCode *mc_check = code_output_method(cgen->output);
             int current_size = method_code_size(mc_check);
-            if (current_size > CLINIT_SIZE_THRESHOLD)
+            if (current_size > clinit_size_threshold(cgen))
             {
                 /* Save current code as a part and start a new one */
                 save_clinit_part(cgen, exec);
             }
 
+            if (generate_packed_array_init(cgen, decl, exec))
+            {
+                continue;
+            }
+
             /* Array initializer list: use streaming with split support.
              * This evaluates and stores each element immediately, and splits
              * if code size exceeds threshold. No block scope needed since
@@ -534,7 +1011,7 @@ static void generate_clinit_code(CodegenVisitor *cgen, CS_Executable *exec)
         /* Check if we need to split before this field (code size approaching limit) */
         MethodCode *mc_check = code_output_method(cgen->output);
         int current_size = method_code_size(mc_check);
-        if (current_size > CLINIT_SIZE_THRESHOLD)
+        if (current_size > clinit_size_threshold(cgen))
         {
             /* Save current code as a part and start a new one */
             save_clinit_part(cgen, exec);
@@ -664,6 +1141,7 @@ static void generate_clinit_code(CodegenVisitor *cgen, CS_Executable *exec)
     {
         /* No split needed, just add return and copy */
         codebuilder_build_return(cgen->builder);
+        optimize_clinit_code(cgen);
 
         MethodCode *mc = code_output_method(cgen->output);
         exec->clinit_code_size = method_code_size(mc);
@@ -699,6 +1177,7 @@ static CS_Executable *code_generate(CS_Compiler *compiler, const char *class_nam
     CodegenVisitor *cgen = create_codegen_visitor(compiler, exec, class_name);
 
     /* Generate code from FileDecl->functions (authoritative source) */
+    int region_cursor = 0;
     if (file_decl)
     {
         for (FunctionDeclarationList *fl = file_decl->functions; fl; fl = fl->next)
@@ -709,16 +1188,23 @@ static CS_Executable *code_generate(CS_Compiler *compiler, const char *class_nam
                 continue;
             }
 
-            code_output_reset_method(cgen->output);
-            codegen_begin_function(cgen, f);
-            codegen_traverse_stmt(f->body, cgen);
-            codegen_finish_function(cgen);
+            generate_method(cgen, f, 0);
 
-            CS_Function *info = find_function_entry(cgen, f);
-            finalize_function(cgen, info);
+            /* Helpers outlined from f, and from those helpers in turn */
+            while (region_cursor < cgen->outline_region_count)
+            {
+                region_cursor++;
+                CG_OutlineRegion *r = &cgen->outline_regions[region_cursor - 1];
+                if (r->called)
+                {
+                    generate_method(cgen, r->helper, region_cursor);
+                }
+            }
         }
     }
 
+    exec->peephole_bytes_removed = cgen->peephole_bytes_removed;
+
     /* Transfer constant pool ownership to exec */
     exec->cp = code_output_take_cp(cgen->output);
 
@@ -731,6 +1217,12 @@ static CS_Executable *code_generate(CS_Compiler *compiler, const char *class_nam
             exec->jvm_static_fields[i] = cgen->static_fields[i];
     }
 
+    /* Transfer the string literal pool (field names are owned by exec) */
+    exec->string_literals = cgen->string_literals;
+    exec->string_literal_count = cgen->string_literal_count;
+    cgen->string_literals = NULL;
+    cgen->string_literal_count = 0;
+
     exec->jvm_class_def_count = cgen->class_def_count;
     if (cgen->class_def_count)
     {
@@ -1001,6 +1493,14 @@ static void free_executable(CS_Executable *exec)
     {
         free(exec->jvm_static_fields);
     }
+    if (exec->string_literals)
+    {
+        for (int i = 0; i < exec->string_literal_count; ++i)
+        {
+            free(exec->string_literals[i].field_name);
+        }
+        free(exec->string_literals);
+    }
     if (exec->jvm_class_defs)
     {
         for (int i = 0; i < exec->jvm_class_def_count; ++i)
@@ -1207,6 +1707,11 @@ static char *build_function_descriptor(CS_Function *fn, CS_Executable *exec)
         return strdup("()I");
     }
 
+    if (fn->signature_kind == CS_FUNC_SIG_OUTLINED)
+    {
+        return strdup(fn->descriptor);
+    }
+
     if (fn->signature_kind == CS_FUNC_SIG_FROM_DECL && fn->decl)
     {
         return (char *)cg_jvm_method_descriptor(fn->decl);
@@ -1255,6 +1760,13 @@ static void serialize_classfile(CS_Executable *exec, const char *class_name)
         cf_builder_add_field(builder, access, field_name, desc);
     }
 
+    /* Add pooled string literal fields */
+    for (int i = 0; i < exec->string_literal_count; ++i)
+    {
+        cf_builder_add_field(builder, ACC_PRIVATE | ACC_STATIC | ACC_SYNTHETIC,
+                             exec->string_literals[i].field_name, "[B");
+    }
+
     /* Add methods */
     for (int i = 0; i < exec->function_count; ++i)
     {
@@ -1346,44 +1858,29 @@ static void serialize_classfile(CS_Executable *exec, const char *class_name)
     cf_builder_destroy(builder);
 }
 
-/* Track generated struct class files to avoid duplicates */
-typedef struct GeneratedClass_tag
-{
-    char *name;
-    struct GeneratedClass_tag *next;
-} GeneratedClass;
-
-static GeneratedClass *generated_classes = NULL;
+/* Track generated struct class files to avoid duplicates (interned name -> name) */
+static NameMap *generated_classes = NULL;
 
 static bool is_class_generated(const char *name)
 {
-    for (GeneratedClass *gc = generated_classes; gc; gc = gc->next)
-    {
-        if (strcmp(gc->name, name) == 0)
-            return true;
-    }
-    return false;
+    if (!generated_classes)
+        return false;
+    return name_map_rank(generated_classes, name) >= 0;
 }
 
 static void mark_class_generated(const char *name)
 {
-    if (is_class_generated(name))
-        return;
-    GeneratedClass *gc = (GeneratedClass *)calloc(1, sizeof(GeneratedClass));
-    gc->name = strdup(name);
-    gc->next = generated_classes;
-    generated_classes = gc;
+    if (!generated_classes)
+        generated_classes = name_map_create();
+    const char *key = cs_intern(name);
+    name_map_offer(generated_classes, key, (char *)key, 0, false);
 }
 
 static void free_generated_classes()
 {
-    while (generated_classes)
-    {
-        GeneratedClass *next = generated_classes->next;
-        free(generated_classes->name);
-        free(generated_classes);
-        generated_classes = next;
-    }
+    if (generated_classes)
+        name_map_destroy(generated_classes);
+    generated_classes = NULL;
 }
 
 /* Generate a class file for a synthetic struct definition */
@@ -1581,6 +2078,213 @@ static void serialize_struct_classfiles(CS_Executable *exec)
     }
 }
 
+/* --incremental: note the struct classes serialize_struct_classfiles() is
+ * about to write for the entry's TU (those no earlier class wrote) */
+static void record_struct_classes(ManifestEntry *entry, CS_Executable *exec)
+{
+    for (int i = 0; i < exec->jvm_class_def_count; ++i)
+    {
+        const char *name = exec->jvm_class_defs[i].name;
+        if (!is_class_generated(name))
+        {
+            manifest_entry_add_class(entry, name);
+        }
+    }
+}
+
+/* --incremental: note the class and pointer classes the entry's TU produced */
+static void record_class_outputs(ManifestEntry *entry, const char *class_name, PtrUsage *usage)
+{
+    manifest_entry_add_class(entry, class_name);
+    entry->ptr_used = usage->used;
+}
+
+static void report_peephole_stats(TranslationUnit *compiler, CS_Executable *exec,
+                                  const char *class_name)
+{
+    if (compiler->ctx && compiler->ctx->peephole_stats)
+    {
+        fprintf(stderr, "peephole: %s: %d bytes removed\n", class_name,
+                exec->peephole_bytes_removed);
+    }
+}
+
+#ifdef __GNUC__
+/* Classes shared out among the workers of generate_classes_parallel() */
+typedef struct ClassBatch_tag
+{
+    TranslationUnit *compiler;
+    const char **names;
+    CS_Executable **execs;
+    PtrUsage **usages; /* Pointer usage of each class */
+    int count;
+    int next; /* Next class to hand out */
+} ClassBatch;
+
+/* Generate and write classes until the batch runs out */
+static void *class_worker(void *arg)
+{
+    ClassBatch *batch = (ClassBatch *)arg;
+
+    /* code_generate() sets current_file_decl, so each worker has its own TU */
+    TranslationUnit *compiler = (TranslationUnit *)calloc(1, sizeof(TranslationUnit));
+    *compiler = *batch->compiler;
+    compiler->decl_map = NULL;
+
+    int i;
+    while ((i = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED)) < batch->count)
+    {
+        PtrUsage *usage = (PtrUsage *)calloc(1, sizeof(PtrUsage));
+        ptr_usage_init(usage);
+        g_ptr_usage = usage;
+        CS_Executable *exec = code_generate(compiler, batch->names[i]);
+        serialize_classfile(exec, batch->names[i]);
+        batch->execs[i] = exec;
+        batch->usages[i] = usage;
+    }
+    g_ptr_usage = NULL;
+    free(compiler);
+    return NULL;
+}
+
+/* -j N: generate and write the classes on N threads.  Struct classes, the
+ * peephole report and freeing follow on this thread in the serial order, so
+ * the first class to use a struct still writes its class file. */
+static void generate_classes_parallel(int jobs, TranslationUnit *compiler,
+                                      const char **names, ManifestEntry **entries, int count)
+{
+    ClassBatch batch;
+    batch.compiler = compiler;
+    batch.names = names;
+    batch.execs = (CS_Executable **)calloc(count, sizeof(CS_Executable *));
+    batch.usages = (PtrUsage **)calloc(count, sizeof(PtrUsage *));
+    batch.count = count;
+    batch.next = 0;
+
+    /* Workers only read the shared index */
+    header_index_sync(compiler->header_index);
+
+    int thread_count = jobs < count ? jobs - 1 : count - 1;
+    pthread_t *threads = (pthread_t *)calloc(thread_count, sizeof(pthread_t));
+    int started = 0;
+    while (started < thread_count &&
+           pthread_create(&threads[started], NULL, class_worker, &batch) == 0)
+    {
+        started++;
+    }
+
+    PtrUsage *own_usage = g_ptr_usage;
+    class_worker(&batch);
+    g_ptr_usage = own_usage;
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    for (int i = 0; i < count; i++)
+    {
+        ptr_usage_merge(g_ptr_usage, batch.usages[i]);
+        report_peephole_stats(compiler, batch.execs[i], names[i]);
+        if (entries[i])
+        {
+            record_struct_classes(entries[i], batch.execs[i]);
+            record_class_outputs(entries[i], names[i], batch.usages[i]);
+        }
+        serialize_struct_classfiles(batch.execs[i]);
+        free_executable(batch.execs[i]);
+        free(batch.usages[i]);
+    }
+    free(batch.execs);
+    free(batch.usages);
+}
+#endif
+
+/* Generate the classes of compiled sources that have none yet, in compile
+ * order.  Returns false when there was nothing left to generate.
+ * TUs reused by --incremental keep their class files; only the pointer
+ * classes they use are carried over. */
+static bool generate_pending_classes(CompilerContext *ctx, TranslationUnit *compiler)
+{
+    int capacity = 0;
+    for (CS_PendingDependency *dep = ctx->compiled_deps; dep; dep = dep->next)
+    {
+        capacity++;
+    }
+    const char **names = (const char **)calloc(capacity + 1, sizeof(char *));
+    ManifestEntry **entries = (ManifestEntry **)calloc(capacity + 1, sizeof(ManifestEntry *));
+    int count = 0;
+    for (CS_PendingDependency *dep = ctx->compiled_deps; dep; dep = dep->next)
+    {
+        /* Only generate code for .c files, not headers */
+        int len = strlen(dep->path);
+        if (len < 2 || strcmp(dep->path + len - 2, ".c") != 0)
+            continue;
+
+        /* Get class_name from FileDecl (already converted from path) */
+        FileDecl *fd = header_store_find(ctx->header_store, dep->path);
+        if (!fd || !fd->class_name)
+            continue;
+        const char *class_name = fd->class_name;
+
+        /* Skip if class already generated */
+        if (is_class_generated(class_name))
+            continue;
+        mark_class_generated(class_name);
+
+        ManifestEntry *entry = build_manifest_find(ctx->build, dep->path, dep->is_embedded);
+        if (entry && entry->reused)
+        {
+            if (entry->ptr_used)
+            {
+                PtrUsage reused_usage;
+                reused_usage.used = entry->ptr_used;
+                ptr_usage_merge(g_ptr_usage, &reused_usage);
+            }
+            continue;
+        }
+        names[count] = class_name;
+        entries[count] = entry;
+        count++;
+    }
+
+#ifdef __GNUC__
+    if (ctx->jobs > 1 && count > 1)
+    {
+        generate_classes_parallel(ctx->jobs, compiler, names, entries, count);
+        free(names);
+        free(entries);
+        return true;
+    }
+#endif
+    PtrUsage *own_usage = g_ptr_usage;
+    for (int i = 0; i < count; i++)
+    {
+        PtrUsage *usage = (PtrUsage *)calloc(1, sizeof(PtrUsage));
+        ptr_usage_init(usage);
+        g_ptr_usage = usage;
+
+        CS_Executable *exec = code_generate(compiler, names[i]);
+        report_peephole_stats(compiler, exec, names[i]);
+
+        serialize_classfile(exec, names[i]);
+        if (entries[i])
+        {
+            record_struct_classes(entries[i], exec);
+            record_class_outputs(entries[i], names[i], usage);
+        }
+        serialize_struct_classfiles(exec);
+
+        g_ptr_usage = own_usage;
+        ptr_usage_merge(g_ptr_usage, usage);
+        free(usage);
+        free_executable(exec);
+    }
+    free(names);
+    free(entries);
+    return count > 0;
+}
+
 /*
  * Dependency resolution is now handled automatically by the preprocessor.
  * When a .h file is included, the preprocessor adds the corresponding .c
@@ -1592,23 +2296,149 @@ int main(int argc, char *argv[])
 {
     if (argc <= 1)
     {
-        printf("Usage: ./codegen <source> [source2 ...]\n");
+        printf("Usage: ./codegen [--no-peephole] [--peephole-stats] [--method-limit=N] [--arena-stats] [--header-cache[=DIR]] [--cache-stats] [--incremental] [-j N] [-o FILE.jar] <source> [source2 ...]\n");
         return 1;
     }
 
     CompilerContext *ctx = compiler_context_create();
+    const char *jar_path = NULL;
+    const char **sources = (const char **)calloc(argc, sizeof(char *));
+    int source_count = 0;
 
-    /* Compile all source files independently */
+    /* Options first, so that bad combinations fail before any compiling */
     for (int i = 1; i < argc; i++)
     {
-        if (!CS_compile(ctx, argv[i], false))
+        if (strcmp(argv[i], "--no-peephole") == 0)
+        {
+            ctx->no_peephole = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--peephole-stats") == 0)
+        {
+            ctx->peephole_stats = true;
+            continue;
+        }
+        if (strncmp(argv[i], "--method-limit=", 15) == 0)
+        {
+            ctx->method_limit = (int)strtol(argv[i] + 15, NULL, 10);
+            if (ctx->method_limit < CG_OUTLINE_MIN_METHOD_LIMIT ||
+                ctx->method_limit > CG_OUTLINE_MAX_METHOD_LIMIT)
+            {
+                fprintf(stderr, "--method-limit must be between %d and %d bytes\n",
+                        CG_OUTLINE_MIN_METHOD_LIMIT, CG_OUTLINE_MAX_METHOD_LIMIT);
+                free(sources);
+                compiler_context_destroy(ctx);
+                return 1;
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "--arena-stats") == 0)
+        {
+            ctx->arena_stats = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--header-cache") == 0)
+        {
+            ctx->header_cache_dir = ".csua-cache";
+            continue;
+        }
+        if (strncmp(argv[i], "--header-cache=", 15) == 0)
+        {
+            ctx->header_cache_dir = argv[i] + 15;
+            continue;
+        }
+        if (strcmp(argv[i], "--cache-stats") == 0)
+        {
+            ctx->cache_stats = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--incremental") == 0)
+        {
+            ctx->incremental = true;
+            continue;
+        }
+        if (strncmp(argv[i], "-j", 2) == 0)
+        {
+            const char *count = argv[i] + 2;
+            if (count[0] == '\0' && i + 1 < argc)
+            {
+                i = i + 1;
+                count = argv[i];
+            }
+            ctx->jobs = (int)strtol(count, NULL, 10);
+            if (ctx->jobs < 1)
+            {
+                fprintf(stderr, "-j needs a thread count of at least 1\n");
+                free(sources);
+                compiler_context_destroy(ctx);
+                return 1;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "-o", 2) == 0)
+        {
+            jar_path = argv[i] + 2;
+            if (jar_path[0] == '\0' && i + 1 < argc)
+            {
+                i = i + 1;
+                jar_path = argv[i];
+            }
+            if (jar_path[0] == '\0')
+            {
+                fprintf(stderr, "-o needs a .jar file name\n");
+                free(sources);
+                compiler_context_destroy(ctx);
+                return 1;
+            }
+            continue;
+        }
+        sources[source_count] = argv[i];
+        source_count++;
+    }
+
+    /* -o: the classes go into one runnable jar whose Main-Class is the
+     * first source's.  --incremental needs the class files of earlier
+     * builds on disk, so the two do not mix. */
+    JarWriter *jar = NULL;
+    if (jar_path)
+    {
+        if (ctx->incremental)
+        {
+            fprintf(stderr, "--incremental cannot be combined with -o\n");
+            free(sources);
+            compiler_context_destroy(ctx);
+            return 1;
+        }
+        if (source_count == 0)
         {
-            fprintf(stderr, "compile failed: %s\n", argv[i]);
+            fprintf(stderr, "-o needs a source to take the Main-Class from\n");
+            free(sources);
             compiler_context_destroy(ctx);
             return 1;
         }
     }
 
+    /* Compile all source files independently */
+    for (int i = 0; i < source_count; i++)
+    {
+        if (!CS_compile(ctx, sources[i], false))
+        {
+            fprintf(stderr, "compile failed: %s\n", sources[i]);
+            free(sources);
+            compiler_context_destroy(ctx);
+            return 1;
+        }
+    }
+
+    if (jar_path)
+    {
+        char *main_class = cs_class_name_from_path(sources[0]);
+        jar = jar_writer_create(jar_path, main_class);
+        free(main_class);
+        cf_set_output_jar(jar);
+    }
+    free(sources);
+
     /* Create TU for codegen (functions are in FileDecl->functions) */
     TranslationUnit *compiler = tu_create(ctx, NULL);
     compiler->stmt_list = ctx->all_statements;
@@ -1632,11 +2462,9 @@ int main(int argc, char *argv[])
         made_progress = false;
 
         /* Compile any pending sources (added by lazy-loaded helpers) */
-        while (ctx->pending_sources)
+        CS_PendingDependency *dep;
+        while ((dep = cs_pop_pending_source(ctx)) != NULL)
         {
-            CS_PendingDependency *dep = ctx->pending_sources;
-            ctx->pending_sources = dep->next;
-            dep->next = NULL;
 
             /* Use internal compile - includes per-TU mean_check */
             if (!compile_source_for_codegen(ctx, dep->path, dep->is_embedded))
@@ -1662,36 +2490,54 @@ int main(int argc, char *argv[])
         }
 
         /* Generate code for all compiled sources */
-        for (CS_PendingDependency *dep = ctx->compiled_deps; dep; dep = dep->next)
+        if (generate_pending_classes(ctx, compiler))
         {
-            /* Only generate code for .c files, not headers */
-            int len = strlen(dep->path);
-            if (len < 2 || strcmp(dep->path + len - 2, ".c") != 0)
-                continue;
-
-            /* Get class_name from FileDecl (already converted from path) */
-            FileDecl *fd = header_store_find(ctx->header_store, dep->path);
-            if (!fd || !fd->class_name)
-                continue;
-            const char *class_name = fd->class_name;
-
-            /* Skip if class already generated */
-            if (is_class_generated(class_name))
-                continue;
-            mark_class_generated(class_name);
             made_progress = true;
+        }
+    }
 
-            CS_Executable *exec = code_generate(compiler, class_name);
+    /* Generate synthetic pointer struct classes */
+    generate_ptr_struct_classes_selective(g_ptr_usage);
 
-            serialize_classfile(exec, class_name);
-            serialize_struct_classfiles(exec);
+    if (jar)
+    {
+        cf_set_output_jar(NULL);
+        bool written = jar_writer_write(jar);
+        if (!written)
+        {
+            fprintf(stderr, "cannot write %s\n", jar_path);
+        }
+        jar_writer_destroy(jar);
+        if (!written)
+        {
+            free_generated_classes();
+            compiler_context_destroy(ctx);
+            return 1;
+        }
+    }
 
-            free_executable(exec);
+    if (ctx->build)
+    {
+        fprintf(stderr, "incremental: %d reused, %d rebuilt\n",
+                ctx->build->reused_count, ctx->build->rebuilt_count);
+        if (!build_manifest_write(ctx->build))
+        {
+            fprintf(stderr, "warning: cannot write the build manifest\n");
         }
     }
 
-    /* Generate synthetic pointer struct classes */
-    generate_ptr_struct_classes_selective(g_ptr_usage);
+    if (ctx->arena_stats)
+    {
+        arena_print_stats();
+        cs_intern_print_stats();
+    }
+
+    if (ctx->cache_stats)
+    {
+        header_cache_print_stats();
+        file_decl_print_resolve_stats();
+        cs_print_closure_stats();
+    }
 
     free_generated_classes();
     compiler_context_destroy(ctx);
@@ -68,21 +68,14 @@ int cg_find_or_add_struct_field(CodegenVisitor *v, const char *class_name,
     else
     {
         /* Look up class definition and get field descriptor from there */
-        for (int i = 0; i < v->class_def_count; ++i)
+        int i = find_class_index(v, class_name);
+        if (i >= 0 && field_index < v->class_defs[i].field_count)
         {
-            if (v->class_defs[i].name && class_name &&
-                strcmp(v->class_defs[i].name, class_name) == 0)
+            CG_ClassField *field = &v->class_defs[i].fields[field_index];
+            if (field->type_spec)
             {
-                if (field_index < v->class_defs[i].field_count)
-                {
-                    CG_ClassField *field = &v->class_defs[i].fields[field_index];
-                    if (field->type_spec)
-                    {
-                        field_type = field->type_spec;
-                        desc = cg_jvm_descriptor(field->type_spec);
-                    }
-                }
-                break;
+                field_type = field->type_spec;
+                desc = cg_jvm_descriptor(field->type_spec);
             }
         }
     }
@@ -95,6 +88,64 @@ int cg_find_or_add_struct_field(CodegenVisitor *v, const char *class_name,
     return cp_builder_add_fieldref(get_cp(v), class_name, field_name, desc);
 }
 
+enum
+{
+    STRING_LITERAL_NAME_MAX = 32
+};
+
+static void ensure_string_literal_slots(CodegenVisitor *v, int string_index)
+{
+    if (string_index < v->string_literal_slot_capacity)
+    {
+        return;
+    }
+    int new_cap = v->string_literal_slot_capacity ? v->string_literal_slot_capacity * 2 : 64;
+    while (new_cap <= string_index)
+    {
+        new_cap *= 2;
+    }
+    int *new_slots = (int *)calloc(new_cap, sizeof(int));
+    for (int i = 0; i < v->string_literal_slot_capacity; i++)
+    {
+        new_slots[i] = v->string_literal_slots[i];
+    }
+    free(v->string_literal_slots);
+    v->string_literal_slots = new_slots;
+    v->string_literal_slot_capacity = new_cap;
+}
+
+int cg_find_or_add_string_literal(CodegenVisitor *v, int string_index)
+{
+    ensure_string_literal_slots(v, string_index);
+    int slot = v->string_literal_slots[string_index];
+    if (slot == 0)
+    {
+        if (v->string_literal_count == v->string_literal_capacity)
+        {
+            int new_cap = v->string_literal_capacity ? v->string_literal_capacity * 2 : 16;
+            CG_StringLiteral *new_literals =
+                (CG_StringLiteral *)calloc(new_cap, sizeof(CG_StringLiteral));
+            for (int i = 0; i < v->string_literal_count; i++)
+            {
+                new_literals[i] = v->string_literals[i];
+            }
+            free(v->string_literals);
+            v->string_literals = new_literals;
+            v->string_literal_capacity = new_cap;
+        }
+
+        CG_StringLiteral *lit = &v->string_literals[v->string_literal_count++];
+        lit->string_index = string_index;
+        lit->field_name = (char *)calloc(STRING_LITERAL_NAME_MAX, sizeof(char));
+        snprintf(lit->field_name, STRING_LITERAL_NAME_MAX, "str$%d", v->string_literal_count - 1);
+        slot = v->string_literal_count;
+        v->string_literal_slots[string_index] = slot;
+    }
+
+    return cp_builder_add_fieldref(get_cp(v), v->current_class_name,
+                                   v->string_literals[slot - 1].field_name, "[B");
+}
+
 int cg_find_or_add_class(CodegenVisitor *v, const char *class_name,
                          int class_index)
 {
@@ -9,6 +9,13 @@ int cg_find_or_add_field(CodegenVisitor *v, Declaration *decl);
 int cg_find_or_add_struct_field(CodegenVisitor *v, const char *class_name,
                                 const char *field_name, int field_index,
                                 TypeSpecifier *field_type);
+/**
+ * Pool a string literal as a private static byte[] field of the current class.
+ * string_index is the CONSTANT_String index of the null-terminated literal.
+ * Returns the constant pool index of the Fieldref; the field is filled in
+ * <clinit>, so each evaluation of the literal is a single getstatic.
+ */
+int cg_find_or_add_string_literal(CodegenVisitor *v, int string_index);
 int cg_find_or_add_class(CodegenVisitor *v, const char *class_name, int class_index);
 int cg_find_or_add_object_class(CodegenVisitor *v);
 
@@ -508,9 +508,16 @@ typedef struct
     char *descriptor;
 } CG_MethodDescriptorEntry;
 
+/* Per thread in the native build, where classes may be generated in parallel */
+#ifdef __GNUC__
+static __thread CG_MethodDescriptorEntry *method_descriptor_cache = NULL;
+static __thread int method_descriptor_cache_count = 0;
+static __thread int method_descriptor_cache_capacity = 0;
+#else
 static CG_MethodDescriptorEntry *method_descriptor_cache = NULL;
 static int method_descriptor_cache_count = 0;
 static int method_descriptor_cache_capacity = 0;
+#endif
 
 static const char *cg_cached_method_descriptor(FunctionDeclaration *func)
 {
@@ -0,0 +1,1256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "cminor_type.h"
+#include "code_output.h"
+#include "codebuilder_frame.h"
+#include "codebuilder_part1.h"
+#include "codebuilder_part3.h"
+#include "codebuilder_types.h"
+#include "codegen_jvm_types.h"
+#include "codegen_outline.h"
+#include "codegen_symbols.h"
+#include "codegenvisitor.h"
+#include "constant_pool.h"
+#include "create.h"
+#include "synthetic_codegen.h"
+
+enum
+{
+    OUTLINE_EPILOGUE_RESERVE = 16, /* Implicit return added after traversal */
+    OUTLINE_MIN_REGION_SIZE = 48,  /* Smaller regions do not pay for the call */
+    OUTLINE_CALL_COST = 3,         /* invokestatic */
+    OUTLINE_MIN_SAVING = 24,       /* Bytes a region must save in the outer method */
+    OUTLINE_CAPTURE_COST = 2,      /* Load of one argument */
+    OUTLINE_PAIR_COST = 4,         /* Loads of a (base, offset) pair */
+    OUTLINE_LIFT_COST = 12,        /* Creating the box of a newly lifted local */
+    OUTLINE_MAX_PARAM_SLOTS = 200  /* JVM limit is 255 */
+};
+
+/* Statement of a block, with its preorder interval for overlap checks */
+typedef struct OutlineElement_tag
+{
+    StatementList *node;
+    int begin;
+    int end;
+    bool run_ok; /* May be part of a run of statements */
+    bool arm_ok; /* May be part of a run of switch arms */
+} OutlineElement;
+
+/* Region that may be outlined: `length` statements from `first`, or the
+ * single statement `single` */
+typedef struct OutlineCandidate_tag
+{
+    StatementList *first;
+    int length;
+    Statement *single;
+    Statement *dispatch; /* Switch of a run of arms */
+    int size;
+    int begin;
+    int end;
+} OutlineCandidate;
+
+typedef struct OutlinePlan_tag
+{
+    CodegenVisitor *v;
+    Statement *body;          /* Body of the method being split */
+    Statement *dispatch_self; /* Its switch, when it is a helper of switch arms */
+    int chunk_limit;          /* Preferred largest region */
+    int preorder;
+
+    OutlineCandidate *candidates;
+    int candidate_count;
+    int candidate_capacity;
+
+    /* Locals of the method; the first incoming_count are the parameters
+     * of the helper being split */
+    Declaration **locals;
+    int local_count;
+    int local_capacity;
+    int incoming_count;
+} OutlinePlan;
+
+/* Locals a region uses and declares */
+typedef struct OutlineScan_tag
+{
+    OutlinePlan *plan;
+    Declaration **declared;
+    int declared_count;
+    int declared_capacity;
+    CG_OutlineCapture *captures;
+    int capture_count;
+    int capture_capacity;
+} OutlineScan;
+
+static CG_OutlineRegion *outline_region(CodegenVisitor *v, int id)
+{
+    return &v->outline_regions[id - 1];
+}
+
+int codegen_outline_method_limit(CompilerContext *ctx)
+{
+    if (!ctx || ctx->method_limit <= 0)
+    {
+        return CG_OUTLINE_DEFAULT_METHOD_LIMIT;
+    }
+    return ctx->method_limit;
+}
+
+/* ============================================================
+ * Region analysis
+ * ============================================================ */
+
+static bool is_foreign(CodegenVisitor *v, Statement *stmt)
+{
+    return stmt->outline_id != 0 && stmt->outline_id != v->outline_current;
+}
+
+/* Control leaves stmt only by completing it; break, continue and case are
+ * fine for the given number of enclosing loops and switches */
+static bool is_self_contained(CodegenVisitor *v, Statement *stmt, int loops, int switches)
+{
+    if (!stmt)
+    {
+        return true;
+    }
+    if (is_foreign(v, stmt))
+    {
+        return false;
+    }
+
+    switch (stmt->type)
+    {
+    case EXPRESSION_STATEMENT:
+    case DECLARATION_STATEMENT:
+        return true;
+    case COMPOUND_STATEMENT:
+        for (StatementList *p = stmt->u.compound_s.list; p; p = p->next)
+        {
+            if (!is_self_contained(v, p->stmt, loops, switches))
+            {
+                return false;
+            }
+        }
+        return true;
+    case IF_STATEMENT:
+        return is_self_contained(v, stmt->u.if_s.then_statement, loops, switches) &&
+               is_self_contained(v, stmt->u.if_s.else_statement, loops, switches);
+    case WHILE_STATEMENT:
+        return is_self_contained(v, stmt->u.while_s.body, loops + 1, switches);
+    case DO_WHILE_STATEMENT:
+        return is_self_contained(v, stmt->u.do_s.body, loops + 1, switches);
+    case FOR_STATEMENT:
+        return is_self_contained(v, stmt->u.for_s.init, loops, switches) &&
+               is_self_contained(v, stmt->u.for_s.body, loops + 1, switches);
+    case SWITCH_STATEMENT:
+        return is_self_contained(v, stmt->u.switch_s.body, loops, switches + 1);
+    case CASE_STATEMENT:
+        return switches > 0 && is_self_contained(v, stmt->u.case_s.statement, loops, switches);
+    case DEFAULT_STATEMENT:
+        return switches > 0 && is_self_contained(v, stmt->u.default_s.statement, loops, switches);
+    case BREAK_STATEMENT:
+        return loops > 0 || switches > 0;
+    case CONTINUE_STATEMENT:
+        return loops > 0;
+    default:
+        /* return, goto, labels */
+        return false;
+    }
+}
+
+/* Does control never fall through the end of stmt into the next one */
+static bool ends_in_jump(Statement *stmt)
+{
+    while (stmt)
+    {
+        switch (stmt->type)
+        {
+        case BREAK_STATEMENT:
+        case CONTINUE_STATEMENT:
+        case RETURN_STATEMENT:
+        case GOTO_STATEMENT:
+            return true;
+        case CASE_STATEMENT:
+            stmt = stmt->u.case_s.statement;
+            break;
+        case DEFAULT_STATEMENT:
+            stmt = stmt->u.default_s.statement;
+            break;
+        case LABEL_STATEMENT:
+            stmt = stmt->u.label_s.statement;
+            break;
+        case COMPOUND_STATEMENT:
+        {
+            StatementList *last = stmt->u.compound_s.list;
+            if (!last)
+            {
+                return false;
+            }
+            while (last->next)
+            {
+                last = last->next;
+            }
+            stmt = last->stmt;
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+static bool is_case_label(Statement *stmt)
+{
+    return stmt && (stmt->type == CASE_STATEMENT || stmt->type == DEFAULT_STATEMENT);
+}
+
+/* A helper can only dispatch again on a switch value that is a variable */
+static bool is_redispatchable(Statement *sw)
+{
+    Expression *e = sw->u.switch_s.expression;
+    return e && e->kind == IDENTIFIER_EXPRESSION && !e->u.identifier.is_function &&
+           !e->u.identifier.is_enum_member && e->u.identifier.u.declaration &&
+           sw->u.switch_s.body && sw->u.switch_s.body->type == COMPOUND_STATEMENT;
+}
+
+/* ============================================================
+ * Candidate collection
+ * ============================================================ */
+
+static void add_candidate(OutlinePlan *p, StatementList *first, int length, Statement *single,
+                          Statement *dispatch, int size, int begin, int end)
+{
+    if (size < OUTLINE_MIN_REGION_SIZE)
+    {
+        return;
+    }
+    if (p->candidate_count == p->candidate_capacity)
+    {
+        int new_cap = p->candidate_capacity ? p->candidate_capacity * 2 : 16;
+        OutlineCandidate *new_candidates =
+            (OutlineCandidate *)calloc(new_cap, sizeof(OutlineCandidate));
+        for (int i = 0; i < p->candidate_count; i++)
+        {
+            new_candidates[i] = p->candidates[i];
+        }
+        free(p->candidates);
+        p->candidates = new_candidates;
+        p->candidate_capacity = new_cap;
+    }
+    OutlineCandidate *c = &p->candidates[p->candidate_count++];
+    c->first = first;
+    c->length = length;
+    c->single = single;
+    c->dispatch = dispatch;
+    c->size = size;
+    c->begin = begin;
+    c->end = end;
+}
+
+/* Greedy runs of consecutive statements, each up to chunk_limit bytes
+ * (a single larger statement forms its own run) */
+static void add_statement_runs(OutlinePlan *p, OutlineElement *e, int n, bool whole_ok)
+{
+    int i = 0;
+    while (i < n)
+    {
+        if (!e[i].run_ok)
+        {
+            i++;
+            continue;
+        }
+        int j = i;
+        int size = 0;
+        while (j < n && e[j].run_ok && (j == i || size + e[j].node->stmt->code_size <= p->chunk_limit))
+        {
+            size += e[j].node->stmt->code_size;
+            j++;
+        }
+        if (whole_ok || i > 0 || j < n)
+        {
+            add_candidate(p, e[i].node, j - i, NULL, NULL, size, e[i].begin, e[j - 1].end);
+        }
+        i = j;
+    }
+}
+
+/* Runs of switch arms: entered only through their case labels (the
+ * statement before them never falls through) and ending at a break of
+ * the switch or its end, which stays in the outer method */
+static void add_arm_runs(OutlinePlan *p, OutlineElement *e, int n, Statement *sw, bool whole_ok)
+{
+    int i = 0;
+    while (i < n)
+    {
+        if (!e[i].arm_ok || !is_case_label(e[i].node->stmt) ||
+            (i > 0 && !ends_in_jump(e[i - 1].node->stmt)))
+        {
+            i++;
+            continue;
+        }
+
+        int j = i;
+        int size = 0;
+        int best = -1;
+        int best_size = 0;
+        while (j < n && e[j].arm_ok)
+        {
+            size += e[j].node->stmt->code_size;
+            j++;
+            bool can_end = j == n || e[j].node->stmt->type == BREAK_STATEMENT;
+            if (can_end && (best < 0 || size <= p->chunk_limit))
+            {
+                best = j;
+                best_size = size;
+            }
+            if (size > p->chunk_limit && best >= 0)
+            {
+                break;
+            }
+        }
+        if (best < 0)
+        {
+            i++;
+            continue;
+        }
+        if (whole_ok || i > 0 || best < n)
+        {
+            add_candidate(p, e[i].node, best - i, NULL, sw, best_size, e[i].begin, e[best - 1].end);
+        }
+        i = best;
+    }
+}
+
+static void collect_stmt(OutlinePlan *p, Statement *stmt, Statement *dispatch);
+
+/* Statement in a branch, loop body or case position */
+static void collect_child(OutlinePlan *p, Statement *stmt)
+{
+    if (!stmt)
+    {
+        return;
+    }
+    int begin = p->preorder;
+    collect_stmt(p, stmt, NULL);
+    if (stmt->type != DECLARATION_STATEMENT && is_self_contained(p->v, stmt, 0, 0))
+    {
+        add_candidate(p, NULL, 0, stmt, NULL, stmt->code_size, begin, p->preorder);
+    }
+}
+
+static void collect_list(OutlinePlan *p, Statement *block, Statement *dispatch)
+{
+    int n = 0;
+    for (StatementList *l = block->u.compound_s.list; l; l = l->next)
+    {
+        n++;
+    }
+    if (n == 0)
+    {
+        return;
+    }
+
+    OutlineElement *e = (OutlineElement *)calloc(n, sizeof(OutlineElement));
+    int i = 0;
+    for (StatementList *l = block->u.compound_s.list; l; l = l->next, i++)
+    {
+        Statement *s = l->stmt;
+        e[i].node = l;
+        e[i].begin = p->preorder;
+        collect_stmt(p, s, NULL);
+        e[i].end = p->preorder;
+        bool movable = s && s->type != DECLARATION_STATEMENT;
+        e[i].run_ok = movable && is_self_contained(p->v, s, 0, 0);
+        e[i].arm_ok = movable && dispatch && is_self_contained(p->v, s, 0, 1);
+    }
+
+    /* The whole body of the method would only move it elsewhere */
+    bool whole_ok = block != p->body;
+    add_statement_runs(p, e, n, whole_ok);
+    if (dispatch && is_redispatchable(dispatch))
+    {
+        add_arm_runs(p, e, n, dispatch, dispatch != p->dispatch_self);
+    }
+    free(e);
+}
+
+static void collect_stmt(OutlinePlan *p, Statement *stmt, Statement *dispatch)
+{
+    if (!stmt)
+    {
+        return;
+    }
+    p->preorder++;
+    if (is_foreign(p->v, stmt))
+    {
+        return;
+    }
+
+    switch (stmt->type)
+    {
+    case COMPOUND_STATEMENT:
+        collect_list(p, stmt, dispatch);
+        break;
+    case IF_STATEMENT:
+        collect_child(p, stmt->u.if_s.then_statement);
+        collect_child(p, stmt->u.if_s.else_statement);
+        break;
+    case WHILE_STATEMENT:
+        collect_child(p, stmt->u.while_s.body);
+        break;
+    case DO_WHILE_STATEMENT:
+        collect_child(p, stmt->u.do_s.body);
+        break;
+    case FOR_STATEMENT:
+        collect_stmt(p, stmt->u.for_s.init, NULL);
+        collect_child(p, stmt->u.for_s.body);
+        break;
+    case SWITCH_STATEMENT:
+        collect_stmt(p, stmt->u.switch_s.body, stmt);
+        break;
+    case CASE_STATEMENT:
+        collect_child(p, stmt->u.case_s.statement);
+        break;
+    case DEFAULT_STATEMENT:
+        collect_child(p, stmt->u.default_s.statement);
+        break;
+    case LABEL_STATEMENT:
+        collect_child(p, stmt->u.label_s.statement);
+        break;
+    default:
+        break;
+    }
+}
+
+/* ============================================================
+ * Captured locals
+ * ============================================================ */
+
+static bool contains_decl(Declaration **decls, int count, Declaration *decl)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (decls[i] == decl)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void add_local(OutlinePlan *p, Declaration *decl)
+{
+    if (!decl || decl->is_static || decl->is_extern ||
+        contains_decl(p->locals, p->local_count, decl))
+    {
+        return;
+    }
+    if (p->local_count == p->local_capacity)
+    {
+        int new_cap = p->local_capacity ? p->local_capacity * 2 : 16;
+        Declaration **new_locals = (Declaration **)calloc(new_cap, sizeof(Declaration *));
+        for (int i = 0; i < p->local_count; i++)
+        {
+            new_locals[i] = p->locals[i];
+        }
+        free(p->locals);
+        p->locals = new_locals;
+        p->local_capacity = new_cap;
+    }
+    p->locals[p->local_count++] = decl;
+}
+
+static void collect_locals(OutlinePlan *p, Statement *stmt)
+{
+    if (!stmt)
+    {
+        return;
+    }
+    switch (stmt->type)
+    {
+    case DECLARATION_STATEMENT:
+        add_local(p, stmt->u.declaration_s);
+        break;
+    case COMPOUND_STATEMENT:
+        for (StatementList *l = stmt->u.compound_s.list; l; l = l->next)
+        {
+            collect_locals(p, l->stmt);
+        }
+        break;
+    case IF_STATEMENT:
+        collect_locals(p, stmt->u.if_s.then_statement);
+        collect_locals(p, stmt->u.if_s.else_statement);
+        break;
+    case WHILE_STATEMENT:
+        collect_locals(p, stmt->u.while_s.body);
+        break;
+    case DO_WHILE_STATEMENT:
+        collect_locals(p, stmt->u.do_s.body);
+        break;
+    case FOR_STATEMENT:
+        collect_locals(p, stmt->u.for_s.init);
+        collect_locals(p, stmt->u.for_s.body);
+        break;
+    case SWITCH_STATEMENT:
+        collect_locals(p, stmt->u.switch_s.body);
+        break;
+    case CASE_STATEMENT:
+        collect_locals(p, stmt->u.case_s.statement);
+        break;
+    case DEFAULT_STATEMENT:
+        collect_locals(p, stmt->u.default_s.statement);
+        break;
+    case LABEL_STATEMENT:
+        collect_locals(p, stmt->u.label_s.statement);
+        break;
+    default:
+        break;
+    }
+}
+
+static void note_declared(OutlineScan *s, Declaration *decl)
+{
+    if (!decl)
+    {
+        return;
+    }
+    if (s->declared_count == s->declared_capacity)
+    {
+        int new_cap = s->declared_capacity ? s->declared_capacity * 2 : 16;
+        Declaration **new_declared = (Declaration **)calloc(new_cap, sizeof(Declaration *));
+        for (int i = 0; i < s->declared_count; i++)
+        {
+            new_declared[i] = s->declared[i];
+        }
+        free(s->declared);
+        s->declared = new_declared;
+        s->declared_capacity = new_cap;
+    }
+    s->declared[s->declared_count++] = decl;
+}
+
+static void note_use(OutlineScan *s, Expression *ident, bool written)
+{
+    if (!ident || ident->kind != IDENTIFIER_EXPRESSION || ident->u.identifier.is_function ||
+        ident->u.identifier.is_enum_member)
+    {
+        return;
+    }
+    Declaration *decl = ident->u.identifier.u.declaration;
+    if (!decl || !contains_decl(s->plan->locals, s->plan->local_count, decl) ||
+        contains_decl(s->declared, s->declared_count, decl))
+    {
+        return;
+    }
+
+    for (int i = 0; i < s->capture_count; i++)
+    {
+        if (s->captures[i].decl == decl)
+        {
+            s->captures[i].written = s->captures[i].written || written;
+            return;
+        }
+    }
+    if (s->capture_count == s->capture_capacity)
+    {
+        int new_cap = s->capture_capacity ? s->capture_capacity * 2 : 8;
+        CG_OutlineCapture *new_captures =
+            (CG_OutlineCapture *)calloc(new_cap, sizeof(CG_OutlineCapture));
+        for (int i = 0; i < s->capture_count; i++)
+        {
+            new_captures[i] = s->captures[i];
+        }
+        free(s->captures);
+        s->captures = new_captures;
+        s->capture_capacity = new_cap;
+    }
+    CG_OutlineCapture *c = &s->captures[s->capture_count++];
+    c->decl = decl;
+    c->kind = CG_CAPTURE_VALUE;
+    c->written = written;
+}
+
+static void scan_expr(OutlineScan *s, Expression *e)
+{
+    if (!e)
+    {
+        return;
+    }
+
+    switch (e->kind)
+    {
+    case IDENTIFIER_EXPRESSION:
+        note_use(s, e, false);
+        return;
+    case ASSIGN_EXPRESSION:
+    {
+        Expression *left = e->u.assignment_expression.left;
+        if (left && left->kind == IDENTIFIER_EXPRESSION)
+        {
+            note_use(s, left, true);
+        }
+        else
+        {
+            scan_expr(s, left);
+        }
+        scan_expr(s, e->u.assignment_expression.right);
+        return;
+    }
+    case INCREMENT_EXPRESSION:
+    case DECREMENT_EXPRESSION:
+    {
+        Expression *target = e->u.inc_dec.target;
+        if (target && target->kind == IDENTIFIER_EXPRESSION)
+        {
+            note_use(s, target, true);
+        }
+        else
+        {
+            scan_expr(s, target);
+        }
+        return;
+    }
+    case FUNCTION_CALL_EXPRESSION:
+        for (ArgumentList *arg = e->u.function_call_expression.argument; arg; arg = arg->next)
+        {
+            scan_expr(s, arg->expr);
+        }
+        scan_expr(s, e->u.function_call_expression.function);
+        return;
+    case MINUS_EXPRESSION:
+        scan_expr(s, e->u.minus_expression);
+        return;
+    case PLUS_EXPRESSION:
+        scan_expr(s, e->u.plus_expression);
+        return;
+    case LOGICAL_NOT_EXPRESSION:
+        scan_expr(s, e->u.logical_not_expression);
+        return;
+    case BIT_NOT_EXPRESSION:
+        scan_expr(s, e->u.bit_not_expression);
+        return;
+    case ADDRESS_EXPRESSION:
+        scan_expr(s, e->u.address_expression);
+        return;
+    case DEREFERENCE_EXPRESSION:
+        scan_expr(s, e->u.dereference_expression);
+        return;
+    case MUL_EXPRESSION:
+    case DIV_EXPRESSION:
+    case MOD_EXPRESSION:
+    case ADD_EXPRESSION:
+    case SUB_EXPRESSION:
+    case LSHIFT_EXPRESSION:
+    case RSHIFT_EXPRESSION:
+    case GT_EXPRESSION:
+    case GE_EXPRESSION:
+    case LT_EXPRESSION:
+    case LE_EXPRESSION:
+    case EQ_EXPRESSION:
+    case NE_EXPRESSION:
+    case BIT_AND_EXPRESSION:
+    case BIT_XOR_EXPRESSION:
+    case BIT_OR_EXPRESSION:
+    case LOGICAL_AND_EXPRESSION:
+    case LOGICAL_OR_EXPRESSION:
+        scan_expr(s, e->u.binary_expression.left);
+        scan_expr(s, e->u.binary_expression.right);
+        return;
+    case CAST_EXPRESSION:
+        scan_expr(s, e->u.cast_expression.expr);
+        return;
+    case TYPE_CAST_EXPRESSION:
+        scan_expr(s, e->u.type_cast_expression.expr);
+        return;
+    case ARRAY_EXPRESSION:
+        scan_expr(s, e->u.array_expression.array);
+        scan_expr(s, e->u.array_expression.index);
+        return;
+    case MEMBER_EXPRESSION:
+        scan_expr(s, e->u.member_expression.target);
+        return;
+    case INITIALIZER_LIST_EXPRESSION:
+        for (ExpressionList *l = e->u.initializer_list; l; l = l->next)
+        {
+            scan_expr(s, l->expression);
+        }
+        return;
+    case DESIGNATED_INITIALIZER_EXPRESSION:
+        scan_expr(s, e->u.designated_initializer.value);
+        return;
+    case CONDITIONAL_EXPRESSION:
+        scan_expr(s, e->u.conditional_expression.condition);
+        scan_expr(s, e->u.conditional_expression.true_expr);
+        scan_expr(s, e->u.conditional_expression.false_expr);
+        return;
+    case COMMA_EXPRESSION:
+        scan_expr(s, e->u.comma_expression.left);
+        scan_expr(s, e->u.comma_expression.right);
+        return;
+    case ARRAY_TO_POINTER_EXPRESSION:
+        scan_expr(s, e->u.array_to_pointer);
+        return;
+    default:
+        /* Literals and sizeof (operand is not evaluated) */
+        return;
+    }
+}
+
+static void scan_stmt(OutlineScan *s, Statement *stmt)
+{
+    if (!stmt)
+    {
+        return;
+    }
+
+    switch (stmt->type)
+    {
+    case EXPRESSION_STATEMENT:
+        scan_expr(s, stmt->u.expression_s);
+        break;
+    case DECLARATION_STATEMENT:
+    {
+        Declaration *decl = stmt->u.declaration_s;
+        if (!decl)
+        {
+            break;
+        }
+        note_declared(s, decl);
+        for (TypeSpecifier *t = decl->type; t && cs_type_is_array(t); t = cs_type_child(t))
+        {
+            scan_expr(s, cs_type_array_size(t));
+        }
+        scan_expr(s, decl->initializer);
+        break;
+    }
+    case COMPOUND_STATEMENT:
+        for (StatementList *l = stmt->u.compound_s.list; l; l = l->next)
+        {
+            scan_stmt(s, l->stmt);
+        }
+        break;
+    case IF_STATEMENT:
+        scan_expr(s, stmt->u.if_s.condition);
+        scan_stmt(s, stmt->u.if_s.then_statement);
+        scan_stmt(s, stmt->u.if_s.else_statement);
+        break;
+    case WHILE_STATEMENT:
+        scan_expr(s, stmt->u.while_s.condition);
+        scan_stmt(s, stmt->u.while_s.body);
+        break;
+    case DO_WHILE_STATEMENT:
+        scan_stmt(s, stmt->u.do_s.body);
+        scan_expr(s, stmt->u.do_s.condition);
+        break;
+    case FOR_STATEMENT:
+        scan_stmt(s, stmt->u.for_s.init);
+        scan_expr(s, stmt->u.for_s.condition);
+        scan_stmt(s, stmt->u.for_s.body);
+        scan_expr(s, stmt->u.for_s.post);
+        break;
+    case SWITCH_STATEMENT:
+        scan_expr(s, stmt->u.switch_s.expression);
+        scan_stmt(s, stmt->u.switch_s.body);
+        break;
+    case CASE_STATEMENT:
+        scan_stmt(s, stmt->u.case_s.statement);
+        break;
+    case DEFAULT_STATEMENT:
+        scan_stmt(s, stmt->u.default_s.statement);
+        break;
+    case LABEL_STATEMENT:
+        scan_stmt(s, stmt->u.label_s.statement);
+        break;
+    case RETURN_STATEMENT:
+        scan_expr(s, stmt->u.return_s.expression);
+        break;
+    default:
+        break;
+    }
+}
+
+static void scan_candidate(OutlineScan *s, OutlineCandidate *c)
+{
+    if (c->dispatch)
+    {
+        scan_expr(s, c->dispatch->u.switch_s.expression);
+    }
+    if (c->single)
+    {
+        scan_stmt(s, c->single);
+        return;
+    }
+    StatementList *l = c->first;
+    for (int i = 0; i < c->length; i++, l = l->next)
+    {
+        scan_stmt(s, l->stmt);
+    }
+}
+
+/* Bytes the candidate saves in the outer method, or -1 if its captures
+ * cannot be passed */
+static int candidate_saving(OutlineScan *s, OutlineCandidate *c)
+{
+    int cost = OUTLINE_CALL_COST;
+    int slots = 0;
+    for (int i = 0; i < s->capture_count; i++)
+    {
+        Declaration *decl = s->captures[i].decl;
+        if (s->captures[i].written && !decl->needs_heap_lift)
+        {
+            /* Struct assignment replaces the object, a box cannot hold it */
+            if (cs_type_is_basic_struct_or_union(decl->type))
+            {
+                return -1;
+            }
+            /* Parameters of a helper were passed by value */
+            for (int k = 0; k < s->plan->incoming_count; k++)
+            {
+                if (s->plan->locals[k] == decl)
+                {
+                    return -1;
+                }
+            }
+            cost += OUTLINE_LIFT_COST;
+        }
+        slots += 2;
+        if (decl->is_scalar_ptr)
+        {
+            cost += OUTLINE_PAIR_COST;
+        }
+        else
+        {
+            cost += OUTLINE_CAPTURE_COST;
+        }
+    }
+    if (slots > OUTLINE_MAX_PARAM_SLOTS)
+    {
+        return -1;
+    }
+    return c->size - cost;
+}
+
+/* ============================================================
+ * Regions
+ * ============================================================ */
+
+/* Assign stmt to region id and return it; case labels of a run of arms
+ * stay in the outer switch, only the statements they label move */
+static Statement *mark_region_stmt(Statement *stmt, int id, bool arms)
+{
+    if (arms)
+    {
+        while (is_case_label(stmt))
+        {
+            stmt = stmt->type == CASE_STATEMENT ? stmt->u.case_s.statement
+                                                : stmt->u.default_s.statement;
+        }
+    }
+    if (stmt)
+    {
+        stmt->outline_id = id;
+    }
+    return stmt;
+}
+
+static char *make_helper_name(CodegenVisitor *v, FunctionDeclaration *root)
+{
+    int part = 0;
+    for (int i = 0; i < v->outline_region_count; i++)
+    {
+        if (v->outline_regions[i].root == root)
+        {
+            part++;
+        }
+    }
+    int size = (int)strlen(root->name) + 32;
+    char *name = (char *)calloc(size, sizeof(char));
+    snprintf(name, size, "%s$part%d", root->name, part);
+    return name;
+}
+
+static void create_region(OutlinePlan *p, OutlineCandidate *c, OutlineScan *s)
+{
+    CodegenVisitor *v = p->v;
+    if (v->outline_region_count == v->outline_region_capacity)
+    {
+        int new_cap = v->outline_region_capacity ? v->outline_region_capacity * 2 : 8;
+        CG_OutlineRegion *new_regions =
+            (CG_OutlineRegion *)calloc(new_cap, sizeof(CG_OutlineRegion));
+        for (int i = 0; i < v->outline_region_count; i++)
+        {
+            new_regions[i] = v->outline_regions[i];
+        }
+        free(v->outline_regions);
+        v->outline_regions = new_regions;
+        v->outline_region_capacity = new_cap;
+    }
+
+    FunctionDeclaration *root = v->outline_current == 0
+                                    ? v->current_function
+                                    : outline_region(v, v->outline_current)->root;
+    char *name = make_helper_name(v, root);
+    int owner = v->outline_current;
+    int id = v->outline_region_count + 1;
+
+    /* Helper body: the region statements in a block of their own */
+    StatementList *list = NULL;
+    StatementList *tail = NULL;
+    if (c->single)
+    {
+        list = cs_create_statement_list(c->single);
+    }
+    else
+    {
+        StatementList *l = c->first;
+        for (int i = 0; i < c->length; i++, l = l->next)
+        {
+            StatementList *node = cs_create_statement_list(l->stmt);
+            if (tail)
+            {
+                tail->next = node;
+            }
+            else
+            {
+                list = node;
+            }
+            tail = node;
+        }
+    }
+    int line = list->stmt->line_number;
+    Statement *body = cs_create_compound_statement(NULL, list);
+    Statement *dispatch = NULL;
+    if (c->dispatch)
+    {
+        dispatch = cs_create_switch_statement(NULL, c->dispatch->u.switch_s.expression, body);
+        dispatch->line_number = line;
+        body = cs_create_compound_statement(NULL, cs_create_statement_list(dispatch));
+    }
+    body->line_number = line;
+
+    FunctionDeclaration *helper =
+        cs_create_function_declaration(NULL, NULL, name, NULL, false, true, NULL, body);
+    helper->class_name = root->class_name;
+    helper->source_path = root->source_path;
+
+    /* The call replaces the last statement generated in the outer method,
+     * after every case label of the region */
+    Statement *call_site = NULL;
+    if (c->single)
+    {
+        call_site = mark_region_stmt(c->single, id, false);
+    }
+    else
+    {
+        StatementList *l = c->first;
+        for (int i = 0; i < c->length; i++, l = l->next)
+        {
+            Statement *marked = mark_region_stmt(l->stmt, id, c->dispatch != NULL);
+            if (marked)
+            {
+                call_site = marked;
+            }
+        }
+    }
+
+    /* Assigned locals are shared with the helper through a box; a boxed
+     * pointer is no longer scalar-replaced */
+    for (int i = 0; i < s->capture_count; i++)
+    {
+        if (s->captures[i].written)
+        {
+            s->captures[i].decl->needs_heap_lift = true;
+            s->captures[i].decl->is_scalar_ptr = false;
+        }
+    }
+
+    CG_OutlineRegion *r = &v->outline_regions[v->outline_region_count++];
+    r->owner = owner;
+    r->root = root;
+    r->helper = helper;
+    r->dispatch = dispatch;
+    r->call_site = call_site;
+    r->captures = s->captures;
+    r->capture_count = s->capture_count;
+    r->descriptor = NULL;
+    r->called = false;
+    s->captures = NULL;
+}
+
+static bool overlaps(OutlineCandidate *a, OutlineCandidate *b)
+{
+    return a->begin < b->end && b->begin < a->end;
+}
+
+bool codegen_outline_plan(CodegenVisitor *v, int code_size)
+{
+    FunctionDeclaration *func = v->current_function;
+    int limit = v->method_limit;
+    if (code_size + OUTLINE_EPILOGUE_RESERVE <= limit || !func || !func->body)
+    {
+        return false;
+    }
+
+    OutlinePlan p = {};
+    p.v = v;
+    p.body = func->body;
+    int target = limit - limit / 16;
+    p.chunk_limit = target * 3 / 4;
+
+    if (v->outline_current == 0)
+    {
+        if (func->is_variadic)
+        {
+            return false;
+        }
+        for (ParameterList *param = func->param; param; param = param->next)
+        {
+            add_local(&p, param->decl);
+        }
+    }
+    else
+    {
+        CG_OutlineRegion *self = outline_region(v, v->outline_current);
+        p.dispatch_self = self->dispatch;
+        for (int i = 0; i < self->capture_count; i++)
+        {
+            add_local(&p, self->captures[i].decl);
+        }
+        p.incoming_count = p.local_count;
+    }
+    collect_locals(&p, func->body);
+    collect_stmt(&p, func->body, NULL);
+
+    /* Regions within the target size first, largest first */
+    int n = p.candidate_count;
+    int *order = (int *)calloc(n + 1, sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        int j = i;
+        while (j > 0)
+        {
+            OutlineCandidate *a = &p.candidates[order[j - 1]];
+            OutlineCandidate *b = &p.candidates[i];
+            bool a_over = a->size > target;
+            bool b_over = b->size > target;
+            if ((a_over == b_over && a->size >= b->size) || (!a_over && b_over))
+            {
+                break;
+            }
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    int needed = code_size + OUTLINE_EPILOGUE_RESERVE - target;
+    int saved = 0;
+    int created = 0;
+    int *chosen = (int *)calloc(n + 1, sizeof(int));
+    for (int k = 0; k < n && saved < needed; k++)
+    {
+        OutlineCandidate *c = &p.candidates[order[k]];
+        bool free_range = true;
+        for (int m = 0; m < created && free_range; m++)
+        {
+            free_range = !overlaps(c, &p.candidates[chosen[m]]);
+        }
+        if (!free_range)
+        {
+            continue;
+        }
+
+        OutlineScan s = {};
+        s.plan = &p;
+        scan_candidate(&s, c);
+        int saving = candidate_saving(&s, c);
+        if (saving >= OUTLINE_MIN_SAVING)
+        {
+            create_region(&p, c, &s);
+            chosen[created++] = order[k];
+            saved += saving;
+        }
+        free(s.captures);
+        free(s.declared);
+    }
+
+    free(chosen);
+    free(order);
+    free(p.candidates);
+    free(p.locals);
+    return created > 0;
+}
+
+/* ============================================================
+ * Calls and helpers
+ * ============================================================ */
+
+static CG_CaptureKind capture_kind(Declaration *decl)
+{
+    if (decl->needs_heap_lift)
+    {
+        return CG_CAPTURE_BOX;
+    }
+    return decl->is_scalar_ptr ? CG_CAPTURE_PAIR : CG_CAPTURE_VALUE;
+}
+
+static const char *pair_base_descriptor(Declaration *decl)
+{
+    return ptr_type_base_descriptor((PtrTypeIndex)cg_pointer_runtime_kind(decl->type));
+}
+
+static const char *value_descriptor(Declaration *decl)
+{
+    return cg_jvm_descriptor(decl->type);
+}
+
+bool codegen_outline_is_call_site(CodegenVisitor *v, Statement *stmt)
+{
+    return outline_region(v, stmt->outline_id)->call_site == stmt;
+}
+
+void codegen_outline_emit_call(CodegenVisitor *v, int id)
+{
+    CG_OutlineRegion *r = outline_region(v, id);
+
+    int length = 3;
+    for (int i = 0; i < r->capture_count; i++)
+    {
+        CG_OutlineCapture *c = &r->captures[i];
+        Declaration *decl = c->decl;
+        c->kind = capture_kind(decl);
+        CodegenSymbolInfo sym = cg_ensure_symbol(v, decl);
+        if (c->kind == CG_CAPTURE_BOX)
+        {
+            codebuilder_build_aload(v->builder, sym.index);
+            length += (int)strlen(cg_heap_lift_array_descriptor(decl->type));
+        }
+        else if (c->kind == CG_CAPTURE_PAIR)
+        {
+            codebuilder_build_aload(v->builder, sym.index);
+            codebuilder_build_iload(v->builder, sym.offset_index);
+            length += (int)strlen(pair_base_descriptor(decl)) + 1;
+        }
+        else
+        {
+            switch (cg_to_value_tag(decl->type))
+            {
+            case CF_VAL_LONG:
+                codebuilder_build_lload(v->builder, sym.index);
+                break;
+            case CF_VAL_FLOAT:
+                codebuilder_build_fload(v->builder, sym.index);
+                break;
+            case CF_VAL_DOUBLE:
+                codebuilder_build_dload(v->builder, sym.index);
+                break;
+            case CF_VAL_INT:
+                codebuilder_build_iload(v->builder, sym.index);
+                break;
+            default:
+                codebuilder_build_aload(v->builder, sym.index);
+                break;
+            }
+            length += (int)strlen(value_descriptor(decl));
+        }
+    }
+
+    char *desc = (char *)calloc(length + 1, sizeof(char));
+    int pos = 0;
+    desc[pos++] = '(';
+    for (int i = 0; i < r->capture_count; i++)
+    {
+        CG_OutlineCapture *c = &r->captures[i];
+        const char *part = c->kind == CG_CAPTURE_BOX    ? cg_heap_lift_array_descriptor(c->decl->type)
+                           : c->kind == CG_CAPTURE_PAIR ? pair_base_descriptor(c->decl)
+                                                        : value_descriptor(c->decl);
+        strcpy(desc + pos, part);
+        pos += (int)strlen(part);
+        if (c->kind == CG_CAPTURE_PAIR)
+        {
+            desc[pos++] = 'I';
+        }
+    }
+    strcpy(desc + pos, ")V");
+    free(r->descriptor);
+    r->descriptor = desc;
+    r->called = true;
+
+    int method_idx = cp_builder_add_methodref(code_output_cp(v->output), v->current_class_name,
+                                              r->helper->name, desc);
+    codebuilder_build_invokestatic(v->builder, method_idx);
+}
+
+void codegen_outline_begin_method(CodegenVisitor *v, FunctionDeclaration *func, int id)
+{
+    v->outline_current = id;
+    for (int i = 0; i < v->outline_region_count; i++)
+    {
+        if (v->outline_regions[i].owner == id)
+        {
+            v->outline_regions[i].called = false;
+        }
+    }
+
+    codegen_begin_function(v, func);
+    if (id == 0)
+    {
+        return;
+    }
+
+    /* Captures arrive as parameters in the order the call pushed them */
+    CG_OutlineRegion *r = outline_region(v, id);
+    int slot = 0;
+    for (int i = 0; i < r->capture_count; i++)
+    {
+        CG_OutlineCapture *c = &r->captures[i];
+        Declaration *decl = c->decl;
+        if (capture_kind(decl) != c->kind)
+        {
+            fprintf(stderr, "codegen: %s: capture %s changed after its call was emitted\n",
+                    func->name, decl->name);
+            exit(1);
+        }
+        if (c->kind == CG_CAPTURE_BOX)
+        {
+            codebuilder_set_param(v->builder, slot,
+                                  cb_type_object(cg_heap_lift_array_descriptor(decl->type)));
+            cg_bind_symbol(v, decl, CG_SYMBOL_PARAM, slot, -1);
+            slot += 1;
+        }
+        else if (c->kind == CG_CAPTURE_PAIR)
+        {
+            codebuilder_set_param(v->builder, slot, cb_type_object(pair_base_descriptor(decl)));
+            codebuilder_set_param(v->builder, slot + 1, cb_type_int());
+            cg_bind_symbol(v, decl, CG_SYMBOL_PARAM, slot, slot + 1);
+            /* The helper body has no declaration of it to analyze */
+            ++v->scalar_ptr_count;
+            slot += 2;
+        }
+        else
+        {
+            CB_VerificationType type = cb_type_from_c_type(decl->type);
+            codebuilder_set_param(v->builder, slot, type);
+            cg_bind_symbol(v, decl, CG_SYMBOL_PARAM, slot, -1);
+            slot += cb_type_slots(&type);
+        }
+    }
+}
+
+CS_Function *codegen_outline_add_function(CodegenVisitor *v, int id)
+{
+    CG_OutlineRegion *r = outline_region(v, id);
+    CS_Function *info = codegen_add_function_entry(v);
+    info->name = strdup(r->helper->name);
+    info->decl = r->helper;
+    info->signature_kind = CS_FUNC_SIG_OUTLINED;
+    info->descriptor = strdup(r->descriptor);
+    info->arg_count = r->capture_count;
+    info->is_native = false;
+    info->is_jvm_main = false;
+    info->is_static = true;
+    return info;
+}
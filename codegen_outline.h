@@ -0,0 +1,84 @@
+#pragma once
+
+#include "ast.h"
+#include "compiler.h"
+#include "executable.h"
+
+typedef struct CodegenVisitor_tag CodegenVisitor;
+
+/*
+ * Method outlining
+ *
+ * HotSpot does not JIT-compile methods with more than 8000 bytes of
+ * bytecode (HugeMethodLimit), and a class file method may not exceed 64KB.
+ * When a generated method is over the limit, codegen_outline_plan() moves
+ * statement regions of it into private static helper methods named
+ * <function>$partN and the method is generated again with a call in place
+ * of each region.  A helper that is still too large is split the same way.
+ *
+ * A region is a run of statements of a block, a single branch, loop body or
+ * case statement, or a run of switch arms ("case 1: ... break; case 2: ...")
+ * whose helper dispatches again on the switch variable.  Control must leave
+ * a region only by completing it: no return, goto or label, and break,
+ * continue and case only for loops and switches inside the region.
+ *
+ * Locals of the outer method used by a region become helper parameters:
+ * passed by value when only read, as their heap-lift box when assigned (the
+ * variable is lifted like one whose address is taken), and as the
+ * (base, offset) pair when they are scalar-replaced pointers.
+ */
+
+enum
+{
+    CG_OUTLINE_DEFAULT_METHOD_LIMIT = 8000, /* HotSpot HugeMethodLimit */
+    CG_OUTLINE_MIN_METHOD_LIMIT = 1024,
+    CG_OUTLINE_MAX_METHOD_LIMIT = 65535 /* Class file code_length limit */
+};
+
+typedef enum
+{
+    CG_CAPTURE_VALUE, /* Read-only local: its value */
+    CG_CAPTURE_BOX,   /* Heap-lifted local: its box array */
+    CG_CAPTURE_PAIR,  /* Scalar-replaced pointer: base array and offset */
+} CG_CaptureKind;
+
+typedef struct CG_OutlineCapture_tag
+{
+    Declaration *decl;
+    CG_CaptureKind kind; /* How the last emitted call passed it */
+    bool written;        /* Assigned inside the region */
+} CG_OutlineCapture;
+
+typedef struct CG_OutlineRegion_tag
+{
+    int owner;                   /* Region id of the method it was cut from (0 = function) */
+    FunctionDeclaration *root;   /* C function the region belongs to */
+    FunctionDeclaration *helper; /* Synthetic void function holding the region */
+    Statement *dispatch;         /* Helper's switch for a run of switch arms */
+    Statement *call_site;        /* Region statement generated as the call */
+    CG_OutlineCapture *captures;
+    int capture_count;
+    char *descriptor; /* Helper descriptor, set when the call is emitted */
+    bool called;      /* Call emitted in the owner's last generation */
+} CG_OutlineRegion;
+
+/* Method size limit selected by --method-limit (0 = default) */
+int codegen_outline_method_limit(CompilerContext *ctx);
+
+/* Begin a generation of method func: a C function (id 0) or the helper of
+ * region id, with its captures bound to the parameter slots */
+void codegen_outline_begin_method(CodegenVisitor *v, FunctionDeclaration *func, int id);
+
+/* Outline regions of the method being generated, whose code is code_size
+ * bytes, so that its next generation fits the limit.  Returns false when it
+ * already fits or nothing more can be outlined. */
+bool codegen_outline_plan(CodegenVisitor *v, int code_size);
+
+/* Is stmt (outlined from the current method) where its region's call goes */
+bool codegen_outline_is_call_site(CodegenVisitor *v, Statement *stmt);
+
+/* Pass the captures of region id and invoke its helper */
+void codegen_outline_emit_call(CodegenVisitor *v, int id);
+
+/* Add the method entry of a generated helper */
+CS_Function *codegen_outline_add_function(CodegenVisitor *v, int id);
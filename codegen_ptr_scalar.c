@@ -0,0 +1,1270 @@
+/*
+ * Scalar replacement of pointer locals
+ *
+ * Every C pointer is a __XPtr wrapper (base array + offset) on the JVM, and
+ * wrappers are immutable, so a pointer walking a buffer with p++ allocates
+ * one wrapper per step.  For a candidate pointer local or parameter the
+ * wrapper is replaced by two JVM locals holding base and offset:
+ *
+ *   *p, p[i], *p++, *(p + n)   ->  aload base; iload offset (+ index); Xaload
+ *   *p = v, p[i] = v           ->  ...; Xastore
+ *   p++, p += n                ->  iinc offset / iadd; istore offset
+ *   p = q                      ->  store the (base, offset) pair of q
+ *   p == q, p < q, p - q, !p   ->  compare offsets and bases directly
+ *
+ * Any other use of the bare pointer value (call argument, return value,
+ * store to memory, ...) materializes a fresh wrapper from the pair.
+ *
+ * cg_scalar_ptr_analyze() walks the function body once before code
+ * generation and weighs the wrappers saved by updates against those added
+ * by materializing, weighting both by loop depth.  Emission and analysis
+ * use the same pattern matchers, so every use the analysis accepted is
+ * emitted by cg_scalar_ptr_emit_expr(); anything else falls back to the
+ * regular visitor, which only ever sees a materialized wrapper.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ast.h"
+#include "cminor_type.h"
+#include "classfile_opcode.h"
+#include "codebuilder_frame.h"
+#include "codebuilder_label.h"
+#include "codebuilder_part1.h"
+#include "codebuilder_part2.h"
+#include "codebuilder_part3.h"
+#include "codebuilder_ptr.h"
+#include "codebuilder_types.h"
+#include "codegen_jvm_types.h"
+#include "codegen_ptr_scalar.h"
+#include "codegen_symbols.h"
+#include "codegenvisitor.h"
+#include "codegenvisitor_expr_util.h"
+#include "codegenvisitor_util.h"
+#include "synthetic_codegen.h"
+
+enum
+{
+    SCALAR_PTR_MAX_LOOP_WEIGHT_DEPTH = 6 /* 8^6: deeper loops weigh the same */
+};
+
+typedef enum
+{
+    SP_ROLE_VALUE,     /* Value is consumed */
+    SP_ROLE_TARGET,    /* Assignment/increment/address target of the regular visitor */
+    SP_ROLE_CONDITION, /* Condition root or &&/||/?: operand: tested against zero */
+    SP_ROLE_DISCARD,   /* Root of an expression statement or for-post: value unused */
+} ScalarPtrRole;
+
+typedef struct ScalarPtrCandidate_tag
+{
+    Declaration *decl;
+    int escape_cost; /* Weighted wrappers created by materializing the pair */
+    int update_gain; /* Weighted wrappers no longer created by p++, p = q, ... */
+    bool rejected;
+} ScalarPtrCandidate;
+
+typedef struct ScalarPtrAnalysis_tag
+{
+    ScalarPtrCandidate *candidates;
+    int count;
+    int capacity;
+} ScalarPtrAnalysis;
+
+/* Locals holding the (base, offset) pair of a pointer comparison operand */
+typedef struct ScalarPtrOperand_tag
+{
+    int base_index;
+    int offset_index;
+} ScalarPtrOperand;
+
+/* ============================================================
+ * Pattern matchers (shared by analysis and emission)
+ * ============================================================ */
+
+static bool is_candidate_decl(Declaration *decl)
+{
+    if (!decl || decl->needs_heap_lift || decl->is_static || decl->is_extern)
+    {
+        return false;
+    }
+    TypeSpecifier *type = decl->type;
+    if (!type || !cs_type_is_pointer(type) || cs_type_is_void_pointer(type))
+    {
+        return false;
+    }
+    TypeSpecifier *pointee = cs_type_child(type);
+    if (!cs_type_is_primitive(pointee) && !cs_type_is_enum(pointee))
+    {
+        return false;
+    }
+    return cg_pointer_runtime_kind(type) != CG_PTR_RUNTIME_OBJECT;
+}
+
+static Declaration *scalar_ident(Expression *e)
+{
+    if (!e || e->kind != IDENTIFIER_EXPRESSION || e->u.identifier.is_function ||
+        e->u.identifier.is_enum_member)
+    {
+        return NULL;
+    }
+    Declaration *decl = e->u.identifier.u.declaration;
+    return (decl && decl->is_scalar_ptr) ? decl : NULL;
+}
+
+static bool is_int_operand(Expression *e)
+{
+    return e && e->type && !cs_type_is_pointer(e->type) && !cs_type_is_array(e->type);
+}
+
+static bool is_typed_pointer(Expression *e)
+{
+    return e && e->type && cs_type_is_pointer(e->type) && !cs_type_is_void_pointer(e->type);
+}
+
+static bool same_runtime_kind(TypeSpecifier *a, TypeSpecifier *b)
+{
+    return cg_pointer_runtime_kind(a) == cg_pointer_runtime_kind(b);
+}
+
+/* Pointer operand of an element access: p, p++, ++p, p--, --p, p + n, n + p, p - n */
+static Declaration *element_pointer(Expression *x)
+{
+    Declaration *decl = scalar_ident(x);
+    if (decl || !x)
+    {
+        return decl;
+    }
+
+    switch (x->kind)
+    {
+    case INCREMENT_EXPRESSION:
+    case DECREMENT_EXPRESSION:
+        return scalar_ident(x->u.inc_dec.target);
+    case ADD_EXPRESSION:
+        decl = scalar_ident(x->u.binary_expression.left);
+        if (decl && is_int_operand(x->u.binary_expression.right))
+        {
+            return decl;
+        }
+        decl = scalar_ident(x->u.binary_expression.right);
+        if (decl && is_int_operand(x->u.binary_expression.left))
+        {
+            return decl;
+        }
+        return NULL;
+    case SUB_EXPRESSION:
+        decl = scalar_ident(x->u.binary_expression.left);
+        if (decl && is_int_operand(x->u.binary_expression.right))
+        {
+            return decl;
+        }
+        return NULL;
+    default:
+        return NULL;
+    }
+}
+
+/* Pointer operand of a primitive element lvalue/rvalue: *X or X[i] */
+static Expression *element_access_pointer(Expression *e)
+{
+    if (!e)
+    {
+        return NULL;
+    }
+    if (e->kind == DEREFERENCE_EXPRESSION)
+    {
+        return element_pointer(e->u.dereference_expression) ? e->u.dereference_expression : NULL;
+    }
+    if (e->kind == ARRAY_EXPRESSION)
+    {
+        Expression *array = e->u.array_expression.array;
+        if (array && array->type && cs_type_is_pointer(array->type) && element_pointer(array))
+        {
+            return array;
+        }
+    }
+    return NULL;
+}
+
+/* p == NULL, NULL != p, ... */
+static Declaration *null_compare_pointer(Expression *expr)
+{
+    if (expr->kind != EQ_EXPRESSION && expr->kind != NE_EXPRESSION)
+    {
+        return NULL;
+    }
+    Expression *left = expr->u.binary_expression.left;
+    Expression *right = expr->u.binary_expression.right;
+    if (right && right->kind == NULL_EXPRESSION)
+    {
+        return scalar_ident(left);
+    }
+    if (left && left->kind == NULL_EXPRESSION)
+    {
+        return scalar_ident(right);
+    }
+    return NULL;
+}
+
+/* Pointer comparison or difference with at least one bare scalar operand */
+static bool is_scalar_pointer_binary(Expression *expr)
+{
+    switch (expr->kind)
+    {
+    case EQ_EXPRESSION:
+    case NE_EXPRESSION:
+    case LT_EXPRESSION:
+    case LE_EXPRESSION:
+    case GT_EXPRESSION:
+    case GE_EXPRESSION:
+    case SUB_EXPRESSION:
+        break;
+    default:
+        return false;
+    }
+    Expression *left = expr->u.binary_expression.left;
+    Expression *right = expr->u.binary_expression.right;
+    if (!is_typed_pointer(left) || !is_typed_pointer(right) ||
+        left->kind == NULL_EXPRESSION || right->kind == NULL_EXPRESSION)
+    {
+        return false;
+    }
+    return scalar_ident(left) || scalar_ident(right);
+}
+
+/* Sources whose (base, offset) pair is produced without a wrapper */
+static Declaration *pair_source_pointer(Expression *e, Declaration *dest)
+{
+    Declaration *src = element_pointer(e);
+    return (src && same_runtime_kind(src->type, dest->type)) ? src : NULL;
+}
+
+static bool is_array_pair_source(Expression *e, Declaration *dest)
+{
+    return e && e->kind == ARRAY_TO_POINTER_EXPRESSION && e->type &&
+           cs_type_is_pointer(e->type) && same_runtime_kind(e->type, dest->type);
+}
+
+/* ============================================================
+ * Analysis
+ * ============================================================ */
+
+static int loop_weight(int depth)
+{
+    if (depth > SCALAR_PTR_MAX_LOOP_WEIGHT_DEPTH)
+    {
+        depth = SCALAR_PTR_MAX_LOOP_WEIGHT_DEPTH;
+    }
+    return 1 << (3 * depth);
+}
+
+static ScalarPtrCandidate *find_candidate(ScalarPtrAnalysis *a, Declaration *decl)
+{
+    for (int i = 0; i < a->count; i++)
+    {
+        if (a->candidates[i].decl == decl)
+        {
+            return &a->candidates[i];
+        }
+    }
+    return NULL;
+}
+
+static void add_candidate(ScalarPtrAnalysis *a, Declaration *decl)
+{
+    if (!is_candidate_decl(decl) || find_candidate(a, decl))
+    {
+        return;
+    }
+    if (a->count == a->capacity)
+    {
+        int new_cap = a->capacity ? a->capacity * 2 : 8;
+        ScalarPtrCandidate *new_candidates =
+            (ScalarPtrCandidate *)calloc(new_cap, sizeof(ScalarPtrCandidate));
+        for (int i = 0; i < a->count; i++)
+        {
+            new_candidates[i] = a->candidates[i];
+        }
+        free(a->candidates);
+        a->candidates = new_candidates;
+        a->capacity = new_cap;
+    }
+    ScalarPtrCandidate *c = &a->candidates[a->count++];
+    c->decl = decl;
+    c->escape_cost = 0;
+    c->update_gain = 0;
+    c->rejected = false;
+    /* Tentatively scalar so the matchers recognize it while scanning */
+    decl->is_scalar_ptr = true;
+}
+
+static void note_escape(ScalarPtrAnalysis *a, Declaration *decl, int depth)
+{
+    ScalarPtrCandidate *c = find_candidate(a, decl);
+    if (c)
+    {
+        c->escape_cost += loop_weight(depth);
+    }
+}
+
+static void note_update(ScalarPtrAnalysis *a, Declaration *decl, int depth)
+{
+    ScalarPtrCandidate *c = find_candidate(a, decl);
+    if (c)
+    {
+        c->update_gain += loop_weight(depth);
+    }
+}
+
+static void reject(ScalarPtrAnalysis *a, Declaration *decl)
+{
+    ScalarPtrCandidate *c = find_candidate(a, decl);
+    if (c)
+    {
+        c->rejected = true;
+    }
+}
+
+static void scan_expr(ScalarPtrAnalysis *a, Expression *e, int depth, ScalarPtrRole role);
+
+static void scan_element_pointer(ScalarPtrAnalysis *a, Expression *x, int depth)
+{
+    switch (x->kind)
+    {
+    case INCREMENT_EXPRESSION:
+    case DECREMENT_EXPRESSION:
+        note_update(a, scalar_ident(x->u.inc_dec.target), depth);
+        break;
+    case ADD_EXPRESSION:
+        if (scalar_ident(x->u.binary_expression.left) &&
+            is_int_operand(x->u.binary_expression.right))
+        {
+            scan_expr(a, x->u.binary_expression.right, depth, SP_ROLE_VALUE);
+        }
+        else
+        {
+            scan_expr(a, x->u.binary_expression.left, depth, SP_ROLE_VALUE);
+        }
+        break;
+    case SUB_EXPRESSION:
+        scan_expr(a, x->u.binary_expression.right, depth, SP_ROLE_VALUE);
+        break;
+    default:
+        break;
+    }
+}
+
+static void scan_pair_source(ScalarPtrAnalysis *a, Expression *e, Declaration *dest, int depth)
+{
+    if (pair_source_pointer(e, dest))
+    {
+        scan_element_pointer(a, e, depth);
+        return;
+    }
+    if (e->kind == NULL_EXPRESSION)
+    {
+        return;
+    }
+    if (is_array_pair_source(e, dest))
+    {
+        scan_expr(a, e->u.array_to_pointer, depth, SP_ROLE_VALUE);
+        return;
+    }
+    /* Generic source: split the wrapper, which must share the base array type */
+    if (!is_typed_pointer(e) || !same_runtime_kind(e->type, dest->type))
+    {
+        reject(a, dest);
+    }
+    scan_expr(a, e, depth, SP_ROLE_VALUE);
+}
+
+static void scan_binary_operands(ScalarPtrAnalysis *a, Expression *e, int depth)
+{
+    scan_expr(a, e->u.binary_expression.left, depth, SP_ROLE_VALUE);
+    scan_expr(a, e->u.binary_expression.right, depth, SP_ROLE_VALUE);
+}
+
+static void scan_expr(ScalarPtrAnalysis *a, Expression *e, int depth, ScalarPtrRole role)
+{
+    if (!e)
+    {
+        return;
+    }
+
+    Declaration *decl = NULL;
+    switch (e->kind)
+    {
+    case IDENTIFIER_EXPRESSION:
+        decl = scalar_ident(e);
+        if (!decl)
+        {
+            return;
+        }
+        if (role == SP_ROLE_TARGET)
+        {
+            reject(a, decl);
+        }
+        else if (role != SP_ROLE_CONDITION)
+        {
+            note_escape(a, decl, depth);
+        }
+        return;
+
+    case DEREFERENCE_EXPRESSION:
+        if (role != SP_ROLE_TARGET && element_access_pointer(e))
+        {
+            scan_element_pointer(a, e->u.dereference_expression, depth);
+            return;
+        }
+        scan_expr(a, e->u.dereference_expression, depth, SP_ROLE_VALUE);
+        return;
+
+    case ARRAY_EXPRESSION:
+        if (role != SP_ROLE_TARGET && element_access_pointer(e))
+        {
+            scan_element_pointer(a, e->u.array_expression.array, depth);
+        }
+        else
+        {
+            scan_expr(a, e->u.array_expression.array, depth, SP_ROLE_VALUE);
+        }
+        scan_expr(a, e->u.array_expression.index, depth, SP_ROLE_VALUE);
+        return;
+
+    case ASSIGN_EXPRESSION:
+    {
+        Expression *left = e->u.assignment_expression.left;
+        Expression *right = e->u.assignment_expression.right;
+        AssignmentOperator aope = e->u.assignment_expression.aope;
+        decl = scalar_ident(left);
+        if (decl)
+        {
+            if (aope == ASSIGN)
+            {
+                scan_pair_source(a, right, decl, depth);
+            }
+            else
+            {
+                if (aope != ADD_ASSIGN && aope != SUB_ASSIGN)
+                {
+                    reject(a, decl);
+                }
+                scan_expr(a, right, depth, SP_ROLE_VALUE);
+            }
+            note_update(a, decl, depth);
+            if (role != SP_ROLE_DISCARD)
+            {
+                note_escape(a, decl, depth);
+            }
+            return;
+        }
+        Expression *pointer = element_access_pointer(left);
+        if (aope == ASSIGN && pointer)
+        {
+            scan_element_pointer(a, pointer, depth);
+            if (left->kind == ARRAY_EXPRESSION)
+            {
+                scan_expr(a, left->u.array_expression.index, depth, SP_ROLE_VALUE);
+            }
+            scan_expr(a, right, depth, SP_ROLE_VALUE);
+            return;
+        }
+        scan_expr(a, left, depth, SP_ROLE_TARGET);
+        scan_expr(a, right, depth, SP_ROLE_VALUE);
+        return;
+    }
+
+    case INCREMENT_EXPRESSION:
+    case DECREMENT_EXPRESSION:
+        decl = scalar_ident(e->u.inc_dec.target);
+        if (decl)
+        {
+            note_update(a, decl, depth);
+            if (role != SP_ROLE_DISCARD)
+            {
+                note_escape(a, decl, depth);
+            }
+            return;
+        }
+        scan_expr(a, e->u.inc_dec.target, depth, SP_ROLE_TARGET);
+        return;
+
+    case ADDRESS_EXPRESSION:
+    {
+        Expression *target = e->u.address_expression;
+        bool is_target = target && (target->kind == ARRAY_EXPRESSION ||
+                                    target->kind == IDENTIFIER_EXPRESSION);
+        scan_expr(a, target, depth, is_target ? SP_ROLE_TARGET : SP_ROLE_VALUE);
+        return;
+    }
+
+    case LOGICAL_NOT_EXPRESSION:
+        if (scalar_ident(e->u.logical_not_expression))
+        {
+            return;
+        }
+        scan_expr(a, e->u.logical_not_expression, depth, SP_ROLE_VALUE);
+        return;
+
+    case EQ_EXPRESSION:
+    case NE_EXPRESSION:
+    case LT_EXPRESSION:
+    case LE_EXPRESSION:
+    case GT_EXPRESSION:
+    case GE_EXPRESSION:
+    case SUB_EXPRESSION:
+    case ADD_EXPRESSION:
+        if (null_compare_pointer(e))
+        {
+            return;
+        }
+        if (is_scalar_pointer_binary(e))
+        {
+            if (!scalar_ident(e->u.binary_expression.left))
+            {
+                scan_expr(a, e->u.binary_expression.left, depth, SP_ROLE_VALUE);
+            }
+            if (!scalar_ident(e->u.binary_expression.right))
+            {
+                scan_expr(a, e->u.binary_expression.right, depth, SP_ROLE_VALUE);
+            }
+            return;
+        }
+        if ((e->kind == ADD_EXPRESSION || e->kind == SUB_EXPRESSION) && element_pointer(e))
+        {
+            /* p + n as a value: one wrapper, as before */
+            scan_element_pointer(a, e, depth);
+            return;
+        }
+        scan_binary_operands(a, e, depth);
+        return;
+
+    case MUL_EXPRESSION:
+    case DIV_EXPRESSION:
+    case MOD_EXPRESSION:
+    case LSHIFT_EXPRESSION:
+    case RSHIFT_EXPRESSION:
+    case BIT_AND_EXPRESSION:
+    case BIT_XOR_EXPRESSION:
+    case BIT_OR_EXPRESSION:
+        scan_binary_operands(a, e, depth);
+        return;
+
+    case LOGICAL_AND_EXPRESSION:
+    case LOGICAL_OR_EXPRESSION:
+        scan_expr(a, e->u.binary_expression.left, depth, SP_ROLE_CONDITION);
+        scan_expr(a, e->u.binary_expression.right, depth, SP_ROLE_CONDITION);
+        return;
+
+    case FUNCTION_CALL_EXPRESSION:
+        for (ArgumentList *arg = e->u.function_call_expression.argument; arg; arg = arg->next)
+        {
+            scan_expr(a, arg->expr, depth, SP_ROLE_VALUE);
+        }
+        scan_expr(a, e->u.function_call_expression.function, depth, SP_ROLE_VALUE);
+        return;
+
+    case MINUS_EXPRESSION:
+        scan_expr(a, e->u.minus_expression, depth, SP_ROLE_VALUE);
+        return;
+    case PLUS_EXPRESSION:
+        scan_expr(a, e->u.plus_expression, depth, SP_ROLE_VALUE);
+        return;
+    case BIT_NOT_EXPRESSION:
+        scan_expr(a, e->u.bit_not_expression, depth, SP_ROLE_VALUE);
+        return;
+    case MEMBER_EXPRESSION:
+        scan_expr(a, e->u.member_expression.target, depth, SP_ROLE_VALUE);
+        return;
+    case CAST_EXPRESSION:
+        scan_expr(a, e->u.cast_expression.expr, depth, SP_ROLE_VALUE);
+        return;
+    case TYPE_CAST_EXPRESSION:
+        scan_expr(a, e->u.type_cast_expression.expr, depth, SP_ROLE_VALUE);
+        return;
+    case ARRAY_TO_POINTER_EXPRESSION:
+        scan_expr(a, e->u.array_to_pointer, depth, SP_ROLE_VALUE);
+        return;
+    case CONDITIONAL_EXPRESSION:
+        scan_expr(a, e->u.conditional_expression.condition, depth, SP_ROLE_CONDITION);
+        scan_expr(a, e->u.conditional_expression.true_expr, depth, SP_ROLE_VALUE);
+        scan_expr(a, e->u.conditional_expression.false_expr, depth, SP_ROLE_VALUE);
+        return;
+    case COMMA_EXPRESSION:
+        scan_expr(a, e->u.comma_expression.left, depth, SP_ROLE_VALUE);
+        scan_expr(a, e->u.comma_expression.right, depth, SP_ROLE_VALUE);
+        return;
+    case INITIALIZER_LIST_EXPRESSION:
+        for (ExpressionList *p = e->u.initializer_list; p; p = p->next)
+        {
+            scan_expr(a, p->expression, depth, SP_ROLE_VALUE);
+        }
+        return;
+    case DESIGNATED_INITIALIZER_EXPRESSION:
+        scan_expr(a, e->u.designated_initializer.value, depth, SP_ROLE_VALUE);
+        return;
+    default:
+        /* Literals and sizeof (operand is not evaluated) */
+        return;
+    }
+}
+
+static void scan_stmt(ScalarPtrAnalysis *a, Statement *stmt, int depth)
+{
+    if (!stmt)
+    {
+        return;
+    }
+
+    switch (stmt->type)
+    {
+    case EXPRESSION_STATEMENT:
+        scan_expr(a, stmt->u.expression_s, depth, SP_ROLE_DISCARD);
+        break;
+    case DECLARATION_STATEMENT:
+    {
+        Declaration *decl = stmt->u.declaration_s;
+        if (!decl)
+        {
+            break;
+        }
+        if (decl->type && cs_type_is_array(decl->type))
+        {
+            for (TypeSpecifier *t = decl->type; t && cs_type_is_array(t); t = cs_type_child(t))
+            {
+                scan_expr(a, cs_type_array_size(t), depth, SP_ROLE_VALUE);
+            }
+        }
+        if (is_candidate_decl(decl))
+        {
+            add_candidate(a, decl);
+            if (decl->initializer)
+            {
+                scan_pair_source(a, decl->initializer, decl, depth);
+            }
+        }
+        else
+        {
+            scan_expr(a, decl->initializer, depth, SP_ROLE_VALUE);
+        }
+        break;
+    }
+    case COMPOUND_STATEMENT:
+        for (StatementList *p = stmt->u.compound_s.list; p; p = p->next)
+        {
+            scan_stmt(a, p->stmt, depth);
+        }
+        break;
+    case IF_STATEMENT:
+        scan_expr(a, stmt->u.if_s.condition, depth, SP_ROLE_CONDITION);
+        scan_stmt(a, stmt->u.if_s.then_statement, depth);
+        scan_stmt(a, stmt->u.if_s.else_statement, depth);
+        break;
+    case WHILE_STATEMENT:
+        scan_expr(a, stmt->u.while_s.condition, depth + 1, SP_ROLE_CONDITION);
+        scan_stmt(a, stmt->u.while_s.body, depth + 1);
+        break;
+    case DO_WHILE_STATEMENT:
+        scan_stmt(a, stmt->u.do_s.body, depth + 1);
+        scan_expr(a, stmt->u.do_s.condition, depth + 1, SP_ROLE_CONDITION);
+        break;
+    case FOR_STATEMENT:
+        scan_stmt(a, stmt->u.for_s.init, depth);
+        scan_expr(a, stmt->u.for_s.condition, depth + 1, SP_ROLE_CONDITION);
+        scan_stmt(a, stmt->u.for_s.body, depth + 1);
+        scan_expr(a, stmt->u.for_s.post, depth + 1, SP_ROLE_DISCARD);
+        break;
+    case SWITCH_STATEMENT:
+        scan_expr(a, stmt->u.switch_s.expression, depth, SP_ROLE_VALUE);
+        scan_stmt(a, stmt->u.switch_s.body, depth);
+        break;
+    case CASE_STATEMENT:
+        scan_stmt(a, stmt->u.case_s.statement, depth);
+        break;
+    case DEFAULT_STATEMENT:
+        scan_stmt(a, stmt->u.default_s.statement, depth);
+        break;
+    case LABEL_STATEMENT:
+        scan_stmt(a, stmt->u.label_s.statement, depth);
+        break;
+    case RETURN_STATEMENT:
+        /* Runs at most once per call, wherever it is nested */
+        scan_expr(a, stmt->u.return_s.expression, 0, SP_ROLE_VALUE);
+        break;
+    default:
+        break;
+    }
+}
+
+void cg_scalar_ptr_analyze(CodegenVisitor *v, FunctionDeclaration *func)
+{
+    v->scalar_ptr_count = 0;
+    if (!func || !func->body)
+    {
+        return;
+    }
+
+    ScalarPtrAnalysis a = {NULL, 0, 0};
+    for (ParameterList *p = func->param; p && !p->is_ellipsis; p = p->next)
+    {
+        add_candidate(&a, p->decl);
+    }
+    scan_stmt(&a, func->body, 0);
+
+    for (int i = 0; i < a.count; i++)
+    {
+        ScalarPtrCandidate *c = &a.candidates[i];
+        bool accept = !c->rejected &&
+                      (c->escape_cost == 0 || c->escape_cost < c->update_gain);
+        c->decl->is_scalar_ptr = accept;
+        if (accept)
+        {
+            ++v->scalar_ptr_count;
+        }
+    }
+    free(a.candidates);
+}
+
+/* ============================================================
+ * Emission
+ * ============================================================ */
+
+static CB_VerificationType base_array_type(Declaration *decl)
+{
+    PtrTypeIndex ptr_idx = (PtrTypeIndex)cg_pointer_runtime_kind(decl->type);
+    return cb_type_object(ptr_type_base_descriptor(ptr_idx));
+}
+
+static void emit_load_pair(CodegenVisitor *v, Declaration *decl)
+{
+    CodegenSymbolInfo sym = cg_ensure_symbol(v, decl);
+    codebuilder_build_aload(v->builder, sym.index);
+    codebuilder_build_iload(v->builder, sym.offset_index);
+}
+
+static void emit_store_pair(CodegenVisitor *v, Declaration *decl)
+{
+    /* Stack: [base, offset] */
+    CodegenSymbolInfo sym = cg_ensure_symbol(v, decl);
+    codebuilder_build_istore(v->builder, sym.offset_index);
+    codebuilder_build_astore(v->builder, sym.index);
+    /* Storing NULL would narrow the slot to the null type; keep the array
+     * type so frames agree at merge points */
+    codebuilder_set_local(v->builder, sym.index, base_array_type(decl));
+}
+
+static void emit_materialize(CodegenVisitor *v, Declaration *decl)
+{
+    emit_load_pair(v, decl);
+    cg_emit_ptr_create(v, decl->type);
+}
+
+static void emit_int_operand(CodegenVisitor *v, Expression *e)
+{
+    codegen_traverse_expr(e, v);
+    if (cs_type_is_long_exact(e->type))
+    {
+        codebuilder_build_l2i(v->builder);
+    }
+}
+
+/* Push [base, offset] for an element_pointer() expression, applying p++/p-- */
+static void emit_element_pointer(CodegenVisitor *v, Expression *x)
+{
+    Declaration *decl = element_pointer(x);
+    switch (x->kind)
+    {
+    case INCREMENT_EXPRESSION:
+    case DECREMENT_EXPRESSION:
+    {
+        CodegenSymbolInfo sym = cg_ensure_symbol(v, decl);
+        int delta = (x->kind == INCREMENT_EXPRESSION) ? 1 : -1;
+        if (x->u.inc_dec.is_prefix)
+        {
+            codebuilder_build_iinc(v->builder, sym.offset_index, delta);
+            emit_load_pair(v, decl);
+        }
+        else
+        {
+            emit_load_pair(v, decl);
+            codebuilder_build_iinc(v->builder, sym.offset_index, delta);
+        }
+        break;
+    }
+    case ADD_EXPRESSION:
+        emit_load_pair(v, decl);
+        if (scalar_ident(x->u.binary_expression.left) &&
+            is_int_operand(x->u.binary_expression.right))
+        {
+            emit_int_operand(v, x->u.binary_expression.right);
+        }
+        else
+        {
+            emit_int_operand(v, x->u.binary_expression.left);
+        }
+        codebuilder_build_iadd(v->builder);
+        break;
+    case SUB_EXPRESSION:
+        emit_load_pair(v, decl);
+        emit_int_operand(v, x->u.binary_expression.right);
+        codebuilder_build_isub(v->builder);
+        break;
+    default:
+        emit_load_pair(v, decl);
+        break;
+    }
+}
+
+/* Push [base, index] of an element_access_pointer() expression */
+static void emit_element_address(CodegenVisitor *v, Expression *e, Expression *pointer)
+{
+    emit_element_pointer(v, pointer);
+    if (e->kind == ARRAY_EXPRESSION)
+    {
+        emit_int_operand(v, e->u.array_expression.index);
+        codebuilder_build_iadd(v->builder);
+    }
+}
+
+/* Push the [base, offset] pair of a value assigned to dest */
+static void emit_pair_source(CodegenVisitor *v, Expression *e, Declaration *dest)
+{
+    if (pair_source_pointer(e, dest))
+    {
+        emit_element_pointer(v, e);
+        return;
+    }
+    if (e->kind == NULL_EXPRESSION)
+    {
+        codebuilder_build_aconst_null(v->builder);
+        codebuilder_build_iconst(v->builder, 0);
+        return;
+    }
+    if (is_array_pair_source(e, dest))
+    {
+        codegen_traverse_expr(e->u.array_to_pointer, v);
+        codebuilder_build_iconst(v->builder, 0);
+        return;
+    }
+    /* Split a wrapper: [ptr] -> [base, offset] */
+    codegen_traverse_expr(e, v);
+    codebuilder_build_dup(v->builder);
+    cg_emit_ptr_get_base(v, e->type);
+    codebuilder_build_swap(v->builder);
+    cg_emit_ptr_get_offset(v, e->type);
+}
+
+static bool is_condition_root(CodegenVisitor *v, Expression *expr)
+{
+    if (v->ctx.truth_expr == expr)
+    {
+        return true;
+    }
+    if (v->ctx.if_depth > 0 &&
+        v->ctx.if_stack[v->ctx.if_depth - 1].if_stmt->u.if_s.condition == expr)
+    {
+        return true;
+    }
+    return v->ctx.for_depth > 0 &&
+           v->ctx.for_stack[v->ctx.for_depth - 1].condition_expr == expr;
+}
+
+static bool is_value_unused(CodegenVisitor *v, Expression *expr)
+{
+    if (v->ctx.stmt_expr == expr)
+    {
+        return true;
+    }
+    for (int i = 0; i < v->ctx.for_depth; i++)
+    {
+        if (v->ctx.for_stack[i].post_expr == expr)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_visitor_target(CodegenVisitor *v, Expression *expr)
+{
+    return v->ctx.assign_target == expr || v->ctx.inc_target == expr ||
+           v->ctx.addr_target == expr;
+}
+
+static void emit_element_read(CodegenVisitor *v, Expression *expr, Expression *pointer)
+{
+    TypeSpecifier *ptr_type = pointer->type;
+    emit_element_address(v, expr, pointer);
+    cg_emit_ptr_element_load(v, ptr_type);
+
+    /* Subscript reads of unsigned char mask like cg_emit_ptr_subscript */
+    if (expr->kind == ARRAY_EXPRESSION &&
+        cg_pointer_runtime_kind(ptr_type) == CG_PTR_RUNTIME_CHAR &&
+        cs_type_is_unsigned(cs_type_child(ptr_type)))
+    {
+        codebuilder_build_iconst(v->builder, 255);
+        codebuilder_build_iand(v->builder);
+    }
+}
+
+static void emit_element_assign(CodegenVisitor *v, Expression *expr, Expression *pointer)
+{
+    Expression *left = expr->u.assignment_expression.left;
+    emit_element_address(v, left, pointer);
+    codegen_traverse_expr(expr->u.assignment_expression.right, v);
+    /* Stack: [base, index, value] -> [value] */
+    codebuilder_build_dup_value_x2(v->builder);
+    cg_emit_ptr_element_store(v, pointer->type);
+}
+
+static void emit_pointer_update(CodegenVisitor *v, Expression *expr, Declaration *decl)
+{
+    CodegenSymbolInfo sym = cg_ensure_symbol(v, decl);
+    bool used = !is_value_unused(v, expr);
+
+    if (expr->kind == INCREMENT_EXPRESSION || expr->kind == DECREMENT_EXPRESSION)
+    {
+        int delta = (expr->kind == INCREMENT_EXPRESSION) ? 1 : -1;
+        bool is_prefix = expr->u.inc_dec.is_prefix;
+        if (used && !is_prefix)
+        {
+            emit_materialize(v, decl);
+        }
+        codebuilder_build_iinc(v->builder, sym.offset_index, delta);
+        if (used && is_prefix)
+        {
+            emit_materialize(v, decl);
+        }
+        return;
+    }
+
+    Expression *right = expr->u.assignment_expression.right;
+    if (expr->u.assignment_expression.aope == ASSIGN)
+    {
+        emit_pair_source(v, right, decl);
+        emit_store_pair(v, decl);
+    }
+    else
+    {
+        codebuilder_build_iload(v->builder, sym.offset_index);
+        emit_int_operand(v, right);
+        if (expr->u.assignment_expression.aope == SUB_ASSIGN)
+        {
+            codebuilder_build_isub(v->builder);
+        }
+        else
+        {
+            codebuilder_build_iadd(v->builder);
+        }
+        codebuilder_build_istore(v->builder, sym.offset_index);
+    }
+    if (used)
+    {
+        emit_materialize(v, decl);
+    }
+}
+
+/* Evaluate a comparison operand into locals; a bare scalar uses its own pair */
+static ScalarPtrOperand save_pointer_operand(CodegenVisitor *v, Expression *e)
+{
+    ScalarPtrOperand operand;
+    Declaration *decl = scalar_ident(e);
+    if (decl)
+    {
+        CodegenSymbolInfo sym = cg_ensure_symbol(v, decl);
+        operand.base_index = sym.index;
+        operand.offset_index = sym.offset_index;
+        return operand;
+    }
+    if (element_pointer(e))
+    {
+        emit_element_pointer(v, e);
+    }
+    else
+    {
+        codegen_traverse_expr(e, v);
+        codebuilder_build_dup(v->builder);
+        cg_emit_ptr_get_base(v, e->type);
+        codebuilder_build_swap(v->builder);
+        cg_emit_ptr_get_offset(v, e->type);
+    }
+    operand.offset_index = allocate_temp_local_for_tag(v, CF_VAL_INT);
+    codebuilder_build_istore(v->builder, operand.offset_index);
+    operand.base_index = allocate_temp_local_for_tag(v, CF_VAL_OBJECT);
+    codebuilder_build_astore(v->builder, operand.base_index);
+    return operand;
+}
+
+static void emit_pointer_binary(CodegenVisitor *v, Expression *expr)
+{
+    ScalarPtrOperand left = save_pointer_operand(v, expr->u.binary_expression.left);
+    ScalarPtrOperand right = save_pointer_operand(v, expr->u.binary_expression.right);
+
+    codebuilder_build_iload(v->builder, left.offset_index);
+    codebuilder_build_iload(v->builder, right.offset_index);
+
+    switch (expr->kind)
+    {
+    case SUB_EXPRESSION:
+        codebuilder_build_isub(v->builder);
+        break;
+    case LT_EXPRESSION:
+        emit_icmp_comparison(v, ICMP_LT);
+        break;
+    case LE_EXPRESSION:
+        emit_icmp_comparison(v, ICMP_LE);
+        break;
+    case GT_EXPRESSION:
+        emit_icmp_comparison(v, ICMP_GT);
+        break;
+    case GE_EXPRESSION:
+        emit_icmp_comparison(v, ICMP_GE);
+        break;
+    default:
+    {
+        /* == / !=: offsets first, then bases (as for wrapper operands) */
+        bool is_eq = (expr->kind == EQ_EXPRESSION);
+        CB_Label *label_result_known = codebuilder_create_label(v->builder);
+        CB_Label *label_end = codebuilder_create_label(v->builder);
+        codebuilder_jump_if_icmp(v->builder, ICMP_NE, label_result_known);
+        codebuilder_build_aload(v->builder, left.base_index);
+        codebuilder_build_aload(v->builder, right.base_index);
+        emit_acmp_comparison(v, is_eq ? ACMP_EQ : ACMP_NE);
+        codebuilder_jump(v->builder, label_end);
+        codebuilder_place_label(v->builder, label_result_known);
+        codebuilder_build_iconst(v->builder, is_eq ? 0 : 1);
+        codebuilder_place_label(v->builder, label_end);
+        break;
+    }
+    }
+}
+
+bool cg_scalar_ptr_compare_branch(CodegenVisitor *v, Expression *expr, bool jump_if, CB_Label *target)
+{
+    if (v->scalar_ptr_count == 0 || expr->kind == SUB_EXPRESSION || !is_scalar_pointer_binary(expr))
+    {
+        return false;
+    }
+
+    ScalarPtrOperand left = save_pointer_operand(v, expr->u.binary_expression.left);
+    ScalarPtrOperand right = save_pointer_operand(v, expr->u.binary_expression.right);
+
+    codebuilder_build_iload(v->builder, left.offset_index);
+    codebuilder_build_iload(v->builder, right.offset_index);
+
+    switch (expr->kind)
+    {
+    case LT_EXPRESSION:
+        codebuilder_jump_if_icmp(v->builder, jump_if ? ICMP_LT : ICMP_GE, target);
+        break;
+    case LE_EXPRESSION:
+        codebuilder_jump_if_icmp(v->builder, jump_if ? ICMP_LE : ICMP_GT, target);
+        break;
+    case GT_EXPRESSION:
+        codebuilder_jump_if_icmp(v->builder, jump_if ? ICMP_GT : ICMP_LE, target);
+        break;
+    case GE_EXPRESSION:
+        codebuilder_jump_if_icmp(v->builder, jump_if ? ICMP_GE : ICMP_LT, target);
+        break;
+    default:
+    {
+        /* Equal iff offsets and bases both match */
+        bool jump_on_equal = ((expr->kind == EQ_EXPRESSION) == jump_if);
+        if (jump_on_equal)
+        {
+            CB_Label *skip_label = codebuilder_create_label(v->builder);
+            codebuilder_jump_if_icmp(v->builder, ICMP_NE, skip_label);
+            codebuilder_build_aload(v->builder, left.base_index);
+            codebuilder_build_aload(v->builder, right.base_index);
+            codebuilder_jump_if_acmp(v->builder, ACMP_EQ, target);
+            codebuilder_place_label(v->builder, skip_label);
+        }
+        else
+        {
+            codebuilder_jump_if_icmp(v->builder, ICMP_NE, target);
+            codebuilder_build_aload(v->builder, left.base_index);
+            codebuilder_build_aload(v->builder, right.base_index);
+            codebuilder_jump_if_acmp(v->builder, ACMP_NE, target);
+        }
+        break;
+    }
+    }
+    return true;
+}
+
+static bool emit_scalar_pattern(CodegenVisitor *v, Expression *expr)
+{
+    Declaration *decl = NULL;
+    Expression *pointer = NULL;
+
+    switch (expr->kind)
+    {
+    case IDENTIFIER_EXPRESSION:
+        decl = scalar_ident(expr);
+        if (!decl)
+        {
+            return false;
+        }
+        if (is_visitor_target(v, expr))
+        {
+            fprintf(stderr, "scalar-replaced pointer '%s' used as unsupported target\n",
+                    decl->name);
+            exit(1);
+        }
+        if (is_condition_root(v, expr))
+        {
+            codebuilder_build_aload(v->builder, cg_ensure_symbol(v, decl).index);
+        }
+        else
+        {
+            emit_materialize(v, decl);
+        }
+        return true;
+
+    case DEREFERENCE_EXPRESSION:
+    case ARRAY_EXPRESSION:
+        pointer = element_access_pointer(expr);
+        if (!pointer || is_visitor_target(v, expr))
+        {
+            return false;
+        }
+        emit_element_read(v, expr, pointer);
+        return true;
+
+    case ASSIGN_EXPRESSION:
+    {
+        Expression *left = expr->u.assignment_expression.left;
+        decl = scalar_ident(left);
+        if (decl)
+        {
+            emit_pointer_update(v, expr, decl);
+            return true;
+        }
+        pointer = element_access_pointer(left);
+        if (!pointer || expr->u.assignment_expression.aope != ASSIGN)
+        {
+            return false;
+        }
+        emit_element_assign(v, expr, pointer);
+        return true;
+    }
+
+    case INCREMENT_EXPRESSION:
+    case DECREMENT_EXPRESSION:
+        decl = scalar_ident(expr->u.inc_dec.target);
+        if (!decl)
+        {
+            return false;
+        }
+        emit_pointer_update(v, expr, decl);
+        return true;
+
+    case LOGICAL_NOT_EXPRESSION:
+        decl = scalar_ident(expr->u.logical_not_expression);
+        if (!decl)
+        {
+            return false;
+        }
+        codebuilder_build_aload(v->builder, cg_ensure_symbol(v, decl).index);
+        emit_if_ref_null_check(v, true);
+        return true;
+
+    case EQ_EXPRESSION:
+    case NE_EXPRESSION:
+    case LT_EXPRESSION:
+    case LE_EXPRESSION:
+    case GT_EXPRESSION:
+    case GE_EXPRESSION:
+    case SUB_EXPRESSION:
+    case ADD_EXPRESSION:
+        decl = null_compare_pointer(expr);
+        if (decl)
+        {
+            codebuilder_build_aload(v->builder, cg_ensure_symbol(v, decl).index);
+            emit_if_ref_null_check(v, expr->kind == EQ_EXPRESSION);
+            return true;
+        }
+        if (is_scalar_pointer_binary(expr))
+        {
+            emit_pointer_binary(v, expr);
+            return true;
+        }
+        if ((expr->kind == ADD_EXPRESSION || expr->kind == SUB_EXPRESSION) &&
+            element_pointer(expr))
+        {
+            emit_element_pointer(v, expr);
+            cg_emit_ptr_create(v, expr->type);
+            return true;
+        }
+        return false;
+
+    default:
+        return false;
+    }
+}
+
+bool cg_scalar_ptr_emit_expr(CodegenVisitor *v, Expression *expr)
+{
+    if (v->scalar_ptr_count == 0)
+    {
+        return false;
+    }
+
+    /* Mirror the enter/leave bookkeeping every visitor handler performs */
+    mark_for_condition_start(v, expr);
+    if (!emit_scalar_pattern(v, expr))
+    {
+        return false;
+    }
+    handle_for_expression_leave(v, expr);
+    return true;
+}
+
+void cg_scalar_ptr_emit_decl(CodegenVisitor *v, Declaration *decl)
+{
+    if (decl->initializer)
+    {
+        emit_pair_source(v, decl->initializer, decl);
+    }
+    else
+    {
+        /* Uninitialized pointer: NULL, matching the null wrapper it replaces */
+        codebuilder_build_aconst_null(v->builder);
+        codebuilder_build_iconst(v->builder, 0);
+    }
+    emit_store_pair(v, decl);
+}
+
+void cg_scalar_ptr_split_params(CodegenVisitor *v, FunctionDeclaration *func)
+{
+    if (!func || v->scalar_ptr_count == 0)
+    {
+        return;
+    }
+    for (ParameterList *p = func->param; p && !p->is_ellipsis; p = p->next)
+    {
+        Declaration *decl = p->decl;
+        if (!decl || !decl->is_scalar_ptr)
+        {
+            continue;
+        }
+        cg_ensure_symbol(v, decl);
+        codebuilder_build_aload(v->builder, decl->index);
+        codebuilder_build_dup(v->builder);
+        cg_emit_ptr_get_base(v, decl->type);
+        codebuilder_build_swap(v->builder);
+        cg_emit_ptr_get_offset(v, decl->type);
+        emit_store_pair(v, decl);
+    }
+}
+
+void cg_scalar_ptr_condition_base(CodegenVisitor *v, Expression *cond)
+{
+    if (scalar_ident(cond))
+    {
+        return;
+    }
+    cg_emit_ptr_get_base(v, cond->type);
+}
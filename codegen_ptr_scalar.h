@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ast.h"
+
+typedef struct CodegenVisitor_tag CodegenVisitor;
+typedef struct CB_Label_tag CB_Label;
+
+/*
+ * Scalar replacement of pointer locals
+ *
+ * Pointer locals and parameters with a primitive pointee whose wrapper object
+ * is rarely needed are kept in two JVM locals (base array, int offset).
+ * Dereference/subscript become a plain Xaload/Xastore and p++ becomes iinc;
+ * a wrapper is only materialized where the pointer value escapes.
+ */
+
+/* Decide which pointers of func are scalar-replaced (sets Declaration.is_scalar_ptr) */
+void cg_scalar_ptr_analyze(CodegenVisitor *v, FunctionDeclaration *func);
+
+/* Split scalar-replaced parameters into their (base, offset) locals at function entry */
+void cg_scalar_ptr_split_params(CodegenVisitor *v, FunctionDeclaration *func);
+
+/* Emit expr if it is a scalar-replaced pointer pattern.
+ * Returns false when the regular visitor should handle it. */
+bool cg_scalar_ptr_emit_expr(CodegenVisitor *v, Expression *expr);
+
+/* Emit the declaration (and initializer) of a scalar-replaced pointer local */
+void cg_scalar_ptr_emit_decl(CodegenVisitor *v, Declaration *decl);
+
+/* Emit a scalar-replaced pointer comparison as a branch to target taken when
+ * its result equals jump_if. Returns false for other expressions. */
+bool cg_scalar_ptr_compare_branch(CodegenVisitor *v, Expression *expr, bool jump_if, CB_Label *target);
+
+/* Emit null test operand of a pointer condition: (cond value) -> base array.
+ * A bare scalar-replaced pointer already pushed its base array. */
+void cg_scalar_ptr_condition_base(CodegenVisitor *v, Expression *cond);
@@ -9,51 +9,75 @@
 #include "codegenvisitor.h"
 #include "codegen_symbols.h"
 #include "codegen_jvm_types.h"
+#include "synthetic_codegen.h"
 
-static bool is_global_declaration(CodegenVisitor *v, Declaration *decl)
+/* The entry symbol_slots names is only trusted when it belongs to decl:
+ * slots are left over from earlier functions and are never reset */
+static CodegenSymbol *lookup_symbol(CodegenVisitor *v, Declaration *decl)
 {
-    for (DeclarationList *d = v->compiler->decl_list; d; d = d->next)
+    if (decl->id >= v->ctx.symbol_slot_capacity)
     {
-        if (d->decl == decl)
-        {
-            return true;
-        }
+        return NULL;
     }
-    return false;
-}
-
-static CodegenSymbol *lookup_symbol(CodegenVisitor *v, Declaration *decl)
-{
-    for (CodegenSymbol *sym = v->ctx.symbol_stack; sym;
-         sym = sym->next)
+    int slot = v->ctx.symbol_slots[decl->id];
+    if (slot > 0 && slot <= v->ctx.symbol_count && v->ctx.symbols[slot - 1]->decl == decl)
     {
-        if (sym->decl == decl)
-        {
-            return sym;
-        }
+        return v->ctx.symbols[slot - 1];
     }
     return NULL;
 }
 
-static void pop_symbols_to(CodegenVisitor *v, CodegenSymbol *target)
+static void set_symbol_slot(CodegenVisitor *v, Declaration *decl, int slot)
 {
-    while (v->ctx.symbol_stack != target)
+    if (decl->id >= v->ctx.symbol_slot_capacity)
     {
-        CodegenSymbol *sym = v->ctx.symbol_stack;
-        v->ctx.symbol_stack = sym->next;
-        free(sym);
+        int capacity = v->ctx.symbol_slot_capacity ? v->ctx.symbol_slot_capacity : 256;
+        while (capacity <= decl->id)
+        {
+            capacity *= 2;
+        }
+        int *slots = (int *)calloc(capacity, sizeof(int));
+        for (int i = 0; i < v->ctx.symbol_slot_capacity; ++i)
+        {
+            slots[i] = v->ctx.symbol_slots[i];
+        }
+        if (v->ctx.symbol_slots)
+        {
+            free(v->ctx.symbol_slots);
+        }
+        v->ctx.symbol_slots = slots;
+        v->ctx.symbol_slot_capacity = capacity;
     }
+    v->ctx.symbol_slots[decl->id] = slot;
 }
 
 static CodegenSymbol *push_symbol(CodegenVisitor *v, Declaration *decl,
                                   CodegenSymbolKind kind, int index)
 {
+    if (v->ctx.symbol_count == v->ctx.symbol_capacity)
+    {
+        int capacity = v->ctx.symbol_capacity ? v->ctx.symbol_capacity * 2 : 32;
+        CodegenSymbol **symbols = (CodegenSymbol **)calloc(capacity, sizeof(CodegenSymbol *));
+        for (int i = 0; i < v->ctx.symbol_count; ++i)
+        {
+            symbols[i] = v->ctx.symbols[i];
+        }
+        if (v->ctx.symbols)
+        {
+            free(v->ctx.symbols);
+        }
+        v->ctx.symbols = symbols;
+        v->ctx.symbol_capacity = capacity;
+    }
+
     CodegenSymbol *sym = (CodegenSymbol *)calloc(1, sizeof(CodegenSymbol));
     sym->decl = decl;
     sym->kind = kind;
     sym->index = index;
-    sym->next = v->ctx.symbol_stack;
-    v->ctx.symbol_stack = sym;
+    sym->offset_index = -1;
+    v->ctx.symbols[v->ctx.symbol_count] = sym;
+    v->ctx.symbol_count = v->ctx.symbol_count + 1;
+    set_symbol_slot(v, decl, v->ctx.symbol_count);
     return sym;
 }
 
@@ -73,11 +97,29 @@ static CodegenSymbol *ensure_symbol_internal(CodegenVisitor *v, Declaration *dec
         return push_symbol(v, decl, CG_SYMBOL_STATIC, decl->index);
     }
 
-    if (is_global_declaration(v, decl))
+    if (decl->is_file_scope)
     {
         return push_symbol(v, decl, CG_SYMBOL_STATIC, decl->index);
     }
 
+    /* Scalar-replaced pointers live in a (base array, int offset) local pair.
+     * A parameter keeps its own slot for the incoming wrapper; the pair is
+     * filled from it at function entry. */
+    if (decl->is_scalar_ptr)
+    {
+        if (decl->index >= 0)
+        {
+            codebuilder_set_param(v->builder, decl->index, cb_type_from_c_type(decl->type));
+        }
+        PtrTypeIndex ptr_idx = (PtrTypeIndex)cg_pointer_runtime_kind(decl->type);
+        const char *base_desc = ptr_type_base_descriptor(ptr_idx);
+        int base_idx = codebuilder_allocate_local(v->builder, cb_type_object(base_desc));
+        int offset_idx = codebuilder_allocate_local(v->builder, cb_type_int());
+        CodegenSymbol *sym = push_symbol(v, decl, CG_SYMBOL_LOCAL, base_idx);
+        sym->offset_index = offset_idx;
+        return sym;
+    }
+
     /* Parameters have pre-assigned indices */
     if (decl->index >= 0)
     {
@@ -126,14 +168,24 @@ static CodegenSymbol *ensure_symbol_internal(CodegenVisitor *v, Declaration *dec
 CodegenSymbolInfo cg_ensure_symbol(CodegenVisitor *v, Declaration *decl)
 {
     CodegenSymbol *sym = ensure_symbol_internal(v, decl);
-    CodegenSymbolInfo info = {sym->kind, sym->index};
+    CodegenSymbolInfo info = {sym->kind, sym->index, sym->offset_index};
     return info;
 }
 
+void cg_bind_symbol(CodegenVisitor *v, Declaration *decl, CodegenSymbolKind kind,
+                    int index, int offset_index)
+{
+    CodegenSymbol *sym = push_symbol(v, decl, kind, index);
+    sym->offset_index = offset_index;
+}
+
 void cg_clear_symbols(CodegenVisitor *v)
 {
-    pop_symbols_to(v, NULL);
-    v->ctx.symbol_stack = NULL;
+    for (int i = 0; i < v->ctx.symbol_count; ++i)
+    {
+        free(v->ctx.symbols[i]);
+    }
+    v->ctx.symbol_count = 0;
 }
 
 void cg_begin_scope(CodegenVisitor *v, bool track_symbols)
@@ -14,16 +14,20 @@ typedef struct CodegenSymbol_tag
     Declaration *decl;
     CodegenSymbolKind kind;
     int index;
-    struct CodegenSymbol_tag *next;
+    int offset_index; /* Scalar-replaced pointer: offset slot (index holds the base array) */
 } CodegenSymbol;
 
 typedef struct CodegenSymbolInfo_tag
 {
     CodegenSymbolKind kind;
     int index;
+    int offset_index;
 } CodegenSymbolInfo;
 
 CodegenSymbolInfo cg_ensure_symbol(CodegenVisitor *v, Declaration *decl);
+/* Map decl to slots the caller already set up (e.g. outlined helper parameters) */
+void cg_bind_symbol(CodegenVisitor *v, Declaration *decl, CodegenSymbolKind kind,
+                    int index, int offset_index);
 void cg_begin_scope(CodegenVisitor *v, bool track_symbols);
 void cg_end_scope(CodegenVisitor *v, const char *context);
 void cg_clear_symbols(CodegenVisitor *v);
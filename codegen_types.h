@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cminor_type.h"
+#include "name_map.h"
 
 /* Forward declaration */
 typedef struct Declaration_tag Declaration;
@@ -16,6 +17,14 @@ typedef struct CG_StaticField
     TypeSpecifier *type_spec;
 } CG_StaticField;
 
+/* Pooled string literal: a private static byte[] field holding the
+ * null-terminated bytes of one distinct literal, filled in <clinit> */
+typedef struct CG_StringLiteral
+{
+    int string_index; /* CONSTANT_String index of the literal text */
+    char *field_name;
+} CG_StringLiteral;
+
 /* Class field definition for codegen */
 typedef struct CG_ClassField
 {
@@ -29,4 +38,5 @@ typedef struct CG_ClassDef
     char *name;
     CG_ClassField *fields;
     int field_count;
+    NameMap *field_map; /* Field name -> fields position (rank) */
 } CG_ClassDef;
@@ -19,6 +19,8 @@
 #include "codegen_constants.h"
 #include "codegen_symbols.h"
 #include "codegen_jvm_types.h"
+#include "codegen_ptr_scalar.h"
+#include "codegen_outline.h"
 #include "codegenvisitor.h"
 #include "codebuilder_ptr.h"
 #include "codebuilder_control.h"
@@ -27,6 +29,7 @@
 #include "cminor_type.h"
 #include "parsed_type.h"
 #include "synthetic_codegen.h"
+#include "peephole.h"
 
 static void ensure_static_capacity(CodegenVisitor *v, int need)
 {
@@ -70,6 +73,14 @@ static void ensure_function_capacity(CodegenVisitor *v, int need)
     v->function_capacity = new_cap;
 }
 
+CS_Function *codegen_add_function_entry(CodegenVisitor *v)
+{
+    ensure_function_capacity(v, 1);
+    CS_Function *info = &v->functions[v->function_count++];
+    info->constant_pool_index = -1;
+    return info;
+}
+
 static void register_static_fields(CodegenVisitor *v)
 {
     DeclarationList *decls = v->compiler->decl_list;
@@ -146,6 +157,7 @@ static bool register_single_struct_def(CodegenVisitor *v, StructDefinition *def)
     ensure_class_def_capacity(v, 1);
     CG_ClassDef *cd = &v->class_defs[v->class_def_count++];
     cd->name = strdup(name);
+    name_map_offer(v->class_def_map, cd->name, cd->name, v->class_def_count - 1, false);
 
     /* Check if this is a union with special handling */
     if (def->is_union)
@@ -206,6 +218,12 @@ static bool register_single_struct_def(CodegenVisitor *v, StructDefinition *def)
             cd->fields = NULL;
         }
     }
+
+    cd->field_map = name_map_create();
+    for (int i = 0; i < cd->field_count; ++i)
+    {
+        name_map_offer(cd->field_map, cd->fields[i].name, cd->fields[i].name, i, false);
+    }
     return true;
 }
 
@@ -256,11 +274,37 @@ static bool is_java_intrinsic_function(FunctionDeclaration *func)
            find_attribute(func->attributes, CS_ATTRIBUTE_AALOAD) != NULL;
 }
 
+/* Grow a table indexed by constant pool index so that it covers index */
+static int *grow_pool_index_table(int *table, int *capacity, int index)
+{
+    int new_cap = *capacity ? *capacity * 2 : 64;
+    while (new_cap <= index)
+    {
+        new_cap *= 2;
+    }
+    int *grown = (int *)calloc(new_cap, sizeof(int));
+    for (int i = 0; i < *capacity; i++)
+    {
+        grown[i] = table[i];
+    }
+    if (table)
+    {
+        free(table);
+    }
+    *capacity = new_cap;
+    return grown;
+}
+
 static void register_functions(CodegenVisitor *v)
 {
     if (!v->compiler->current_file_decl)
         return;
 
+    /* Function-table entry + 1 by Methodref index: definitions that share a
+     * method share its entry */
+    int *entry_by_index = NULL;
+    int entry_capacity = 0;
+
     FunctionDeclarationList *funcs = v->compiler->current_file_decl->functions;
     while (funcs)
     {
@@ -301,21 +345,20 @@ static void register_functions(CodegenVisitor *v)
             int idx = cg_add_method(v, func);
             func->index = (int)idx;
 
-            CS_Function *info = NULL;
-            for (int i = 0; i < v->function_count; ++i)
+            if (idx >= entry_capacity)
             {
-                if (v->functions[i].constant_pool_index == (int32_t)idx)
-                {
-                    info = &v->functions[i];
-                    break;
-                }
+                entry_by_index = grow_pool_index_table(entry_by_index, &entry_capacity, idx);
             }
-            if (!info)
+            int entry = entry_by_index[idx] - 1;
+            if (entry < 0)
             {
                 ensure_function_capacity(v, 1);
-                info = &v->functions[v->function_count++];
-                info->constant_pool_index = (int32_t)idx;
+                entry = v->function_count++;
+                v->functions[entry].constant_pool_index = (int32_t)idx;
+                entry_by_index[idx] = entry + 1;
             }
+            func->function_entry = entry;
+            CS_Function *info = &v->functions[entry];
             info->name = strdup(resolve_function_name(func));
             info->decl = func;
             info->arg_count = argc;
@@ -339,6 +382,10 @@ static void register_functions(CodegenVisitor *v)
         }
         funcs = funcs->next;
     }
+    if (entry_by_index)
+    {
+        free(entry_by_index);
+    }
 }
 
 static void ensure_bytecode_capacity(CodegenVisitor *v)
@@ -456,6 +503,8 @@ void codegen_begin_function(CodegenVisitor *v, FunctionDeclaration *func)
     v->ctx.switch_depth = 0;
     cg_clear_symbols(v);
     v->ctx.has_return = false;
+    v->ctx.stmt_expr = NULL;
+    v->ctx.truth_expr = NULL;
     v->bytecode_count = 0;
     v->has_last_bytecode = false;
 
@@ -576,6 +625,10 @@ void codegen_begin_function(CodegenVisitor *v, FunctionDeclaration *func)
             decl->index = new_slot;
         }
     }
+
+    /* Keep pointers that rarely escape as (base, offset) local pairs */
+    cg_scalar_ptr_analyze(v, func);
+    cg_scalar_ptr_split_params(v, func);
 }
 
 void codegen_finish_function(CodegenVisitor *v)
@@ -668,6 +721,12 @@ void codegen_finish_function(CodegenVisitor *v)
     /* Resolve any pending jumps from Label API */
     codebuilder_resolve_jumps(v->builder);
 
+    /* Rewrite the resolved code before its frames are generated */
+    if (v->peephole_enabled)
+    {
+        v->peephole_bytes_removed += peephole_optimize(v);
+    }
+
     /* Generate StackMapTable frames from CodeBuilder's branch targets */
     int frame_count = 0;
     v->temp_stack_map_frames = codebuilder_generate_stackmap(v->builder, v->stackmap_cp,
@@ -697,7 +756,12 @@ CodegenVisitor *create_codegen_visitor(CS_Compiler *compiler, CS_Executable *exe
     visitor->ctx.scope_depth = 0;
     visitor->builder = codebuilder_create(code_output_cp(visitor->output), code_output_method(visitor->output),
                                           true, NULL, NULL, NULL);
-    visitor->ctx.symbol_stack = NULL;
+    visitor->class_def_map = name_map_create();
+    visitor->ctx.symbols = NULL;
+    visitor->ctx.symbol_count = 0;
+    visitor->ctx.symbol_capacity = 0;
+    visitor->ctx.symbol_slots = NULL;
+    visitor->ctx.symbol_slot_capacity = 0;
     visitor->ctx.if_stack = NULL;
     visitor->ctx.if_depth = 0;
     visitor->ctx.if_capacity = 0;
@@ -714,6 +778,13 @@ CodegenVisitor *create_codegen_visitor(CS_Compiler *compiler, CS_Executable *exe
     visitor->bytecode_capacity = 0;
     visitor->last_bytecode_index = 0;
     visitor->has_last_bytecode = false;
+    visitor->peephole_enabled = !compiler->ctx || !compiler->ctx->no_peephole;
+    visitor->peephole_bytes_removed = 0;
+    visitor->method_limit = codegen_outline_method_limit(compiler->ctx);
+    visitor->outline_regions = NULL;
+    visitor->outline_region_count = 0;
+    visitor->outline_region_capacity = 0;
+    visitor->outline_current = 0;
 
     /* StackMapTable constant pool (merged into final classfile later) */
     visitor->stackmap_cp = cf_cp_create();
@@ -1065,6 +1136,10 @@ void codegen_traverse_expr(Expression *expr, CodegenVisitor *cg)
 {
     if (expr)
     {
+        if (cg_scalar_ptr_emit_expr(cg, expr))
+        {
+            return;
+        }
         codegen_enter_expr(expr, cg);
         codegen_traverse_expr_children(expr, cg);
         codegen_leave_expr(expr, cg);
@@ -1171,12 +1246,18 @@ static void codegen_traverse_stmt_children(Statement *stmt, CodegenVisitor *cg)
     {
     case EXPRESSION_STATEMENT:
         /* Reachability is checked at codegen_traverse_stmt level */
+        cg->ctx.stmt_expr = stmt->u.expression_s;
         codegen_traverse_expr(stmt->u.expression_s, cg);
         break;
     case DECLARATION_STATEMENT:
     {
         /* Reachability is checked at codegen_traverse_stmt level */
         Declaration *decl = stmt->u.declaration_s;
+        if (decl && decl->is_scalar_ptr)
+        {
+            /* Initializer is emitted as a (base, offset) pair by leave_declstmt */
+            break;
+        }
         if (decl && decl->type && cs_type_is_array(decl->type))
         {
             for (TypeSpecifier *t = decl->type; t && cs_type_is_array(t); t = cs_type_child(t))
@@ -1204,7 +1285,7 @@ static void codegen_traverse_stmt_children(Statement *stmt, CodegenVisitor *cg)
         /* Only evaluate condition if reachable */
         if (cg->builder->alive)
         {
-            codegen_traverse_expr(stmt->u.if_s.condition, cg);
+            handle_if_condition(cg, stmt);
         }
         codegen_traverse_stmt(stmt->u.if_s.then_statement, cg);
         codegen_traverse_stmt(stmt->u.if_s.else_statement, cg);
@@ -1213,7 +1294,7 @@ static void codegen_traverse_stmt_children(Statement *stmt, CodegenVisitor *cg)
         /* Only evaluate condition if reachable */
         if (cg->builder->alive)
         {
-            codegen_traverse_expr(stmt->u.while_s.condition, cg);
+            handle_loop_condition(cg, stmt->u.while_s.condition);
         }
         codegen_traverse_stmt(stmt->u.while_s.body, cg);
         break;
@@ -1223,7 +1304,7 @@ static void codegen_traverse_stmt_children(Statement *stmt, CodegenVisitor *cg)
         if (cg->builder->alive)
         {
             codebuilder_do_while_cond(cg->builder);
-            codegen_traverse_expr(stmt->u.do_s.condition, cg);
+            handle_loop_condition(cg, stmt->u.do_s.condition);
         }
         break;
     case FOR_STATEMENT:
@@ -1231,11 +1312,10 @@ static void codegen_traverse_stmt_children(Statement *stmt, CodegenVisitor *cg)
         if (cg->builder->alive)
         {
             codegen_traverse_stmt(stmt->u.for_s.init, cg);
-            codegen_traverse_expr(stmt->u.for_s.condition, cg);
-            /* If body is NULL (empty for loop like "for(...);"), we still need to
-             * generate the condition branch. handle_for_body_entry is normally
-             * called when entering the body statement, but with NULL body it's
-             * never called, leaving the condition value on the stack. */
+            handle_loop_condition(cg, stmt->u.for_s.condition);
+            /* If body is NULL (empty for loop like "for(...);"), body_label is
+             * still placed here. handle_for_body_entry is normally called when
+             * entering the body statement, but with NULL body it's never called. */
             if (!stmt->u.for_s.body)
             {
                 handle_for_body_entry(cg, NULL);
@@ -1283,6 +1363,30 @@ void codegen_traverse_stmt(Statement *stmt, CodegenVisitor *cg)
         return;
     }
 
+    MethodCode *mc = code_output_method(cg->output);
+    int start_pc = method_code_size(mc);
+
+    /* Statements outlined into a helper method: the region's call site
+     * invokes the helper, its other statements generate nothing here.  The
+     * enclosing if/loop/switch labels at its boundary are still placed. */
+    if (stmt->outline_id != 0 && stmt->outline_id != cg->outline_current)
+    {
+        handle_if_boundary(cg, stmt);
+        handle_for_body_entry(cg, stmt);
+        handle_switch_entry(cg, stmt);
+        if (codebuilder_is_alive(cg->builder) && codegen_outline_is_call_site(cg, stmt))
+        {
+            if (stmt->line_number > 0)
+            {
+                method_code_add_line_number(mc, stmt->line_number);
+            }
+            codegen_outline_emit_call(cg, stmt->outline_id);
+        }
+        stmt->code_size = method_code_size(mc) - start_pc;
+        return;
+    }
+    stmt->code_size = 0;
+
     /*
      * Javac-style reachability gate:
      * Skip code generation for unreachable statements, EXCEPT for:
@@ -1316,10 +1420,13 @@ void codegen_traverse_stmt(Statement *stmt, CodegenVisitor *cg)
     /* Record line number for debugging (LineNumberTable) */
     if (stmt->line_number > 0 && codebuilder_is_alive(cg->builder))
     {
-        method_code_add_line_number(code_output_method(cg->output), stmt->line_number);
+        method_code_add_line_number(mc, stmt->line_number);
     }
 
     codegen_enter_stmt(stmt, cg);
     codegen_traverse_stmt_children(stmt, cg);
     codegen_leave_stmt(stmt, cg);
+
+    /* Sizes of the last generation drive codegen_outline_plan() */
+    stmt->code_size = method_code_size(mc) - start_pc;
 }
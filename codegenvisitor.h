@@ -14,6 +14,7 @@ typedef struct CodegenIfContext_tag CodegenIfContext;
 typedef struct CodegenForContext_tag CodegenForContext;
 typedef struct CodegenSwitchContext_tag CodegenSwitchContext;
 typedef struct CodegenSymbol_tag CodegenSymbol;
+typedef struct CG_OutlineRegion_tag CG_OutlineRegion;
 
 /* Note: Local variable slot management is delegated to CodeBuilder
  * using codebuilder_begin_block/end_block for block-level scoping.
@@ -27,7 +28,14 @@ typedef struct CodegenContext_tag
 {
     int scope_depth; /* Block nesting depth (for underflow checks) */
 
-    CodegenSymbol *symbol_stack; /* Declaration -> slot mapping (persists for entire function) */
+    /* Declaration -> slot mapping (persists for entire function) */
+    CodegenSymbol **symbols;
+    int symbol_count;
+    int symbol_capacity;
+
+    /* Declaration id -> 1-based entry in symbols of its latest binding */
+    int *symbol_slots;
+    int symbol_slot_capacity;
 
     CodegenIfContext *if_stack;
     int if_depth;
@@ -51,6 +59,8 @@ typedef struct CodegenContext_tag
     bool assign_is_simple;
     struct Expression_tag *addr_target; /* Target of ADDRESS_EXPRESSION (&) */
     struct Expression_tag *inc_target;  /* Target of INCREMENT/DECREMENT */
+    struct Expression_tag *stmt_expr;   /* Root of current expression statement (value unused) */
+    struct Expression_tag *truth_expr;  /* Operand of &&, || or ?: tested only against zero */
     int flatten_init_depth;
 
     /* Label registry for goto/label support (function-scoped) */
@@ -118,9 +128,18 @@ struct CodegenVisitor_tag
     int static_field_count;
     int static_field_capacity;
 
+    /* String literal pool; string_literal_slots maps a CONSTANT_String
+     * index to its literal index + 1 (0 = not pooled yet) */
+    CG_StringLiteral *string_literals;
+    int string_literal_count;
+    int string_literal_capacity;
+    int *string_literal_slots;
+    int string_literal_slot_capacity;
+
     CG_ClassDef *class_defs;
     int class_def_count;
     int class_def_capacity;
+    NameMap *class_def_map; /* Class name -> class_defs position (rank) */
 
     CS_Function *functions;
     int function_count;
@@ -134,6 +153,17 @@ struct CodegenVisitor_tag
 
     CodegenContext ctx;
     CodeBuilder *builder;
+    bool peephole_enabled;      /* Run peephole_optimize() on each method */
+    int peephole_bytes_removed; /* Code bytes removed in this class */
+    int scalar_ptr_count; /* Scalar-replaced pointers in current function */
+
+    /* Method outlining (see codegen_outline.h) */
+    int method_limit;                  /* Largest method body to emit, in bytes */
+    CG_OutlineRegion *outline_regions; /* Region id N is outline_regions[N - 1] */
+    int outline_region_count;
+    int outline_region_capacity;
+    int outline_current; /* Region being generated (0 = a C function) */
+
     const char *current_class_name; /* For StackMap object types */
     CF_ConstantPool *stackmap_cp;   /* Constant pool used while building StackMapTable */
 
@@ -147,6 +177,7 @@ CodegenVisitor *create_codegen_visitor(CS_Compiler *compiler,
                                        const char *class_name);
 void codegen_begin_function(CodegenVisitor *v, FunctionDeclaration *func);
 void codegen_finish_function(CodegenVisitor *v);
+CS_Function *codegen_add_function_entry(CodegenVisitor *v);
 void cg_record_bytecode(CodegenVisitor *v, CF_Opcode opcode, int pc, int length);
 
 /* Switch-based AST traversal (replaces function pointer dispatch) */
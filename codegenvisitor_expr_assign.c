@@ -861,8 +861,8 @@ void leave_assignexpr(Expression *expr, Visitor *visitor)
                 if (decl->needs_heap_lift && sym.kind != CG_SYMBOL_STATIC)
                 {
                     /* Heap-lifted pointer: boxed in Object[] array.
-                     * Load box, load box[0], add int, store back to box[0]. */
-                    codebuilder_build_aload(cg->builder, sym.index);
+                     * The box was loaded as the assignment target; load box[0],
+                     * add int, store back to box[0]. */
                     /* Stack: [box] */
                     codebuilder_build_dup(cg->builder);
                     /* Stack: [box, box] */
@@ -941,6 +941,14 @@ void leave_assignexpr(Expression *expr, Visitor *visitor)
                 return;
             }
 
+            /* Heap-lifted scalar: the box was loaded as the assignment target,
+             * so the current value is box[0] rather than a local. */
+            bool boxed = decl->needs_heap_lift && sym.kind != CG_SYMBOL_STATIC;
+            if (boxed)
+            {
+                tag = cg_to_value_tag(decl->type);
+            }
+
             /* Save the new value to a temp local */
             int value_local = allocate_temp_local_for_tag(cg, tag);
             switch (tag)
@@ -968,6 +976,13 @@ void leave_assignexpr(Expression *expr, Visitor *visitor)
                 int pool_idx = cg_find_or_add_field(cg, decl);
                 codebuilder_build_getstatic(cg->builder, pool_idx);
             }
+            else if (boxed)
+            {
+                /* Stack: [box] -> [box, 0, value] */
+                codebuilder_build_iconst(cg->builder, 0);
+                codebuilder_build_dup2(cg->builder);
+                cg_emit_array_load_for_type(cg, decl->type);
+            }
             else
             {
                 switch (tag)
@@ -1097,6 +1112,14 @@ void leave_assignexpr(Expression *expr, Visitor *visitor)
             }
 
             /* Duplicate result for expression value, then store */
+            if (boxed)
+            {
+                /* Stack: [box, 0, result] -> [result, box, 0, result] */
+                codebuilder_build_dup_value_x2(cg->builder);
+                cg_emit_array_store_for_type(cg, decl->type);
+                handle_for_expression_leave(cg, expr);
+                return;
+            }
             codebuilder_build_dup_value(cg->builder);
 
             if (sym.kind == CG_SYMBOL_STATIC)
@@ -1173,11 +1196,11 @@ void leave_assignexpr(Expression *expr, Visitor *visitor)
                 /* Stack: [value, array_ref, 0, value] */
             }
 
-            /* Now store into array[0] */
+            /* Now store into array[0] (char/short/bool boxes are [B/[S/[Z) */
             switch (actual_tag)
             {
             case CF_VAL_INT:
-                codebuilder_build_iastore(cg->builder);
+                cg_emit_array_store_for_type(cg, decl->type);
                 break;
             case CF_VAL_LONG:
                 codebuilder_build_lastore(cg->builder);
@@ -1449,6 +1472,74 @@ void leave_incexpr(Expression *expr, Visitor *visitor)
             codebuilder_build_aastore(cg->builder);
             /* Stack: [result] */
         }
+        else if (decl->needs_heap_lift)
+        {
+            /* Heap-lifted scalar: boxed in a 1-element primitive array.
+             *   aload box; iconst 0; dup2   -> [box, 0, box, 0]
+             *   xaload                      -> [box, 0, val]
+             *   (postfix: dup_x2            -> [val, box, 0, val])
+             *   const 1; add/sub            -> [..., box, 0, new]
+             *   (prefix: dup_x2             -> [new, box, 0, new])
+             *   xastore                     -> [result]
+             */
+            codebuilder_build_aload(cg->builder, sym.index);
+            codebuilder_build_iconst(cg->builder, 0);
+            codebuilder_build_dup2(cg->builder);
+            cg_emit_array_load_for_type(cg, decl_type);
+            /* Stack: [box, 0, val] */
+
+            if (!is_prefix)
+            {
+                codebuilder_build_dup_value_x2(cg->builder);
+            }
+
+            if (cs_type_is_double_exact(decl_type))
+            {
+                codebuilder_build_dconst(cg->builder, 1.0);
+                if (is_decrement)
+                    codebuilder_build_dsub(cg->builder);
+                else
+                    codebuilder_build_dadd(cg->builder);
+            }
+            else if (cs_type_is_float_exact(decl_type))
+            {
+                codebuilder_build_fconst(cg->builder, 1.0f);
+                if (is_decrement)
+                    codebuilder_build_fsub(cg->builder);
+                else
+                    codebuilder_build_fadd(cg->builder);
+            }
+            else if (cs_type_is_long_exact(decl_type))
+            {
+                codebuilder_build_lconst(cg->builder, 1);
+                if (is_decrement)
+                    codebuilder_build_lsub(cg->builder);
+                else
+                    codebuilder_build_ladd(cg->builder);
+            }
+            else if (cs_type_is_integral(decl_type) || cs_type_is_bool(decl_type))
+            {
+                codebuilder_build_iconst(cg->builder, 1);
+                if (is_decrement)
+                    codebuilder_build_isub(cg->builder);
+                else
+                    codebuilder_build_iadd(cg->builder);
+            }
+            else
+            {
+                fprintf(stderr, "unsupported increment operand type: kind=%d, decl=%s\n", cs_type_kind(decl_type), decl->name ? decl->name : "(null)");
+                exit(1);
+            }
+            /* Stack: postfix=[val, box, 0, new], prefix=[box, 0, new] */
+
+            if (is_prefix)
+            {
+                codebuilder_build_dup_value_x2(cg->builder);
+            }
+
+            cg_emit_array_store_for_type(cg, decl_type);
+            /* Stack: [result] */
+        }
         else
         {
             /* Load current value */
@@ -59,7 +59,6 @@ void leave_initializerlistexpr(Expression *expr, Visitor *visitor)
                 init_list->expression->kind == DESIGNATED_INITIALIZER_EXPRESSION)
             {
                 int class_idx = find_class_index(cg, struct_name);
-                CG_ClassDef *class_def = &cg->class_defs[class_idx];
                 field_indices = (int *)calloc(init_count, sizeof(int));
                 int idx = 0;
                 for (ExpressionList *p = init_list; p; p = p->next, idx++)
@@ -68,14 +67,10 @@ void leave_initializerlistexpr(Expression *expr, Visitor *visitor)
                     if (di && di->kind == DESIGNATED_INITIALIZER_EXPRESSION)
                     {
                         const char *fname = di->u.designated_initializer.field_name;
-                        for (int fi = 0; fi < class_def->field_count; fi++)
+                        int field_idx = find_field_index(cg, class_idx, fname);
+                        if (field_idx >= 0)
                         {
-                            if (class_def->fields[fi].name && fname &&
-                                strcmp(class_def->fields[fi].name, fname) == 0)
-                            {
-                                field_indices[idx] = (int)fi;
-                                break;
-                            }
+                            field_indices[idx] = field_idx;
                         }
                     }
                     else
@@ -255,7 +250,6 @@ void leave_initializerlistexpr(Expression *expr, Visitor *visitor)
             fprintf(stderr, "error: struct class not found: %s\n", struct_name);
             exit(1);
         }
-        CG_ClassDef *class_def = &cg->class_defs[class_idx];
 
         /* Create outer array: ANEWARRAY for struct array */
         int length = declared_length ? declared_length : value_count;
@@ -297,14 +291,10 @@ void leave_initializerlistexpr(Expression *expr, Visitor *visitor)
                         if (di && di->kind == DESIGNATED_INITIALIZER_EXPRESSION)
                         {
                             const char *fname = di->u.designated_initializer.field_name;
-                            for (int j = 0; j < class_def->field_count; j++)
+                            int field_idx = find_field_index(cg, class_idx, fname);
+                            if (field_idx >= 0)
                             {
-                                if (class_def->fields[j].name && fname &&
-                                    strcmp(class_def->fields[j].name, fname) == 0)
-                                {
-                                    field_indices[fi] = (int)j;
-                                    break;
-                                }
+                                field_indices[fi] = field_idx;
                             }
                         }
                         else
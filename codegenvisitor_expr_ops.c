@@ -8,8 +8,10 @@
 #include "codegenvisitor.h"
 #include "codegenvisitor_expr_ops.h"
 #include "codebuilder_ptr.h"
+#include "codegen_ptr_scalar.h"
 #include "codegenvisitor_util.h"
 #include "codegenvisitor_expr_util.h"
+#include "codebuilder_frame.h"
 #include "codebuilder_label.h"
 #include "codebuilder_part1.h"
 #include "codebuilder_part2.h"
@@ -829,38 +831,59 @@ void leave_logical_not_expr(Expression *expr, Visitor *visitor)
     handle_for_expression_leave(cg, expr);
 }
 
-void leave_compareexpr(Expression *expr, Visitor *visitor)
+/* IfCond tested by a comparison expression */
+static IfCond compare_if_cond(Expression *expr)
 {
-    CodegenVisitor *cg = (CodegenVisitor *)visitor;
-    Expression *left = expr->u.binary_expression.left;
-
-    TypeSpecifier *left_type = left->type;
-    IfCond cond = IF_EQ;
-
     switch (expr->kind)
     {
     case EQ_EXPRESSION:
-        cond = IF_EQ;
-        break;
+        return IF_EQ;
     case NE_EXPRESSION:
-        cond = IF_NE;
-        break;
+        return IF_NE;
     case LT_EXPRESSION:
-        cond = IF_LT;
-        break;
+        return IF_LT;
     case LE_EXPRESSION:
-        cond = IF_LE;
-        break;
+        return IF_LE;
     case GT_EXPRESSION:
-        cond = IF_GT;
-        break;
+        return IF_GT;
     case GE_EXPRESSION:
-        cond = IF_GE;
-        break;
+        return IF_GE;
     default:
-        fprintf(stderr, "unsupported comparison operator %d\n", expr->kind);
-        exit(1);
+        break;
     }
+    fprintf(stderr, "unsupported comparison operator %d\n", expr->kind);
+    exit(1);
+}
+
+/* Opposite condition (NaN handling stays with the fcmp/dcmp variant) */
+static IfCond negate_if_cond(IfCond cond)
+{
+    switch (cond)
+    {
+    case IF_EQ:
+        return IF_NE;
+    case IF_NE:
+        return IF_EQ;
+    case IF_LT:
+        return IF_GE;
+    case IF_GE:
+        return IF_LT;
+    case IF_GT:
+        return IF_LE;
+    case IF_LE:
+        return IF_GT;
+    }
+    fprintf(stderr, "invalid IfCond for negation: %d\n", cond);
+    exit(1);
+}
+
+void leave_compareexpr(Expression *expr, Visitor *visitor)
+{
+    CodegenVisitor *cg = (CodegenVisitor *)visitor;
+    Expression *left = expr->u.binary_expression.left;
+
+    TypeSpecifier *left_type = left->type;
+    IfCond cond = compare_if_cond(expr);
 
     if (cs_type_is_double_exact(left_type))
     {
@@ -1025,130 +1048,236 @@ void leave_compareexpr(Expression *expr, Visitor *visitor)
     handle_for_expression_leave(cg, expr);
 }
 
-void leave_conditionalexpr(Expression *expr, Visitor *visitor)
+/* Branch to target when the truth value of cond equals jump_if.
+ * Pointers test their .base field, arrays the reference, everything else != 0. */
+static void emit_truth_branch(CodegenVisitor *cg, Expression *cond, bool jump_if, CB_Label *target)
 {
-    CodegenVisitor *cg = (CodegenVisitor *)visitor;
-
-    Expression *condition = expr->u.conditional_expression.condition;
-    Expression *true_expr = expr->u.conditional_expression.true_expr;
-    Expression *false_expr = expr->u.conditional_expression.false_expr;
+    TypeSpecifier *cond_type = cond->type;
 
-    /* Create labels for control flow */
-    CB_Label *false_label = codebuilder_create_label(cg->builder);
-    CB_Label *end_label = codebuilder_create_label(cg->builder);
-
-    /* Evaluate condition */
-    codegen_traverse_expr(condition, cg);
+    cg->ctx.truth_expr = cond;
+    codegen_traverse_expr(cond, cg);
 
-    /* Jump to false_label based on condition type:
-     * - bool/int: ifeq (if value == 0)
-     * - pointer: check .base field is null
-     * - array: ifnull (if reference == null) */
-    TypeSpecifier *cond_type = condition->type;
-    if (cs_type_is_pointer(cond_type))
+    if (cs_type_is_pointer(cond_type) || cs_type_is_array(cond_type))
     {
-        if (cs_type_is_void_pointer(cond_type))
+        /* void* is a raw Object reference; other pointers are wrappers */
+        if (cs_type_is_pointer(cond_type) && !cs_type_is_void_pointer(cond_type))
         {
-            /* void* is raw Object reference */
-            codebuilder_jump_if_null(cg->builder, false_label);
+            cg_scalar_ptr_condition_base(cg, cond);
+        }
+        if (jump_if)
+        {
+            codebuilder_jump_if_not_null(cg->builder, target);
         }
         else
         {
-            /* Pointer wrapper: check if .base field is null */
-            cg_emit_ptr_get_base(cg, cond_type);
-            codebuilder_jump_if_null(cg->builder, false_label);
+            codebuilder_jump_if_null(cg->builder, target);
         }
     }
-    else if (cs_type_is_array(cond_type))
-    {
-        codebuilder_jump_if_null(cg->builder, false_label);
-    }
     else
     {
-        codebuilder_jump_if_op(cg->builder, IF_EQ, false_label);
+        codebuilder_jump_if_op(cg->builder, jump_if ? IF_NE : IF_EQ, target);
     }
-
-    /* True branch: evaluate true_expr */
-    codegen_traverse_expr(true_expr, cg);
-
-    /* Jump to end_label */
-    codebuilder_jump(cg->builder, end_label);
-
-    /* False branch */
-    codebuilder_place_label(cg->builder, false_label);
-
-    /* Evaluate false_expr */
-    codegen_traverse_expr(false_expr, cg);
-
-    /* End label */
-    codebuilder_place_label(cg->builder, end_label);
-
-    handle_for_expression_leave(cg, expr);
 }
 
-void leave_logical_and_expr(Expression *expr, Visitor *visitor)
+/* Pointer comparison in condition context. Returns false when the operands
+ * need the value path of leave_compareexpr. */
+static bool emit_pointer_compare_branch(CodegenVisitor *cg, Expression *expr, IfCond cond,
+                                        bool jump_if, CB_Label *target)
 {
-    CodegenVisitor *cg = (CodegenVisitor *)visitor;
-
     Expression *left = expr->u.binary_expression.left;
     Expression *right = expr->u.binary_expression.right;
+    bool left_is_null = (left->kind == NULL_EXPRESSION);
+    bool right_is_null = (right->kind == NULL_EXPRESSION);
 
-    /* Create labels for control flow */
-    CB_Label *false_label = codebuilder_create_label(cg->builder);
-    CB_Label *end_label = codebuilder_create_label(cg->builder);
+    if ((cond == IF_EQ || cond == IF_NE) && left_is_null != right_is_null)
+    {
+        /* p == NULL tests !p, p != NULL tests p */
+        emit_truth_branch(cg, left_is_null ? right : left,
+                          (cond == IF_EQ) ? !jump_if : jump_if, target);
+        return true;
+    }
+    if (cg_scalar_ptr_compare_branch(cg, expr, jump_if, target))
+    {
+        return true;
+    }
+    if (cond == IF_EQ || cond == IF_NE || left_is_null || right_is_null ||
+        !cs_type_is_pointer(left->type) || !cs_type_is_pointer(right->type) ||
+        cs_type_is_void_pointer(left->type) || cs_type_is_void_pointer(right->type))
+    {
+        return false;
+    }
 
-    /* Evaluate left operand */
+    /* Relational comparison: compare .offset fields only (same array assumed) */
     codegen_traverse_expr(left, cg);
+    cg_emit_ptr_get_offset(cg, left->type);
+    codegen_traverse_expr(right, cg);
+    cg_emit_ptr_get_offset(cg, right->type);
+    codebuilder_jump_if_icmp(cg->builder,
+                             if_cond_to_icmp_cond(jump_if ? cond : negate_if_cond(cond)),
+                             target);
+    return true;
+}
 
-    /* If left is 0/null, short-circuit to false */
+/* Comparison in condition context: compare and branch directly.
+ * Returns false when leave_compareexpr must materialize the value. */
+static bool emit_compare_branch(CodegenVisitor *cg, Expression *expr, bool jump_if, CB_Label *target)
+{
+    Expression *left = expr->u.binary_expression.left;
+    Expression *right = expr->u.binary_expression.right;
     TypeSpecifier *left_type = left->type;
-    if (cs_type_is_pointer(left_type))
+    IfCond cond = compare_if_cond(expr);
+    IfCond branch_cond = jump_if ? cond : negate_if_cond(cond);
+
+    if (cs_type_is_pointer(left_type) || cs_type_is_pointer(right->type))
+    {
+        return emit_pointer_compare_branch(cg, expr, cond, jump_if, target);
+    }
+
+    if (cs_type_is_double_exact(left_type))
+    {
+        codegen_traverse_expr(left, cg);
+        codegen_traverse_expr(right, cg);
+        codebuilder_build_dcmp(cg->builder, cond == IF_LT || cond == IF_LE ? CMP_NAN_G : CMP_NAN_L);
+        codebuilder_jump_if_op(cg->builder, branch_cond, target);
+    }
+    else if (cs_type_is_float_exact(left_type))
     {
-        if (cs_type_is_void_pointer(left_type))
+        codegen_traverse_expr(left, cg);
+        codegen_traverse_expr(right, cg);
+        codebuilder_build_fcmp(cg->builder, cond == IF_LT || cond == IF_LE ? CMP_NAN_G : CMP_NAN_L);
+        codebuilder_jump_if_op(cg->builder, branch_cond, target);
+    }
+    else if (cs_type_is_long_exact(left_type))
+    {
+        codegen_traverse_expr(left, cg);
+        codegen_traverse_expr(right, cg);
+        if (cs_type_is_unsigned(left_type))
         {
-            codebuilder_jump_if_null(cg->builder, false_label);
+            emit_unsigned_lcmp(cg);
         }
         else
         {
-            cg_emit_ptr_get_base(cg, left_type);
-            codebuilder_jump_if_null(cg->builder, false_label);
+            codebuilder_build_lcmp(cg->builder);
         }
+        codebuilder_jump_if_op(cg->builder, branch_cond, target);
     }
-    else if (cs_type_is_array(left_type))
+    else if (cs_type_is_int_exact(left_type) || cs_type_is_short_exact(left_type) ||
+             cs_type_is_char_exact(left_type) || cs_type_is_bool(left_type) ||
+             cs_type_is_enum(left_type))
     {
-        codebuilder_jump_if_null(cg->builder, false_label);
+        codegen_traverse_expr(left, cg);
+        codegen_traverse_expr(right, cg);
+        if (cs_type_is_unsigned(left_type))
+        {
+            emit_unsigned_icmp(cg);
+            codebuilder_jump_if_op(cg->builder, branch_cond, target);
+        }
+        else
+        {
+            codebuilder_jump_if_icmp(cg->builder, if_cond_to_icmp_cond(branch_cond), target);
+        }
     }
     else
     {
-        codebuilder_jump_if_op(cg->builder, IF_EQ, false_label);
+        return false;
     }
+    return true;
+}
 
-    /* Evaluate right operand */
-    codegen_traverse_expr(right, cg);
-
-    /* If right is 0/null, short-circuit to false */
-    TypeSpecifier *right_type = right->type;
-    if (cs_type_is_pointer(right_type))
+void codegen_emit_cond_branch(CodegenVisitor *cg, Expression *cond, bool jump_if, CB_Label *target)
+{
+    switch (cond->kind)
     {
-        if (cs_type_is_void_pointer(right_type))
+    case LOGICAL_NOT_EXPRESSION:
+        codegen_emit_cond_branch(cg, cond->u.logical_not_expression, !jump_if, target);
+        return;
+    case LOGICAL_AND_EXPRESSION:
+    case LOGICAL_OR_EXPRESSION:
+    {
+        /* && short-circuits on false, || on true */
+        bool short_value = (cond->kind == LOGICAL_OR_EXPRESSION);
+        Expression *left = cond->u.binary_expression.left;
+        Expression *right = cond->u.binary_expression.right;
+        if (jump_if == short_value)
         {
-            codebuilder_jump_if_null(cg->builder, false_label);
+            /* Either operand alone decides */
+            codegen_emit_cond_branch(cg, left, jump_if, target);
+            codegen_emit_cond_branch(cg, right, jump_if, target);
         }
         else
         {
-            cg_emit_ptr_get_base(cg, right_type);
-            codebuilder_jump_if_null(cg->builder, false_label);
+            /* Left short-circuits past the jump; right decides */
+            CB_Label *skip_label = codebuilder_create_label(cg->builder);
+            codegen_emit_cond_branch(cg, left, short_value, skip_label);
+            codegen_emit_cond_branch(cg, right, jump_if, target);
+            codebuilder_place_label(cg->builder, skip_label);
+            /* Temps allocated by the right operand are not set on the skip path */
+            codebuilder_restore_frame_safe(cg->builder, skip_label->frame);
         }
+        return;
     }
-    else if (cs_type_is_array(right_type))
-    {
-        codebuilder_jump_if_null(cg->builder, false_label);
-    }
-    else
-    {
-        codebuilder_jump_if_op(cg->builder, IF_EQ, false_label);
+    case EQ_EXPRESSION:
+    case NE_EXPRESSION:
+    case LT_EXPRESSION:
+    case LE_EXPRESSION:
+    case GT_EXPRESSION:
+    case GE_EXPRESSION:
+        if (emit_compare_branch(cg, cond, jump_if, target))
+        {
+            return;
+        }
+        break;
+    default:
+        break;
     }
 
+    emit_truth_branch(cg, cond, jump_if, target);
+}
+
+void leave_conditionalexpr(Expression *expr, Visitor *visitor)
+{
+    CodegenVisitor *cg = (CodegenVisitor *)visitor;
+
+    Expression *condition = expr->u.conditional_expression.condition;
+    Expression *true_expr = expr->u.conditional_expression.true_expr;
+    Expression *false_expr = expr->u.conditional_expression.false_expr;
+
+    /* Create labels for control flow */
+    CB_Label *false_label = codebuilder_create_label(cg->builder);
+    CB_Label *end_label = codebuilder_create_label(cg->builder);
+
+    /* Evaluate condition, jumping to false_label when it is false */
+    codegen_emit_cond_branch(cg, condition, false, false_label);
+
+    /* True branch: evaluate true_expr */
+    codegen_traverse_expr(true_expr, cg);
+
+    /* Jump to end_label */
+    codebuilder_jump(cg->builder, end_label);
+
+    /* False branch */
+    codebuilder_place_label(cg->builder, false_label);
+
+    /* Evaluate false_expr */
+    codegen_traverse_expr(false_expr, cg);
+
+    /* End label */
+    codebuilder_place_label(cg->builder, end_label);
+
+    handle_for_expression_leave(cg, expr);
+}
+
+void leave_logical_and_expr(Expression *expr, Visitor *visitor)
+{
+    CodegenVisitor *cg = (CodegenVisitor *)visitor;
+
+    /* Create labels for control flow */
+    CB_Label *false_label = codebuilder_create_label(cg->builder);
+    CB_Label *end_label = codebuilder_create_label(cg->builder);
+
+    /* Short-circuit to false as soon as an operand is 0/null */
+    codegen_emit_cond_branch(cg, expr, false, false_label);
+
     /* Both true, push 1 */
     codebuilder_build_iconst(cg->builder, 1);
     codebuilder_jump(cg->builder, end_label);
@@ -1167,64 +1296,12 @@ void leave_logical_or_expr(Expression *expr, Visitor *visitor)
 {
     CodegenVisitor *cg = (CodegenVisitor *)visitor;
 
-    Expression *left = expr->u.binary_expression.left;
-    Expression *right = expr->u.binary_expression.right;
-
     /* Create labels for control flow */
     CB_Label *true_label = codebuilder_create_label(cg->builder);
     CB_Label *end_label = codebuilder_create_label(cg->builder);
 
-    /* Evaluate left operand */
-    codegen_traverse_expr(left, cg);
-
-    /* If left is non-zero/non-null, short-circuit to true */
-    TypeSpecifier *left_type = left->type;
-    if (cs_type_is_pointer(left_type))
-    {
-        if (cs_type_is_void_pointer(left_type))
-        {
-            codebuilder_jump_if_not_null(cg->builder, true_label);
-        }
-        else
-        {
-            cg_emit_ptr_get_base(cg, left_type);
-            codebuilder_jump_if_not_null(cg->builder, true_label);
-        }
-    }
-    else if (cs_type_is_array(left_type))
-    {
-        codebuilder_jump_if_not_null(cg->builder, true_label);
-    }
-    else
-    {
-        codebuilder_jump_if_op(cg->builder, IF_NE, true_label);
-    }
-
-    /* Evaluate right operand */
-    codegen_traverse_expr(right, cg);
-
-    /* If right is non-zero/non-null, short-circuit to true */
-    TypeSpecifier *right_type = right->type;
-    if (cs_type_is_pointer(right_type))
-    {
-        if (cs_type_is_void_pointer(right_type))
-        {
-            codebuilder_jump_if_not_null(cg->builder, true_label);
-        }
-        else
-        {
-            cg_emit_ptr_get_base(cg, right_type);
-            codebuilder_jump_if_not_null(cg->builder, true_label);
-        }
-    }
-    else if (cs_type_is_array(right_type))
-    {
-        codebuilder_jump_if_not_null(cg->builder, true_label);
-    }
-    else
-    {
-        codebuilder_jump_if_op(cg->builder, IF_NE, true_label);
-    }
+    /* Short-circuit to true as soon as an operand is non-zero/non-null */
+    codegen_emit_cond_branch(cg, expr, true, true_label);
 
     /* Both false, push 0 */
     codebuilder_build_iconst(cg->builder, 0);
@@ -3,6 +3,9 @@
 #include "cminor_base.h"
 #include "visitor.h"
 
+typedef struct CodegenVisitor_tag CodegenVisitor;
+typedef struct CB_Label_tag CB_Label;
+
 void leave_addexpr(Expression *expr, Visitor *visitor);
 void leave_subexpr(Expression *expr, Visitor *visitor);
 void leave_mulexpr(Expression *expr, Visitor *visitor);
@@ -24,3 +27,8 @@ void leave_array_to_pointer_expr(Expression *expr, Visitor *visitor);
 void leave_conditionalexpr(Expression *expr, Visitor *visitor);
 void leave_logical_and_expr(Expression *expr, Visitor *visitor);
 void leave_logical_or_expr(Expression *expr, Visitor *visitor);
+
+/* Condition context: evaluate cond and jump to target when its truth value
+ * equals jump_if, falling through otherwise. Comparisons, &&, || and ! become
+ * branches instead of a materialized 0/1. */
+void codegen_emit_cond_branch(CodegenVisitor *cg, Expression *cond, bool jump_if, CB_Label *target);
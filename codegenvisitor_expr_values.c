@@ -146,19 +146,31 @@ void leave_stringexpr(Expression *expr, Visitor *visitor)
     char *null_term_str = (char *)calloc(str.len + 1, sizeof(char));
     memcpy(null_term_str, str.data, str.len);
     int str_idx = cp_builder_add_string_len(cp, null_term_str, str.len + 1);
-    codebuilder_build_ldc(cg->builder, str_idx, CF_VAL_OBJECT);
+    free(null_term_str);
 
-    /* Get StandardCharsets.UTF_8 */
-    int utf8_field_idx = cp_builder_add_fieldref(
-        cp, "java/nio/charset/StandardCharsets", "UTF_8",
-        "Ljava/nio/charset/Charset;");
-    codebuilder_build_getstatic(cg->builder, utf8_field_idx);
-
-    /* Call String.getBytes(Charset) -> byte[] (already null-terminated) */
-    int getbytes_idx = cp_builder_add_methodref(
-        cp, "java/lang/String", "getBytes",
-        "(Ljava/nio/charset/Charset;)[B");
-    codebuilder_build_invokevirtual(cg->builder, getbytes_idx);
+    if (cg->current_function)
+    {
+        /* Inside a function: load the byte[] pooled in <clinit> */
+        int field_idx = cg_find_or_add_string_literal(cg, str_idx);
+        codebuilder_build_getstatic(cg->builder, field_idx);
+    }
+    else
+    {
+        /* Static initializers run once, so encode inline */
+        codebuilder_build_ldc(cg->builder, str_idx, CF_VAL_OBJECT);
+
+        /* Get StandardCharsets.UTF_8 */
+        int utf8_field_idx = cp_builder_add_fieldref(
+            cp, "java/nio/charset/StandardCharsets", "UTF_8",
+            "Ljava/nio/charset/Charset;");
+        codebuilder_build_getstatic(cg->builder, utf8_field_idx);
+
+        /* Call String.getBytes(Charset) -> byte[] (already null-terminated) */
+        int getbytes_idx = cp_builder_add_methodref(
+            cp, "java/lang/String", "getBytes",
+            "(Ljava/nio/charset/Charset;)[B");
+        codebuilder_build_invokevirtual(cg->builder, getbytes_idx);
+    }
 
     /* Push offset 0 */
     codebuilder_build_iconst(cg->builder, 0);
@@ -642,7 +654,7 @@ void leave_identifierexpr(Expression *expr, Visitor *visitor)
             {
                 codebuilder_build_faload(cg->builder);
             }
-            else if (cs_type_is_int_exact(decl->type))
+            else if (cs_type_is_int_exact(decl->type) || cs_type_is_enum(decl->type))
             {
                 codebuilder_build_iaload(cg->builder);
             }
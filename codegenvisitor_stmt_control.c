@@ -207,30 +207,6 @@ void leave_whilestmt(Statement *stmt, Visitor *visitor)
         codebuilder_place_label(cg->builder, body_label);
     }
 
-    /* If condition branch wasn't emitted (e.g., empty body), emit it now */
-    if (!ctx.has_cond_branch && ctx.condition_expr && cg->builder->alive)
-    {
-        TypeSpecifier *cond_type = ctx.condition_expr->type;
-        if (cs_type_is_pointer(cond_type))
-        {
-            if (cs_type_is_void_pointer(cond_type))
-            {
-                fprintf(stderr, "void* condition not supported\n");
-                exit(1);
-            }
-            cg_emit_ptr_get_base(cg, cond_type);
-            codebuilder_jump_if_null(cg->builder, end_label);
-        }
-        else if (cs_type_is_array(cond_type))
-        {
-            codebuilder_jump_if_null(cg->builder, end_label);
-        }
-        else
-        {
-            codebuilder_jump_if_not(cg->builder, end_label);
-        }
-    }
-
     codebuilder_jump(cg->builder, cond_label);
     codebuilder_place_label(cg->builder, end_label);
 
@@ -249,13 +225,6 @@ void leave_dowhilestmt(Statement *stmt, Visitor *visitor)
 
     pop_for_context(cg, stmt);
 
-    /*
-     * Save alive state BEFORE placing labels.
-     * Placing cond_label may restore frame and mark alive (if frame_saved),
-     * but the condition expression was only evaluated if alive BEFORE labels.
-     */
-    bool was_alive_before_labels = cg->builder->alive;
-
     /* Place any unplaced labels (dead code path) */
     if (!body_label->is_placed)
     {
@@ -266,38 +235,10 @@ void leave_dowhilestmt(Statement *stmt, Visitor *visitor)
         codebuilder_place_label(cg->builder, cond_label);
     }
 
-    /* If body ended unreachable (e.g., do { goto X; } while(0)), skip condition jump.
-     * Use saved alive state because cond_label placement may have made us alive. */
-    if (!was_alive_before_labels)
-    {
-        /* Code is unreachable - just mark end_label for any continue statements */
-        codebuilder_place_label(cg->builder, end_label);
-        cg_end_scope(cg, "do-while statement");
-        return;
-    }
-
-    /* If condition is true (non-zero/non-null), jump back to body; else fall through to end */
-    /* Use ifnonnull on .base for pointer conditions, ifne for bool/int */
-    TypeSpecifier *cond_type = stmt->u.do_s.condition->type;
-    if (cs_type_is_pointer(cond_type))
-    {
-        if (cs_type_is_void_pointer(cond_type))
-        {
-            fprintf(stderr, "void* condition not supported\n");
-            exit(1);
-        }
-        /* Pointer wrapper: check if .base field is non-null */
-        cg_emit_ptr_get_base(cg, cond_type);
-        codebuilder_jump_if_not_null(cg->builder, body_label);
-    }
-    else if (cs_type_is_array(cond_type))
-    {
-        codebuilder_jump_if_not_null(cg->builder, body_label);
-    }
-    else
-    {
-        codebuilder_jump_if(cg->builder, body_label);
-    }
+    /* The condition branch back to body_label was emitted after the body
+     * (handle_loop_condition). If the body ended unreachable (e.g.,
+     * do { goto X; } while(0)) there is no condition; end_label still
+     * serves break statements. */
     codebuilder_place_label(cg->builder, end_label);
 
     cg_end_scope(cg, "do-while statement");
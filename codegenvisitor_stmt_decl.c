@@ -14,23 +14,10 @@
 #include "codegen_symbols.h"
 #include "codegen_constants.h"
 #include "codegen_jvm_types.h"
+#include "codegen_ptr_scalar.h"
 #include "cminor_type.h"
 #include "synthetic_codegen.h"
 
-/* Helper to find field index by name in a class definition */
-static int find_field_index_by_name(CG_ClassDef *class_def, const char *field_name)
-{
-    for (int i = 0; i < class_def->field_count; i++)
-    {
-        if (class_def->fields[i].name && field_name &&
-            strcmp(class_def->fields[i].name, field_name) == 0)
-        {
-            return (int)i;
-        }
-    }
-    return -1; /* Not found */
-}
-
 void leave_declstmt(Statement *stmt, Visitor *visitor)
 {
     CodegenVisitor *cg = (CodegenVisitor *)visitor;
@@ -49,6 +36,12 @@ void leave_declstmt(Statement *stmt, Visitor *visitor)
         return;
     }
 
+    if (decl->is_scalar_ptr)
+    {
+        cg_scalar_ptr_emit_decl(cg, decl);
+        return;
+    }
+
     CodegenSymbolInfo sym = cg_ensure_symbol(cg, decl);
 
     /* Handle arrays (both VLA and fixed-size).
@@ -349,7 +342,6 @@ void leave_declstmt(Statement *stmt, Visitor *visitor)
                 init_list->expression->kind == DESIGNATED_INITIALIZER_EXPRESSION)
             {
                 int class_idx = find_class_index(cg, struct_name);
-                CG_ClassDef *class_def = &cg->class_defs[class_idx];
 
                 field_indices = (int *)calloc(init_count, sizeof(int));
                 int idx = 0;
@@ -359,7 +351,7 @@ void leave_declstmt(Statement *stmt, Visitor *visitor)
                     if (di && di->kind == DESIGNATED_INITIALIZER_EXPRESSION)
                     {
                         const char *fname = di->u.designated_initializer.field_name;
-                        field_indices[idx] = find_field_index_by_name(class_def, fname);
+                        field_indices[idx] = find_field_index(cg, class_idx, fname);
                     }
                     else
                     {
@@ -443,16 +435,33 @@ void leave_declstmt(Statement *stmt, Visitor *visitor)
         if (decl->initializer)
         {
             /* Stack: [init_value, array_ref]
-             * Need: array_ref on stack, then store init_value at index 0
-             * Use semantic API that auto-selects dup_x1 or dup2_x1 based on init_value category */
-            codebuilder_build_dup_value_x1(cg->builder);
-            /* Stack: [array_ref, init_value, array_ref] */
-            codebuilder_build_swap(cg->builder);
-            /* Stack: [array_ref, array_ref, init_value] */
-            codebuilder_build_iconst(cg->builder, 0);
-            /* Stack: [array_ref, array_ref, init_value, 0] */
-            codebuilder_build_swap(cg->builder);
-            /* Stack: [array_ref, array_ref, 0, init_value] */
+             * Need: array_ref on stack, then store init_value at index 0 */
+            CF_ValueTag init_tag = cg_to_value_tag(decl->type);
+            if (init_tag == CF_VAL_LONG || init_tag == CF_VAL_DOUBLE)
+            {
+                /* 2-slot init_value cannot be swapped; shuffle with dup_x2 + pop */
+                codebuilder_build_dup_x2(cg->builder);
+                /* Stack: [array_ref, init_value(2), array_ref] */
+                codebuilder_build_dup_x2(cg->builder);
+                /* Stack: [array_ref, array_ref, init_value(2), array_ref] */
+                codebuilder_build_pop(cg->builder);
+                codebuilder_build_iconst(cg->builder, 0);
+                /* Stack: [array_ref, array_ref, init_value(2), 0] */
+                codebuilder_build_dup_x2(cg->builder);
+                codebuilder_build_pop(cg->builder);
+                /* Stack: [array_ref, array_ref, 0, init_value(2)] */
+            }
+            else
+            {
+                codebuilder_build_dup_x1(cg->builder);
+                /* Stack: [array_ref, init_value, array_ref] */
+                codebuilder_build_swap(cg->builder);
+                /* Stack: [array_ref, array_ref, init_value] */
+                codebuilder_build_iconst(cg->builder, 0);
+                /* Stack: [array_ref, array_ref, init_value, 0] */
+                codebuilder_build_swap(cg->builder);
+                /* Stack: [array_ref, array_ref, 0, init_value] */
+            }
             if (decl->type && (cs_type_is_array(decl->type) ||
                                cs_type_is_pointer(decl->type) ||
                                cs_type_is_basic_struct_or_union(decl->type)))
@@ -5,6 +5,8 @@
 #include "codegenvisitor.h"
 #include "codegenvisitor_util.h"
 #include "codegenvisitor_stmt_util.h"
+#include "codegenvisitor_expr_ops.h"
+#include "codegenvisitor_expr_util.h"
 #include "codebuilder_ptr.h"
 #include "codebuilder_control.h"
 #include "codebuilder_internal.h"
@@ -203,48 +205,56 @@ CodegenForContext pop_for_context(CodegenVisitor *v, Statement *stmt)
     return ctx;
 }
 
+void handle_if_condition(CodegenVisitor *v, Statement *stmt)
+{
+    CodegenIfContext *ctx = &v->ctx.if_stack[v->ctx.if_depth - 1];
+    if (ctx->if_stmt != stmt)
+    {
+        fprintf(stderr, "mismatched if context\n");
+        exit(1);
+    }
+
+    /* If condition is false, jump to else/end block; else fall through to then */
+    CB_Label *false_block = ctx->else_block ? ctx->else_block : ctx->end_block;
+    codegen_emit_cond_branch(v, stmt->u.if_s.condition, false, false_block);
+    ctx->has_cond_branch = true;
+    codebuilder_place_label(v->builder, ctx->then_block);
+}
+
+void handle_loop_condition(CodegenVisitor *v, Expression *condition)
+{
+    if (!condition)
+    {
+        return;
+    }
+
+    CodegenForContext *ctx = &v->ctx.for_stack[v->ctx.for_depth - 1];
+    CB_ControlEntry *entry = codebuilder_current_loop(v->builder);
+    if (!entry || ctx->condition_expr != condition)
+    {
+        fprintf(stderr, "mismatched loop context\n");
+        exit(1);
+    }
+
+    if (ctx->is_do_while)
+    {
+        /* If condition is true, jump back to body; else fall through to end */
+        codegen_emit_cond_branch(v, condition, true, entry->u.loop_ctx.body_label);
+    }
+    else
+    {
+        /* If condition is false, jump to end_label; else fall through to body */
+        mark_for_condition_start(v, condition);
+        codegen_emit_cond_branch(v, condition, false, entry->u.loop_ctx.end_label);
+    }
+    ctx->has_cond_branch = true;
+}
+
 void handle_if_boundary(CodegenVisitor *v, Statement *stmt)
 {
     for (int32_t i = (int32_t)v->ctx.if_depth - 1; i >= 0; --i)
     {
         CodegenIfContext *ctx = &v->ctx.if_stack[i];
-        if (ctx->then_stmt == stmt && !ctx->has_cond_branch)
-        {
-            /* Skip condition branch if dead - no condition value on stack */
-            if (!v->builder->alive)
-            {
-                /* Dead code path - just place labels without condition branch */
-                codebuilder_place_label(v->builder, ctx->then_block);
-                ctx->has_cond_branch = true;
-                break;
-            }
-            /* If condition is false (0/null), jump to else/end block; else fall through to then */
-            CB_Label *false_block = ctx->else_block ? ctx->else_block : ctx->end_block;
-            /* Use ifnull on .base for pointer conditions, ifeq for bool/int */
-            TypeSpecifier *cond_type = ctx->if_stmt->u.if_s.condition->type;
-            if (cs_type_is_pointer(cond_type))
-            {
-                if (cs_type_is_void_pointer(cond_type))
-                {
-                    fprintf(stderr, "void* condition not supported\n");
-                    exit(1);
-                }
-                /* Pointer wrapper: check if .base field is null */
-                cg_emit_ptr_get_base(v, cond_type);
-                codebuilder_jump_if_null(v->builder, false_block);
-            }
-            else if (cs_type_is_array(cond_type))
-            {
-                codebuilder_jump_if_null(v->builder, false_block);
-            }
-            else
-            {
-                codebuilder_jump_if_not(v->builder, false_block);
-            }
-            ctx->has_cond_branch = true;
-            codebuilder_place_label(v->builder, ctx->then_block);
-            break;
-        }
         if (ctx->else_stmt && ctx->else_stmt == stmt && ctx->has_cond_branch)
         {
             /* Save then block's alive state before jumping to end */
@@ -305,39 +315,13 @@ void handle_for_body_entry(CodegenVisitor *v, Statement *stmt)
             codebuilder_place_label(v->builder, entry->u.loop_ctx.cond_label);
         }
 
-        if (!ctx->has_cond_branch)
+        if (ctx->condition_expr && !ctx->has_cond_branch)
         {
-            if (ctx->condition_expr)
-            {
-                /* If condition is false (0/null), jump to end_label; else fall through to body */
-                /* Use ifnull on .base for pointer conditions, ifeq for bool/int */
-                TypeSpecifier *cond_type = ctx->condition_expr->type;
-                if (cs_type_is_pointer(cond_type))
-                {
-                    if (cs_type_is_void_pointer(cond_type))
-                    {
-                        fprintf(stderr, "void* condition not supported\n");
-                        exit(1);
-                    }
-                    /* Pointer wrapper: check if .base field is null */
-                    cg_emit_ptr_get_base(v, cond_type);
-                    codebuilder_jump_if_null(v->builder, entry->u.loop_ctx.end_label);
-                }
-                else if (cs_type_is_array(cond_type))
-                {
-                    codebuilder_jump_if_null(v->builder, entry->u.loop_ctx.end_label);
-                }
-                else
-                {
-                    codebuilder_jump_if_not(v->builder, entry->u.loop_ctx.end_label);
-                }
-            }
-            else
-            {
-                /* Infinite loop - just fall through to body */
-            }
-            ctx->has_cond_branch = true;
+            fprintf(stderr, "loop condition branch missing\n");
+            exit(1);
         }
+        /* Infinite loop (no condition) - just fall through to body */
+        ctx->has_cond_branch = true;
 
         codebuilder_place_label(v->builder, entry->u.loop_ctx.body_label);
         break;
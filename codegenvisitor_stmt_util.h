@@ -25,6 +25,10 @@ CodegenForContext pop_for_context(CodegenVisitor *v, Statement *stmt);
 CodegenSwitchContext *push_switch_context(CodegenVisitor *v, Statement *stmt);
 CodegenSwitchContext pop_switch_context(CodegenVisitor *v, Statement *stmt);
 
+/* Condition branches (emitted in place of the condition value) */
+void handle_if_condition(CodegenVisitor *v, Statement *stmt);
+void handle_loop_condition(CodegenVisitor *v, Expression *condition);
+
 /* Statement boundary handlers */
 void handle_if_boundary(CodegenVisitor *v, Statement *stmt);
 void handle_for_body_entry(CodegenVisitor *v, Statement *stmt);
@@ -20,18 +20,7 @@
 
 int find_class_index(CodegenVisitor *v, const char *name)
 {
-    if (!name)
-    {
-        return -1;
-    }
-    for (int i = 0; i < v->class_def_count; ++i)
-    {
-        if (v->class_defs[i].name && strcmp(v->class_defs[i].name, name) == 0)
-        {
-            return i;
-        }
-    }
-    return -1;
+    return name_map_rank(v->class_def_map, name);
 }
 
 int find_field_index(CodegenVisitor *v, int class_idx, const char *field_name)
@@ -40,15 +29,7 @@ int find_field_index(CodegenVisitor *v, int class_idx, const char *field_name)
     {
         return -1;
     }
-    CG_ClassDef *cd = &v->class_defs[class_idx];
-    for (int i = 0; i < cd->field_count; ++i)
-    {
-        if (cd->fields[i].name && strcmp(cd->fields[i].name, field_name) == 0)
-        {
-            return i;
-        }
-    }
-    return -1;
+    return name_map_rank(v->class_defs[class_idx].field_map, field_name);
 }
 
 const char *cg_get_struct_class_name(CodegenVisitor *cg, TypeSpecifier *type)
@@ -174,7 +155,7 @@ void cg_emit_array_store_for_type(CodegenVisitor *cg, TypeSpecifier *element_typ
     {
         codebuilder_build_lastore(cg->builder);
     }
-    else if (cs_type_is_char_exact(element_type))
+    else if (cs_type_is_char_exact(element_type) || cs_type_is_bool(element_type))
     {
         codebuilder_build_bastore(cg->builder);
     }
@@ -193,6 +174,39 @@ void cg_emit_array_store_for_type(CodegenVisitor *cg, TypeSpecifier *element_typ
     }
 }
 
+void cg_emit_array_load_for_type(CodegenVisitor *cg, TypeSpecifier *element_type)
+{
+    if (cs_type_is_double_exact(element_type))
+    {
+        codebuilder_build_daload(cg->builder);
+    }
+    else if (cs_type_is_float_exact(element_type))
+    {
+        codebuilder_build_faload(cg->builder);
+    }
+    else if (cs_type_is_long_exact(element_type))
+    {
+        codebuilder_build_laload(cg->builder);
+    }
+    else if (cs_type_is_char_exact(element_type) || cs_type_is_bool(element_type))
+    {
+        codebuilder_build_baload(cg->builder);
+    }
+    else if (cs_type_is_short_exact(element_type))
+    {
+        codebuilder_build_saload(cg->builder);
+    }
+    else if (cs_type_is_pointer(element_type) || cs_type_is_array(element_type) ||
+             (cs_type_is_named(element_type) && cs_type_is_basic_struct_or_union(element_type)))
+    {
+        codebuilder_build_aaload(cg->builder);
+    }
+    else
+    {
+        codebuilder_build_iaload(cg->builder);
+    }
+}
+
 int allocate_temp_local(CodegenVisitor *v)
 {
     /* Allocate temporary local for int type (Javac-style) */
@@ -12,6 +12,7 @@ int array_length_from_type(TypeSpecifier *type);
 int newarray_type_code(TypeSpecifier *element_type);
 void cg_emit_newarray_for_type(CodegenVisitor *cg, TypeSpecifier *element_type);
 void cg_emit_array_store_for_type(CodegenVisitor *cg, TypeSpecifier *element_type);
+void cg_emit_array_load_for_type(CodegenVisitor *cg, TypeSpecifier *element_type);
 
 /* Local variable utilities */
 int allocate_temp_local(CodegenVisitor *v);
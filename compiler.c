@@ -2,29 +2,97 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "ast.h"
+#include "build_manifest.h"
 #include "compiler.h"
 #include "util.h"
 #include "scanner.h"
 #include "embedded_data.h"
+#include "header_cache.h"
 #include "header_decl_visitor.h"
 #include "header_store.h"
+#include "intern.h"
 #include "definitions.h"
 #include "meanvisitor.h"
 #include "parsed_type.h"
 #include "parser.h"
 
+#ifdef __GNUC__
+#include <pthread.h>
+
+/* Guards the context's source queue, compiled list and header claims while
+ * the parallel front end runs; waiters are woken through context_changed */
+static pthread_mutex_t context_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t context_changed = PTHREAD_COND_INITIALIZER;
+#endif
+
 static int mean_debug = 0;
 #define DBG_PRINT(...) \
     if (mean_debug)    \
     fprintf(stderr, __VA_ARGS__)
 
+/* One source file's front end work.  Parsing (with its headers) and the
+ * per-TU mean_check are separate steps so that -j N can parse on worker
+ * threads and still check in the serial order. */
+typedef struct CS_SourceJob_tag
+{
+    char *path;
+    bool is_embedded;
+    TranslationUnit *tu;
+    FileDecl *source_file_decl;
+    struct Arena_tag *arena;
+
+    CS_PendingDependency *headers; /* Headers in the order this TU indexed them */
+
+    /* Recorded by the parallel front end only */
+    CS_PendingDependency *sources; /* Sources queued by this file, in include order */
+
+    /* --incremental */
+    ManifestEntry *manifest_entry; /* This TU in the manifest being built */
+    ManifestEntry *previous_entry; /* This TU in the previous build's manifest */
+    bool reused;                   /* Up to date: parse, mean_check and codegen are skipped */
+
+    struct CS_SourceJob_tag *next;
+} CS_SourceJob;
+
+/* Headers a TU still has to index, most recently pushed first.  A path is
+ * on the stack at most once; paths holds the ones that are. */
+typedef struct CS_HeaderStack_tag
+{
+    CS_PendingDependency *list;
+    CS_PathMap *paths;
+} CS_HeaderStack;
+
+
+static void context_lock(CompilerContext *ctx)
+{
+#ifdef __GNUC__
+    if (ctx->parallel)
+        pthread_mutex_lock(&context_mutex);
+#endif
+}
+
+static void context_unlock(CompilerContext *ctx)
+{
+#ifdef __GNUC__
+    if (ctx->parallel)
+    {
+        pthread_cond_broadcast(&context_changed);
+        pthread_mutex_unlock(&context_mutex);
+    }
+#endif
+}
+
 CompilerContext *compiler_context_create()
 {
     CompilerContext *ctx = (CompilerContext *)calloc(1, sizeof(CompilerContext));
     ctx->header_store = header_store_create();
+    ctx->header_arena = arena_create("headers");
     ctx->pending_sources = NULL;
     ctx->compiled_deps = NULL;
+    ctx->pending_paths = cs_path_map_create();
+    ctx->compiled_paths = cs_path_map_create();
     return ctx;
 }
 
@@ -70,18 +138,9 @@ static void tu_destroy(TranslationUnit *tu)
     free(tu);
 }
 
-/* Per-translation-unit mean_check.
- * tu->header_index must already be populated with source file and its headers.
- * Other .c files are NOT visible - this enforces translation unit isolation. */
-static bool do_mean_check_for_tu(TranslationUnit *tu, FileDecl *source_file)
+/* Resolve types for visible files only (uses header_index for per-TU visibility) */
+static void resolve_visible_types(TranslationUnit *tu)
 {
-    DBG_PRINT("DEBUG: do_mean_check_for_tu start for %s\n",
-              source_file->class_name ? source_file->class_name : "(null)");
-
-    /* header_index is already populated by process_dependencies */
-    tu->current_file_decl = source_file;
-
-    /* Resolve types for visible files only (uses header_index for per-TU visibility) */
     for (int i = 0; i < tu->header_index->file_count; i++)
     {
         FileDecl *fd = tu->header_index->files[i];
@@ -92,6 +151,20 @@ static bool do_mean_check_for_tu(TranslationUnit *tu, FileDecl *source_file)
         FileDecl *fd = tu->header_index->files[i];
         file_decl_resolve_struct_types(fd, tu->header_index);
     }
+}
+
+/* Per-translation-unit mean_check.
+ * tu->header_index must already be populated with source file and its headers.
+ * Other .c files are NOT visible - this enforces translation unit isolation. */
+static bool do_mean_check_for_tu(TranslationUnit *tu, FileDecl *source_file)
+{
+    DBG_PRINT("DEBUG: do_mean_check_for_tu start for %s\n",
+              source_file->class_name ? source_file->class_name : "(null)");
+
+    /* header_index is already populated by process_dependencies */
+    tu->current_file_decl = source_file;
+
+    resolve_visible_types(tu);
 
     MeanVisitor *mean_visitor = create_mean_visitor(tu);
 
@@ -155,18 +228,68 @@ static const char *normalize_path(const char *path)
     return path;
 }
 
-/* Check if a file is in the dependency list */
-static bool is_in_dependency_list(CS_PendingDependency *list, const char *path,
-                                  bool is_embedded)
+CS_PathMap *cs_path_map_create()
+{
+    CS_PathMap *map = (CS_PathMap *)calloc(1, sizeof(CS_PathMap));
+    map->files = name_map_create();
+    map->embedded_files = name_map_create();
+    return map;
+}
+
+static NameMap *path_map_side(CS_PathMap *map, bool is_embedded)
+{
+    if (is_embedded)
+        return map->embedded_files;
+    return map->files;
+}
+
+void *cs_path_map_get(CS_PathMap *map, const char *path, bool is_embedded)
+{
+    return name_map_get(path_map_side(map, is_embedded), normalize_path(path));
+}
+
+/* Set the value for path; NULL takes it out */
+void cs_path_map_set(CS_PathMap *map, const char *path, bool is_embedded, void *value)
+{
+    const char *key = cs_intern(normalize_path(path));
+    name_map_offer(path_map_side(map, is_embedded), key, value, 0, true);
+}
+
+/* Maps used as sets hold the map itself as the value of each path */
+static bool path_map_contains(CS_PathMap *map, const char *path, bool is_embedded)
+{
+    CS_PathMap *found = (CS_PathMap *)cs_path_map_get(map, path, is_embedded);
+    return found != NULL;
+}
+
+static void path_map_add(CS_PathMap *map, const char *path, bool is_embedded)
+{
+    cs_path_map_set(map, path, is_embedded, map);
+}
+
+static void path_map_remove(CS_PathMap *map, const char *path, bool is_embedded)
+{
+    cs_path_map_set(map, path, is_embedded, NULL);
+}
+
+void cs_path_map_destroy(CS_PathMap *map)
+{
+    name_map_destroy(map->files);
+    name_map_destroy(map->embedded_files);
+    free(map);
+}
+
+/* Make map hold exactly the paths of list */
+static void path_map_reset(CS_PathMap *map, CS_PendingDependency *list)
 {
-    const char *normalized = normalize_path(path);
+    name_map_destroy(map->files);
+    name_map_destroy(map->embedded_files);
+    map->files = name_map_create();
+    map->embedded_files = name_map_create();
     for (CS_PendingDependency *dep = list; dep; dep = dep->next)
     {
-        const char *dep_normalized = normalize_path(dep->path);
-        if (dep->is_embedded == is_embedded && strcmp(dep_normalized, normalized) == 0)
-            return true;
+        path_map_add(map, dep->path, dep->is_embedded);
     }
-    return false;
 }
 
 /* Add path to compiled list */
@@ -177,6 +300,12 @@ static void mark_as_compiled(CompilerContext *ctx, const char *path, bool is_emb
     dep->is_embedded = is_embedded;
     dep->next = ctx->compiled_deps;
     ctx->compiled_deps = dep;
+    path_map_add(ctx->compiled_paths, path, is_embedded);
+}
+
+static bool is_compiled(CompilerContext *ctx, const char *path, bool is_embedded)
+{
+    return path_map_contains(ctx->compiled_paths, path, is_embedded);
 }
 
 /* Check if path ends with .h */
@@ -184,7 +313,8 @@ static bool is_header_path(const char *path);
 
 /* Forward declaration */
 static bool parse_header_internal(CompilerContext *ctx, const char *header_path, bool is_embedded,
-                                  CS_PendingDependency **pending_headers_out);
+                                  CS_HeaderStack *pending_headers_out,
+                                  CS_PendingDependency **sources_out);
 
 static bool is_header_path(const char *path)
 {
@@ -195,9 +325,9 @@ static bool is_header_path(const char *path)
 /* Add source to pending_sources if not already compiled/pending */
 static void add_pending_source(CompilerContext *ctx, const char *path, bool is_embedded)
 {
-    if (is_in_dependency_list(ctx->compiled_deps, path, is_embedded))
+    if (is_compiled(ctx, path, is_embedded))
         return;
-    if (is_in_dependency_list(ctx->pending_sources, path, is_embedded))
+    if (path_map_contains(ctx->pending_paths, path, is_embedded))
         return;
 
     DBG_PRINT("[add_source] %s (embedded=%d)\n", path, is_embedded);
@@ -206,115 +336,418 @@ static void add_pending_source(CompilerContext *ctx, const char *path, bool is_e
     dep->is_embedded = is_embedded;
     dep->next = ctx->pending_sources;
     ctx->pending_sources = dep;
+    path_map_add(ctx->pending_paths, path, is_embedded);
 }
 
-/* Add header to a local pending list (not the global pending_sources) */
-static void add_pending_header_local(CS_PendingDependency **list_ptr,
-                                     const char *path, bool is_embedded)
+/* Append after *last_ptr, the last entry of list (NULL while it is empty),
+ * and make the new entry the last one */
+static void append_dependency_at(CS_PendingDependency **list_ptr, CS_PendingDependency **last_ptr,
+                                 const char *path, bool is_embedded)
+{
+    CS_PendingDependency *dep = (CS_PendingDependency *)calloc(1, sizeof(CS_PendingDependency));
+    dep->path = strdup(path);
+    dep->is_embedded = is_embedded;
+    dep->next = NULL;
+    CS_PendingDependency *last = *last_ptr;
+    if (last)
+        last->next = dep;
+    else
+        *list_ptr = dep;
+    *last_ptr = dep;
+}
+
+/* Append to the end of list, keeping the order entries were found in */
+static void append_dependency(CS_PendingDependency **list_ptr, const char *path, bool is_embedded)
+{
+    CS_PendingDependency *last = *list_ptr;
+    while (last && last->next)
+        last = last->next;
+    append_dependency_at(list_ptr, &last, path, is_embedded);
+}
+
+/* Queue a source for compilation.  sources_out, when given, also records
+ * it for the parallel front end's replay of the serial order. */
+static void queue_source(CompilerContext *ctx, const char *path, bool is_embedded,
+                         CS_PendingDependency **sources_out)
+{
+    if (sources_out)
+        append_dependency(sources_out, path, is_embedded);
+    context_lock(ctx);
+    add_pending_source(ctx, path, is_embedded);
+    context_unlock(ctx);
+}
+
+static CS_HeaderStack *header_stack_create()
+{
+    CS_HeaderStack *stack = (CS_HeaderStack *)calloc(1, sizeof(CS_HeaderStack));
+    stack->paths = cs_path_map_create();
+    return stack;
+}
+
+static void header_stack_destroy(CS_HeaderStack *stack)
+{
+    free_dependency_list(stack->list);
+    cs_path_map_destroy(stack->paths);
+    free(stack);
+}
+
+/* Push a header onto a TU's stack (not the global pending_sources) */
+static void add_pending_header_local(CS_HeaderStack *stack, const char *path, bool is_embedded)
 {
     /* Check for duplicates */
-    const char *normalized = normalize_path(path);
-    for (CS_PendingDependency *dep = *list_ptr; dep; dep = dep->next)
-    {
-        const char *dep_normalized = normalize_path(dep->path);
-        if (dep->is_embedded == is_embedded && strcmp(dep_normalized, normalized) == 0)
-            return;
-    }
+    if (path_map_contains(stack->paths, path, is_embedded))
+        return;
 
     CS_PendingDependency *dep = (CS_PendingDependency *)calloc(1, sizeof(CS_PendingDependency));
     dep->path = strdup(path);
     dep->is_embedded = is_embedded;
-    dep->next = *list_ptr;
-    *list_ptr = dep;
+    dep->next = stack->list;
+    stack->list = dep;
+    path_map_add(stack->paths, path, is_embedded);
 }
 
-/* Pop from local pending list */
-static CS_PendingDependency *pop_pending_header_local(CS_PendingDependency **list_ptr)
+/* Pop from a TU's stack */
+static CS_PendingDependency *pop_pending_header_local(CS_HeaderStack *stack)
 {
-    CS_PendingDependency *dep = *list_ptr;
+    CS_PendingDependency *dep = stack->list;
     if (dep)
     {
-        *list_ptr = dep->next;
+        stack->list = dep->next;
         dep->next = NULL;
+        path_map_remove(stack->paths, dep->path, dep->is_embedded);
     }
     return dep;
 }
 
-/* Collect dependencies from scanner into local lists.
- * Headers go to pending_headers, sources go to ctx->pending_sources. */
+/* Headers go to pending_headers, sources go to ctx->pending_sources */
+static void queue_dependency(CompilerContext *ctx, const char *path, bool is_embedded,
+                             CS_HeaderStack *pending_headers,
+                             CS_PendingDependency **sources_out)
+{
+    if (is_header_path(path))
+    {
+        add_pending_header_local(pending_headers, path, is_embedded);
+    }
+    else
+    {
+        queue_source(ctx, path, is_embedded, sources_out);
+    }
+}
+
+/* Collect dependencies from scanner into local lists */
 static void collect_dependencies_to_lists(CompilerContext *ctx, Scanner *scanner,
-                                          CS_PendingDependency **pending_headers)
+                                          CS_HeaderStack *pending_headers,
+                                          CS_PendingDependency **sources_out)
 {
     int count = cs_scanner_dependency_count(scanner);
     for (int i = 0; i < count; ++i)
     {
         const char *path = cs_scanner_dependency_path(scanner, i);
         bool is_embedded = cs_scanner_dependency_is_embedded(scanner, i);
-        if (!path)
-            continue;
-
-        if (is_header_path(path))
-        {
-            add_pending_header_local(pending_headers, path, is_embedded);
-        }
-        else
-        {
-            add_pending_source(ctx, path, is_embedded);
-        }
+        if (path)
+            queue_dependency(ctx, path, is_embedded, pending_headers, sources_out);
     }
 }
 
-/* Pop next pending source, or NULL if empty */
-static CS_PendingDependency *pop_pending_source(CompilerContext *ctx)
+CS_PendingDependency *cs_pop_pending_source(CompilerContext *ctx)
 {
     CS_PendingDependency *dep = ctx->pending_sources;
     if (dep)
     {
         ctx->pending_sources = dep->next;
         dep->next = NULL;
+        path_map_remove(ctx->pending_paths, dep->path, dep->is_embedded);
     }
     return dep;
 }
 
-static void append_stmt_list(StatementList **dst, StatementList *src)
+/* Link src after *dst.  *last_ptr is a known element of *dst to search
+ * for the end from (NULL = the head); it is left at the new end. */
+static void append_stmt_list(StatementList **dst, StatementList **last_ptr, StatementList *src)
 {
     if (!src)
         return;
+    StatementList *last = *last_ptr;
     if (!*dst)
     {
         *dst = src;
-        return;
     }
-    StatementList *last = *dst;
+    else
+    {
+        if (!last)
+            last = *dst;
+        while (last->next)
+            last = last->next;
+        last->next = src;
+    }
+    last = src;
     while (last->next)
         last = last->next;
-    last->next = src;
+    *last_ptr = last;
 }
 
-static void append_decl_list(DeclarationList **dst, DeclarationList *src)
+static void append_decl_list(DeclarationList **dst, DeclarationList **last_ptr, DeclarationList *src)
 {
     if (!src)
         return;
+    DeclarationList *last = *last_ptr;
     if (!*dst)
     {
         *dst = src;
-        return;
     }
-    DeclarationList *last = *dst;
+    else
+    {
+        if (!last)
+            last = *dst;
+        while (last->next)
+            last = last->next;
+        last->next = src;
+    }
+    last = src;
     while (last->next)
         last = last->next;
-    last->next = src;
+    *last_ptr = last;
 }
 
-/* Parse a single .c file (no mean_check, just parse and collect dependencies) */
-static bool compile_source_internal(CompilerContext *ctx, const char *compile_path, bool is_embedded)
+static CS_SourceJob *source_job_create(const char *path, bool is_embedded)
 {
-    if (is_in_dependency_list(ctx->compiled_deps, compile_path, is_embedded))
-        return true;
+    CS_SourceJob *job = (CS_SourceJob *)calloc(1, sizeof(CS_SourceJob));
+    job->path = strdup(path);
+    job->is_embedded = is_embedded;
+    return job;
+}
 
-    /* Mark as compiled early to prevent re-entry during parsing */
-    mark_as_compiled(ctx, compile_path, is_embedded);
+/* The TU and its arena stay alive for codegen */
+static void source_job_free(CS_SourceJob *job)
+{
+    free(job->path);
+    free_dependency_list(job->sources);
+    free_dependency_list(job->headers);
+    free(job);
+}
 
+/* --incremental: note the #include list the scanner found in the source */
+static void record_includes(ManifestEntry *entry, Scanner *scanner)
+{
+    int count = cs_scanner_dependency_count(scanner);
+    for (int i = 0; i < count; ++i)
+    {
+        const char *path = cs_scanner_dependency_path(scanner, i);
+        if (path)
+            manifest_entry_add_include(entry, path, cs_scanner_dependency_is_embedded(scanner, i));
+    }
+}
+
+/* --incremental: queue the #include list of a TU that is not parsed again,
+ * as collect_dependencies_to_lists() would after parsing it */
+static void replay_includes(CompilerContext *ctx, CS_SourceJob *job,
+                            CS_HeaderStack *pending_headers,
+                            CS_PendingDependency **sources_out)
+{
+    for (ManifestInput *include = job->previous_entry->includes; include; include = include->next)
+    {
+        queue_dependency(ctx, include->path, include->is_embedded, pending_headers, sources_out);
+        manifest_entry_add_include(job->manifest_entry, include->path, include->is_embedded);
+    }
+}
+
+/* Make sure header_path is in the HeaderStore, parsing it if nobody has */
+static bool ensure_header_parsed(CompilerContext *ctx, const char *header_path, bool is_embedded,
+                                 CS_HeaderStack *pending_headers);
+
+/*
+ * Include closures.  A TU indexes its headers by popping a stack of
+ * pending includes: a header not yet in the index is added and its own
+ * includes are pushed, unless the same path is pending already.  When a
+ * popped header has a closure and none of the closure's paths is pending
+ * further down the stack, that walk adds exactly the closure's files that
+ * are not yet indexed, in closure order, and leaves the rest of the stack
+ * as it was.  The closure is then added directly.  A closure path that is
+ * still pending would be indexed later, at its own place in the stack, so
+ * in that case the header's includes are pushed as before.  Either way the
+ * TU sees its headers in the same order.
+ */
+static int closures_computed = 0;
+static int headers_from_closures = 0;
+static int headers_from_includes = 0;
+
+#ifdef __GNUC__
+#define COUNT_EVENTS(counter, n) __atomic_add_fetch(&counter, n, __ATOMIC_RELAXED)
+#else
+#define COUNT_EVENTS(counter, n) counter = counter + n
+#endif
+
+void cs_print_closure_stats()
+{
+    fprintf(stderr, "include closures: %d computed, %d headers indexed from closures, %d by walking includes\n",
+            closures_computed, headers_from_closures, headers_from_includes);
+}
+
+/* fd->closure; other workers may set it in the native build */
+static FileClosure *header_closure(FileDecl *fd)
+{
+#ifdef __GNUC__
+    return __atomic_load_n(&fd->closure, __ATOMIC_ACQUIRE);
+#else
+    return fd->closure;
+#endif
+}
+
+static void set_header_closure(FileDecl *fd, FileClosure *closure)
+{
+#ifdef __GNUC__
+    __atomic_store_n(&fd->closure, closure, __ATOMIC_RELEASE);
+#else
+    fd->closure = closure;
+#endif
+}
+
+/* True when no path of closure is on the pending stack (whether embedded or not) */
+static bool closure_applies(FileClosure *closure, CS_HeaderStack *pending)
+{
+    for (int i = 0; i < closure->count; i++)
+    {
+        const char *path = closure->files[i]->path;
+        if (path_map_contains(pending->paths, path, false) || path_map_contains(pending->paths, path, true))
+            return false;
+    }
+    return true;
+}
+
+static bool closure_has_file(NameMap *files, FileDecl *fd)
+{
+    return (FileDecl *)name_map_get(files, fd->path) == fd;
+}
+
+static void closure_add(FileClosure *closure, FileDecl *fd, bool is_embedded)
+{
+    if (closure->count >= closure->capacity)
+    {
+        int new_capacity = closure->capacity ? closure->capacity * 2 : 8;
+        FileDecl **files = (FileDecl **)calloc(new_capacity, sizeof(FileDecl *));
+        bool *embedded = (bool *)calloc(new_capacity, sizeof(bool));
+        for (int i = 0; i < closure->count; i++)
+        {
+            files[i] = closure->files[i];
+            embedded[i] = closure->is_embedded[i];
+        }
+        free(closure->files);
+        free(closure->is_embedded);
+        closure->files = files;
+        closure->is_embedded = embedded;
+        closure->capacity = new_capacity;
+    }
+    closure->files[closure->count] = fd;
+    closure->is_embedded[closure->count] = is_embedded;
+    closure->count = closure->count + 1;
+}
+
+/* Walk the includes of fd the way parse_source_job() does, starting from
+ * an empty index.  Every header reached must be parsed; NULL if one is not
+ * a header FileDecl (a source included like a header may still grow). */
+static FileClosure *compute_header_closure(CompilerContext *ctx, FileDecl *fd, bool is_embedded)
+{
+    FileClosure *closure = (FileClosure *)calloc(1, sizeof(FileClosure));
+    NameMap *indexed = name_map_create(); /* FileDecl path -> FileDecl */
+    CS_HeaderStack *pending = header_stack_create();
+    add_pending_header_local(pending, fd->path, is_embedded);
+    bool ok = true;
+
+    CS_PendingDependency *hdr;
+    while ((hdr = pop_pending_header_local(pending)) != NULL)
+    {
+        FileDecl *file = NULL;
+        if (ok)
+            file = header_store_find(ctx->header_store, hdr->path);
+        if (!file || !file->is_header)
+        {
+            ok = false;
+        }
+        else if (!closure_has_file(indexed, file))
+        {
+            FileClosure *known = header_closure(file);
+            if (known && closure_applies(known, pending))
+            {
+                for (int i = 0; i < known->count; i++)
+                {
+                    FileDecl *member = known->files[i];
+                    if (!closure_has_file(indexed, member))
+                    {
+                        name_map_offer(indexed, member->path, member, 0, false);
+                        closure_add(closure, member, known->is_embedded[i]);
+                    }
+                }
+            }
+            else
+            {
+                name_map_offer(indexed, file->path, file, 0, false);
+                closure_add(closure, file, hdr->is_embedded);
+                int dep_count = file_decl_dependency_count(file);
+                for (int di = 0; di < dep_count; di++)
+                {
+                    FileDependency *dep = file_decl_get_dependency(file, di);
+                    if (dep)
+                        add_pending_header_local(pending, dep->path, dep->is_embedded);
+                }
+            }
+        }
+        free(hdr->path);
+        free(hdr);
+    }
+    header_stack_destroy(pending);
+    name_map_destroy(indexed);
+    if (!ok)
+    {
+        free(closure->files);
+        free(closure->is_embedded);
+        free(closure);
+        return NULL;
+    }
+    return closure;
+}
+
+/* After a TU indexed its headers, every header it saw and everything those
+ * include is parsed: compute the closures still missing.  Later headers in
+ * the TU's order are mostly included by earlier ones, so they go first and
+ * the earlier closures are built from theirs. */
+static void compute_missing_closures(CompilerContext *ctx, CS_PendingDependency *headers)
+{
+    int count = 0;
+    for (CS_PendingDependency *h = headers; h; h = h->next)
+        count++;
+    if (count == 0)
+        return;
+    CS_PendingDependency **order = (CS_PendingDependency **)calloc(count, sizeof(CS_PendingDependency *));
+    int n = 0;
+    for (CS_PendingDependency *h = headers; h; h = h->next)
+    {
+        order[n] = h;
+        n++;
+    }
+    for (int i = count - 1; i >= 0; i--)
+    {
+        FileDecl *fd = header_store_find(ctx->header_store, order[i]->path);
+        if (!fd || !fd->is_header || header_closure(fd))
+            continue;
+        FileClosure *closure = compute_header_closure(ctx, fd, order[i]->is_embedded);
+        if (closure)
+        {
+            /* Another worker may have set an equal closure meanwhile */
+            set_header_closure(fd, closure);
+            COUNT_EVENTS(closures_computed, 1);
+        }
+    }
+    free(order);
+}
+
+/* Parse a single .c file and the headers it includes (no mean_check).
+ * Each header is parsed once; this TU's header_index gets every header it can see.
+ * An up-to-date TU of an incremental build keeps an empty FileDecl and only
+ * brings its headers in. */
+static bool parse_source_job(CompilerContext *ctx, CS_SourceJob *job)
+{
+    const char *compile_path = job->path;
+    bool is_embedded = job->is_embedded;
     unsigned char *input_bytes = NULL;
     int input_size = 0;
     bool read_ok = false;
@@ -343,8 +776,19 @@ static bool compile_source_internal(CompilerContext *ctx, const char *compile_pa
         return false;
     }
 
-    /* Create fresh TranslationUnit for this source file */
+    if (ctx->build)
+    {
+        job->manifest_entry = manifest_entry_create(compile_path, is_embedded, input_bytes, input_size);
+        job->previous_entry = build_manifest_find(ctx->previous_build, compile_path, is_embedded);
+        job->reused = manifest_entry_is_up_to_date(job->manifest_entry, job->previous_entry);
+        job->manifest_entry->reused = job->reused;
+    }
+
+    /* Create fresh TranslationUnit for this source file; its nodes go to an arena of its own */
     TranslationUnit *tu = tu_create(ctx, compile_path);
+    job->tu = tu;
+    job->arena = arena_create(compile_path);
+    Arena *previous_arena = arena_set_current(job->arena);
 
     CS_ScannerConfig config = {
         .source_path = compile_path,
@@ -353,13 +797,19 @@ static bool compile_source_internal(CompilerContext *ctx, const char *compile_pa
         .tu = tu,
     };
 
-    Scanner *scanner = cs_create_scanner(&config);
-    if (!scanner)
+    Scanner *scanner = NULL;
+    if (!job->reused)
     {
-        if (input_owned)
-            free(input_bytes);
-        tu_destroy(tu);
-        return false;
+        scanner = cs_create_scanner(&config);
+        if (!scanner)
+        {
+            if (input_owned)
+                free(input_bytes);
+            tu_destroy(tu);
+            job->tu = NULL;
+            arena_set_current(previous_arena);
+            return false;
+        }
     }
 
     /* Create FileDecl for this source (declarations will be added during parsing) */
@@ -368,7 +818,7 @@ static bool compile_source_internal(CompilerContext *ctx, const char *compile_pa
     /* Add to header_index (visible in this TU) */
     header_index_add_file(tu->header_index, tu->current_file_decl);
 
-    if (yyparse(scanner))
+    if (scanner && yyparse(scanner))
     {
         DBG_PRINT("Parse Error");
         cs_delete_scanner(scanner);
@@ -378,49 +828,86 @@ static bool compile_source_internal(CompilerContext *ctx, const char *compile_pa
     }
 
     /* Save source file's FileDecl */
-    FileDecl *source_file_decl = tu->current_file_decl;
-
-    /* Collect dependencies from scanner into local header queue */
-    CS_PendingDependency *pending_headers = NULL;
-    collect_dependencies_to_lists(ctx, scanner, &pending_headers);
+    job->source_file_decl = tu->current_file_decl;
+
+    /* Collect dependencies from scanner into local header queue.
+     * The parallel front end records the order of sources and headers. */
+    CS_HeaderStack *pending_headers = header_stack_create();
+    CS_PendingDependency *sources = NULL;
+    CS_PendingDependency *visited = NULL;
+    CS_PendingDependency *visited_last = NULL;
+    CS_PendingDependency **sources_out = NULL;
+    if (ctx->parallel)
+        sources_out = &sources;
+    if (scanner)
+    {
+        collect_dependencies_to_lists(ctx, scanner, pending_headers, sources_out);
+        if (job->manifest_entry)
+            record_includes(job->manifest_entry, scanner);
+        cs_delete_scanner(scanner);
+    }
+    else
+    {
+        replay_includes(ctx, job, pending_headers, sources_out);
+    }
+    job->sources = sources;
 
-    cs_delete_scanner(scanner);
     if (input_owned)
         free(input_bytes);
 
     /* Process header queue: parse each header, collect its deps, repeat */
     CS_PendingDependency *hdr;
-    while ((hdr = pop_pending_header_local(&pending_headers)) != NULL)
+    while ((hdr = pop_pending_header_local(pending_headers)) != NULL)
     {
         const char *header_path = hdr->path;
         bool hdr_is_embedded = hdr->is_embedded;
 
-        /* Parse header if not already in header_store */
-        if (!header_store_is_parsed(ctx->header_store, header_path))
+        if (!ensure_header_parsed(ctx, header_path, hdr_is_embedded, pending_headers))
         {
-            if (!parse_header_internal(ctx, header_path, hdr_is_embedded, &pending_headers))
-            {
-                free(hdr->path);
-                free(hdr);
-                free_dependency_list(pending_headers);
-                return false;
-            }
+            free(hdr->path);
+            free(hdr);
+            header_stack_destroy(pending_headers);
+            free_dependency_list(visited);
+            arena_set_current(previous_arena);
+            return false;
         }
 
         /* Add to this TU's header_index */
         FileDecl *fd = header_store_find(ctx->header_store, header_path);
         if (fd && !header_index_contains(tu->header_index, fd))
         {
-            header_index_add_file(tu->header_index, fd);
-
-            /* Also add stored dependencies of this header to pending queue */
-            int dep_count = file_decl_dependency_count(fd);
-            for (int di = 0; di < dep_count; di++)
+            FileClosure *closure = header_closure(fd);
+            if (closure && closure_applies(closure, pending_headers))
             {
-                FileDependency *dep = file_decl_get_dependency(fd, di);
-                if (dep)
+                /* Everything this header brings in, in walking order */
+                int added = 0;
+                for (int i = 0; i < closure->count; i++)
                 {
-                    add_pending_header_local(&pending_headers, dep->path, dep->is_embedded);
+                    FileDecl *member = closure->files[i];
+                    if (!header_index_contains(tu->header_index, member))
+                    {
+                        header_index_add_file(tu->header_index, member);
+                        append_dependency_at(&visited, &visited_last, member->path, closure->is_embedded[i]);
+                        added++;
+                    }
+                }
+                COUNT_EVENTS(headers_from_closures, added);
+            }
+            else
+            {
+                header_index_add_file(tu->header_index, fd);
+                append_dependency_at(&visited, &visited_last, header_path, hdr_is_embedded);
+                COUNT_EVENTS(headers_from_includes, 1);
+
+                /* Also add stored dependencies of this header to pending queue */
+                int dep_count = file_decl_dependency_count(fd);
+                for (int di = 0; di < dep_count; di++)
+                {
+                    FileDependency *dep = file_decl_get_dependency(fd, di);
+                    if (dep)
+                    {
+                        add_pending_header_local(pending_headers, dep->path, dep->is_embedded);
+                    }
                 }
             }
         }
@@ -429,45 +916,399 @@ static bool compile_source_internal(CompilerContext *ctx, const char *compile_pa
         free(hdr);
     }
 
+    header_stack_destroy(pending_headers);
+    job->headers = visited;
+    compute_missing_closures(ctx, visited);
+
     /* Restore source file's FileDecl */
-    tu->current_file_decl = source_file_decl;
+    tu->current_file_decl = job->source_file_decl;
+    arena_set_current(previous_arena);
 
     /* Note: Do NOT call store_function_prototypes here. Prototypes from included
      * headers are already stored in their respective header FileDeclss by
      * parse_header_internal. Storing them again here would incorrectly associate
      * them with the source file's class name instead of the header's class name. */
+    return true;
+}
 
+/* --incremental: add the checked TU to the manifest being built, in the
+ * serial compile order, and report whether it was reused */
+static void record_manifest_entry(CompilerContext *ctx, CS_SourceJob *job)
+{
+    ManifestEntry *entry = job->manifest_entry;
+    for (CS_PendingDependency *h = job->headers; h; h = h->next)
+    {
+        manifest_entry_add_header(entry, h->path, h->is_embedded);
+    }
+    if (job->reused)
+    {
+        manifest_entry_copy_outputs(entry, job->previous_entry);
+    }
+    build_manifest_append(ctx->build, entry);
+    fprintf(stderr, "incremental: %s %s\n", job->reused ? "reused" : "rebuilt", job->path);
+}
+
+/* Per-TU mean_check of a parsed job, then hand its statements and declarations to ctx */
+static bool check_source_job(CompilerContext *ctx, CS_SourceJob *job)
+{
     /* Per-TU mean_check: only this .c and its included headers are visible.
-     * Other .c files are NOT visible - enforces translation unit isolation. */
-    if (!do_mean_check_for_tu(tu, source_file_decl))
+     * Other .c files are NOT visible - enforces translation unit isolation.
+     * A reused TU has nothing to check, but its headers' types are resolved
+     * as its check would. */
+    Arena *previous_arena = arena_set_current(job->arena);
+    bool mean_ok = true;
+    if (job->reused)
+    {
+        job->tu->current_file_decl = job->source_file_decl;
+        resolve_visible_types(job->tu);
+    }
+    else
+    {
+        mean_ok = do_mean_check_for_tu(job->tu, job->source_file_decl);
+    }
+    arena_set_current(previous_arena);
+    if (!mean_ok)
     {
         return false;
     }
+    if (job->manifest_entry)
+    {
+        record_manifest_entry(ctx, job);
+    }
 
     /* Aggregate statements and declarations to ctx (for later codegen) */
     StatementList *tmp_stmts = ctx->all_statements;
-    append_stmt_list(&tmp_stmts, tu->stmt_list);
+    StatementList *last_stmt = ctx->all_statements_last;
+    append_stmt_list(&tmp_stmts, &last_stmt, job->tu->stmt_list);
     ctx->all_statements = tmp_stmts;
+    ctx->all_statements_last = last_stmt;
 
     DeclarationList *tmp_decls = ctx->all_declarations;
-    append_decl_list(&tmp_decls, tu->decl_list);
+    DeclarationList *last_decl = ctx->all_declarations_last;
+    append_decl_list(&tmp_decls, &last_decl, job->tu->decl_list);
     ctx->all_declarations = tmp_decls;
+    ctx->all_declarations_last = last_decl;
 
     return true;
 }
 
+/* Parse and check a single .c file */
+static bool compile_source_internal(CompilerContext *ctx, const char *compile_path, bool is_embedded)
+{
+    if (is_compiled(ctx, compile_path, is_embedded))
+        return true;
+
+    /* Mark as compiled early to prevent re-entry during parsing */
+    mark_as_compiled(ctx, compile_path, is_embedded);
+
+    CS_SourceJob *job = source_job_create(compile_path, is_embedded);
+    bool ok = parse_source_job(ctx, job) && check_source_job(ctx, job);
+    source_job_free(job);
+    return ok;
+}
+
+#ifdef __GNUC__
+/* A header that one worker parses while the others wait for it */
+typedef struct CS_HeaderClaim_tag
+{
+    char *path;
+    bool done;
+    bool ok;
+    FileDecl *fd;
+    CS_PendingDependency *sources; /* Sources queued when it was parsed */
+    struct CS_HeaderClaim_tag *next;
+} CS_HeaderClaim;
+
+/* Shared by the workers while ctx->parallel is set */
+typedef struct CS_ParallelFrontEnd_tag
+{
+    CS_SourceJob *jobs;
+    CS_PathMap *job_map; /* Source path -> job */
+    CS_HeaderClaim *claims;
+    NameMap *claim_map;  /* Header path -> claim */
+    int active; /* Workers parsing a source right now */
+    bool failed;
+} CS_ParallelFrontEnd;
+
+static CS_ParallelFrontEnd *front_end = NULL;
+
+static CS_HeaderClaim *find_header_claim(CS_ParallelFrontEnd *pfe, const char *path)
+{
+    return (CS_HeaderClaim *)name_map_get(pfe->claim_map, path);
+}
+
+/* Parse-once latch: the first worker to claim a header parses it, later
+ * ones wait until it is done.  The sources the parse queues are kept on
+ * the claim for the replay in compile_parallel(). */
+static bool claim_header(CompilerContext *ctx, const char *header_path, bool is_embedded,
+                         CS_HeaderStack *pending_headers)
+{
+    CS_ParallelFrontEnd *pfe = front_end;
+    pthread_mutex_lock(&context_mutex);
+    CS_HeaderClaim *claim = find_header_claim(pfe, header_path);
+    if (claim)
+    {
+        while (!claim->done)
+            pthread_cond_wait(&context_changed, &context_mutex);
+        bool ok = claim->ok;
+        pthread_mutex_unlock(&context_mutex);
+        return ok;
+    }
+    claim = (CS_HeaderClaim *)calloc(1, sizeof(CS_HeaderClaim));
+    claim->path = strdup(header_path);
+    claim->next = pfe->claims;
+    pfe->claims = claim;
+    name_map_offer(pfe->claim_map, claim->path, claim, 0, false);
+    pthread_mutex_unlock(&context_mutex);
+
+    CS_PendingDependency *sources = NULL;
+    bool ok = parse_header_internal(ctx, header_path, is_embedded, pending_headers, &sources);
+    FileDecl *fd = ok ? header_store_find(ctx->header_store, header_path) : NULL;
+
+    ok = ok && fd != NULL;
+
+    pthread_mutex_lock(&context_mutex);
+    claim->sources = sources;
+    claim->fd = fd;
+    claim->ok = ok;
+    claim->done = true;
+    pthread_cond_broadcast(&context_changed);
+    pthread_mutex_unlock(&context_mutex);
+    return ok;
+}
+#endif
+
+static bool ensure_header_parsed(CompilerContext *ctx, const char *header_path, bool is_embedded,
+                                 CS_HeaderStack *pending_headers)
+{
+#ifdef __GNUC__
+    if (ctx->parallel)
+        return claim_header(ctx, header_path, is_embedded, pending_headers);
+#endif
+    if (header_store_is_parsed(ctx->header_store, header_path))
+        return true;
+    return parse_header_internal(ctx, header_path, is_embedded, pending_headers, NULL);
+}
+
+#ifdef __GNUC__
+/* Take sources off the shared queue and parse them until the queue is
+ * empty and no other worker can add to it */
+static void *front_end_worker(void *arg)
+{
+    CompilerContext *ctx = (CompilerContext *)arg;
+    CS_ParallelFrontEnd *pfe = front_end;
+
+    pthread_mutex_lock(&context_mutex);
+    while (!pfe->failed)
+    {
+        CS_PendingDependency *dep = cs_pop_pending_source(ctx);
+        if (!dep)
+        {
+            if (pfe->active == 0)
+                break;
+            pthread_cond_wait(&context_changed, &context_mutex);
+            continue;
+        }
+        if (is_compiled(ctx, dep->path, dep->is_embedded))
+        {
+            free(dep->path);
+            free(dep);
+            continue;
+        }
+        mark_as_compiled(ctx, dep->path, dep->is_embedded);
+        CS_SourceJob *job = source_job_create(dep->path, dep->is_embedded);
+        job->next = pfe->jobs;
+        pfe->jobs = job;
+        cs_path_map_set(pfe->job_map, job->path, job->is_embedded, job);
+        free(dep->path);
+        free(dep);
+        pfe->active = pfe->active + 1;
+        pthread_mutex_unlock(&context_mutex);
+
+        bool ok = parse_source_job(ctx, job);
+
+        pthread_mutex_lock(&context_mutex);
+        pfe->active = pfe->active - 1;
+        if (!ok)
+            pfe->failed = true;
+        pthread_cond_broadcast(&context_changed);
+    }
+    pthread_mutex_unlock(&context_mutex);
+    return NULL;
+}
+
+static CS_SourceJob *find_source_job(CS_ParallelFrontEnd *pfe, const char *path, bool is_embedded)
+{
+    return (CS_SourceJob *)cs_path_map_get(pfe->job_map, path, is_embedded);
+}
+
+/* files: FileDecl path -> FileDecl of the files relinked into the store */
+static bool file_is_listed(NameMap *files, FileDecl *fd)
+{
+    return (FileDecl *)name_map_get(files, fd->path) == fd;
+}
+
+static void list_file(HeaderStore *store, NameMap *files, FileDecl *fd)
+{
+    fd->next = store->files;
+    store->files = fd;
+    name_map_offer(files, fd->path, fd, 0, false);
+}
+
+/* -j N: parse the pending sources on N threads, then replay the serial
+ * source loop over the parsed jobs.  The replay rebuilds the compiled list
+ * and the HeaderStore's file order exactly as a serial run leaves them and
+ * runs mean_check in that order, so the generated classes do not depend on
+ * the thread schedule.  mean_check itself stays on this thread: it
+ * resolves types into shared header declarations and fixes up extern
+ * declarations of other files. */
+static bool compile_parallel(CompilerContext *ctx)
+{
+    CS_ParallelFrontEnd *pfe = (CS_ParallelFrontEnd *)calloc(1, sizeof(CS_ParallelFrontEnd));
+    pfe->job_map = cs_path_map_create();
+    pfe->claim_map = name_map_create();
+    FileDecl *files_before = ctx->header_store->files;
+    CS_PendingDependency *compiled_before = ctx->compiled_deps;
+    CS_PendingDependency *roots = NULL;
+    CS_PendingDependency *roots_last = NULL;
+    for (CS_PendingDependency *dep = ctx->pending_sources; dep; dep = dep->next)
+    {
+        append_dependency_at(&roots, &roots_last, dep->path, dep->is_embedded);
+    }
+
+    front_end = pfe;
+    ctx->parallel = true;
+    int thread_count = ctx->jobs - 1;
+    pthread_t *threads = (pthread_t *)calloc(thread_count, sizeof(pthread_t));
+    int started = 0;
+    while (started < thread_count &&
+           pthread_create(&threads[started], NULL, front_end_worker, ctx) == 0)
+    {
+        started++;
+    }
+    front_end_worker(ctx);
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    ctx->parallel = false;
+    front_end = NULL;
+
+    bool ok = !pfe->failed;
+    if (ok)
+    {
+        /* Forget the order the workers got to the files in */
+        while (ctx->compiled_deps != compiled_before)
+        {
+            CS_PendingDependency *next = ctx->compiled_deps->next;
+            free(ctx->compiled_deps->path);
+            free(ctx->compiled_deps);
+            ctx->compiled_deps = next;
+        }
+        path_map_reset(ctx->compiled_paths, ctx->compiled_deps);
+        NameMap *listed = name_map_create();
+        for (FileDecl *fd = files_before; fd; fd = fd->next)
+        {
+            name_map_offer(listed, fd->path, fd, 0, false);
+        }
+        ctx->header_store->files = files_before;
+        ctx->pending_sources = roots;
+        path_map_reset(ctx->pending_paths, roots);
+        roots = NULL;
+
+        CS_PendingDependency *dep;
+        while (ok && (dep = cs_pop_pending_source(ctx)) != NULL)
+        {
+            if (!is_compiled(ctx, dep->path, dep->is_embedded))
+            {
+                mark_as_compiled(ctx, dep->path, dep->is_embedded);
+                CS_SourceJob *job = find_source_job(pfe, dep->path, dep->is_embedded);
+                list_file(ctx->header_store, listed, job->source_file_decl);
+
+                for (CS_PendingDependency *src = job->sources; src; src = src->next)
+                {
+                    add_pending_source(ctx, src->path, src->is_embedded);
+                }
+                /* A header's parse belongs to the first TU that reaches it */
+                for (CS_PendingDependency *h = job->headers; h; h = h->next)
+                {
+                    CS_HeaderClaim *claim = find_header_claim(pfe, h->path);
+                    if (!claim || file_is_listed(listed, claim->fd))
+                        continue;
+                    mark_as_compiled(ctx, h->path, h->is_embedded);
+                    list_file(ctx->header_store, listed, claim->fd);
+                    for (CS_PendingDependency *src = claim->sources; src; src = src->next)
+                    {
+                        add_pending_source(ctx, src->path, src->is_embedded);
+                    }
+                }
+
+                ok = check_source_job(ctx, job);
+            }
+            free(dep->path);
+            free(dep);
+        }
+        name_map_destroy(listed);
+    }
+
+    free_dependency_list(roots);
+    free_dependency_list(ctx->pending_sources);
+    ctx->pending_sources = NULL;
+    path_map_reset(ctx->pending_paths, NULL);
+    while (pfe->jobs)
+    {
+        CS_SourceJob *next = pfe->jobs->next;
+        source_job_free(pfe->jobs);
+        pfe->jobs = next;
+    }
+    while (pfe->claims)
+    {
+        CS_HeaderClaim *next = pfe->claims->next;
+        free(pfe->claims->path);
+        free_dependency_list(pfe->claims->sources);
+        free(pfe->claims);
+        pfe->claims = next;
+    }
+    cs_path_map_destroy(pfe->job_map);
+    name_map_destroy(pfe->claim_map);
+    free(pfe);
+    return ok;
+}
+#endif
+
+/* --incremental: load the previous build's manifest and start the new one.
+ * Both are keyed by the compiler and the options that change the classes. */
+static void start_incremental_build(CompilerContext *ctx)
+{
+    char *fingerprint = (char *)calloc(96, sizeof(char));
+    snprintf(fingerprint, 96, "compiler %d no-peephole %d method-limit %d",
+             (int)cs_compiler_hash(), ctx->no_peephole ? 1 : 0, ctx->method_limit);
+    ctx->previous_build = build_manifest_load(fingerprint);
+    ctx->build = build_manifest_create(fingerprint);
+    free(fingerprint);
+}
+
 bool CS_compile(CompilerContext *ctx, const char *path, bool is_embedded)
 {
     if (!ctx || !path || !path[0])
         return false;
 
+    if (ctx->incremental && !ctx->build)
+        start_incremental_build(ctx);
+
     /* Add initial entry to source queue */
     add_pending_source(ctx, path, is_embedded);
 
+#ifdef __GNUC__
+    if (ctx->jobs > 1)
+        return compile_parallel(ctx);
+#endif
+
     /* Process source queue (headers are processed inside compile_source_internal).
      * Each source file has its own per-TU mean_check inside compile_source_internal. */
     CS_PendingDependency *dep;
-    while ((dep = pop_pending_source(ctx)) != NULL)
+    while ((dep = cs_pop_pending_source(ctx)) != NULL)
     {
         bool ok = compile_source_internal(ctx, dep->path, dep->is_embedded);
 
@@ -504,10 +1345,98 @@ static char *get_corresponding_source(const char *header_path)
     return source_path;
 }
 
+/* Fill fd from the header cache, queueing the header's dependencies as
+ * parsing would.  False if the cache is off or has no current entry. */
+static bool load_cached_header(CompilerContext *ctx, FileDecl *fd, bool is_embedded,
+                               const unsigned char *bytes, int size, Arena *header_arena,
+                               CS_HeaderStack *pending_headers_out,
+                               CS_PendingDependency **sources_out)
+{
+    if (!ctx->header_cache_dir)
+        return false;
+
+    FileDependency *deps = NULL;
+    int dep_count = 0;
+    Arena *previous_arena = arena_set_current(header_arena);
+    bool hit = header_cache_load(ctx->header_cache_dir, fd, is_embedded, bytes, size, &deps, &dep_count);
+    arena_set_current(previous_arena);
+    if (!hit)
+        return false;
+
+    for (int i = 0; i < dep_count; ++i)
+    {
+        queue_dependency(ctx, deps[i].path, deps[i].is_embedded, pending_headers_out, sources_out);
+        if (is_header_path(deps[i].path))
+        {
+            file_decl_add_dependency(fd, deps[i].path, deps[i].is_embedded);
+        }
+    }
+    free(deps);
+    return true;
+}
+
+/* Parse a header's bytes into fd with a fresh TranslationUnit (no recursion) */
+static bool parse_header_bytes(CompilerContext *ctx, FileDecl *fd, bool is_embedded,
+                               const unsigned char *bytes, int size, Arena *header_arena,
+                               CS_HeaderStack *pending_headers_out,
+                               CS_PendingDependency **sources_out)
+{
+    TranslationUnit *tu = tu_create(ctx, fd->path);
+    Arena *previous_arena = arena_set_current(header_arena);
+
+    CS_ScannerConfig config = {
+        .source_path = fd->path,
+        .input_bytes = bytes,
+        .input_size = size,
+        .tu = tu,
+    };
+
+    Scanner *scanner = cs_create_scanner(&config);
+    if (!scanner)
+    {
+        arena_set_current(previous_arena);
+        return false;
+    }
+
+    /* Declarations are added to the header's FileDecl during parsing */
+    tu->current_file_decl = fd;
+
+    if (yyparse(scanner) != 0)
+    {
+        cs_delete_scanner(scanner);
+        arena_set_current(previous_arena);
+        return false;
+    }
+    arena_set_current(previous_arena);
+
+    /* Collect dependencies into output list (no recursive parsing here) */
+    collect_dependencies_to_lists(ctx, scanner, pending_headers_out, sources_out);
+
+    /* Store header dependencies in FileDecl for later reuse */
+    int dep_count = cs_scanner_dependency_count(scanner);
+    for (int i = 0; i < dep_count; ++i)
+    {
+        const char *dep_path = cs_scanner_dependency_path(scanner, i);
+        bool dep_is_embedded = cs_scanner_dependency_is_embedded(scanner, i);
+        if (dep_path && is_header_path(dep_path))
+        {
+            file_decl_add_dependency(fd, dep_path, dep_is_embedded);
+        }
+    }
+
+    if (ctx->header_cache_dir)
+    {
+        header_cache_store(ctx->header_cache_dir, fd, is_embedded, bytes, size, scanner);
+    }
+    cs_delete_scanner(scanner);
+    return true;
+}
+
 /* Parse a single header file. Dependencies are collected into pending_headers_out.
  * Each header is parsed with its own fresh TranslationUnit (no recursion). */
 static bool parse_header_internal(CompilerContext *ctx, const char *header_path, bool is_embedded,
-                                  CS_PendingDependency **pending_headers_out)
+                                  CS_HeaderStack *pending_headers_out,
+                                  CS_PendingDependency **sources_out)
 {
     if (!ctx || !header_path)
         return false;
@@ -517,7 +1446,9 @@ static bool parse_header_internal(CompilerContext *ctx, const char *header_path,
         return true;
 
     /* Mark as compiled early to prevent re-entry */
+    context_lock(ctx);
     mark_as_compiled(ctx, header_path, is_embedded);
+    context_unlock(ctx);
 
     unsigned char *input_bytes = NULL;
     int input_size = 0;
@@ -548,52 +1479,20 @@ static bool parse_header_internal(CompilerContext *ctx, const char *header_path,
         return false;
     }
 
-    /* Create fresh TranslationUnit for this header */
-    TranslationUnit *tu = tu_create(ctx, header_path);
-
-    CS_ScannerConfig config = {
-        .source_path = header_path,
-        .input_bytes = input_bytes,
-        .input_size = input_size,
-        .tu = tu,
-    };
-
-    Scanner *scanner = cs_create_scanner(&config);
-    if (!scanner)
-    {
-        if (input_owned)
-            free(input_bytes);
-        return false;
-    }
-
-    /* Create FileDecl for this header (declarations will be added during parsing) */
-    tu->current_file_decl = header_store_get_or_create(ctx->header_store, header_path);
+    /* The header's nodes are kept with the HeaderStore (in an arena of their own
+     * while workers parse concurrently) */
+    Arena *header_arena = ctx->parallel ? arena_create(header_path) : ctx->header_arena;
+    FileDecl *fd = header_store_get_or_create(ctx->header_store, header_path);
 
-    if (yyparse(scanner) != 0)
+    bool loaded = load_cached_header(ctx, fd, is_embedded, input_bytes, input_size, header_arena,
+                                     pending_headers_out, sources_out);
+    if (!loaded && !parse_header_bytes(ctx, fd, is_embedded, input_bytes, input_size, header_arena,
+                                       pending_headers_out, sources_out))
     {
-        cs_delete_scanner(scanner);
         if (input_owned)
             free(input_bytes);
         return false;
     }
-
-    /* Collect dependencies into output list (no recursive parsing here) */
-    collect_dependencies_to_lists(ctx, scanner, pending_headers_out);
-
-    /* Store header dependencies in FileDecl for later reuse */
-    FileDecl *fd = tu->current_file_decl;
-    int dep_count = cs_scanner_dependency_count(scanner);
-    for (int i = 0; i < dep_count; ++i)
-    {
-        const char *dep_path = cs_scanner_dependency_path(scanner, i);
-        bool dep_is_embedded = cs_scanner_dependency_is_embedded(scanner, i);
-        if (dep_path && is_header_path(dep_path))
-        {
-            file_decl_add_dependency(fd, dep_path, dep_is_embedded);
-        }
-    }
-
-    cs_delete_scanner(scanner);
     if (input_owned)
         free(input_bytes);
 
@@ -616,7 +1515,7 @@ static bool parse_header_internal(CompilerContext *ctx, const char *header_path,
             const EmbeddedFile *embedded_src = embedded_find(name);
             if (embedded_src)
             {
-                add_pending_source(ctx, corresponding_source, true);
+                queue_source(ctx, corresponding_source, true, sources_out);
             }
         }
         else
@@ -626,7 +1525,7 @@ static bool parse_header_internal(CompilerContext *ctx, const char *header_path,
             if (fp)
             {
                 fclose(fp);
-                add_pending_source(ctx, corresponding_source, false);
+                queue_source(ctx, corresponding_source, false, sources_out);
             }
         }
         free(corresponding_source);
@@ -641,17 +1540,18 @@ void cs_add_runtime_dependency(CompilerContext *ctx, const char *header_name)
         return;
 
     /* Parse header and all its dependencies using the same loop pattern */
-    CS_PendingDependency *pending_headers = NULL;
-    add_pending_header_local(&pending_headers, header_name, true);
+    CS_HeaderStack *pending_headers = header_stack_create();
+    add_pending_header_local(pending_headers, header_name, true);
 
     CS_PendingDependency *hdr;
-    while ((hdr = pop_pending_header_local(&pending_headers)) != NULL)
+    while ((hdr = pop_pending_header_local(pending_headers)) != NULL)
     {
         if (!header_store_is_parsed(ctx->header_store, hdr->path))
         {
-            parse_header_internal(ctx, hdr->path, hdr->is_embedded, &pending_headers);
+            parse_header_internal(ctx, hdr->path, hdr->is_embedded, pending_headers, NULL);
         }
         free(hdr->path);
         free(hdr);
     }
+    header_stack_destroy(pending_headers);
 }
@@ -20,6 +20,14 @@ typedef struct CS_PendingDependency_tag
     struct CS_PendingDependency_tag *next;
 } CS_PendingDependency;
 
+/* Dependency paths -> values.  Paths are compared without a leading "./"
+ * and interned once; embedded files and files on disk are kept apart. */
+typedef struct CS_PathMap_tag
+{
+    NameMap *files;
+    NameMap *embedded_files;
+} CS_PathMap;
+
 /* Forward declare FileDecl */
 typedef struct FileDecl_tag FileDecl;
 
@@ -31,11 +39,29 @@ typedef struct CompilerContext_tag
     HeaderStore *header_store;             /* Persistent storage for all declarations */
     CS_PendingDependency *pending_sources; /* Source files to compile */
     CS_PendingDependency *compiled_deps;   /* Already compiled dependencies */
+    CS_PathMap *pending_paths;             /* Paths in pending_sources */
+    CS_PathMap *compiled_paths;            /* Paths in compiled_deps */
+    struct Arena_tag *header_arena;        /* Nodes of parsed headers (live as long as header_store) */
 
     /* Aggregated from all translation units (for mean_check and codegen)
      * Note: functions are stored in FileDecl->functions directly */
     StatementList *all_statements;
     DeclarationList *all_declarations;
+    StatementList *all_statements_last; /* Tails the next TU is appended after */
+    DeclarationList *all_declarations_last;
+
+    /* Code generation options (command line) */
+    bool no_peephole;    /* --no-peephole: skip the bytecode peephole pass */
+    bool peephole_stats; /* --peephole-stats: report bytes removed per class */
+    int method_limit;    /* --method-limit=N: largest method body in bytes (0 = default) */
+    bool arena_stats;    /* --arena-stats: report node allocation per arena and string interning */
+    int jobs;            /* -j N: parse translation units on N threads (native build only) */
+    char *header_cache_dir; /* --header-cache[=DIR]: reuse parsed headers from DIR (NULL = off) */
+    bool cache_stats;       /* --cache-stats: report header cache hits and misses, skipped type resolution and include closure use */
+    bool incremental;       /* --incremental: skip TUs whose inputs match the build manifest */
+    struct BuildManifest_tag *previous_build; /* Manifest of the last build (NULL if none or stale) */
+    struct BuildManifest_tag *build;          /* Manifest of this build, written after codegen */
+    bool parallel;       /* Set while the -j worker threads run */
 } CompilerContext;
 
 /*
@@ -53,6 +79,11 @@ typedef struct TranslationUnit_tag
     StatementList *stmt_list;
     DeclarationList *decl_list;
 
+    /* Name -> first declaration in decl_list (see cs_search_decl_global) */
+    NameMap *decl_map;
+    DeclarationList *decl_map_list; /* decl_list the map was built from */
+    DeclarationList *decl_map_last; /* Last node of it already in the map */
+
     /* Translation unit local */
     FileDecl *current_file_decl;
 
@@ -90,5 +121,18 @@ TranslationUnit *tu_create(CompilerContext *ctx, const char *source_path);
 bool CS_compile(CompilerContext *ctx, const char *path, bool is_embedded);
 void cs_add_runtime_dependency(CompilerContext *ctx, const char *header_name);
 
+/* compiler.c - Path maps (see CS_PathMap) */
+CS_PathMap *cs_path_map_create();
+void *cs_path_map_get(CS_PathMap *map, const char *path, bool is_embedded);
+/* Set the value for path; NULL takes it out */
+void cs_path_map_set(CS_PathMap *map, const char *path, bool is_embedded, void *value);
+void cs_path_map_destroy(CS_PathMap *map);
+
+/* Take the next source off ctx->pending_sources (NULL if none) */
+CS_PendingDependency *cs_pop_pending_source(CompilerContext *ctx);
+
+/* Report include closures computed and headers indexed through them to stderr */
+void cs_print_closure_stats();
+
 /* Compatibility macro: parser uses 'compiler' but we pass TranslationUnit */
 #define compiler tu
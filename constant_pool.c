@@ -87,6 +87,12 @@ static void ensure_metadata_capacity(ConstantPoolBuilder *cp, int index)
     cp->metadata_capacity = new_cap;
 }
 
+/* True if a deduplicated entry already carries metadata of this type */
+static bool has_metadata(ConstantPoolBuilder *cp, int index, CP_ConstantType type)
+{
+    return index < cp->metadata_count && cp->metadata[index].type == type;
+}
+
 static void set_metadata_at(ConstantPoolBuilder *cp, int index, CP_ConstantType type)
 {
     ensure_metadata_capacity(cp, index);
@@ -162,6 +168,10 @@ int cp_builder_add_string_len(ConstantPoolBuilder *cp, const char *data, int len
         return 0;
     }
     int idx = cf_cp_add_string_len(cp->cf_cp, (const uint8_t *)data, len);
+    if (has_metadata(cp, idx, CP_CONST_STRING))
+    {
+        return idx;
+    }
     set_metadata_at(cp, idx, CP_CONST_STRING);
     cp->metadata[idx].u.c_string.len = len;
     cp->metadata[idx].u.c_string.data = (uint8_t *)calloc(len, sizeof(uint8_t));
@@ -201,6 +211,10 @@ int cp_builder_add_methodref(ConstantPoolBuilder *cp, const char *class_name,
     }
 
     int idx = cf_cp_add_methodref(cp->cf_cp, class_name, method_name, descriptor);
+    if (has_metadata(cp, idx, CP_CONST_METHOD))
+    {
+        return idx;
+    }
     set_metadata_at(cp, idx, CP_CONST_METHOD);
     cp->metadata[idx].u.c_method.class_name = strdup(class_name ? class_name : "");
     cp->metadata[idx].u.c_method.name = strdup(method_name ? method_name : "");
@@ -238,6 +252,10 @@ int cp_builder_add_fieldref(ConstantPoolBuilder *cp, const char *class_name,
     }
 
     int idx = cf_cp_add_fieldref(cp->cf_cp, class_name, field_name, descriptor);
+    if (has_metadata(cp, idx, CP_CONST_FIELD))
+    {
+        return idx;
+    }
     set_metadata_at(cp, idx, CP_CONST_FIELD);
     cp->metadata[idx].u.c_field.class_name = strdup(class_name ? class_name : "");
     cp->metadata[idx].u.c_field.name = strdup(field_name ? field_name : "");
@@ -255,6 +273,10 @@ int cp_builder_add_class(ConstantPoolBuilder *cp, const char *class_name)
     }
 
     int idx = cf_cp_add_class(cp->cf_cp, class_name);
+    if (has_metadata(cp, idx, CP_CONST_CLASS))
+    {
+        return idx;
+    }
     set_metadata_at(cp, idx, CP_CONST_CLASS);
     cp->metadata[idx].u.c_class.name = strdup(class_name ? class_name : "");
     cp->metadata[idx].u.c_class.class_index = -1;
@@ -2,9 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "ascii.h"
 #include "ast.h"
 #include "definitions.h"
+#include "intern.h"
 #include "compiler.h"
 #include "create.h"
 #include "util.h"
@@ -13,14 +15,14 @@
 
 static Expression *cs_create_expression(CS_Creator *creator, ExpressionKind ekind)
 {
-    Expression *expr = (Expression *)calloc(1, sizeof(Expression));
+    Expression *expr = arena_new_expression();
     expr->kind = ekind;
     expr->type = NULL;
     expr->parsed_type = NULL;
     expr->line_number = creator ? creator->line_number : 1;
     if (creator && creator->source_path)
     {
-        expr->input_location.path = cs_create_identifier(creator->source_path);
+        expr->input_location.path = cs_intern(creator->source_path);
     }
     else
     {
@@ -74,8 +76,7 @@ Expression *cs_create_null_expression(CS_Creator *creator)
 ExpressionList *cs_chain_expression_list(ExpressionList *list, Expression *expr)
 {
     ExpressionList *p = list;
-    ExpressionList *nlist =
-        (ExpressionList *)calloc(1, sizeof(ExpressionList));
+    ExpressionList *nlist = arena_new_expression_list();
     nlist->next = NULL;
     nlist->expression = expr;
     if (p != NULL)
@@ -112,7 +113,7 @@ Expression *cs_create_string_expression(CS_Creator *creator, CS_String v)
 Expression *cs_create_identifier_expression(CS_Creator *creator, char *identifier)
 {
     Expression *expr = cs_create_expression(creator, IDENTIFIER_EXPRESSION);
-    expr->u.identifier.name = identifier;
+    expr->u.identifier.name = (char *)cs_intern(identifier);
     expr->u.identifier.is_function = false;
     expr->u.identifier.is_enum_member = false;
     expr->u.identifier.u.declaration = NULL;
@@ -301,9 +302,10 @@ Expression *cs_create_array_to_pointer_expression(CS_Creator *creator,
     return expr;
 }
 
+/* Identifiers are interned: the result is shared and must not be modified */
 char *cs_create_identifier(const char *str)
 {
-    return strdup(str);
+    return (char *)cs_intern(str);
 }
 
 /* Extract a quoted string and advance cursor past the closing quote */
@@ -441,7 +443,7 @@ static bool extract_java_ref(const char *raw, const char *prefix,
 
 AttributeSpecifier *cs_create_attribute(const char *raw_text)
 {
-    AttributeSpecifier *attr = (AttributeSpecifier *)calloc(1, sizeof(AttributeSpecifier));
+    AttributeSpecifier *attr = arena_new_attribute();
     attr->kind = CS_ATTRIBUTE_UNKNOWN;
     attr->text = cs_create_identifier(raw_text ? raw_text : "");
     attr->class_name = NULL;
@@ -543,7 +545,7 @@ AttributeSpecifier *cs_chain_attribute(AttributeSpecifier *list,
 /* For Statement */
 static Statement *cs_create_statement(CS_Creator *creator, StatementType type)
 {
-    Statement *stmt = (Statement *)calloc(1, sizeof(Statement));
+    Statement *stmt = arena_new_statement();
     stmt->type = type;
     stmt->line_number = creator ? creator->line_number : 1;
     return stmt;
@@ -664,10 +666,10 @@ Statement *cs_create_return_statement(CS_Creator *creator, Expression *expressio
 ParameterList *cs_create_parameter(CS_Creator *creator, ParsedType *type,
                                    char *name, bool is_ellipsis)
 {
-    ParameterList *param = (ParameterList *)calloc(1, sizeof(ParameterList));
+    ParameterList *param = arena_new_parameter_list();
     param->type = NULL;
     param->parsed_type = cs_copy_parsed_type(type);
-    param->name = name;
+    param->name = (char *)cs_intern(name);
     param->line_number = creator ? creator->line_number : 1;
     param->is_ellipsis = is_ellipsis;
     param->next = NULL;
@@ -678,13 +680,13 @@ static Declaration *cs_create_declaration(CS_Creator *creator, ParsedType *type,
                                           char *name, Expression *initializer,
                                           bool is_static)
 {
-    Declaration *decl = (Declaration *)calloc(1, sizeof(Declaration));
+    Declaration *decl = arena_new_declaration();
     decl->type = NULL;
     decl->parsed_type = cs_copy_parsed_type(type);
-    decl->name = name;
+    decl->name = (char *)cs_intern(name);
     decl->initializer = initializer;
     const char *path = creator ? creator->source_path : NULL;
-    decl->source_path = path ? strdup(path) : NULL;
+    decl->source_path = (char *)cs_intern(path);
     decl->class_name = NULL; /* Set by header_decl_add_declaration from FileDecl */
     decl->index = -1;
     decl->needs_heap_lift = false;
@@ -703,7 +705,7 @@ Statement *cs_create_declaration_statement(CS_Creator *creator, ParsedType *type
 
 StatementList *cs_create_statement_list(Statement *stmt)
 {
-    StatementList *stmt_list = (StatementList *)calloc(1, sizeof(StatementList));
+    StatementList *stmt_list = arena_new_statement_list();
     stmt_list->stmt = stmt;
     stmt_list->next = NULL;
     return stmt_list;
@@ -711,7 +713,7 @@ StatementList *cs_create_statement_list(Statement *stmt)
 
 DeclarationList *cs_create_declaration_list(Declaration *decl)
 {
-    DeclarationList *list = calloc(1, sizeof(DeclarationList));
+    DeclarationList *list = arena_new_declaration_list();
     list->next = NULL;
     list->decl = decl;
     return list;
@@ -726,18 +728,17 @@ FunctionDeclaration *cs_create_function_declaration(CS_Creator *creator,
                                                     AttributeSpecifier *attributes,
                                                     Statement *body)
 {
-    FunctionDeclaration *decl =
-        (FunctionDeclaration *)calloc(1, sizeof(FunctionDeclaration));
+    FunctionDeclaration *decl = arena_new_function_declaration();
     decl->type = NULL;
     decl->parsed_type = cs_copy_parsed_type(type);
-    decl->name = name;
+    decl->name = (char *)cs_intern(name);
     decl->param = param;
     decl->is_variadic = is_variadic;
     decl->is_static = is_static;
     decl->attributes = attributes;
     decl->body = body;
     const char *path = creator ? creator->source_path : NULL;
-    decl->source_path = path ? strdup(path) : NULL;
+    decl->source_path = (char *)cs_intern(path);
     decl->class_name = NULL; /* Set by header_decl_add_function from FileDecl */
     decl->index = -1;
     return decl;
@@ -745,7 +746,7 @@ FunctionDeclaration *cs_create_function_declaration(CS_Creator *creator,
 
 ArgumentList *cs_create_argument(Expression *expr)
 {
-    ArgumentList *argument = calloc(1, sizeof(ArgumentList));
+    ArgumentList *argument = arena_new_argument_list();
     argument->expr = expr;
     argument->next = NULL;
     return argument;
@@ -19,7 +19,6 @@ const unsigned char embedded_limits_data[] = {
 0x38, 0x3b, 0x0a, 0x63, 0x6f, 0x6e, 0x73, 0x74, 0x20, 0x69, 0x6e, 0x74, 0x20, 0x49, 0x4e, 0x54,
 0x5f, 0x4d, 0x41, 0x58, 0x20, 0x3d, 0x20, 0x32, 0x31, 0x34, 0x37, 0x34, 0x38, 0x33, 0x36, 0x34,
 0x37, 0x3b, 0x0a,
-
 };
 const int embedded_limits_size = sizeof embedded_limits_data;
 
@@ -38,7 +37,6 @@ const unsigned char embedded_limits_h_data[] = {
 0x6e, 0x74, 0x20, 0x49, 0x4e, 0x54, 0x5f, 0x4d, 0x49, 0x4e, 0x3b, 0x0a, 0x65, 0x78, 0x74, 0x65,
 0x72, 0x6e, 0x20, 0x63, 0x6f, 0x6e, 0x73, 0x74, 0x20, 0x69, 0x6e, 0x74, 0x20, 0x49, 0x4e, 0x54,
 0x5f, 0x4d, 0x41, 0x58, 0x3b, 0x0a,
-
 };
 const int embedded_limits_h_size = sizeof embedded_limits_h_data;
 
@@ -51,13 +49,11 @@ const unsigned char embedded_stdarg_h_data[] = {
 0x6e, 0x5f, 0x76, 0x61, 0x5f, 0x61, 0x72, 0x67, 0x28, 0x76, 0x61, 0x5f, 0x6c, 0x69, 0x73, 0x74,
 0x20, 0x61, 0x70, 0x29, 0x3b, 0x0a, 0x76, 0x6f, 0x69, 0x64, 0x20, 0x76, 0x61, 0x5f, 0x65, 0x6e,
 0x64, 0x28, 0x76, 0x61, 0x5f, 0x6c, 0x69, 0x73, 0x74, 0x20, 0x61, 0x70, 0x29, 0x3b, 0x0a,
-
 };
 const int embedded_stdarg_h_size = sizeof embedded_stdarg_h_data;
 
 const unsigned char embedded_stddef_h_data[] = {
 0x23, 0x70, 0x72, 0x61, 0x67, 0x6d, 0x61, 0x20, 0x6f, 0x6e, 0x63, 0x65, 0x0a,
-
 };
 const int embedded_stddef_h_size = sizeof embedded_stddef_h_data;
 
@@ -77,7 +73,6 @@ const unsigned char embedded_stdint_h_data[] = {
 0x74, 0x36, 0x34, 0x5f, 0x74, 0x3b, 0x0a, 0x74, 0x79, 0x70, 0x65, 0x64, 0x65, 0x66, 0x20, 0x75,
 0x6e, 0x73, 0x69, 0x67, 0x6e, 0x65, 0x64, 0x20, 0x6c, 0x6f, 0x6e, 0x67, 0x20, 0x75, 0x69, 0x6e,
 0x74, 0x36, 0x34, 0x5f, 0x74, 0x3b, 0x0a,
-
 };
 const int embedded_stdint_h_size = sizeof embedded_stdint_h_data;
 
@@ -969,7 +964,6 @@ const unsigned char embedded_stdio_data[] = {
 0x20, 0x20, 0x73, 0x74, 0x72, 0x65, 0x61, 0x6d, 0x43, 0x6c, 0x6f, 0x73, 0x65, 0x28, 0x66, 0x69,
 0x6c, 0x65, 0x2d, 0x3e, 0x73, 0x74, 0x72, 0x65, 0x61, 0x6d, 0x29, 0x3b, 0x0a, 0x20, 0x20, 0x20,
 0x20, 0x72, 0x65, 0x74, 0x75, 0x72, 0x6e, 0x20, 0x30, 0x3b, 0x0a, 0x7d, 0x0a,
-
 };
 const int embedded_stdio_size = sizeof embedded_stdio_data;
 
@@ -1022,7 +1016,6 @@ const unsigned char embedded_stdio_h_data[] = {
 0x63, 0x6c, 0x6f, 0x73, 0x65, 0x28, 0x46, 0x49, 0x4c, 0x45, 0x20, 0x2a, 0x66, 0x69, 0x6c, 0x65,
 0x29, 0x3b, 0x0a, 0x0a, 0x65, 0x6e, 0x75, 0x6d, 0x0a, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x45,
 0x4f, 0x46, 0x20, 0x3d, 0x20, 0x2d, 0x31, 0x0a, 0x7d, 0x3b, 0x0a,
-
 };
 const int embedded_stdio_h_size = sizeof embedded_stdio_h_data;
 
@@ -1465,7 +1458,6 @@ const unsigned char embedded_stdlib_data[] = {
 0x72, 0x74, 0x29, 0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x72, 0x65, 0x74, 0x75, 0x72, 0x6e, 0x20,
 0x70, 0x61, 0x72, 0x73, 0x65, 0x46, 0x6c, 0x6f, 0x61, 0x74, 0x28, 0x6a, 0x73, 0x74, 0x72, 0x29,
 0x3b, 0x0a, 0x7d, 0x0a,
-
 };
 const int embedded_stdlib_size = sizeof embedded_stdlib_data;
 
@@ -1491,7 +1483,6 @@ const unsigned char embedded_stdlib_h_data[] = {
 0x6f, 0x66, 0x28, 0x63, 0x6f, 0x6e, 0x73, 0x74, 0x20, 0x63, 0x68, 0x61, 0x72, 0x20, 0x2a, 0x73,
 0x74, 0x72, 0x2c, 0x20, 0x63, 0x68, 0x61, 0x72, 0x20, 0x2a, 0x2a, 0x65, 0x6e, 0x64, 0x70, 0x74,
 0x72, 0x29, 0x3b, 0x0a,
-
 };
 const int embedded_stdlib_h_size = sizeof embedded_stdlib_h_data;
 
@@ -1616,7 +1607,6 @@ const unsigned char embedded_string_data[] = {
 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x69, 0x20, 0x3d, 0x20, 0x69, 0x20, 0x2b, 0x20, 0x31,
 0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x72, 0x65, 0x74, 0x75,
 0x72, 0x6e, 0x20, 0x64, 0x65, 0x73, 0x74, 0x3b, 0x0a, 0x7d, 0x0a,
-
 };
 const int embedded_string_size = sizeof embedded_string_data;
 
@@ -1645,7 +1635,6 @@ const unsigned char embedded_string_h_data[] = {
 0x20, 0x2a, 0x73, 0x74, 0x72, 0x6e, 0x63, 0x70, 0x79, 0x28, 0x63, 0x68, 0x61, 0x72, 0x20, 0x2a,
 0x64, 0x65, 0x73, 0x74, 0x2c, 0x20, 0x63, 0x6f, 0x6e, 0x73, 0x74, 0x20, 0x63, 0x68, 0x61, 0x72,
 0x20, 0x2a, 0x73, 0x72, 0x63, 0x2c, 0x20, 0x69, 0x6e, 0x74, 0x20, 0x6e, 0x29, 0x3b, 0x0a,
-
 };
 const int embedded_string_h_size = sizeof embedded_string_h_data;
 
@@ -1664,6 +1653,8 @@ const EmbeddedFile embedded_files[] = {
 };
 const int embedded_file_count = sizeof embedded_files / sizeof *embedded_files;
 
+const unsigned int embedded_compiler_hash = 788587895U;
+
 const EmbeddedFile *embedded_find(const char *name)
 {
     if (!name)
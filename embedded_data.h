@@ -47,5 +47,9 @@ extern const int embedded_string_h_size;
 extern const EmbeddedFile embedded_files[];
 extern const int embedded_file_count;
 
+/* Checksum of the compiler's sources and the embedded files, taken when
+ * embedded_data.c is generated */
+extern const unsigned int embedded_compiler_hash;
+
 /* Lookup an embedded file by basename (e.g., "stdio.c") */
 const EmbeddedFile *embedded_find(const char *name);
@@ -15,7 +15,8 @@ typedef enum
 {
     CS_FUNC_SIG_FROM_DECL = 0,
     CS_FUNC_SIG_C_MAIN,
-    CS_FUNC_SIG_JVM_MAIN_WRAPPER
+    CS_FUNC_SIG_JVM_MAIN_WRAPPER,
+    CS_FUNC_SIG_OUTLINED /* Helper split off a large method: uses descriptor */
 } CS_FunctionSignatureKind;
 
 typedef struct
@@ -28,6 +29,7 @@ typedef struct
     bool is_jvm_main;   /* Function should be emitted as JVM main */
     bool is_static;     /* static function -> private in JVM */
     bool main_has_args; /* main takes (int argc, char *argv[]) */
+    char *descriptor;   /* CS_FUNC_SIG_OUTLINED: method descriptor */
     uint8_t *code;
     int code_size;
     int max_stack;
@@ -55,6 +57,8 @@ typedef struct
     ConstantPoolBuilder *cp; /* Constant pool (owned) */
     CG_StaticField *jvm_static_fields;
     int jvm_static_field_count;
+    CG_StringLiteral *string_literals;
+    int string_literal_count;
     CG_ClassDef *jvm_class_defs;
     int jvm_class_def_count;
     CS_Function *functions;
@@ -72,4 +76,7 @@ typedef struct
     /* Split clinit helper methods (when <clinit> exceeds 64KB) */
     CS_ClinitPart *clinit_parts;
     int clinit_part_count;
+
+    /* Bytes the peephole pass removed (reported by --peephole-stats) */
+    int peephole_bytes_removed;
 } CS_Executable;
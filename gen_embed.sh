@@ -1,6 +1,9 @@
 #!/bin/sh
 # Generate embedded_data.c from source files
-# Usage: ./gen_embed.sh file1=name1 file2=name2 ... > embedded_data.c
+# Usage: COMPILER_SOURCES="a.c b.h ..." ./gen_embed.sh file1=name1 file2=name2 ... > embedded_data.c
+#
+# The checksum of COMPILER_SOURCES and the embedded files becomes
+# embedded_compiler_hash, which identifies the compiler in cache keys.
 
 echo "/* Auto-generated file - do not edit */"
 echo "#include \"embedded_data.h\""
@@ -33,6 +36,14 @@ done
 echo "};"
 echo "const int embedded_file_count = sizeof embedded_files / sizeof *embedded_files;"
 echo ""
+
+embedded=""
+for arg in "$@"; do
+    embedded="$embedded ${arg%%=*}"
+done
+hash=$(cat $COMPILER_SOURCES $embedded | cksum | cut -d' ' -f1)
+echo "const unsigned int embedded_compiler_hash = ${hash}U;"
+echo ""
 echo "const EmbeddedFile *embedded_find(const char *name)"
 echo "{"
 echo "    if (!name)"
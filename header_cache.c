@@ -0,0 +1,785 @@
+/*
+ * header_cache.c - On-disk cache of parsed headers
+ *
+ * Entry layout (integers are 4 bytes, little endian; strings are a length,
+ * -1 for NULL, followed by the bytes):
+ *
+ *   key:     magic, version, compiler hash, header path, embedded flag,
+ *            content size, two content hashes, payload size, payload hash
+ *   payload: #include list, structs, typedefs, enums,
+ *            functions (in declaration order), extern declarations
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "header_cache.h"
+#include "arena.h"
+#include "ast.h"
+#include "compiler.h"
+#include "create.h"
+#include "definitions.h"
+#include "intern.h"
+#include "parsed_type.h"
+#include "scanner.h"
+#include "util.h"
+
+#ifdef __GNUC__
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+enum
+{
+    /* Bump whenever the entry layout changes.  Parser and FileDecl changes
+     * are covered by the compiler hash in the key. */
+    HEADER_CACHE_VERSION = 1,
+    HEADER_CACHE_MAGIC = 0x43485343, /* "CSHC" */
+    HEADER_CACHE_INITIAL_CAPACITY = 4096
+};
+
+/* Array size expressions an entry can hold */
+enum
+{
+    CACHED_SIZE_NONE,
+    CACHED_SIZE_INT,
+    CACHED_SIZE_UINT,
+    CACHED_SIZE_IDENTIFIER
+};
+
+static int cache_hits = 0;
+static int cache_misses = 0;
+static int cache_stores = 0;
+static int cache_uncacheable = 0;
+static int cache_write_failures = 0;
+
+/* Atomic in the native build, where -j N workers load and store entries */
+#ifdef __GNUC__
+#define COUNT_EVENT(counter) __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED)
+#else
+#define COUNT_EVENT(counter) counter = counter + 1
+#endif
+
+void header_cache_print_stats()
+{
+    fprintf(stderr, "header cache: %d hits, %d misses, %d stored, %d not cacheable, %d write failures\n",
+            cache_hits, cache_misses, cache_stores, cache_uncacheable, cache_write_failures);
+}
+
+/* <dir>/<hash of path and embedded flag>.hdr */
+static char *entry_path(const char *dir, const char *path, bool is_embedded)
+{
+    uint32_t h = cs_content_hash((const unsigned char *)path, strlen(path));
+    if (is_embedded)
+    {
+        h = (h ^ 0x65U) * 16777619U;
+    }
+    const char *digits = "0123456789abcdef";
+    int dir_len = strlen(dir);
+    char *file = (char *)calloc(dir_len + 14, sizeof(char));
+    strcpy(file, dir);
+    file[dir_len] = '/';
+    for (int i = 0; i < 8; i++)
+    {
+        file[dir_len + 8 - i] = digits[(int)((h >> (4 * i)) & 15U)];
+    }
+    strcpy(file + dir_len + 9, ".hdr");
+    return file;
+}
+
+/* ============================================================
+ * Writing
+ * ============================================================ */
+
+typedef struct CacheWriter_tag
+{
+    unsigned char *data;
+    int size;
+    int capacity;
+    bool unsupported; /* fd holds something an entry cannot represent */
+} CacheWriter;
+
+static void writer_init(CacheWriter *w)
+{
+    w->capacity = HEADER_CACHE_INITIAL_CAPACITY;
+    w->data = (unsigned char *)calloc(w->capacity, sizeof(unsigned char));
+    w->size = 0;
+    w->unsupported = false;
+}
+
+static void put_byte(CacheWriter *w, int value)
+{
+    if (w->size == w->capacity)
+    {
+        int capacity = w->capacity * 2;
+        unsigned char *data = (unsigned char *)calloc(capacity, sizeof(unsigned char));
+        for (int i = 0; i < w->size; i++)
+        {
+            data[i] = w->data[i];
+        }
+        free(w->data);
+        w->data = data;
+        w->capacity = capacity;
+    }
+    w->data[w->size] = (unsigned char)(value & 255);
+    w->size = w->size + 1;
+}
+
+static void put_int(CacheWriter *w, int value)
+{
+    put_byte(w, value);
+    put_byte(w, value >> 8);
+    put_byte(w, value >> 16);
+    put_byte(w, value >> 24);
+}
+
+static void put_bool(CacheWriter *w, bool value)
+{
+    put_byte(w, value ? 1 : 0);
+}
+
+static void put_string(CacheWriter *w, const char *str)
+{
+    if (!str)
+    {
+        put_int(w, -1);
+        return;
+    }
+    int len = strlen(str);
+    put_int(w, len);
+    for (int i = 0; i < len; i++)
+    {
+        put_byte(w, str[i]);
+    }
+}
+
+static void put_array_size(CacheWriter *w, Expression *size)
+{
+    if (!size)
+    {
+        put_byte(w, CACHED_SIZE_NONE);
+        return;
+    }
+    if (size->kind == INT_EXPRESSION || size->kind == UINT_EXPRESSION)
+    {
+        put_byte(w, size->kind == INT_EXPRESSION ? CACHED_SIZE_INT : CACHED_SIZE_UINT);
+        put_int(w, size->line_number);
+        put_int(w, size->u.int_value);
+        return;
+    }
+    if (size->kind == IDENTIFIER_EXPRESSION)
+    {
+        put_byte(w, CACHED_SIZE_IDENTIFIER);
+        put_int(w, size->line_number);
+        put_string(w, size->u.identifier.name);
+        return;
+    }
+    w->unsupported = true;
+}
+
+static void put_parsed_type(CacheWriter *w, ParsedType *type)
+{
+    if (!type)
+    {
+        put_bool(w, false);
+        return;
+    }
+    put_bool(w, true);
+    put_int(w, type->kind);
+    put_int(w, type->basic_type);
+    put_int(w, type->name_space);
+    put_string(w, type->name);
+    put_bool(w, type->is_unsigned);
+    put_bool(w, type->is_const);
+    put_array_size(w, type->array_size);
+    put_parsed_type(w, type->child);
+}
+
+static void put_dependencies(CacheWriter *w, Scanner *scanner)
+{
+    int count = cs_scanner_dependency_count(scanner);
+    put_int(w, count);
+    for (int i = 0; i < count; i++)
+    {
+        put_string(w, cs_scanner_dependency_path(scanner, i));
+        put_bool(w, cs_scanner_dependency_is_embedded(scanner, i));
+    }
+}
+
+static void put_structs(CacheWriter *w, FileDecl *fd)
+{
+    put_int(w, fd->struct_count);
+    for (int i = 0; i < fd->struct_count; i++)
+    {
+        StructDefinition *def = fd->structs[i];
+        put_string(w, def->id.name);
+        put_string(w, def->id.search_name);
+        put_bool(w, def->is_union);
+        int count = 0;
+        for (StructMember *m = def->members; m; m = m->next)
+        {
+            count++;
+        }
+        put_int(w, count);
+        for (StructMember *m = def->members; m; m = m->next)
+        {
+            put_string(w, m->name);
+            put_parsed_type(w, m->parsed_type);
+        }
+    }
+}
+
+static void put_typedefs(CacheWriter *w, FileDecl *fd)
+{
+    put_int(w, fd->typedef_count);
+    for (int i = 0; i < fd->typedef_count; i++)
+    {
+        TypedefDefinition *def = fd->typedefs[i];
+        put_string(w, def->name);
+        put_parsed_type(w, def->parsed_type);
+        put_string(w, def->source_path);
+    }
+}
+
+static void put_enums(CacheWriter *w, FileDecl *fd)
+{
+    put_int(w, fd->enum_count);
+    for (int i = 0; i < fd->enum_count; i++)
+    {
+        EnumDefinition *def = fd->enums[i];
+        put_string(w, def->id.name);
+        put_string(w, def->id.search_name);
+        put_int(w, def->member_count);
+        for (EnumMember *m = def->members; m; m = m->next)
+        {
+            put_string(w, m->name);
+            put_int(w, m->value);
+            put_bool(w, m->has_explicit_value);
+        }
+    }
+}
+
+static void put_function(CacheWriter *w, FunctionDeclaration *func)
+{
+    if (func->body)
+    {
+        w->unsupported = true;
+        return;
+    }
+    put_string(w, func->name);
+    put_parsed_type(w, func->parsed_type);
+    put_bool(w, func->is_variadic);
+    put_bool(w, func->is_static);
+    put_string(w, func->source_path);
+
+    int count = 0;
+    for (ParameterList *p = func->param; p; p = p->next)
+    {
+        count++;
+    }
+    put_int(w, count);
+    for (ParameterList *p = func->param; p; p = p->next)
+    {
+        put_string(w, p->name);
+        put_parsed_type(w, p->parsed_type);
+        put_int(w, p->line_number);
+        put_bool(w, p->is_ellipsis);
+    }
+
+    count = 0;
+    for (AttributeSpecifier *a = func->attributes; a; a = a->next)
+    {
+        count++;
+    }
+    put_int(w, count);
+    for (AttributeSpecifier *a = func->attributes; a; a = a->next)
+    {
+        put_int(w, a->kind);
+        put_string(w, a->text);
+        put_string(w, a->class_name);
+        put_string(w, a->member_name);
+        put_string(w, a->descriptor);
+    }
+}
+
+static void put_functions(CacheWriter *w, FileDecl *fd)
+{
+    /* fd->functions is newest first; store them in declaration order */
+    FunctionDeclaration **funcs = (FunctionDeclaration **)calloc(fd->function_count + 1,
+                                                                  sizeof(FunctionDeclaration *));
+    int count = 0;
+    for (FunctionDeclarationList *node = fd->functions; node && count < fd->function_count; node = node->next)
+    {
+        funcs[count] = node->func;
+        count++;
+    }
+    put_int(w, count);
+    for (int i = count - 1; i >= 0; i--)
+    {
+        put_function(w, funcs[i]);
+    }
+    free(funcs);
+}
+
+static void put_declarations(CacheWriter *w, FileDecl *fd)
+{
+    put_int(w, fd->declaration_count);
+    for (int i = 0; i < fd->declaration_count; i++)
+    {
+        Declaration *decl = fd->declarations[i];
+        if (decl->initializer)
+        {
+            w->unsupported = true;
+        }
+        put_string(w, decl->name);
+        put_parsed_type(w, decl->parsed_type);
+        put_string(w, decl->source_path);
+        put_bool(w, decl->is_static);
+        put_bool(w, decl->is_extern);
+    }
+}
+
+static bool write_entry_file(const char *file, CacheWriter *key, CacheWriter *payload)
+{
+    FILE *fp = fopen(file, "wb");
+    if (!fp)
+    {
+        return false;
+    }
+    int written = fwrite((const char *)key->data, 1, key->size, fp);
+    bool ok = written == key->size;
+    if (ok)
+    {
+        written = fwrite((const char *)payload->data, 1, payload->size, fp);
+        ok = written == payload->size;
+    }
+    fclose(fp);
+    return ok;
+}
+
+void header_cache_store(const char *dir, FileDecl *fd, bool is_embedded,
+                        const unsigned char *bytes, int size, Scanner *scanner)
+{
+    if (!dir || !fd || !scanner)
+        return;
+
+    CacheWriter payload;
+    writer_init(&payload);
+    put_dependencies(&payload, scanner);
+    put_structs(&payload, fd);
+    put_typedefs(&payload, fd);
+    put_enums(&payload, fd);
+    put_functions(&payload, fd);
+    put_declarations(&payload, fd);
+    if (payload.unsupported)
+    {
+        free(payload.data);
+        COUNT_EVENT(cache_uncacheable);
+        return;
+    }
+
+    CacheWriter key;
+    writer_init(&key);
+    put_int(&key, HEADER_CACHE_MAGIC);
+    put_int(&key, HEADER_CACHE_VERSION);
+    put_int(&key, (int)cs_compiler_hash());
+    put_string(&key, fd->path);
+    put_bool(&key, is_embedded);
+    put_int(&key, size);
+    put_int(&key, (int)cs_content_hash(bytes, size));
+    put_int(&key, (int)cs_content_hash2(bytes, size));
+    put_int(&key, payload.size);
+    put_int(&key, (int)cs_content_hash(payload.data, payload.size));
+
+    char *file = entry_path(dir, fd->path, is_embedded);
+    bool ok = write_entry_file(file, &key, &payload);
+#ifdef __GNUC__
+    if (!ok)
+    {
+        mkdir(dir, 0777);
+        ok = write_entry_file(file, &key, &payload);
+    }
+#endif
+    if (ok)
+    {
+        COUNT_EVENT(cache_stores);
+    }
+    else
+    {
+        COUNT_EVENT(cache_write_failures);
+    }
+    free(file);
+    free(key.data);
+    free(payload.data);
+}
+
+/* ============================================================
+ * Reading
+ * ============================================================ */
+
+typedef struct CacheReader_tag
+{
+    const unsigned char *data;
+    int size;
+    int pos;
+    bool failed; /* Truncated or malformed entry */
+    const char *path;
+} CacheReader;
+
+static int get_byte(CacheReader *r)
+{
+    if (r->pos >= r->size)
+    {
+        r->failed = true;
+        return 0;
+    }
+    int value = r->data[r->pos];
+    r->pos = r->pos + 1;
+    return value;
+}
+
+static int get_int(CacheReader *r)
+{
+    uint32_t b0 = (uint32_t)get_byte(r);
+    uint32_t b1 = (uint32_t)get_byte(r);
+    uint32_t b2 = (uint32_t)get_byte(r);
+    uint32_t b3 = (uint32_t)get_byte(r);
+    return (int)(b0 | (b1 << 8) | (b2 << 16) | (b3 << 24));
+}
+
+static bool get_bool(CacheReader *r)
+{
+    return get_byte(r) != 0;
+}
+
+/* Element count; every element takes at least one byte */
+static int get_count(CacheReader *r)
+{
+    int count = get_int(r);
+    if (count < 0 || count > r->size - r->pos)
+    {
+        r->failed = true;
+        return 0;
+    }
+    return count;
+}
+
+static char *get_string(CacheReader *r)
+{
+    int len = get_int(r);
+    if (len == -1 || r->failed)
+    {
+        return NULL;
+    }
+    if (len < 0 || len > r->size - r->pos)
+    {
+        r->failed = true;
+        return NULL;
+    }
+    const char *str = cs_intern_span((const char *)(r->data + r->pos), len);
+    r->pos = r->pos + len;
+    return (char *)str;
+}
+
+static Expression *get_array_size(CacheReader *r)
+{
+    int tag = get_byte(r);
+    if (tag == CACHED_SIZE_NONE)
+    {
+        return NULL;
+    }
+    CS_Creator creator;
+    creator.line_number = get_int(r);
+    creator.source_path = r->path;
+    creator.tu = NULL;
+    if (tag == CACHED_SIZE_INT)
+    {
+        return cs_create_int_expression(&creator, get_int(r));
+    }
+    if (tag == CACHED_SIZE_UINT)
+    {
+        return cs_create_uint_expression(&creator, get_int(r));
+    }
+    if (tag == CACHED_SIZE_IDENTIFIER)
+    {
+        return cs_create_identifier_expression(&creator, get_string(r));
+    }
+    r->failed = true;
+    return NULL;
+}
+
+static ParsedType *get_parsed_type(CacheReader *r)
+{
+    if (!get_bool(r) || r->failed)
+    {
+        return NULL;
+    }
+    ParsedType *type = arena_new_parsed_type();
+    type->kind = (CS_TypeKind)get_int(r);
+    type->basic_type = (CS_BasicType)get_int(r);
+    type->name_space = (CS_TypeNamespace)get_int(r);
+    type->name = get_string(r);
+    type->is_unsigned = get_bool(r);
+    type->is_const = get_bool(r);
+    type->array_size = get_array_size(r);
+    type->child = get_parsed_type(r);
+    return type;
+}
+
+static StructDefinition *get_struct(CacheReader *r)
+{
+    StructDefinition *def = (StructDefinition *)calloc(1, sizeof(StructDefinition));
+    def->id.name = get_string(r);
+    def->id.search_name = get_string(r);
+    def->is_union = get_bool(r);
+    def->next = NULL;
+    int count = get_count(r);
+    StructMember *last = NULL;
+    for (int i = 0; i < count && !r->failed; i++)
+    {
+        StructMember *member = (StructMember *)calloc(1, sizeof(StructMember));
+        member->name = get_string(r);
+        member->type = NULL;
+        member->parsed_type = get_parsed_type(r);
+        member->next = NULL;
+        if (last)
+            last->next = member;
+        else
+            def->members = member;
+        last = member;
+    }
+    return def;
+}
+
+static TypedefDefinition *get_typedef(CacheReader *r)
+{
+    TypedefDefinition *def = (TypedefDefinition *)calloc(1, sizeof(TypedefDefinition));
+    def->name = get_string(r);
+    def->parsed_type = get_parsed_type(r);
+    def->type = NULL;
+    def->canonical = NULL;
+    def->source_path = get_string(r);
+    def->next = NULL;
+    return def;
+}
+
+static EnumDefinition *get_enum(CacheReader *r)
+{
+    EnumDefinition *def = (EnumDefinition *)calloc(1, sizeof(EnumDefinition));
+    def->id.name = get_string(r);
+    def->id.search_name = get_string(r);
+    def->next = NULL;
+    int count = get_count(r);
+    def->member_count = count;
+    EnumMember *last = NULL;
+    for (int i = 0; i < count && !r->failed; i++)
+    {
+        EnumMember *member = (EnumMember *)calloc(1, sizeof(EnumMember));
+        member->name = get_string(r);
+        member->value = get_int(r);
+        member->has_explicit_value = get_bool(r);
+        member->enum_def = def;
+        member->next = NULL;
+        if (last)
+            last->next = member;
+        else
+            def->members = member;
+        last = member;
+    }
+    return def;
+}
+
+static FunctionDeclaration *get_function(CacheReader *r)
+{
+    FunctionDeclaration *func = arena_new_function_declaration();
+    func->name = get_string(r);
+    func->type = NULL;
+    func->parsed_type = get_parsed_type(r);
+    func->is_variadic = get_bool(r);
+    func->is_static = get_bool(r);
+    func->source_path = get_string(r);
+    func->body = NULL;
+    func->class_name = NULL; /* Set by header_decl_add_function from FileDecl */
+    func->index = -1;
+
+    int count = get_count(r);
+    ParameterList *last_param = NULL;
+    for (int i = 0; i < count && !r->failed; i++)
+    {
+        ParameterList *param = arena_new_parameter_list();
+        param->type = NULL;
+        param->name = get_string(r);
+        param->parsed_type = get_parsed_type(r);
+        param->line_number = get_int(r);
+        param->is_ellipsis = get_bool(r);
+        param->decl = NULL;
+        param->next = NULL;
+        if (last_param)
+            last_param->next = param;
+        else
+            func->param = param;
+        last_param = param;
+    }
+
+    count = get_count(r);
+    AttributeSpecifier *last_attribute = NULL;
+    for (int i = 0; i < count && !r->failed; i++)
+    {
+        AttributeSpecifier *attribute = arena_new_attribute();
+        attribute->kind = (CS_AttributeKind)get_int(r);
+        attribute->text = get_string(r);
+        attribute->class_name = get_string(r);
+        attribute->member_name = get_string(r);
+        attribute->descriptor = get_string(r);
+        attribute->next = NULL;
+        if (last_attribute)
+            last_attribute->next = attribute;
+        else
+            func->attributes = attribute;
+        last_attribute = attribute;
+    }
+    return func;
+}
+
+static Declaration *get_declaration(CacheReader *r)
+{
+    Declaration *decl = arena_new_declaration();
+    decl->name = get_string(r);
+    decl->type = NULL;
+    decl->parsed_type = get_parsed_type(r);
+    decl->initializer = NULL;
+    decl->source_path = get_string(r);
+    decl->class_name = NULL; /* Set by header_decl_add_declaration from FileDecl */
+    decl->index = -1;
+    decl->needs_heap_lift = false;
+    decl->is_static = get_bool(r);
+    decl->is_extern = get_bool(r);
+    return decl;
+}
+
+/* Check the entry key against the header being compiled */
+static bool read_key(CacheReader *r, const char *path, bool is_embedded,
+                     const unsigned char *bytes, int size)
+{
+    if (get_int(r) != HEADER_CACHE_MAGIC || get_int(r) != HEADER_CACHE_VERSION)
+        return false;
+    if (get_int(r) != (int)cs_compiler_hash())
+        return false;
+    char *entry_path_name = get_string(r);
+    if (!entry_path_name || strcmp(entry_path_name, path) != 0)
+        return false;
+    if (get_bool(r) != is_embedded || get_int(r) != size)
+        return false;
+    if (get_int(r) != (int)cs_content_hash(bytes, size) || get_int(r) != (int)cs_content_hash2(bytes, size))
+        return false;
+    int payload_size = get_int(r);
+    int payload_hash = get_int(r);
+    if (r->failed || payload_size != r->size - r->pos)
+        return false;
+    return payload_hash == (int)cs_content_hash(r->data + r->pos, payload_size);
+}
+
+/* Decode the payload completely before adding anything to fd, so a bad
+ * entry leaves fd empty for the parser */
+static bool read_payload(CacheReader *r, FileDecl *fd, FileDependency **deps_out, int *dep_count_out)
+{
+    int dep_count = get_count(r);
+    FileDependency *deps = (FileDependency *)calloc(dep_count + 1, sizeof(FileDependency));
+    for (int i = 0; i < dep_count && !r->failed; i++)
+    {
+        deps[i].path = get_string(r);
+        deps[i].is_embedded = get_bool(r);
+    }
+
+    int struct_count = get_count(r);
+    StructDefinition **structs = (StructDefinition **)calloc(struct_count + 1, sizeof(StructDefinition *));
+    for (int i = 0; i < struct_count && !r->failed; i++)
+        structs[i] = get_struct(r);
+
+    int typedef_count = get_count(r);
+    TypedefDefinition **typedefs = (TypedefDefinition **)calloc(typedef_count + 1, sizeof(TypedefDefinition *));
+    for (int i = 0; i < typedef_count && !r->failed; i++)
+        typedefs[i] = get_typedef(r);
+
+    int enum_count = get_count(r);
+    EnumDefinition **enums = (EnumDefinition **)calloc(enum_count + 1, sizeof(EnumDefinition *));
+    for (int i = 0; i < enum_count && !r->failed; i++)
+        enums[i] = get_enum(r);
+
+    int function_count = get_count(r);
+    FunctionDeclaration **funcs = (FunctionDeclaration **)calloc(function_count + 1, sizeof(FunctionDeclaration *));
+    for (int i = 0; i < function_count && !r->failed; i++)
+        funcs[i] = get_function(r);
+
+    int declaration_count = get_count(r);
+    Declaration **decls = (Declaration **)calloc(declaration_count + 1, sizeof(Declaration *));
+    for (int i = 0; i < declaration_count && !r->failed; i++)
+        decls[i] = get_declaration(r);
+
+    bool ok = !r->failed && r->pos == r->size;
+    if (ok)
+    {
+        for (int i = 0; i < struct_count; i++)
+            header_decl_add_struct(fd, structs[i]);
+        for (int i = 0; i < typedef_count; i++)
+            header_decl_add_typedef(fd, typedefs[i]);
+        for (int i = 0; i < enum_count; i++)
+            header_decl_add_enum(fd, enums[i]);
+        for (int i = 0; i < function_count; i++)
+            header_decl_add_function(fd, funcs[i]);
+        for (int i = 0; i < declaration_count; i++)
+            header_decl_add_declaration(fd, decls[i]);
+        *deps_out = deps;
+        *dep_count_out = dep_count;
+    }
+    else
+    {
+        free(deps);
+    }
+    free(structs);
+    free(typedefs);
+    free(enums);
+    free(funcs);
+    free(decls);
+    return ok;
+}
+
+bool header_cache_load(const char *dir, FileDecl *fd, bool is_embedded,
+                       const unsigned char *bytes, int size,
+                       FileDependency **deps_out, int *dep_count_out)
+{
+    if (!dir || !fd || !fd->path)
+        return false;
+
+    char *file = entry_path(dir, fd->path, is_embedded);
+    unsigned char *data = NULL;
+    int data_size = 0;
+    bool found = cs_read_file_bytes(file, &data, &data_size);
+    free(file);
+    if (!found)
+    {
+        COUNT_EVENT(cache_misses);
+        return false;
+    }
+
+    CacheReader reader;
+    reader.data = data;
+    reader.size = data_size;
+    reader.pos = 0;
+    reader.failed = false;
+    reader.path = fd->path;
+    bool ok = read_key(&reader, fd->path, is_embedded, bytes, size) &&
+              read_payload(&reader, fd, deps_out, dep_count_out);
+    free(data);
+    if (ok)
+    {
+        COUNT_EVENT(cache_hits);
+    }
+    else
+    {
+        COUNT_EVENT(cache_misses);
+    }
+    return ok;
+}
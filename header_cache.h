@@ -0,0 +1,44 @@
+#pragma once
+
+/*
+ * header_cache.h - On-disk cache of parsed headers
+ *
+ * A header's FileDecl depends only on the header's own bytes: every header
+ * is parsed with a fresh TranslationUnit whose index sees no other file,
+ * and #include only records a dependency.  header_cache_store() writes the
+ * structs, typedefs, enums, prototypes, extern declarations and #include
+ * list of a freshly parsed header to <dir>/<hash>.hdr in a compact binary
+ * form; header_cache_load() fills an empty FileDecl from that file with a
+ * single read instead of running the scanner and parser.
+ *
+ * An entry records the cache format version, a hash of the compiler's
+ * sources, the header path and the size and hashes of the header
+ * contents, so an edited header, another file at the same path or an entry
+ * written by another build of the compiler is a miss.  Headers whose
+ * declarations cannot be represented (function bodies, initialized
+ * variables, array sizes that are not literals or identifiers) are parsed
+ * every time.
+ *
+ * Nodes are allocated in the current arena and strings are interned, as
+ * the parser does.  The statistics counters may be bumped from the
+ * parallel front end's workers.
+ */
+
+#include "cminor_base.h"
+#include "header_store.h"
+
+/* Fill the empty fd from the cache entry for bytes/size under dir.
+ * On a hit, *deps_out receives the header's #include list in source order
+ * (free the array, not the interned paths) and true is returned. */
+bool header_cache_load(const char *dir, FileDecl *fd, bool is_embedded,
+                       const unsigned char *bytes, int size,
+                       FileDependency **deps_out, int *dep_count_out);
+
+/* Write the cache entry for the freshly parsed fd, whose scanner recorded
+ * the #include list.  Creates dir if needed (native build only); failures
+ * are counted, not reported. */
+void header_cache_store(const char *dir, FileDecl *fd, bool is_embedded,
+                        const unsigned char *bytes, int size, Scanner *scanner);
+
+/* Report hits, misses, entries written and uncacheable headers to stderr */
+void header_cache_print_stats();
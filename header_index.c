@@ -6,15 +6,155 @@
 
 #define INITIAL_CAPACITY 8
 
+static void allocate_file_arrays(HeaderIndex *index, int capacity)
+{
+    index->files = (FileDecl **)calloc(capacity, sizeof(FileDecl *));
+    index->merged_structs = (int *)calloc(capacity, sizeof(int));
+    index->merged_enums = (int *)calloc(capacity, sizeof(int));
+    index->merged_typedefs = (int *)calloc(capacity, sizeof(int));
+    index->merged_functions = (int *)calloc(capacity, sizeof(int));
+    index->merged_declarations = (int *)calloc(capacity, sizeof(int));
+    index->file_capacity = capacity;
+}
+
 HeaderIndex *header_index_create()
 {
     HeaderIndex *index = (HeaderIndex *)calloc(1, sizeof(HeaderIndex));
-    index->files = (FileDecl **)calloc(INITIAL_CAPACITY, sizeof(FileDecl *));
+    allocate_file_arrays(index, INITIAL_CAPACITY);
     index->file_count = 0;
-    index->file_capacity = INITIAL_CAPACITY;
+    index->synced_generation = header_store_generation();
+    index->file_map = name_map_create();
+    index->structs = name_map_create();
+    index->struct_files = name_map_create();
+    index->enums = name_map_create();
+    index->enum_files = name_map_create();
+    index->typedefs = name_map_create();
+    index->functions = name_map_create();
+    index->declarations = name_map_create();
+    index->enum_members = name_map_create();
     return index;
 }
 
+static void grow_file_arrays(HeaderIndex *index)
+{
+    FileDecl **files = index->files;
+    int *merged_structs = index->merged_structs;
+    int *merged_enums = index->merged_enums;
+    int *merged_typedefs = index->merged_typedefs;
+    int *merged_functions = index->merged_functions;
+    int *merged_declarations = index->merged_declarations;
+
+    allocate_file_arrays(index, index->file_capacity * 2);
+    for (int i = 0; i < index->file_count; i++)
+    {
+        index->files[i] = files[i];
+        index->merged_structs[i] = merged_structs[i];
+        index->merged_enums[i] = merged_enums[i];
+        index->merged_typedefs[i] = merged_typedefs[i];
+        index->merged_functions[i] = merged_functions[i];
+        index->merged_declarations[i] = merged_declarations[i];
+    }
+    free(merged_structs);
+    free(merged_enums);
+    free(merged_typedefs);
+    free(merged_functions);
+    free(merged_declarations);
+}
+
+/* Merge the declarations files[pos] gained since it was last merged.
+ * Within a file the maps keep the same winner as file_decl_find_*: the
+ * earliest struct/enum/typedef/declaration and the latest function. */
+static void merge_file(HeaderIndex *index, int pos)
+{
+    FileDecl *fd = index->files[pos];
+
+    for (int i = index->merged_structs[pos]; i < fd->struct_count; i++)
+    {
+        StructDefinition *def = fd->structs[i];
+        name_map_offer(index->structs, def->id.search_name, def, pos, false);
+        name_map_offer(index->struct_files, def->id.search_name, fd, pos, false);
+        name_map_offer(index->structs, def->id.name, def, pos, false);
+        name_map_offer(index->struct_files, def->id.name, fd, pos, false);
+    }
+    index->merged_structs[pos] = fd->struct_count;
+
+    for (int i = index->merged_enums[pos]; i < fd->enum_count; i++)
+    {
+        EnumDefinition *def = fd->enums[i];
+        name_map_offer(index->enums, def->id.search_name, def, pos, false);
+        name_map_offer(index->enum_files, def->id.search_name, fd, pos, false);
+        name_map_offer(index->enums, def->id.name, def, pos, false);
+        name_map_offer(index->enum_files, def->id.name, fd, pos, false);
+        for (EnumMember *m = def->members; m; m = m->next)
+        {
+            name_map_offer(index->enum_members, m->name, m, pos, false);
+        }
+    }
+    index->merged_enums[pos] = fd->enum_count;
+
+    for (int i = index->merged_typedefs[pos]; i < fd->typedef_count; i++)
+    {
+        TypedefDefinition *def = fd->typedefs[i];
+        name_map_offer(index->typedefs, def->name, def, pos, false);
+    }
+    index->merged_typedefs[pos] = fd->typedef_count;
+
+    for (int i = index->merged_declarations[pos]; i < fd->declaration_count; i++)
+    {
+        Declaration *decl = fd->declarations[i];
+        name_map_offer(index->declarations, decl->name, decl, pos, false);
+    }
+    index->merged_declarations[pos] = fd->declaration_count;
+
+    /* New functions are at the head of the list; offer them oldest first */
+    int new_functions = fd->function_count - index->merged_functions[pos];
+    if (new_functions > 0)
+    {
+        FunctionDeclaration **batch =
+            (FunctionDeclaration **)calloc(new_functions, sizeof(FunctionDeclaration *));
+        FunctionDeclarationList *fl = fd->functions;
+        for (int i = 0; i < new_functions && fl; i++)
+        {
+            batch[i] = fl->func;
+            fl = fl->next;
+        }
+        for (int i = new_functions - 1; i >= 0; i--)
+        {
+            name_map_offer(index->functions, batch[i]->name, batch[i], pos, true);
+        }
+        free(batch);
+    }
+    index->merged_functions[pos] = fd->function_count;
+}
+
+/* Bring the maps up to date with files that grew since the last lookup */
+static void sync_index(HeaderIndex *index)
+{
+    int generation = header_store_generation();
+    if (index->synced_generation == generation)
+        return;
+
+    for (int i = 0; i < index->file_count; i++)
+    {
+        FileDecl *fd = index->files[i];
+        if (index->merged_structs[i] != fd->struct_count ||
+            index->merged_enums[i] != fd->enum_count ||
+            index->merged_typedefs[i] != fd->typedef_count ||
+            index->merged_functions[i] != fd->function_count ||
+            index->merged_declarations[i] != fd->declaration_count)
+        {
+            merge_file(index, i);
+        }
+    }
+    index->synced_generation = generation;
+}
+
+void header_index_sync(HeaderIndex *index)
+{
+    if (index)
+        sync_index(index);
+}
+
 void header_index_add_file(HeaderIndex *index, FileDecl *fd)
 {
     if (!index || !fd)
@@ -24,20 +164,16 @@ void header_index_add_file(HeaderIndex *index, FileDecl *fd)
     if (header_index_contains(index, fd))
         return;
 
-    /* Grow array if needed */
+    /* Grow arrays if needed */
     if (index->file_count >= index->file_capacity)
     {
-        int new_capacity = index->file_capacity * 2;
-        FileDecl **new_files = (FileDecl **)calloc(new_capacity, sizeof(FileDecl *));
-        for (int i = 0; i < index->file_count; i++)
-        {
-            new_files[i] = index->files[i];
-        }
-        index->files = new_files;
-        index->file_capacity = new_capacity;
+        grow_file_arrays(index);
     }
 
-    index->files[index->file_count++] = fd;
+    int pos = index->file_count++;
+    index->files[pos] = fd;
+    name_map_offer(index->file_map, fd->path, fd, pos, false);
+    merge_file(index, pos);
 }
 
 bool header_index_contains(HeaderIndex *index, FileDecl *fd)
@@ -45,12 +181,8 @@ bool header_index_contains(HeaderIndex *index, FileDecl *fd)
     if (!index || !fd)
         return false;
 
-    for (int i = 0; i < index->file_count; i++)
-    {
-        if (index->files[i] == fd)
-            return true;
-    }
-    return false;
+    /* FileDecl paths are unique within the HeaderStore */
+    return (FileDecl *)name_map_get(index->file_map, fd->path) == fd;
 }
 
 StructDefinition *header_index_find_struct(HeaderIndex *index, const char *name)
@@ -64,17 +196,11 @@ StructDefinition *header_index_find_struct_with_file(HeaderIndex *index, const c
     if (!index || !name)
         return NULL;
 
-    for (int i = 0; i < index->file_count; i++)
-    {
-        StructDefinition *sd = file_decl_find_struct(index->files[i], name);
-        if (sd)
-        {
-            if (out_fd)
-                *out_fd = index->files[i];
-            return sd;
-        }
-    }
-    return NULL;
+    sync_index(index);
+    StructDefinition *sd = (StructDefinition *)name_map_get(index->structs, name);
+    if (sd && out_fd)
+        *out_fd = (FileDecl *)name_map_get(index->struct_files, name);
+    return sd;
 }
 
 EnumDefinition *header_index_find_enum(HeaderIndex *index, const char *name)
@@ -88,17 +214,11 @@ EnumDefinition *header_index_find_enum_with_file(HeaderIndex *index, const char
     if (!index || !name)
         return NULL;
 
-    for (int i = 0; i < index->file_count; i++)
-    {
-        EnumDefinition *ed = file_decl_find_enum(index->files[i], name);
-        if (ed)
-        {
-            if (out_fd)
-                *out_fd = index->files[i];
-            return ed;
-        }
-    }
-    return NULL;
+    sync_index(index);
+    EnumDefinition *ed = (EnumDefinition *)name_map_get(index->enums, name);
+    if (ed && out_fd)
+        *out_fd = (FileDecl *)name_map_get(index->enum_files, name);
+    return ed;
 }
 
 TypedefDefinition *header_index_find_typedef(HeaderIndex *index, const char *name)
@@ -106,13 +226,8 @@ TypedefDefinition *header_index_find_typedef(HeaderIndex *index, const char *nam
     if (!index || !name)
         return NULL;
 
-    for (int i = 0; i < index->file_count; i++)
-    {
-        TypedefDefinition *td = file_decl_find_typedef(index->files[i], name);
-        if (td)
-            return td;
-    }
-    return NULL;
+    sync_index(index);
+    return (TypedefDefinition *)name_map_get(index->typedefs, name);
 }
 
 FunctionDeclaration *header_index_find_function(HeaderIndex *index, const char *name)
@@ -120,13 +235,8 @@ FunctionDeclaration *header_index_find_function(HeaderIndex *index, const char *
     if (!index || !name)
         return NULL;
 
-    for (int i = 0; i < index->file_count; i++)
-    {
-        FunctionDeclaration *f = file_decl_find_function(index->files[i], name);
-        if (f)
-            return f;
-    }
-    return NULL;
+    sync_index(index);
+    return (FunctionDeclaration *)name_map_get(index->functions, name);
 }
 
 Declaration *header_index_find_declaration(HeaderIndex *index, const char *name)
@@ -134,13 +244,8 @@ Declaration *header_index_find_declaration(HeaderIndex *index, const char *name)
     if (!index || !name)
         return NULL;
 
-    for (int i = 0; i < index->file_count; i++)
-    {
-        Declaration *d = file_decl_find_declaration(index->files[i], name);
-        if (d)
-            return d;
-    }
-    return NULL;
+    sync_index(index);
+    return (Declaration *)name_map_get(index->declarations, name);
 }
 
 EnumMember *header_index_find_enum_member(HeaderIndex *index,
@@ -150,24 +255,9 @@ EnumMember *header_index_find_enum_member(HeaderIndex *index,
     if (!index || !member_name)
         return NULL;
 
-    for (int i = 0; i < index->file_count; i++)
-    {
-        FileDecl *fd = index->files[i];
-        for (int j = 0; j < fd->enum_count; j++)
-        {
-            EnumDefinition *ed = fd->enums[j];
-            if (!ed)
-                continue;
-            for (EnumMember *m = ed->members; m; m = m->next)
-            {
-                if (m->name && strcmp(m->name, member_name) == 0)
-                {
-                    if (out_enum)
-                        *out_enum = ed;
-                    return m;
-                }
-            }
-        }
-    }
-    return NULL;
+    sync_index(index);
+    EnumMember *m = (EnumMember *)name_map_get(index->enum_members, member_name);
+    if (m && out_enum)
+        *out_enum = m->enum_def;
+    return m;
 }
@@ -17,6 +17,29 @@ typedef struct HeaderIndex_tag
     FileDecl **files; /* Array of visible FileDecl pointers */
     int file_count;
     int file_capacity;
+
+    /* Declarations of files[i] already merged into the maps below.  A file
+     * can grow after it is added (the source file being parsed), so lookups
+     * merge the rest when header_store_generation() has moved on. */
+    int *merged_structs;
+    int *merged_enums;
+    int *merged_typedefs;
+    int *merged_functions;
+    int *merged_declarations;
+    int synced_generation;
+
+    /* Merged name -> declaration maps.  The rank of an entry is the position
+     * of its file, so the first visible file declaring a name wins, as it
+     * does when the files are searched in order. */
+    NameMap *file_map; /* path -> FileDecl */
+    NameMap *structs;
+    NameMap *struct_files; /* name -> FileDecl of the struct in structs */
+    NameMap *enums;
+    NameMap *enum_files; /* name -> FileDecl of the enum in enums */
+    NameMap *typedefs;
+    NameMap *functions;
+    NameMap *declarations;
+    NameMap *enum_members;
 } HeaderIndex;
 
 /* Lifecycle */
@@ -25,6 +48,11 @@ HeaderIndex *header_index_create();
 /* Add a FileDecl to the visible set */
 void header_index_add_file(HeaderIndex *index, FileDecl *fd);
 
+/* Merge whatever the visible files gained since the last lookup.  Lookups
+ * do this on demand; call it before several threads share the index so
+ * that their lookups only read it. */
+void header_index_sync(HeaderIndex *index);
+
 /* Check if a file is already in the index */
 bool header_index_contains(HeaderIndex *index, FileDecl *fd);
 
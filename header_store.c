@@ -9,17 +9,42 @@
 #include "cminor_type.h"
 #include "parsed_type.h"
 #include "create.h"
+#include "intern.h"
 
-static char *dup_string(const char *s)
+#ifdef __GNUC__
+#include <pthread.h>
+
+/* Guards the file list against the workers of the parallel front end.
+ * Each FileDecl itself is only written by the thread that parses it. */
+static pthread_mutex_t store_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static int store_generation = 0;
+
+int header_store_generation()
 {
-    if (!s)
-        return NULL;
-    return strdup(s);
+#ifdef __GNUC__
+    return __atomic_load_n(&store_generation, __ATOMIC_RELAXED);
+#else
+    return store_generation;
+#endif
+}
+
+/* A declaration was added to fd */
+static void bump_generation(FileDecl *fd)
+{
+    fd->revision = fd->revision + 1;
+#ifdef __GNUC__
+    __atomic_add_fetch(&store_generation, 1, __ATOMIC_RELAXED);
+#else
+    store_generation = store_generation + 1;
+#endif
 }
 
 HeaderStore *header_store_create()
 {
     HeaderStore *store = (HeaderStore *)calloc(1, sizeof(HeaderStore));
+    store->file_map = name_map_create();
     return store;
 }
 
@@ -29,19 +54,25 @@ void header_store_destroy(HeaderStore *store)
     (void)store;
 }
 
+static FileDecl *find_file(HeaderStore *store, const char *key)
+{
+    return (FileDecl *)name_map_get(store->file_map, key);
+}
+
 FileDecl *header_store_find(HeaderStore *store, const char *path)
 {
     if (!store || !path)
         return NULL;
 
-    for (FileDecl *fd = store->files; fd; fd = fd->next)
-    {
-        if (strcmp(fd->path, path) == 0)
-        {
-            return fd;
-        }
-    }
-    return NULL;
+    const char *key = cs_intern(path);
+#ifdef __GNUC__
+    pthread_mutex_lock(&store_lock);
+    FileDecl *found = find_file(store, key);
+    pthread_mutex_unlock(&store_lock);
+    return found;
+#else
+    return find_file(store, key);
+#endif
 }
 
 bool header_store_is_parsed(HeaderStore *store, const char *path)
@@ -62,17 +93,28 @@ FileDecl *header_store_get_or_create(HeaderStore *store, const char *path)
     if (!store || !path)
         return NULL;
 
-    FileDecl *existing = header_store_find(store, path);
-    if (existing)
-        return existing;
-
-    FileDecl *fd = (FileDecl *)calloc(1, sizeof(FileDecl));
-    fd->path = dup_string(path);
-    fd->class_name = cs_class_name_from_path(path);
-    fd->is_header = is_header_file(path);
-    fd->next = store->files;
-    store->files = fd;
-
+    const char *key = cs_intern(path);
+#ifdef __GNUC__
+    pthread_mutex_lock(&store_lock);
+#endif
+    FileDecl *fd = find_file(store, key);
+    if (!fd)
+    {
+        fd = (FileDecl *)calloc(1, sizeof(FileDecl));
+        fd->path = (char *)key;
+        char *class_name = cs_class_name_from_path(path);
+        fd->class_name = (char *)cs_intern(class_name);
+        free(class_name);
+        fd->is_header = is_header_file(path);
+        fd->typedefs_resolved_revision = -1;
+        fd->struct_types_resolved_revision = -1;
+        fd->next = store->files;
+        store->files = fd;
+        name_map_offer(store->file_map, key, fd, 0, false);
+    }
+#ifdef __GNUC__
+    pthread_mutex_unlock(&store_lock);
+#endif
     return fd;
 }
 
@@ -84,7 +126,7 @@ void header_decl_add_function(FileDecl *fd, FunctionDeclaration *func)
     /* Set class_name from FileDecl if not already set */
     if (!func->class_name && fd->class_name)
     {
-        func->class_name = dup_string(fd->class_name);
+        func->class_name = fd->class_name;
     }
 
     /* Add to front of linked list */
@@ -92,6 +134,13 @@ void header_decl_add_function(FileDecl *fd, FunctionDeclaration *func)
     node->func = func;
     node->next = fd->functions;
     fd->functions = node;
+    fd->function_count++;
+
+    /* The most recently added declaration of a name wins */
+    if (!fd->function_map)
+        fd->function_map = name_map_create();
+    name_map_offer(fd->function_map, func->name, func, 0, true);
+    bump_generation(fd);
 }
 
 static void ensure_struct_capacity(FileDecl *fd, int needed)
@@ -121,6 +170,13 @@ int header_decl_add_struct(FileDecl *fd, StructDefinition *def)
     fd->structs[fd->struct_count] = def;
     fd->struct_count++;
 
+    /* Earlier definitions win; lookups match either name */
+    if (!fd->struct_map)
+        fd->struct_map = name_map_create();
+    name_map_offer(fd->struct_map, def->id.search_name, def, 0, false);
+    name_map_offer(fd->struct_map, def->id.name, def, 0, false);
+    bump_generation(fd);
+
     return index;
 }
 
@@ -148,6 +204,11 @@ void header_decl_add_typedef(FileDecl *fd, TypedefDefinition *def)
     ensure_typedef_capacity(fd, 1);
     fd->typedefs[fd->typedef_count] = def;
     fd->typedef_count++;
+
+    if (!fd->typedef_map)
+        fd->typedef_map = name_map_create();
+    name_map_offer(fd->typedef_map, def->name, def, 0, false);
+    bump_generation(fd);
 }
 
 static void ensure_enum_capacity(FileDecl *fd, int needed)
@@ -177,6 +238,12 @@ int header_decl_add_enum(FileDecl *fd, EnumDefinition *def)
     fd->enums[fd->enum_count] = def;
     fd->enum_count++;
 
+    if (!fd->enum_map)
+        fd->enum_map = name_map_create();
+    name_map_offer(fd->enum_map, def->id.search_name, def, 0, false);
+    name_map_offer(fd->enum_map, def->id.name, def, 0, false);
+    bump_generation(fd);
+
     return index;
 }
 
@@ -204,109 +271,58 @@ void header_decl_add_declaration(FileDecl *fd, Declaration *decl)
     /* Set class_name from FileDecl if not already set */
     if (!decl->class_name && fd->class_name)
     {
-        decl->class_name = dup_string(fd->class_name);
+        decl->class_name = fd->class_name;
     }
 
     ensure_declaration_capacity(fd, 1);
     fd->declarations[fd->declaration_count] = decl;
     fd->declaration_count++;
+
+    if (!fd->declaration_map)
+        fd->declaration_map = name_map_create();
+    name_map_offer(fd->declaration_map, decl->name, decl, 0, false);
+    bump_generation(fd);
 }
 
 /* Lookup by name within a file.
  * For named types: matches search_name (e.g., "Preprocessor")
  * For anonymous types: matches name (e.g., "foo$0")
  * Also matches by name for internal lookups (e.g., "preprocessor_h$Preprocessor")
+ * Both names are keys of fd->struct_map; the earliest definition wins.
  */
 StructDefinition *file_decl_find_struct(FileDecl *fd, const char *name)
 {
     if (!fd || !name)
         return NULL;
-
-    for (int i = 0; i < fd->struct_count; i++)
-    {
-        StructDefinition *def = fd->structs[i];
-        /* Match by search_name (original C name) if available */
-        if (def->id.search_name && strcmp(def->id.search_name, name) == 0)
-        {
-            return def;
-        }
-        /* Match by name (class name) for anonymous or internal lookups */
-        if (def->id.name && strcmp(def->id.name, name) == 0)
-        {
-            return def;
-        }
-    }
-    return NULL;
+    return (StructDefinition *)name_map_get(fd->struct_map, name);
 }
 
 EnumDefinition *file_decl_find_enum(FileDecl *fd, const char *name)
 {
     if (!fd || !name)
         return NULL;
-
-    for (int i = 0; i < fd->enum_count; i++)
-    {
-        EnumDefinition *def = fd->enums[i];
-        /* Match by search_name (original C name) if available */
-        if (def->id.search_name && strcmp(def->id.search_name, name) == 0)
-        {
-            return def;
-        }
-        /* Match by name (class name) for anonymous or internal lookups */
-        if (def->id.name && strcmp(def->id.name, name) == 0)
-        {
-            return def;
-        }
-    }
-    return NULL;
+    return (EnumDefinition *)name_map_get(fd->enum_map, name);
 }
 
 TypedefDefinition *file_decl_find_typedef(FileDecl *fd, const char *name)
 {
     if (!fd || !name)
         return NULL;
-
-    for (int i = 0; i < fd->typedef_count; i++)
-    {
-        TypedefDefinition *def = fd->typedefs[i];
-        if (def->name && strcmp(def->name, name) == 0)
-        {
-            return def;
-        }
-    }
-    return NULL;
+    return (TypedefDefinition *)name_map_get(fd->typedef_map, name);
 }
 
 FunctionDeclaration *file_decl_find_function(FileDecl *fd, const char *name)
 {
     if (!fd || !name)
         return NULL;
-
-    for (FunctionDeclarationList *fl = fd->functions; fl; fl = fl->next)
-    {
-        FunctionDeclaration *f = fl->func;
-        if (f && f->name && strcmp(f->name, name) == 0)
-        {
-            return f;
-        }
-    }
-    return NULL;
+    return (FunctionDeclaration *)name_map_get(fd->function_map, name);
 }
 
 Declaration *file_decl_find_declaration(FileDecl *fd, const char *name)
 {
     if (!fd || !name)
         return NULL;
-
-    for (int i = 0; i < fd->declaration_count; i++)
-    {
-        Declaration *decl = fd->declarations[i];
-        if (decl->name && strcmp(decl->name, name) == 0)
-        {
-            return decl;
-        }
-    }
-    return NULL;
+    return (Declaration *)name_map_get(fd->declaration_map, name);
 }
 
 static void ensure_dependency_capacity(FileDecl *fd, int needed)
@@ -330,15 +346,16 @@ void file_decl_add_dependency(FileDecl *fd, const char *path, bool is_embedded)
     if (!fd || !path)
         return;
 
-    /* Check for duplicates */
+    /* Check for duplicates (dependency paths are interned) */
+    const char *key = cs_intern(path);
     for (int i = 0; i < fd->dependency_count; i++)
     {
-        if (strcmp(fd->dependencies[i].path, path) == 0)
+        if (fd->dependencies[i].path == key)
             return;
     }
 
     ensure_dependency_capacity(fd, 1);
-    fd->dependencies[fd->dependency_count].path = dup_string(path);
+    fd->dependencies[fd->dependency_count].path = (char *)key;
     fd->dependencies[fd->dependency_count].is_embedded = is_embedded;
     fd->dependency_count++;
 }
@@ -355,12 +372,30 @@ FileDependency *file_decl_get_dependency(FileDecl *fd, int index)
     return &fd->dependencies[index];
 }
 
+/* Resolve passes over a FileDecl run and skipped (main thread only) */
+static int resolve_passes_performed = 0;
+static int resolve_passes_skipped = 0;
+
+void file_decl_print_resolve_stats()
+{
+    fprintf(stderr, "type resolution: %d file passes performed, %d skipped\n",
+            resolve_passes_performed, resolve_passes_skipped);
+}
+
 /* Resolve typedef types in a FileDecl (first pass) */
 void file_decl_resolve_typedefs(FileDecl *fd, HeaderIndex *index)
 {
     if (!fd || !index)
         return;
 
+    if (fd->typedefs_resolved_revision == fd->revision)
+    {
+        resolve_passes_skipped++;
+        return;
+    }
+    resolve_passes_performed++;
+
+    bool complete = true;
     for (int i = 0; i < fd->typedef_count; i++)
     {
         TypedefDefinition *def = fd->typedefs[i];
@@ -399,7 +434,13 @@ void file_decl_resolve_typedefs(FileDecl *fd, HeaderIndex *index)
                 def->canonical = def->type;
             }
         }
+
+        if (def->parsed_type && !def->type)
+        {
+            complete = false;
+        }
     }
+    fd->typedefs_resolved_revision = complete ? fd->revision : -1;
 }
 
 /* Resolve struct member and function types in a FileDecl (second pass) */
@@ -408,7 +449,15 @@ void file_decl_resolve_struct_types(FileDecl *fd, HeaderIndex *index)
     if (!fd || !index)
         return;
 
+    if (fd->struct_types_resolved_revision == fd->revision)
+    {
+        resolve_passes_skipped++;
+        return;
+    }
+    resolve_passes_performed++;
+
     /* Resolve struct member types */
+    bool complete = true;
     for (int i = 0; i < fd->struct_count; i++)
     {
         StructDefinition *def = fd->structs[i];
@@ -417,6 +466,7 @@ void file_decl_resolve_struct_types(FileDecl *fd, HeaderIndex *index)
             if (!m->type && m->parsed_type)
             {
                 m->type = cs_resolve_type_with_index(m->parsed_type, index);
+                complete = complete && m->type != NULL;
             }
         }
     }
@@ -432,6 +482,7 @@ void file_decl_resolve_struct_types(FileDecl *fd, HeaderIndex *index)
         if (!f->type && f->parsed_type)
         {
             f->type = cs_resolve_type_with_index(f->parsed_type, index);
+            complete = complete && f->type != NULL;
         }
 
         /* Resolve parameter types */
@@ -442,7 +493,9 @@ void file_decl_resolve_struct_types(FileDecl *fd, HeaderIndex *index)
             if (!p->type && p->parsed_type)
             {
                 p->type = cs_resolve_type_with_index(p->parsed_type, index);
+                complete = complete && p->type != NULL;
             }
         }
     }
+    fd->struct_types_resolved_revision = complete ? fd->revision : -1;
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "name_map.h"
+
 /* Forward declarations */
 typedef struct TypeSpecifier_tag TypeSpecifier;
 typedef struct StructMember_tag StructMember;
@@ -38,8 +40,9 @@ typedef struct FileDecl_tag
     char *corresponding_source; /* For headers: e.g., "foo.c" */
     bool is_header;             /* true if .h, false if .c */
 
-    /* Functions (linked list of FunctionDeclaration) */
+    /* Functions (linked list of FunctionDeclaration, most recent first) */
     FunctionDeclarationList *functions;
+    int function_count;
 
     /* Structs (array for index access) - stores actual StructDefinition */
     StructDefinition **structs;
@@ -66,22 +69,59 @@ typedef struct FileDecl_tag
     int dependency_count;
     int dependency_capacity;
 
+    /* Name lookup tables, filled as declarations are added (NULL while empty) */
+    NameMap *struct_map;      /* search_name and class name -> StructDefinition */
+    NameMap *enum_map;        /* search_name and class name -> EnumDefinition */
+    NameMap *typedef_map;     /* name -> TypedefDefinition */
+    NameMap *function_map;    /* name -> most recently added FunctionDeclaration */
+    NameMap *declaration_map; /* name -> Declaration */
+
+    /* Type resolution memo.  revision counts the declarations added to the
+     * file; a resolve pass that leaves nothing unresolved records it, and
+     * passes over the file at the same revision are skipped (-1 = none). */
+    int revision;
+    int typedefs_resolved_revision;
+    int struct_types_resolved_revision;
+
+    /* Include closure of a header, computed once its includes are all
+     * parsed (NULL until then; see compiler.c) */
+    struct FileClosure_tag *closure;
+
     struct FileDecl_tag *next;
 } FileDecl;
 
+/* The headers a translation unit that includes only one header adds to its
+ * HeaderIndex: the header itself first, then everything it includes,
+ * directly or not, in the order the TU would index them */
+typedef struct FileClosure_tag
+{
+    FileDecl **files;
+    bool *is_embedded; /* Embedded flag each file was included with */
+    int count;
+    int capacity;
+} FileClosure;
+
 /* Backwards compatibility alias */
 typedef FileDecl HeaderDecl;
 
-/* The file store itself */
+/* The file store itself.  Files are listed newest first and found by path
+ * through file_map.  In the native build find and get_or_create are
+ * thread-safe; parsing a file stays the job of a single thread (see the
+ * parse-once claims in compiler.c). */
 typedef struct HeaderStore_tag
 {
     FileDecl *files;
+    NameMap *file_map; /* Interned path -> FileDecl */
 } HeaderStore;
 
 /* Lifecycle */
 HeaderStore *header_store_create();
 void header_store_destroy(HeaderStore *store);
 
+/* Counter bumped by every declaration added to any FileDecl; lets a
+ * HeaderIndex notice files that grew after they were indexed */
+int header_store_generation();
+
 /* File management */
 FileDecl *header_store_get_or_create(HeaderStore *store, const char *path);
 FileDecl *header_store_find(HeaderStore *store, const char *path);
@@ -120,9 +160,14 @@ Declaration *file_decl_find_declaration(FileDecl *fd, const char *name);
 typedef struct HeaderIndex_tag HeaderIndex;
 
 /* Resolve typedef types in a FileDecl (first pass).
- * Uses HeaderIndex for per-TU visibility. */
+ * Uses HeaderIndex for per-TU visibility.  Resolved types are kept on the
+ * declarations, so once every typedef is resolved later passes are skipped. */
 void file_decl_resolve_typedefs(FileDecl *fd, HeaderIndex *index);
 
 /* Resolve struct member and function types in a FileDecl (second pass).
- * Call this after all typedefs have been resolved. */
+ * Call this after all typedefs have been resolved.  Skipped like the
+ * first pass once everything is resolved. */
 void file_decl_resolve_struct_types(FileDecl *fd, HeaderIndex *index);
+
+/* Report resolve passes performed and skipped to stderr */
+void file_decl_print_resolve_stats();
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "ast.h"
+#include "util.h"
+
+#ifdef __GNUC__
+#include <pthread.h>
+
+/* The table is shared by the workers of the parallel front end */
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* Strings are chained per bucket through index arrays; index 0 is unused
+ * so that 0 terminates a chain. */
+typedef struct InternTable_tag
+{
+    char **strings;
+    uint32_t *hashes;
+    int *next;
+    int count;
+    int capacity;
+
+    int *heads;
+    int mask;
+
+    /* Statistics */
+    int lookups;
+    int saved_bytes;
+} InternTable;
+
+static InternTable *intern_table = NULL;
+
+/* Re-create the buckets for the current capacity (one bucket per two slots) */
+static void intern_rebuild_buckets(InternTable *table)
+{
+    int bucket_count = table->capacity * 2;
+    if (table->heads)
+    {
+        free(table->heads);
+    }
+    table->heads = (int *)calloc(bucket_count, sizeof(int));
+    table->mask = bucket_count - 1;
+    for (int i = 1; i < table->count; ++i)
+    {
+        int bucket = (int)(table->hashes[i] & (uint32_t)table->mask);
+        table->next[i] = table->heads[bucket];
+        table->heads[bucket] = i;
+    }
+}
+
+static void intern_grow(InternTable *table)
+{
+    int new_capacity = table->capacity * 2;
+    char **strings = (char **)calloc(new_capacity, sizeof(char *));
+    uint32_t *hashes = (uint32_t *)calloc(new_capacity, sizeof(uint32_t));
+    int *next = (int *)calloc(new_capacity, sizeof(int));
+    for (int i = 1; i < table->count; ++i)
+    {
+        strings[i] = table->strings[i];
+        hashes[i] = table->hashes[i];
+    }
+    free(table->strings);
+    free(table->hashes);
+    free(table->next);
+    table->strings = strings;
+    table->hashes = hashes;
+    table->next = next;
+    table->capacity = new_capacity;
+    intern_rebuild_buckets(table);
+}
+
+static InternTable *intern_get_table()
+{
+    if (!intern_table)
+    {
+        InternTable *table = (InternTable *)calloc(1, sizeof(InternTable));
+        table->capacity = 1024;
+        table->strings = (char **)calloc(table->capacity, sizeof(char *));
+        table->hashes = (uint32_t *)calloc(table->capacity, sizeof(uint32_t));
+        table->next = (int *)calloc(table->capacity, sizeof(int));
+        table->count = 1;
+        intern_rebuild_buckets(table);
+        intern_table = table;
+    }
+    return intern_table;
+}
+
+const char *cs_intern(const char *str)
+{
+    if (!str)
+    {
+        return NULL;
+    }
+    return cs_intern_span(str, strlen(str));
+}
+
+static const char *intern_span_locked(const char *str, int len)
+{
+    InternTable *table = intern_get_table();
+    uint32_t hash = cs_span_hash(str, len);
+    table->lookups = table->lookups + 1;
+
+    int bucket = (int)(hash & (uint32_t)table->mask);
+    for (int i = table->heads[bucket]; i != 0; i = table->next[i])
+    {
+        if (table->hashes[i] == hash && strncmp(table->strings[i], str, len) == 0 &&
+            table->strings[i][len] == '\0')
+        {
+            /* Re-interning a canonical string saves nothing */
+            if (table->strings[i] != str)
+            {
+                table->saved_bytes = table->saved_bytes + len + 1;
+            }
+            return table->strings[i];
+        }
+    }
+
+    if (table->count == table->capacity)
+    {
+        intern_grow(table);
+        bucket = (int)(hash & (uint32_t)table->mask);
+    }
+    char *copy = (char *)calloc(len + 1, sizeof(char));
+    memcpy(copy, str, len);
+    int idx = table->count;
+    table->count = table->count + 1;
+    table->strings[idx] = copy;
+    table->hashes[idx] = hash;
+    table->next[idx] = table->heads[bucket];
+    table->heads[bucket] = idx;
+    return table->strings[idx];
+}
+
+const char *cs_intern_span(const char *str, int len)
+{
+#ifdef __GNUC__
+    pthread_mutex_lock(&intern_lock);
+    const char *interned = intern_span_locked(str, len);
+    pthread_mutex_unlock(&intern_lock);
+    return interned;
+#else
+    return intern_span_locked(str, len);
+#endif
+}
+
+void cs_intern_print_stats()
+{
+    InternTable *table = intern_get_table();
+    fprintf(stderr, "intern: %d lookups, %d distinct strings, %d bytes not duplicated\n",
+            table->lookups, table->count - 1, table->saved_bytes);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+ * intern.h - Interned string table
+ *
+ * Identifiers, source paths and class names recur throughout the AST and
+ * the HeaderStore.  cs_intern() returns one canonical copy per distinct
+ * string, so equal interned strings compare equal by pointer and each
+ * distinct string is stored once.  Interned strings live until the process
+ * exits and must not be modified or freed.  In the native build the
+ * table is guarded by a mutex, so the parallel front end may intern from
+ * several threads.
+ */
+
+#include "cminor_base.h"
+
+/* Canonical copy of str (NULL for NULL) */
+const char *cs_intern(const char *str);
+
+/* Canonical copy of the len bytes at str, which need not be NUL-terminated */
+const char *cs_intern_span(const char *str, int len);
+
+/* Report lookups, distinct strings and bytes not duplicated to stderr */
+void cs_intern_print_stats();
@@ -0,0 +1,364 @@
+/*
+ * jar_writer.c - Runnable .jar output for -o
+ *
+ * A .jar is a ZIP archive.  Each member is a local header followed by its
+ * bytes; the central directory after the last member lists every member
+ * with the offset of its local header, and the end record locates the
+ * central directory.  All fields are little-endian.
+ *
+ * Only what a class loader needs is written: stored members, no extra
+ * fields, no comments, no ZIP64, so an archive holds at most 65535 members
+ * and 4 GB.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "jar_writer.h"
+
+#ifdef __GNUC__
+#include <pthread.h>
+
+/* Guards the entry list against concurrent jar_writer_add */
+static pthread_mutex_t jar_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+enum
+{
+    ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50,
+    ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014b50,
+    ZIP_END_SIGNATURE = 0x06054b50,
+    ZIP_VERSION = 10,      /* 1.0: stored members */
+    ZIP_METHOD_STORED = 0,
+    ZIP_MAX_ENTRIES = 65535,
+    /* 1980-01-01 00:00:00, the earliest MS-DOS date, for every member */
+    ZIP_DOS_TIME = 0,
+    ZIP_DOS_DATE = 0x21,
+    JAR_INITIAL_CAPACITY = 64
+};
+
+#define MANIFEST_NAME "META-INF/MANIFEST.MF"
+
+/* ============================================================
+ * CRC-32 (ISO 3309, as used by ZIP)
+ * ============================================================ */
+
+/* Built on first use */
+static uint32_t *crc_table = NULL;
+
+static void init_crc_table()
+{
+    if (crc_table)
+        return;
+    uint32_t *table = (uint32_t *)calloc(256, sizeof(uint32_t));
+    for (int n = 0; n < 256; n++)
+    {
+        uint32_t c = (uint32_t)n;
+        for (int k = 0; k < 8; k++)
+        {
+            if (c & 1U)
+            {
+                c = 0xEDB88320U ^ (c >> 1);
+            }
+            else
+            {
+                c = c >> 1;
+            }
+        }
+        table[n] = c;
+    }
+    crc_table = table;
+}
+
+static uint32_t crc32_of(const unsigned char *data, int size)
+{
+    init_crc_table();
+    uint32_t c = 0xFFFFFFFFU;
+    for (int i = 0; i < size; i++)
+    {
+        c = crc_table[(c ^ data[i]) & 255U] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFU;
+}
+
+/* ============================================================
+ * Entries
+ * ============================================================ */
+
+JarWriter *jar_writer_create(const char *path, const char *main_class)
+{
+    JarWriter *jar = (JarWriter *)calloc(1, sizeof(JarWriter));
+    jar->path = strdup(path);
+    jar->main_class = strdup(main_class);
+    jar->capacity = JAR_INITIAL_CAPACITY;
+    jar->entries = (JarEntry **)calloc(jar->capacity, sizeof(JarEntry *));
+    jar->count = 0;
+    return jar;
+}
+
+/* Index of the first entry whose name is not less than name */
+static int find_entry(JarWriter *jar, const char *name)
+{
+    int low = 0;
+    int high = jar->count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (strcmp(jar->entries[mid]->name, name) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void insert_entry(JarWriter *jar, int index, JarEntry *entry)
+{
+    if (jar->count == jar->capacity)
+    {
+        int capacity = jar->capacity * 2;
+        JarEntry **entries = (JarEntry **)calloc(capacity, sizeof(JarEntry *));
+        for (int i = 0; i < jar->count; i++)
+        {
+            entries[i] = jar->entries[i];
+        }
+        free(jar->entries);
+        jar->entries = entries;
+        jar->capacity = capacity;
+    }
+    for (int i = jar->count; i > index; i--)
+    {
+        jar->entries[i] = jar->entries[i - 1];
+    }
+    jar->entries[index] = entry;
+    jar->count = jar->count + 1;
+}
+
+void jar_writer_add(JarWriter *jar, const char *name, unsigned char *data, int size)
+{
+#ifdef __GNUC__
+    pthread_mutex_lock(&jar_mutex);
+#endif
+    int index = find_entry(jar, name);
+    JarEntry *entry = NULL;
+    if (index < jar->count && strcmp(jar->entries[index]->name, name) == 0)
+    {
+        entry = jar->entries[index];
+        free(entry->data);
+    }
+    else
+    {
+        entry = (JarEntry *)calloc(1, sizeof(JarEntry));
+        entry->name = strdup(name);
+        insert_entry(jar, index, entry);
+    }
+    entry->data = data;
+    entry->size = size;
+#ifdef __GNUC__
+    pthread_mutex_unlock(&jar_mutex);
+#endif
+}
+
+static void free_entry(JarEntry *entry)
+{
+    free(entry->name);
+    free(entry->data);
+    free(entry);
+}
+
+void jar_writer_destroy(JarWriter *jar)
+{
+    if (!jar)
+        return;
+    for (int i = 0; i < jar->count; i++)
+    {
+        free_entry(jar->entries[i]);
+    }
+    free(jar->entries);
+    free(jar->path);
+    free(jar->main_class);
+    free(jar);
+}
+
+/* ============================================================
+ * Writing
+ * ============================================================ */
+
+/* Headers and the central directory being built; members' bytes are
+ * written straight from their entries */
+typedef struct ZipBuffer_tag
+{
+    unsigned char *data;
+    int size;
+    int capacity;
+} ZipBuffer;
+
+static void buffer_init(ZipBuffer *b, int capacity)
+{
+    b->capacity = capacity;
+    b->data = (unsigned char *)calloc(b->capacity, sizeof(unsigned char));
+    b->size = 0;
+}
+
+static void put_byte(ZipBuffer *b, int value)
+{
+    if (b->size == b->capacity)
+    {
+        int capacity = b->capacity * 2;
+        unsigned char *data = (unsigned char *)calloc(capacity, sizeof(unsigned char));
+        for (int i = 0; i < b->size; i++)
+        {
+            data[i] = b->data[i];
+        }
+        free(b->data);
+        b->data = data;
+        b->capacity = capacity;
+    }
+    b->data[b->size] = (unsigned char)(value & 255);
+    b->size = b->size + 1;
+}
+
+static void put_u2(ZipBuffer *b, int value)
+{
+    put_byte(b, value);
+    put_byte(b, value >> 8);
+}
+
+static void put_u4(ZipBuffer *b, uint32_t value)
+{
+    put_byte(b, (int)(value & 255U));
+    put_byte(b, (int)((value >> 8) & 255U));
+    put_byte(b, (int)((value >> 16) & 255U));
+    put_byte(b, (int)((value >> 24) & 255U));
+}
+
+static void put_name(ZipBuffer *b, const char *name)
+{
+    int len = strlen(name);
+    for (int i = 0; i < len; i++)
+    {
+        put_byte(b, name[i]);
+    }
+}
+
+/* The fields local and central headers share, from "version needed" on */
+static void put_entry_fields(ZipBuffer *b, JarEntry *entry)
+{
+    put_u2(b, ZIP_VERSION);
+    put_u2(b, 0); /* Flags */
+    put_u2(b, ZIP_METHOD_STORED);
+    put_u2(b, ZIP_DOS_TIME);
+    put_u2(b, ZIP_DOS_DATE);
+    put_u4(b, entry->crc);
+    put_u4(b, (uint32_t)entry->size); /* Compressed size */
+    put_u4(b, (uint32_t)entry->size);
+    put_u2(b, strlen(entry->name));
+    put_u2(b, 0); /* Extra field length */
+}
+
+/* Write the local header and the bytes of entry at offset */
+static bool write_member(FILE *fp, JarEntry *entry, int offset)
+{
+    entry->crc = crc32_of(entry->data, entry->size);
+    entry->offset = offset;
+
+    ZipBuffer header;
+    buffer_init(&header, 64);
+    put_u4(&header, ZIP_LOCAL_HEADER_SIGNATURE);
+    put_entry_fields(&header, entry);
+    put_name(&header, entry->name);
+    int written = fwrite((const char *)header.data, 1, header.size, fp);
+    bool ok = written == header.size;
+    if (ok && entry->size > 0)
+    {
+        written = fwrite((const char *)entry->data, 1, entry->size, fp);
+        ok = written == entry->size;
+    }
+    free(header.data);
+    return ok;
+}
+
+static void put_central_header(ZipBuffer *b, JarEntry *entry)
+{
+    put_u4(b, ZIP_CENTRAL_HEADER_SIGNATURE);
+    put_u2(b, ZIP_VERSION); /* Version made by: MS-DOS */
+    put_entry_fields(b, entry);
+    put_u2(b, 0); /* Comment length */
+    put_u2(b, 0); /* Disk number */
+    put_u2(b, 0); /* Internal attributes */
+    put_u4(b, 0); /* External attributes */
+    put_u4(b, (uint32_t)entry->offset);
+    put_name(b, entry->name);
+}
+
+static JarEntry *create_manifest(JarWriter *jar)
+{
+    ZipBuffer text;
+    buffer_init(&text, 128);
+    put_name(&text, "Manifest-Version: 1.0\r\n");
+    put_name(&text, "Created-By: codegen\r\n");
+    put_name(&text, "Main-Class: ");
+    put_name(&text, jar->main_class);
+    put_name(&text, "\r\n\r\n");
+
+    JarEntry *manifest = (JarEntry *)calloc(1, sizeof(JarEntry));
+    manifest->name = strdup(MANIFEST_NAME);
+    manifest->data = text.data;
+    manifest->size = text.size;
+    return manifest;
+}
+
+bool jar_writer_write(JarWriter *jar)
+{
+    if (jar->count + 1 > ZIP_MAX_ENTRIES)
+    {
+        fprintf(stderr, "%s: too many classes for a jar (%d)\n", jar->path, jar->count);
+        return false;
+    }
+    FILE *fp = fopen(jar->path, "wb");
+    if (!fp)
+        return false;
+
+    /* The manifest comes first so that streaming readers find it */
+    JarEntry *manifest = create_manifest(jar);
+    bool ok = write_member(fp, manifest, 0);
+    int offset = 30 + strlen(manifest->name) + manifest->size;
+    for (int i = 0; ok && i < jar->count; i++)
+    {
+        JarEntry *entry = jar->entries[i];
+        ok = write_member(fp, entry, offset);
+        offset = offset + 30 + strlen(entry->name) + entry->size;
+    }
+
+    if (ok)
+    {
+        ZipBuffer directory;
+        buffer_init(&directory, 64 * (jar->count + 1));
+        put_central_header(&directory, manifest);
+        for (int i = 0; i < jar->count; i++)
+        {
+            put_central_header(&directory, jar->entries[i]);
+        }
+        int directory_size = directory.size;
+        put_u4(&directory, ZIP_END_SIGNATURE);
+        put_u2(&directory, 0); /* This disk */
+        put_u2(&directory, 0); /* Disk with the central directory */
+        put_u2(&directory, jar->count + 1);
+        put_u2(&directory, jar->count + 1);
+        put_u4(&directory, (uint32_t)directory_size);
+        put_u4(&directory, (uint32_t)offset);
+        put_u2(&directory, 0); /* Comment length */
+        int written = fwrite((const char *)directory.data, 1, directory.size, fp);
+        ok = written == directory.size;
+        free(directory.data);
+    }
+    fclose(fp);
+    free_entry(manifest);
+    return ok;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+ * jar_writer.h - Runnable .jar output for -o
+ *
+ * The classes of a build are added as they are generated and the archive
+ * is written when the build is done.  Entries are stored (not compressed),
+ * carry a fixed timestamp and are written in name order after
+ * META-INF/MANIFEST.MF, so the same classes always give the same bytes,
+ * however many threads generated them.
+ *
+ * Classes may be added from the workers of the parallel code generator.
+ */
+
+#include "cminor_base.h"
+
+/* One archive member */
+typedef struct JarEntry_tag
+{
+    char *name;
+    unsigned char *data;
+    int size;
+    uint32_t crc;
+    int offset; /* Of its local header; set while writing */
+} JarEntry;
+
+typedef struct JarWriter_tag
+{
+    char *path;
+    char *main_class;
+    JarEntry **entries; /* Sorted by name */
+    int count;
+    int capacity;
+} JarWriter;
+
+/* Archive to be written to path; main_class goes into the manifest */
+JarWriter *jar_writer_create(const char *path, const char *main_class);
+
+/* Add a member; the writer takes ownership of data.  A member added
+ * again under the same name replaces the earlier one. */
+void jar_writer_add(JarWriter *jar, const char *name, unsigned char *data, int size);
+
+/* Write the archive; false if the file cannot be written */
+bool jar_writer_write(JarWriter *jar);
+
+void jar_writer_destroy(JarWriter *jar);
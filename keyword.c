@@ -4,50 +4,103 @@
 #include "ast.h"
 #include "parser.h"
 
-static const struct OPE keyword_list[] = {
-    {"NULL", NULL_T},
-    {"bool", BOOL_T},
-    {"break", BREAK},
-    {"case", CASE},
-    {"char", CHAR_T},
-    {"const", CONST_T},
-    {"continue", CONTINUE},
-    {"default", DEFAULT},
+/*
+ * Perfect hash over the keywords, gperf-style: a word's slot is its length
+ * plus the associated values of its first and last characters.  Characters
+ * that start or end no keyword map past the table.  When adding a keyword,
+ * re-pick asso_values so every keyword still lands in a distinct slot.
+ */
+enum
+{
+    MIN_WORD_LENGTH = 2,
+    MAX_WORD_LENGTH = 8,
+    MAX_HASH_VALUE = 41
+};
+
+static const unsigned char asso_values[256] = {
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 10, 42, 0, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 17, 22, 5, 4, 14, 18, 7, 0, 42, 11, 15, 13, 19, 4,
+    42, 42, 15, 11, 1, 14, 10, 1, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+    42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+};
+
+static const struct OPE wordlist[] = {
+    {"", 0},
+    {"", 0},
+    {"", 0},
+    {"", 0},
+    {"int", INT_T},
+    {"", 0},
+    {"", 0},
+    {"", 0},
+    {"", 0},
+    {"true", TRUE_T},
+    {"while", WHILE},
     {"do", DO},
-    {"double", DOUBLE_T},
     {"else", ELSE},
-    {"enum", ENUM_T},
-    {"extern", EXTERN_T},
-    {"false", FALSE_T},
-    {"float", FLOAT_T},
-    {"for", FOR},
-    {"goto", GOTO},
+    {"default", DEFAULT},
+    {"NULL", NULL_T},
+    {"double", DOUBLE_T},
     {"if", IF},
-    {"int", INT_T},
-    {"long", LONG_T},
-    {"return", RETURN},
     {"short", SHORT_T},
-    {"sizeof", SIZEOF},
-    {"static", STATIC_T},
     {"struct", STRUCT_T},
-    {"switch", SWITCH},
-    {"true", TRUE_T},
+    {"void", VOID_T},
+    {"float", FLOAT_T},
+    {"enum", ENUM_T},
     {"typedef", TYPEDEF_T},
-    {"union", UNION_T},
+    {"false", FALSE_T},
+    {"switch", SWITCH},
+    {"", 0},
+    {"goto", GOTO},
     {"unsigned", UNSIGNED_T},
-    {"void", VOID_T},
-    {"while", WHILE},
+    {"const", CONST_T},
+    {"extern", EXTERN_T},
+    {"case", CASE},
+    {"sizeof", SIZEOF},
+    {"for", FOR},
+    {"break", BREAK},
+    {"continue", CONTINUE},
+    {"", 0},
+    {"bool", BOOL_T},
+    {"long", LONG_T},
+    {"union", UNION_T},
+    {"static", STATIC_T},
+    {"return", RETURN},
+    {"char", CHAR_T},
 };
 
+static int keyword_hash(char *str, unsigned int len)
+{
+    return (int)len + asso_values[str[0] & 0xFF] + asso_values[str[len - 1] & 0xFF];
+}
+
 struct OPE *in_word_set(char *str, unsigned int len)
 {
-    (void)len;
-    for (int i = 0; i < sizeof keyword_list / sizeof *keyword_list; ++i)
+    if (len < MIN_WORD_LENGTH || len > MAX_WORD_LENGTH)
+    {
+        return NULL;
+    }
+    int key = keyword_hash(str, len);
+    if (key > MAX_HASH_VALUE)
+    {
+        return NULL;
+    }
+    char *name = wordlist[key].name;
+    if (str[0] == name[0] && strncmp(str, name, len) == 0 && name[len] == '\0')
     {
-        if (strcmp(str, keyword_list[i].name) == 0)
-        {
-            return (struct OPE *)(&keyword_list[i]);
-        }
+        return (struct OPE *)(&wordlist[key]);
     }
     return NULL;
 }
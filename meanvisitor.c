@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "meanvisitor.h"
+#include "arena.h"
 #include "util.h"
 #include "create.h"
 #include "cminor_type.h"
@@ -379,44 +380,29 @@ static void leave_floatexpr(Expression *expr, Visitor *visitor)
 
 static void push_scope(MeanVisitor *visitor)
 {
-    Scope *scope = (Scope *)calloc(1, sizeof(Scope));
-    scope->decl_list = NULL;
-    scope->next = visitor->current_scope;
-    visitor->current_scope = scope;
+    symbol_table_push_scope(visitor->scopes);
 }
 
 static void pop_scope(MeanVisitor *visitor)
 {
-    if (visitor->current_scope)
-    {
-        visitor->current_scope = visitor->current_scope->next;
-    }
+    symbol_table_pop_scope(visitor->scopes);
+}
+
+static bool at_file_scope(MeanVisitor *visitor)
+{
+    return symbol_table_depth(visitor->scopes) == 0;
 }
 
 static void add_decl_to_scope(MeanVisitor *visitor, Declaration *decl)
 {
-    if (visitor->current_scope)
-    {
-        DeclarationList *node = (DeclarationList *)calloc(1, sizeof(DeclarationList));
-        node->decl = decl;
-        node->next = visitor->current_scope->decl_list;
-        visitor->current_scope->decl_list = node;
-    }
+    symbol_table_add(visitor->scopes, decl);
 }
 
+/* Innermost block-scope declaration of name; a later declaration in the
+ * same block shadows an earlier one */
 static Declaration *search_decl_in_scope(MeanVisitor *visitor, char *name)
 {
-    for (Scope *scope = visitor->current_scope; scope; scope = scope->next)
-    {
-        for (DeclarationList *list = scope->decl_list; list; list = list->next)
-        {
-            if (!strcmp(list->decl->name, name))
-            {
-                return list->decl;
-            }
-        }
-    }
-    return NULL;
+    return symbol_table_lookup(visitor->scopes, name);
 }
 
 static void enter_identexpr(Expression *expr, Visitor *visitor)
@@ -2245,7 +2231,7 @@ static void enter_declstmt(Statement *stmt, Visitor *visitor)
 {
     DBG_PRINT("DEBUG: enter_declstmt\n");
     MeanVisitor *mean = (MeanVisitor *)visitor;
-    if (mean->current_scope == NULL)
+    if (at_file_scope(mean))
     {
         CS_Compiler *compiler = mean->compiler;
         Declaration *decl = stmt->u.declaration_s;
@@ -2255,6 +2241,7 @@ static void enter_declstmt(Statement *stmt, Visitor *visitor)
         {
             decl->class_name = compiler->current_file_decl->class_name;
         }
+        decl->is_file_scope = true;
         compiler->decl_list = cs_chain_declaration(compiler->decl_list, decl);
     }
 }
@@ -2346,7 +2333,7 @@ static void leave_declstmt(Statement *stmt, Visitor *visitor)
      * clear is_extern on any existing extern declaration with the same name
      * and update its class_name to the defining class.
      * This ensures the field gets generated in register_static_fields(). */
-    if (!mean->current_scope && !decl->is_extern)
+    if (at_file_scope(mean) && !decl->is_extern)
     {
         Declaration *existing = cs_search_decl_global(mean->compiler, decl->name);
         if (existing && existing != decl && existing->is_extern)
@@ -3082,7 +3069,7 @@ MeanVisitor *create_mean_visitor(CS_Compiler *compiler)
     visitor->check_log = NULL;
     visitor->check_log_tail = NULL;
     visitor->log_count = 0;
-    visitor->current_scope = NULL;
+    visitor->scopes = symbol_table_create();
     visitor->compiler = compiler;
 
     /* Legacy function pointer arrays are no longer used.
@@ -3119,7 +3106,7 @@ void mean_visitor_enter_function(MeanVisitor *visitor, FunctionDeclaration *func
         {
             param->type = resolve_parsed_type(visitor->compiler, param->parsed_type);
         }
-        Declaration *decl = calloc(1, sizeof(Declaration));
+        Declaration *decl = arena_new_declaration();
         decl->name = param->name;
         decl->type = param->type;
         decl->parsed_type = param->parsed_type;
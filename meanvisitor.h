@@ -2,6 +2,7 @@
 
 #include "ast.h"
 #include "compiler.h"
+#include "symbol_table.h"
 #include "visitor.h"
 
 typedef struct MeanVisitor_tag MeanVisitor;
@@ -12,12 +13,6 @@ typedef struct MeanCheckLog_tag
     struct MeanCheckLog_tag *next;
 } MeanCheckLogger;
 
-typedef struct Scope_tag
-{
-    DeclarationList *decl_list;
-    struct Scope_tag *next;
-} Scope;
-
 typedef enum
 {
     VISIT_NORMAL,
@@ -46,7 +41,7 @@ typedef struct MeanVisitor_tag
     int log_count;
     MeanCheckLogger *check_log_tail;
     MeanCheckLogger *check_log;
-    Scope *current_scope;
+    SymbolTable *scopes; /* Block-scoped declarations (depth 0 = file scope) */
     SwitchTypeStack *switch_type_stack;    /* Current switch expression type */
     FunctionDeclaration *current_function; /* Current function for return type propagation */
 } MeanVisitor;
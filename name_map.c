@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "name_map.h"
+#include "ast.h"
+#include "util.h"
+
+/* Re-create the buckets for the current capacity (one bucket per two slots) */
+static void name_map_rebuild_buckets(NameMap *map)
+{
+    int bucket_count = map->capacity * 2;
+    if (map->heads)
+    {
+        free(map->heads);
+    }
+    map->heads = (int *)calloc(bucket_count, sizeof(int));
+    map->mask = bucket_count - 1;
+    for (int i = 1; i < map->count; ++i)
+    {
+        int bucket = (int)(map->hashes[i] & (uint32_t)map->mask);
+        map->next[i] = map->heads[bucket];
+        map->heads[bucket] = i;
+    }
+}
+
+static void name_map_allocate(NameMap *map, int capacity)
+{
+    map->keys = (const char **)calloc(capacity, sizeof(char *));
+    map->hashes = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+    map->values = (void **)calloc(capacity, sizeof(void *));
+    map->ranks = (int *)calloc(capacity, sizeof(int));
+    map->next = (int *)calloc(capacity, sizeof(int));
+    map->capacity = capacity;
+}
+
+static void name_map_grow(NameMap *map)
+{
+    const char **keys = map->keys;
+    uint32_t *hashes = map->hashes;
+    void **values = map->values;
+    int *ranks = map->ranks;
+    int *next = map->next;
+
+    name_map_allocate(map, map->capacity * 2);
+    for (int i = 1; i < map->count; ++i)
+    {
+        map->keys[i] = keys[i];
+        map->hashes[i] = hashes[i];
+        map->values[i] = values[i];
+        map->ranks[i] = ranks[i];
+    }
+    free(keys);
+    free(hashes);
+    free(values);
+    free(ranks);
+    free(next);
+    name_map_rebuild_buckets(map);
+}
+
+NameMap *name_map_create()
+{
+    NameMap *map = (NameMap *)calloc(1, sizeof(NameMap));
+    name_map_allocate(map, 16);
+    map->count = 1;
+    name_map_rebuild_buckets(map);
+    return map;
+}
+
+static int name_map_find(NameMap *map, const char *key, int length, uint32_t hash)
+{
+    int bucket = (int)(hash & (uint32_t)map->mask);
+    for (int i = map->heads[bucket]; i != 0; i = map->next[i])
+    {
+        if (map->hashes[i] == hash &&
+            (map->keys[i] == key ||
+             (strncmp(map->keys[i], key, length) == 0 && map->keys[i][length] == '\0')))
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void *name_map_get(NameMap *map, const char *key)
+{
+    if (!map || !key)
+    {
+        return NULL;
+    }
+    int length = strlen(key);
+    int idx = name_map_find(map, key, length, cs_span_hash(key, length));
+    if (idx == 0)
+    {
+        return NULL;
+    }
+    return map->values[idx];
+}
+
+void *name_map_get_span(NameMap *map, const char *key, int length)
+{
+    if (!map || !key)
+    {
+        return NULL;
+    }
+    int idx = name_map_find(map, key, length, cs_span_hash(key, length));
+    if (idx == 0)
+    {
+        return NULL;
+    }
+    return map->values[idx];
+}
+
+int name_map_rank(NameMap *map, const char *key)
+{
+    if (!map || !key)
+    {
+        return -1;
+    }
+    int length = strlen(key);
+    int idx = name_map_find(map, key, length, cs_span_hash(key, length));
+    if (idx == 0)
+    {
+        return -1;
+    }
+    return map->ranks[idx];
+}
+
+void name_map_offer(NameMap *map, const char *key, void *value, int rank, bool replace_equal)
+{
+    if (!map || !key)
+    {
+        return;
+    }
+    int length = strlen(key);
+    uint32_t hash = cs_span_hash(key, length);
+    int idx = name_map_find(map, key, length, hash);
+    if (idx != 0)
+    {
+        if (rank < map->ranks[idx] || (rank == map->ranks[idx] && replace_equal))
+        {
+            map->keys[idx] = key;
+            map->values[idx] = value;
+            map->ranks[idx] = rank;
+        }
+        return;
+    }
+
+    if (map->count == map->capacity)
+    {
+        name_map_grow(map);
+    }
+    idx = map->count;
+    map->count = map->count + 1;
+    map->keys[idx] = key;
+    map->hashes[idx] = hash;
+    map->values[idx] = value;
+    map->ranks[idx] = rank;
+    int bucket = (int)(hash & (uint32_t)map->mask);
+    map->next[idx] = map->heads[bucket];
+    map->heads[bucket] = idx;
+}
+
+void name_map_destroy(NameMap *map)
+{
+    if (!map)
+    {
+        return;
+    }
+    free(map->keys);
+    free(map->hashes);
+    free(map->values);
+    free(map->ranks);
+    free(map->next);
+    free(map->heads);
+    free(map);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+/*
+ * name_map.h - Hash map from names to declarations
+ *
+ * Keys are not copied; they must stay alive and unchanged while the map is
+ * in use (declaration names are never freed).  Each entry carries a rank
+ * that decides which of several declarations with the same name is kept:
+ * a lower rank replaces a higher one, and an equal rank replaces the
+ * existing entry only when the caller asks for last-match-wins.
+ */
+
+#include "cminor_base.h"
+
+typedef struct NameMap_tag
+{
+    const char **keys;
+    uint32_t *hashes;
+    void **values;
+    int *ranks;
+    int *next;
+    int count; /* Entries in use; index 0 is unused so that 0 ends a chain */
+    int capacity;
+
+    int *heads;
+    int mask;
+} NameMap;
+
+NameMap *name_map_create();
+
+/* Value stored for key, or NULL */
+void *name_map_get(NameMap *map, const char *key);
+
+/* Value stored for the length bytes at key (not NUL-terminated), or NULL */
+void *name_map_get_span(NameMap *map, const char *key, int length);
+
+/* Rank stored for key, or -1 */
+int name_map_rank(NameMap *map, const char *key);
+
+/* Store value for key unless an entry of better rank exists (see above) */
+void name_map_offer(NameMap *map, const char *key, void *value, int rank, bool replace_equal);
+
+/* Free the map itself; keys and values belong to the caller */
+void name_map_destroy(NameMap *map);
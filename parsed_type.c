@@ -7,6 +7,7 @@
  */
 
 #include "parsed_type.h"
+#include "arena.h"
 #include "create.h"
 #include "cminor_type.h"
 #include "header_store.h"
@@ -24,7 +25,7 @@
 
 static ParsedType *cs_allocate_parsed_type()
 {
-    return (ParsedType *)calloc(1, sizeof(ParsedType));
+    return arena_new_parsed_type();
 }
 
 /* ============================================================
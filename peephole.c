@@ -0,0 +1,824 @@
+/*
+ * Peephole optimization of a finished method
+ *
+ * The code builder emits each statement and expression in isolation, which
+ * leaves short redundant sequences at their seams.  This pass works on the
+ * resolved bytecode of one method:
+ *
+ *   1. decode the code into v->bytecode (cg_record_bytecode) and find the
+ *      branch targets with cfg_build()
+ *   2. rewrite/remove instructions on a per-instruction table; a pattern
+ *      never spans an instruction that is a branch target, except at its
+ *      first instruction
+ *   3. drop code that is no longer reachable
+ *   4. re-encode, then remap LineNumberTable entries and the builder's
+ *      branch-target frames (StackMapTable is generated afterwards)
+ *
+ * Rewrites:
+ *
+ *   xstore n; xload n        ->  dup(2); xstore n      (2-byte / wide forms)
+ *   dup_x1; pop              ->  swap
+ *   dup_x2; swap; putfield A; swap; dup_x1; swap; putfield B
+ *                            ->  dup_x2; dup_x2; swap; putfield A; putfield B
+ *   branch to goto L         ->  branch to L
+ *   goto to xreturn          ->  xreturn
+ *   ifXX L1; goto L2; L1:    ->  if!XX L2
+ *   goto to next instruction ->  (removed)
+ *   iconst_0/1; ifeq/ifne L  ->  goto L / (removed)
+ *
+ * The dup rewrites need one or two more operand stack slots, added to the
+ * method's max_stack when they fire.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "codebuilder_frame.h"
+#include "codegenvisitor.h"
+#include "peephole.h"
+
+enum
+{
+    PEEP_MAX_PASSES = 8,
+    PEEP_MAX_THREAD = 16
+};
+
+typedef struct PeepInstr_tag
+{
+    int pc;              /* Original bytecode offset */
+    int op;              /* Opcode emitted for this instruction */
+    int src_pc;          /* Original bytes copied verbatim (-1: op byte alone) */
+    int src_len;
+    int target;          /* Branch target instruction index (-1 if none) */
+    int *switch_targets; /* Switch target indices, default first (owned) */
+    int switch_count;
+    int refs;            /* Branches targeting this instruction */
+    int new_pc;
+    bool removed;
+} PeepInstr;
+
+typedef struct PeepMethod_tag
+{
+    const uint8_t *code;
+    int code_size;
+    PeepInstr *ins;
+    int count;
+    int extra_stack; /* Operand stack slots added by dup rewrites */
+} PeepMethod;
+
+static bool peep_is_cond(int op)
+{
+    return (op >= CF_IFEQ && op <= CF_IF_ACMPNE) || op == CF_IFNULL || op == CF_IFNONNULL;
+}
+
+static bool peep_is_return(int op)
+{
+    return op >= CF_IRETURN && op <= CF_RETURN;
+}
+
+static bool peep_is_switch(int op)
+{
+    return op == CF_TABLESWITCH || op == CF_LOOKUPSWITCH;
+}
+
+static bool peep_ends_flow(int op)
+{
+    return op == CF_GOTO || op == CF_ATHROW || peep_is_return(op) || peep_is_switch(op);
+}
+
+/* ifeq <-> ifne, iflt <-> ifge, ... (opcodes come in complementary pairs) */
+static int peep_negate(int op)
+{
+    if (op == CF_IFNULL)
+    {
+        return CF_IFNONNULL;
+    }
+    if (op == CF_IFNONNULL)
+    {
+        return CF_IFNULL;
+    }
+    return (op - CF_IFEQ) % 2 == 0 ? op + 1 : op - 1;
+}
+
+/* First instruction at or after i that is still present (count if none) */
+static int peep_live(PeepMethod *m, int i)
+{
+    while (i < m->count && m->ins[i].removed)
+    {
+        i++;
+    }
+    return i;
+}
+
+static int peep_next(PeepMethod *m, int i)
+{
+    return peep_live(m, i + 1);
+}
+
+static int peep_dest(PeepMethod *m, int i)
+{
+    return peep_live(m, m->ins[i].target);
+}
+
+static int peep_find(PeepMethod *m, int pc)
+{
+    int lo = 0;
+    int hi = m->count - 1;
+    while (lo <= hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (m->ins[mid].pc == pc)
+        {
+            return mid;
+        }
+        if (m->ins[mid].pc < pc)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+static void peep_count_refs(PeepMethod *m)
+{
+    for (int i = 0; i < m->count; ++i)
+    {
+        m->ins[i].refs = 0;
+    }
+    for (int i = peep_live(m, 0); i < m->count; i = peep_next(m, i))
+    {
+        PeepInstr *in = &m->ins[i];
+        if (in->target >= 0)
+        {
+            int d = peep_live(m, in->target);
+            if (d < m->count)
+            {
+                m->ins[d].refs++;
+            }
+        }
+        for (int t = 0; t < in->switch_count; ++t)
+        {
+            int d = peep_live(m, in->switch_targets[t]);
+            if (d < m->count)
+            {
+                m->ins[d].refs++;
+            }
+        }
+    }
+}
+
+/* Remove instruction i; branches to it now reach the next instruction */
+static void peep_remove(PeepMethod *m, int i)
+{
+    m->ins[i].removed = true;
+    int n = peep_live(m, i);
+    if (n < m->count)
+    {
+        m->ins[n].refs += m->ins[i].refs;
+    }
+}
+
+static void peep_set_op(PeepInstr *in, int op)
+{
+    in->op = op;
+    in->src_pc = -1;
+    in->src_len = 1;
+    in->target = -1;
+}
+
+/* 2-byte or wide xload/xstore (base is CF_ILOAD or CF_ISTORE).
+ * kind is 0..4 for i, l, f, d, a. */
+static bool peep_local_op(PeepMethod *m, int i, int base, int *kind, int *index)
+{
+    PeepInstr *in = &m->ins[i];
+    if (in->src_pc < 0)
+    {
+        return false;
+    }
+
+    const uint8_t *p = m->code + in->src_pc;
+    int op = p[0];
+    int idx = p[1];
+    if (op == CF_WIDE)
+    {
+        op = p[1];
+        idx = (p[2] << 8) | p[3];
+    }
+    if (op < base || op > base + 4)
+    {
+        return false;
+    }
+    *kind = op - base;
+    *index = idx;
+    return true;
+}
+
+/* xstore n; xload n -> dup(2); xstore n */
+static bool peep_store_load(PeepMethod *m, int i)
+{
+    int k = peep_next(m, i);
+    int store_kind = 0;
+    int store_index = 0;
+    int load_kind = 0;
+    int load_index = 0;
+    if (k >= m->count || m->ins[k].refs > 0 ||
+        !peep_local_op(m, i, CF_ISTORE, &store_kind, &store_index) ||
+        !peep_local_op(m, k, CF_ILOAD, &load_kind, &load_index) ||
+        store_kind != load_kind || store_index != load_index)
+    {
+        return false;
+    }
+
+    bool two_slots = store_kind == 1 || store_kind == 3;
+    PeepInstr *store = &m->ins[i];
+    PeepInstr *load = &m->ins[k];
+    load->op = store->op;
+    load->src_pc = store->src_pc;
+    load->src_len = store->src_len;
+    peep_set_op(store, two_slots ? CF_DUP2 : CF_DUP);
+    int extra = two_slots ? 2 : 1;
+    if (m->extra_stack < extra)
+    {
+        m->extra_stack = extra;
+    }
+    return true;
+}
+
+/* dup_x1; pop -> swap */
+static bool peep_dup_pop(PeepMethod *m, int i)
+{
+    int k = peep_next(m, i);
+    if (m->ins[i].op != CF_DUP_X1 || k >= m->count || m->ins[k].refs > 0 ||
+        m->ins[k].op != CF_POP)
+    {
+        return false;
+    }
+    peep_set_op(&m->ins[i], CF_SWAP);
+    peep_remove(m, k);
+    return true;
+}
+
+/* Pointer wrapper field stores: (base, offset, ptr) -> ptr
+ *   dup_x2; swap; putfield A; swap; dup_x1; swap; putfield B
+ *   -> dup_x2; dup_x2; swap; putfield A; putfield B */
+static bool peep_field_pair(PeepMethod *m, int i)
+{
+    int ops[7];
+    ops[0] = CF_DUP_X2;
+    ops[1] = CF_SWAP;
+    ops[2] = CF_PUTFIELD;
+    ops[3] = CF_SWAP;
+    ops[4] = CF_DUP_X1;
+    ops[5] = CF_SWAP;
+    ops[6] = CF_PUTFIELD;
+
+    int idx[7];
+    int j = i;
+    for (int n = 0; n < 7; ++n)
+    {
+        if (j >= m->count || m->ins[j].op != ops[n] || (n > 0 && m->ins[j].refs > 0))
+        {
+            return false;
+        }
+        idx[n] = j;
+        j = peep_next(m, j);
+    }
+
+    PeepInstr *put_a = &m->ins[idx[2]];
+    PeepInstr *put_b = &m->ins[idx[6]];
+    int a_pc = put_a->src_pc;
+    int a_len = put_a->src_len;
+
+    peep_set_op(&m->ins[idx[1]], CF_DUP_X2);
+    peep_set_op(put_a, CF_SWAP);
+    m->ins[idx[3]].op = CF_PUTFIELD;
+    m->ins[idx[3]].src_pc = a_pc;
+    m->ins[idx[3]].src_len = a_len;
+    m->ins[idx[4]].op = CF_PUTFIELD;
+    m->ins[idx[4]].src_pc = put_b->src_pc;
+    m->ins[idx[4]].src_len = put_b->src_len;
+    peep_remove(m, idx[5]);
+    peep_remove(m, idx[6]);
+    if (m->extra_stack < 1)
+    {
+        m->extra_stack = 1;
+    }
+    return true;
+}
+
+/* Branch to a goto -> branch to the goto's target */
+static bool peep_thread_jump(PeepMethod *m, int i)
+{
+    PeepInstr *in = &m->ins[i];
+    bool changed = false;
+    for (int hop = 0; hop < PEEP_MAX_THREAD; ++hop)
+    {
+        int d = peep_dest(m, i);
+        if (d >= m->count || d == i || m->ins[d].op != CF_GOTO)
+        {
+            break;
+        }
+        int next = peep_dest(m, d);
+        if (next >= m->count || next == d)
+        {
+            break;
+        }
+        in->target = next;
+        m->ins[next].refs++;
+        changed = true;
+    }
+    return changed;
+}
+
+/* goto L; ... L: xreturn -> xreturn */
+static bool peep_goto_return(PeepMethod *m, int i)
+{
+    if (m->ins[i].op != CF_GOTO)
+    {
+        return false;
+    }
+    int d = peep_dest(m, i);
+    if (d >= m->count || !peep_is_return(m->ins[d].op))
+    {
+        return false;
+    }
+    peep_set_op(&m->ins[i], m->ins[d].op);
+    return true;
+}
+
+/* ifXX L1; goto L2; L1: -> if!XX L2 */
+static bool peep_invert_branch(PeepMethod *m, int i)
+{
+    int k = peep_next(m, i);
+    if (!peep_is_cond(m->ins[i].op) || k >= m->count || m->ins[k].op != CF_GOTO ||
+        m->ins[k].refs > 0 || peep_dest(m, i) != peep_next(m, k))
+    {
+        return false;
+    }
+    m->ins[i].op = peep_negate(m->ins[i].op);
+    m->ins[i].target = m->ins[k].target;
+    peep_remove(m, k);
+    return true;
+}
+
+/* goto to the next instruction */
+static bool peep_goto_next(PeepMethod *m, int i)
+{
+    if (m->ins[i].op != CF_GOTO || peep_dest(m, i) != peep_next(m, i))
+    {
+        return false;
+    }
+    peep_remove(m, i);
+    return true;
+}
+
+/* iconst_0/1; ifeq/ifne L -> goto L, or nothing */
+static bool peep_const_branch(PeepMethod *m, int i)
+{
+    int op = m->ins[i].op;
+    int k = peep_next(m, i);
+    if ((op != CF_ICONST_0 && op != CF_ICONST_1) || k >= m->count || m->ins[k].refs > 0 ||
+        (m->ins[k].op != CF_IFEQ && m->ins[k].op != CF_IFNE))
+    {
+        return false;
+    }
+
+    bool taken = (op == CF_ICONST_1) == (m->ins[k].op == CF_IFNE);
+    peep_remove(m, i);
+    if (taken)
+    {
+        m->ins[k].op = CF_GOTO;
+    }
+    else
+    {
+        peep_remove(m, k);
+    }
+    return true;
+}
+
+/* Push i on the reachability worklist if not seen yet; returns the new top */
+static int peep_mark(PeepMethod *m, bool *reached, int *work, int top, int i)
+{
+    if (i < m->count && !reached[i])
+    {
+        reached[i] = true;
+        work[top] = i;
+        top++;
+    }
+    return top;
+}
+
+/* Remove instructions not reachable from the method entry */
+static bool peep_remove_unreachable(PeepMethod *m)
+{
+    bool *reached = (bool *)calloc(m->count, sizeof(bool));
+    int *work = (int *)calloc(m->count, sizeof(int));
+    int top = 0;
+    top = peep_mark(m, reached, work, top, peep_live(m, 0));
+    while (top > 0)
+    {
+        top--;
+        int i = work[top];
+        PeepInstr *in = &m->ins[i];
+        if (!peep_ends_flow(in->op))
+        {
+            top = peep_mark(m, reached, work, top, peep_next(m, i));
+        }
+        if (in->target >= 0)
+        {
+            top = peep_mark(m, reached, work, top, peep_live(m, in->target));
+        }
+        for (int t = 0; t < in->switch_count; ++t)
+        {
+            top = peep_mark(m, reached, work, top, peep_live(m, in->switch_targets[t]));
+        }
+    }
+
+    bool changed = false;
+    for (int i = 0; i < m->count; ++i)
+    {
+        if (!m->ins[i].removed && !reached[i])
+        {
+            m->ins[i].removed = true;
+            changed = true;
+        }
+    }
+    free(reached);
+    free(work);
+    return changed;
+}
+
+static bool peep_run_rules(PeepMethod *m)
+{
+    bool changed = false;
+    peep_count_refs(m);
+    for (int i = peep_live(m, 0); i < m->count; i = peep_next(m, i))
+    {
+        PeepInstr *in = &m->ins[i];
+        if (in->target >= 0 && peep_thread_jump(m, i))
+        {
+            changed = true;
+        }
+        if (peep_goto_return(m, i) || peep_goto_next(m, i) || peep_invert_branch(m, i) ||
+            peep_const_branch(m, i) || peep_store_load(m, i) || peep_dup_pop(m, i) ||
+            peep_field_pair(m, i))
+        {
+            changed = true;
+        }
+    }
+    if (peep_remove_unreachable(m))
+    {
+        changed = true;
+    }
+    return changed;
+}
+
+/* Switch operands start at the next 4-byte boundary after the opcode */
+static int peep_switch_pad(int pc)
+{
+    return 3 - pc % 4;
+}
+
+static int peep_encoded_length(PeepInstr *in, int pc)
+{
+    if (peep_is_switch(in->op))
+    {
+        return in->src_len - peep_switch_pad(in->src_pc) + peep_switch_pad(pc);
+    }
+    if (in->target >= 0)
+    {
+        return 3;
+    }
+    return in->src_len;
+}
+
+static void peep_put_s4(uint8_t *out, int pos, int value)
+{
+    out[pos] = (uint8_t)((value >> 24) & 0xFF);
+    out[pos + 1] = (uint8_t)((value >> 16) & 0xFF);
+    out[pos + 2] = (uint8_t)((value >> 8) & 0xFF);
+    out[pos + 3] = (uint8_t)(value & 0xFF);
+}
+
+static void peep_encode_switch(PeepMethod *m, PeepInstr *in, uint8_t *out)
+{
+    int pc = in->new_pc;
+    int pos = pc + 1 + peep_switch_pad(pc);
+    int src = in->src_pc + 1 + peep_switch_pad(in->src_pc);
+    out[pc] = (uint8_t)in->op;
+
+    peep_put_s4(out, pos, m->ins[peep_live(m, in->switch_targets[0])].new_pc - pc);
+    if (in->op == CF_TABLESWITCH)
+    {
+        memcpy(out + pos + 4, m->code + src + 4, 8);
+        for (int t = 1; t < in->switch_count; ++t)
+        {
+            int d = peep_live(m, in->switch_targets[t]);
+            peep_put_s4(out, pos + 8 + 4 * t, m->ins[d].new_pc - pc);
+        }
+    }
+    else
+    {
+        memcpy(out + pos + 4, m->code + src + 4, 4);
+        for (int t = 1; t < in->switch_count; ++t)
+        {
+            int d = peep_live(m, in->switch_targets[t]);
+            memcpy(out + pos + 8 * t, m->code + src + 8 * t, 4);
+            peep_put_s4(out, pos + 8 * t + 4, m->ins[d].new_pc - pc);
+        }
+    }
+}
+
+/* Lay out and encode the remaining instructions.
+ * Returns NULL if a branch no longer fits a 16-bit offset. */
+static uint8_t *peep_encode(PeepMethod *m, int *new_size)
+{
+    int pc = 0;
+    for (int i = 0; i < m->count; ++i)
+    {
+        if (!m->ins[i].removed)
+        {
+            m->ins[i].new_pc = pc;
+            pc += peep_encoded_length(&m->ins[i], pc);
+        }
+    }
+    *new_size = pc;
+
+    /* Removed instructions map to the next remaining one */
+    int next_pc = pc;
+    for (int i = m->count - 1; i >= 0; --i)
+    {
+        if (m->ins[i].removed)
+        {
+            m->ins[i].new_pc = next_pc;
+        }
+        else
+        {
+            next_pc = m->ins[i].new_pc;
+        }
+    }
+
+    uint8_t *out = (uint8_t *)calloc(pc > 0 ? pc : 1, sizeof(uint8_t));
+    for (int i = peep_live(m, 0); i < m->count; i = peep_next(m, i))
+    {
+        PeepInstr *in = &m->ins[i];
+        if (peep_is_switch(in->op))
+        {
+            peep_encode_switch(m, in, out);
+        }
+        else if (in->target >= 0)
+        {
+            int d = peep_dest(m, i);
+            int offset = d < m->count ? m->ins[d].new_pc - in->new_pc : 0;
+            if (d >= m->count || offset < -32768 || offset > 32767)
+            {
+                free(out);
+                return NULL;
+            }
+            out[in->new_pc] = (uint8_t)in->op;
+            out[in->new_pc + 1] = (uint8_t)((offset >> 8) & 0xFF);
+            out[in->new_pc + 2] = (uint8_t)(offset & 0xFF);
+        }
+        else if (in->src_pc >= 0)
+        {
+            memcpy(out + in->new_pc, m->code + in->src_pc, in->src_len);
+        }
+        else
+        {
+            out[in->new_pc] = (uint8_t)in->op;
+        }
+    }
+    return out;
+}
+
+static int peep_map_pc(PeepMethod *m, int pc, int new_size)
+{
+    int idx = peep_find(m, pc);
+    return idx >= 0 ? m->ins[idx].new_pc : new_size;
+}
+
+static void peep_remap_lines(PeepMethod *m, MethodCode *mc, int new_size)
+{
+    int w = 0;
+    for (int i = 0; i < mc->line_number_count; ++i)
+    {
+        LineNumberEntry entry = mc->line_numbers[i];
+        entry.start_pc = peep_map_pc(m, entry.start_pc, new_size);
+        if (entry.start_pc >= new_size)
+        {
+            continue;
+        }
+        /* Entries collapsed onto one pc: the last one describes it */
+        if (w > 0 && mc->line_numbers[w - 1].start_pc == entry.start_pc)
+        {
+            w--;
+        }
+        mc->line_numbers[w] = entry;
+        w++;
+    }
+    mc->line_number_count = w;
+}
+
+/* Keep one frame per remaining branch target. A frame recorded at a
+ * removed instruction moves to the next one unless that has its own. */
+static void peep_remap_frames(PeepMethod *m, CodeBuilder *builder)
+{
+    int *chosen = (int *)calloc(m->count > 0 ? m->count : 1, sizeof(int));
+    for (int i = 0; i < m->count; ++i)
+    {
+        chosen[i] = -1;
+    }
+
+    for (int t = 0; t < builder->branch_target_count; ++t)
+    {
+        CB_BranchTarget *bt = &builder->branch_targets[t];
+        int idx = peep_find(m, bt->pc);
+        int j = idx >= 0 ? peep_live(m, idx) : m->count;
+        if (j >= m->count || m->ins[j].refs == 0)
+        {
+            cb_free_frame(bt->frame);
+            bt->frame = NULL;
+            continue;
+        }
+
+        int prev = chosen[j];
+        if (prev < 0)
+        {
+            chosen[j] = t;
+            continue;
+        }
+        int prev_pc = builder->branch_targets[prev].pc;
+        if (prev_pc != m->ins[j].pc && (bt->pc == m->ins[j].pc || bt->pc > prev_pc))
+        {
+            cb_free_frame(builder->branch_targets[prev].frame);
+            builder->branch_targets[prev].frame = NULL;
+            chosen[j] = t;
+        }
+        else
+        {
+            cb_free_frame(bt->frame);
+            bt->frame = NULL;
+        }
+    }
+
+    CB_BranchTarget *targets = (CB_BranchTarget *)calloc(
+        builder->branch_target_capacity > 0 ? builder->branch_target_capacity : 1,
+        sizeof(CB_BranchTarget));
+    int count = 0;
+    for (int j = 0; j < m->count; ++j)
+    {
+        if (chosen[j] >= 0)
+        {
+            targets[count] = builder->branch_targets[chosen[j]];
+            targets[count].pc = m->ins[j].new_pc;
+            count++;
+        }
+    }
+    free(builder->branch_targets);
+    builder->branch_targets = targets;
+    builder->branch_target_count = count;
+    free(chosen);
+}
+
+/* Decode the method into the instruction table. Returns false for code the
+ * pass does not handle (subroutines, wide gotos, exception handlers). */
+static bool peep_decode(CodegenVisitor *v, PeepMethod *m)
+{
+    CodeBuilder *builder = v->builder;
+    for (int t = 0; t < builder->branch_target_count; ++t)
+    {
+        if (builder->branch_targets[t].is_exception)
+        {
+            return false;
+        }
+    }
+
+    v->bytecode_count = 0;
+    for (int pc = 0; pc < m->code_size;)
+    {
+        int length = cfg_instr_length(m->code, m->code_size, pc);
+        int op = m->code[pc];
+        if (length == 0 || pc + length > m->code_size || op == CF_JSR || op == CF_RET ||
+            op == CF_GOTO_W || op == CF_JSR_W)
+        {
+            return false;
+        }
+        cg_record_bytecode(v, m->code[pc], pc, length);
+        pc += length;
+    }
+
+    m->count = v->bytecode_count;
+    m->ins = (PeepInstr *)calloc(m->count > 0 ? m->count : 1, sizeof(PeepInstr));
+    for (int i = 0; i < m->count; ++i)
+    {
+        m->ins[i].pc = v->bytecode[i].pc;
+    }
+
+    CFG_Info cfg = cfg_build(v->bytecode, v->bytecode_count, m->code, m->code_size, NULL, 0);
+    bool ok = true;
+    for (int i = 0; i < m->count; ++i)
+    {
+        BytecodeInstr *bc = &v->bytecode[i];
+        PeepInstr *in = &m->ins[i];
+        in->op = m->code[bc->pc];
+        in->src_pc = bc->pc;
+        in->src_len = bc->length;
+        in->target = -1;
+
+        if (peep_is_cond(in->op) || in->op == CF_GOTO)
+        {
+            in->target = peep_find(m, cfg.succ_pc0[i]);
+            ok = ok && in->target >= 0;
+        }
+        else if (peep_is_switch(in->op))
+        {
+            int *pcs = NULL;
+            in->switch_count = cfg_switch_targets(m->code, m->code_size, bc->pc, &pcs);
+            in->switch_targets = (int *)calloc(in->switch_count > 0 ? in->switch_count : 1,
+                                               sizeof(int));
+            for (int t = 0; t < in->switch_count; ++t)
+            {
+                in->switch_targets[t] = peep_find(m, pcs[t]);
+                ok = ok && in->switch_targets[t] >= 0;
+            }
+            free(pcs);
+        }
+    }
+    cfg_free(&cfg);
+    return ok;
+}
+
+static void peep_free(PeepMethod *m)
+{
+    for (int i = 0; i < m->count; ++i)
+    {
+        free(m->ins[i].switch_targets);
+    }
+    free(m->ins);
+}
+
+int peephole_optimize(CodegenVisitor *v)
+{
+    MethodCode *mc = v->builder->method;
+    PeepMethod m;
+    m.code = mc->code;
+    m.code_size = mc->code_size;
+    m.ins = NULL;
+    m.count = 0;
+    m.extra_stack = 0;
+    if (m.code_size == 0)
+    {
+        return 0;
+    }
+
+    if (!peep_decode(v, &m))
+    {
+        peep_free(&m);
+        return 0;
+    }
+
+    bool changed = false;
+    for (int pass = 0; pass < PEEP_MAX_PASSES; ++pass)
+    {
+        if (!peep_run_rules(&m))
+        {
+            break;
+        }
+        changed = true;
+    }
+    if (!changed)
+    {
+        peep_free(&m);
+        return 0;
+    }
+
+    int new_size = 0;
+    uint8_t *out = peep_encode(&m, &new_size);
+    if (!out || new_size > m.code_size)
+    {
+        free(out);
+        peep_free(&m);
+        return 0;
+    }
+
+    peep_count_refs(&m);
+    peep_remap_lines(&m, mc, new_size);
+    peep_remap_frames(&m, v->builder);
+    v->builder->max_stack += m.extra_stack;
+
+    int removed = m.code_size - new_size;
+    mc->code_size = 0;
+    for (int i = 0; i < new_size; ++i)
+    {
+        method_code_emit_u1(mc, out[i]);
+    }
+    free(out);
+    peep_free(&m);
+    return removed;
+}
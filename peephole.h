@@ -0,0 +1,16 @@
+#pragma once
+
+typedef struct CodegenVisitor_tag CodegenVisitor;
+
+/*
+ * Peephole optimization of a finished method
+ *
+ * Runs after codebuilder_resolve_jumps() and before StackMapTable
+ * generation.  The method's bytecode is decoded into v->bytecode,
+ * split into basic blocks by cfg_build(), rewritten, and re-encoded;
+ * branch offsets, switch padding, LineNumberTable entries and the
+ * builder's branch-target frames are remapped to the new layout.
+ */
+
+/* Optimize the current method in place. Returns the number of code bytes removed. */
+int peephole_optimize(CodegenVisitor *v);
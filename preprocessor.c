@@ -8,6 +8,7 @@
 #include "compiler.h"
 #include "create.h"
 #include "embedded_data.h"
+#include "intern.h"
 #include "keyword.h"
 #include "scanner.h"
 #include "preprocessor.h"
@@ -23,6 +24,7 @@ static void advance_logical_line(Preprocessor *pp);
 static void sync_location(Preprocessor *pp);
 static void mark_token_start(Preprocessor *pp);
 static char *retain_string(Preprocessor *pp, const char *src);
+static int lex_token(Preprocessor *pp, PreprocessorToken *tok);
 
 static char *dup_string(const char *src)
 {
@@ -263,42 +265,44 @@ static void ensure_macro_stack_capacity(MacroExpansionStack *stack)
             (MacroExpansion *)calloc(new_cap, sizeof(MacroExpansion));
         for (int i = 0; i < stack->size; i++)
             new_data[i] = stack->data[i];
+        free(stack->data);
         stack->data = new_data;
         stack->capacity = new_cap;
     }
 }
 
-static void push_expansion(MacroExpansionStack *stack, MacroExpansion exp)
+/* Open a frame over tokens (freed when it is popped).  macro is not
+ * expanded again until the frame has been read to its end. */
+static void push_expansion(Preprocessor *pp, PreprocessorToken *tokens, int count, Macro *macro,
+                           bool barrier)
 {
+    MacroExpansionStack *stack = pp->expansions;
     ensure_macro_stack_capacity(stack);
-    stack->data[stack->size++] = exp;
-}
-
-static MacroExpansion *top_expansion(MacroExpansionStack *stack)
-{
-    if (stack->size == 0)
-        return NULL;
-    return &stack->data[stack->size - 1];
+    MacroExpansion *exp = &stack->data[stack->size++];
+    exp->tokens = tokens;
+    exp->count = count;
+    exp->position = 0;
+    exp->macro = macro;
+    exp->barrier = barrier;
+    if (macro)
+        macro->expanding = true;
 }
 
-static void pop_expansion(MacroExpansionStack *stack)
+static void pop_expansion(Preprocessor *pp)
 {
+    MacroExpansionStack *stack = pp->expansions;
     if (stack->size == 0)
         return;
     MacroExpansion *exp = &stack->data[--stack->size];
-    free((void *)exp->text);
+    if (exp->macro)
+        exp->macro->expanding = false;
+    free(exp->tokens);
+    exp->tokens = NULL;
 }
 
-static Macro *find_macro(Macro *macros, const char *name)
+static Macro *find_macro(Preprocessor *pp, const char *name)
 {
-    for (Macro *m = macros; m; m = m->next)
-    {
-        if (strcmp(m->name, name) == 0)
-        {
-            return m;
-        }
-    }
-    return NULL;
+    return (Macro *)name_map_get(pp->macro_table, name);
 }
 
 static void free_macro(Macro *macro)
@@ -306,63 +310,24 @@ static void free_macro(Macro *macro)
     if (!macro)
         return;
     free(macro->name);
-    for (int i = 0; i < macro->param_count; ++i)
-    {
-        free(macro->params[i]);
-    }
-    free(macro->params);
     free(macro->body);
     free(macro);
 }
 
+/* Make macro the definition of its name.  A definition it replaces stays
+ * on pp->macros, since open expansion frames may still refer to it. */
 static void add_macro(Preprocessor *pp, Macro *macro)
 {
-    Macro *existing = find_macro(pp->macros, macro->name);
-    if (existing)
-    {
-        macro->next = existing->next;
-        existing->next = NULL;
-        free_macro(existing);
-        if (pp->macros == existing)
-        {
-            pp->macros = macro;
-        }
-        else
-        {
-            Macro *iter = pp->macros;
-            while (iter && iter->next != existing)
-                iter = iter->next;
-            if (iter)
-                iter->next = macro;
-            else
-                macro->next = pp->macros;
-        }
-    }
-    else
-    {
-        macro->next = pp->macros;
-        pp->macros = macro;
-    }
+    macro->next = pp->macros;
+    pp->macros = macro;
+    name_map_offer(pp->macro_table, macro->name, macro, 0, true);
 }
 
 static void remove_macro(Preprocessor *pp, const char *name)
 {
-    Macro *prev = NULL;
-    Macro *cur = pp->macros;
-    while (cur)
-    {
-        if (strcmp(cur->name, name) == 0)
-        {
-            if (prev)
-                prev->next = cur->next;
-            else
-                pp->macros = cur->next;
-            free_macro(cur);
-            return;
-        }
-        prev = cur;
-        cur = cur->next;
-    }
+    Macro *macro = find_macro(pp, name);
+    if (macro)
+        name_map_offer(pp->macro_table, macro->name, NULL, 0, true);
 }
 
 static void free_macros(Macro *macro)
@@ -434,6 +399,154 @@ static void advance_logical_line(Preprocessor *pp)
     sync_location(pp);
 }
 
+/*
+ * Block scanning: text the lexer never sees (comments, blank runs and
+ * inactive #if regions) is skipped by reading the current ByteBuffer
+ * directly and counting the newlines passed.  Each loop stops at a
+ * backslash, which may start a line continuation, and leaves it to the
+ * character-at-a-time path.
+ */
+
+/* Account for newlines passed by a block scan of frame's buffer */
+static void advance_lines(Preprocessor *pp, SourceFrame *frame, int count, int line_start)
+{
+    if (count == 0)
+        return;
+    ByteBuffer *buf = frame->buffer;
+    buf->line = buf->line + count;
+    buf->line_start_pos = line_start;
+    frame->logical_line = frame->logical_line + count;
+    sync_location(pp);
+}
+
+/* Skip spaces, tabs and newlines before a token */
+static void skip_blank_text(Preprocessor *pp)
+{
+    SourceFrame *frame = current_frame(pp->sources);
+    if (!frame)
+        return;
+    ByteBuffer *buf = frame->buffer;
+    const char *data = buf->data;
+    int size = buf->size;
+    int pos = buf->position;
+    int lines = 0;
+    int line_start = buf->line_start_pos;
+    while (pos < size)
+    {
+        char ch = data[pos];
+        if (ch == '\n')
+        {
+            lines++;
+            line_start = pos + 1;
+            pp->at_line_start = true;
+        }
+        else if (ch != ' ' && ch != '\t')
+        {
+            break;
+        }
+        pos++;
+    }
+    buf->position = pos;
+    advance_lines(pp, frame, lines, line_start);
+}
+
+/* Skip the text of a // comment up to its newline */
+static void skip_line_comment_text(Preprocessor *pp)
+{
+    SourceFrame *frame = current_frame(pp->sources);
+    if (!frame)
+        return;
+    ByteBuffer *buf = frame->buffer;
+    const char *data = buf->data;
+    int size = buf->size;
+    int pos = buf->position;
+    while (pos < size && data[pos] != '\n' && data[pos] != '\\')
+        pos++;
+    buf->position = pos;
+}
+
+/* Skip the text of a block comment after its opening.  Returns EOF once
+ * the closing marker is consumed, otherwise the character before the
+ * stopping point (0 if none) for the character-at-a-time path. */
+static int skip_block_comment_text(Preprocessor *pp)
+{
+    SourceFrame *frame = current_frame(pp->sources);
+    if (!frame)
+        return 0;
+    ByteBuffer *buf = frame->buffer;
+    const char *data = buf->data;
+    int size = buf->size;
+    int pos = buf->position;
+    int lines = 0;
+    int line_start = buf->line_start_pos;
+    int prev = 0;
+    bool closed = false;
+    while (pos < size)
+    {
+        char ch = data[pos];
+        if (ch == '\\')
+            break;
+        pos++;
+        if (ch == '\n')
+        {
+            lines++;
+            line_start = pos;
+        }
+        else if (ch == '/' && prev == '*')
+        {
+            closed = true;
+            break;
+        }
+        prev = ch & 0xFF;
+    }
+    buf->position = pos;
+    if (lines > 0)
+        pp->at_line_start = true;
+    advance_lines(pp, frame, lines, line_start);
+    if (closed)
+        return EOF;
+    return prev;
+}
+
+/* Skip inactive text up to a '#' that starts a line */
+static void skip_inactive_text(Preprocessor *pp)
+{
+    SourceFrame *frame = current_frame(pp->sources);
+    if (!frame)
+        return;
+    ByteBuffer *buf = frame->buffer;
+    const char *data = buf->data;
+    int size = buf->size;
+    int pos = buf->position;
+    int lines = 0;
+    int line_start = buf->line_start_pos;
+    bool at_line_start = pp->at_line_start;
+    while (pos < size)
+    {
+        char ch = data[pos];
+        if (ch == '\\' || (ch == '#' && at_line_start))
+            break;
+        /* Block comments are left to the caller, which keeps the line start
+         * across them, so a '#' after a comment still starts a directive */
+        if (ch == '/' && pos + 1 < size && data[pos + 1] == '*')
+            break;
+        pos++;
+        if (ch == '\n')
+        {
+            lines++;
+            line_start = pos;
+            at_line_start = true;
+        }
+        else if (!(ascii_class_table[ch & 0xFF] & ASCII_CLASS_SPACE))
+        {
+            at_line_start = false;
+        }
+    }
+    buf->position = pos;
+    pp->at_line_start = at_line_start;
+    advance_lines(pp, frame, lines, line_start);
+}
+
 static void mark_token_start(Preprocessor *pp)
 {
     if (!pp)
@@ -467,6 +580,7 @@ static void ensure_yytext_capacity(Scanner *scanner)
         scanner->yt_max += BUFFER_GROW;
         char *new_buf = (char *)calloc(scanner->yt_max, sizeof(char));
         memcpy(new_buf, scanner->yytext, old_max);
+        free(scanner->yytext);
         scanner->yytext = new_buf;
     }
 }
@@ -487,59 +601,8 @@ static void resetText(Scanner *scanner)
         scanner->yytext[0] = '\0';
 }
 
-static void push_expansion_text(Preprocessor *pp, const char *text, Macro *macro)
-{
-    if (!text)
-        return;
-    int len = strlen(text);
-    bool ends_with_space = len > 0 && ascii_is_space(text[len - 1]);
-    char last_nonspace = '\0';
-    for (int i = len; i > 0; --i)
-    {
-        if (!ascii_is_space(text[i - 1]))
-        {
-            last_nonspace = text[i - 1];
-            break;
-        }
-    }
-
-    char *buffer = NULL;
-    if (len > 0 && !ends_with_space && ascii_is_identchar(last_nonspace))
-    {
-        int next = get_raw_char(pp);
-        if (next != EOF)
-            unget_raw_char(pp, next);
-        if (next != EOF && ascii_is_identchar((unsigned char)next))
-        {
-            buffer = (char *)calloc(len + 2, sizeof(char));
-            strncpy(buffer, text, len);
-            buffer[len] = ' ';
-            buffer[len + 1] = '\0';
-        }
-    }
-    MacroExpansion exp = {buffer ? buffer : dup_string(text), 0, macro};
-    push_expansion(pp->expansions, exp);
-    if (macro)
-        macro->expanding = true;
-}
-
 static int get_raw_char_no_continuation(Preprocessor *pp)
 {
-    MacroExpansion *exp = top_expansion(pp->expansions);
-    if (exp)
-    {
-        char ch = exp->text[exp->position];
-        if (ch == '\0')
-        {
-            if (exp->macro)
-                exp->macro->expanding = false;
-            pop_expansion(pp->expansions);
-            return get_raw_char(pp);
-        }
-        exp->position++;
-        return ch;
-    }
-
     int ch = source_getc(pp);
     if (ch == EOF)
         return EOF;
@@ -557,13 +620,6 @@ static void unget_raw_char(Preprocessor *pp, int ch)
             sync_location(pp);
         }
     }
-    MacroExpansion *exp = top_expansion(pp->expansions);
-    if (exp)
-    {
-        if (exp->position > 0)
-            exp->position--;
-        return;
-    }
     source_ungetc(pp, ch);
 }
 
@@ -612,6 +668,7 @@ static void append_char(char **buf, int *len, int *cap, char ch)
             return;
         if (*buf && old_cap > 0)
             memcpy(new_buf, *buf, old_cap);
+        free(*buf);
         *buf = new_buf;
         *cap = new_cap;
     }
@@ -619,14 +676,6 @@ static void append_char(char **buf, int *len, int *cap, char ch)
     (*buf)[*len] = '\0';
 }
 
-static void append_string(char **buf, int *len, int *cap, const char *src)
-{
-    while (*src)
-    {
-        append_char(buf, len, cap, *src++);
-    }
-}
-
 static int peek_char(Preprocessor *pp)
 {
     int ch = get_raw_char(pp);
@@ -648,8 +697,36 @@ static int next_nonspace_char(Preprocessor *pp)
     return EOF;
 }
 
+/* Directive line copied straight from the current source buffer, with its
+ * newline; NULL when it has a backslash (a possible continuation) or runs
+ * to the end of the buffer */
+static char *read_line_span(Preprocessor *pp)
+{
+    SourceFrame *frame = current_frame(pp->sources);
+    if (!frame)
+        return NULL;
+    ByteBuffer *buf = frame->buffer;
+    const char *data = buf->data;
+    int size = buf->size;
+    int start = buf->position;
+    int pos = start;
+    while (pos < size && data[pos] != '\n' && data[pos] != '\\')
+        pos++;
+    if (pos == size || data[pos] == '\\')
+        return NULL;
+    int len = pos + 1 - start;
+    char *line = (char *)calloc(len + 1, sizeof(char));
+    memcpy(line, data + start, len);
+    buf->position = pos + 1;
+    advance_lines(pp, frame, 1, pos + 1);
+    return line;
+}
+
 static char *read_line_raw(Preprocessor *pp)
 {
+    char *line = read_line_span(pp);
+    if (line)
+        return line;
     char *buf = NULL;
     int len = 0;
     int cap = 0;
@@ -734,15 +811,11 @@ static void skip_whitespace_internal(const char **cursor)
         (*cursor)++;
 }
 
-typedef enum
+enum
 {
-    PP_TOKEN_IDENTIFIER,
-    PP_TOKEN_NUMBER,
-    PP_TOKEN_STRING,
-    PP_TOKEN_CHAR,
-    PP_TOKEN_WHITESPACE,
-    PP_TOKEN_OTHER,
-} PreprocessorTokenType;
+    PP_TOKEN_END = 0,    /* End of an argument being pre-expanded */
+    PP_TOKEN_INVALID = 1 /* Character that starts no token; an error once emitted */
+};
 
 typedef struct
 {
@@ -751,25 +824,19 @@ typedef struct
     int capacity;
 } TokenArray;
 
-static void free_tokens(PreprocessorToken *tokens, int count)
-{
-    if (!tokens)
-        return;
-    for (int i = 0; i < count; ++i)
-    {
-        free(tokens[i].text);
-    }
-    free(tokens);
-}
-
-static void free_token_array(TokenArray *arr)
+static void init_token(PreprocessorToken *tok, int type)
 {
-    free_tokens(arr->data, arr->size);
-    arr->data = NULL;
-    arr->size = arr->capacity = 0;
+    tok->type = type;
+    tok->text = NULL;
+    tok->length = 0;
+    tok->long_value = 0;
+    tok->double_value = 0.0;
+    tok->transient = false;
+    tok->param = 0;
+    tok->no_expand = false;
 }
 
-static void ensure_token_capacity(TokenArray *arr)
+static void push_token(TokenArray *arr, const PreprocessorToken *tok)
 {
     if (arr->size == arr->capacity)
     {
@@ -777,332 +844,122 @@ static void ensure_token_capacity(TokenArray *arr)
         PreprocessorToken *new_data = (PreprocessorToken *)calloc(new_cap, sizeof(PreprocessorToken));
         for (int i = 0; i < arr->size; i++)
             new_data[i] = arr->data[i];
+        free(arr->data);
         arr->data = new_data;
         arr->capacity = new_cap;
     }
+    arr->data[arr->size++] = *tok;
 }
 
-static void push_token(TokenArray *arr, PreprocessorTokenType type, const char *start,
-                       int len)
-{
-    ensure_token_capacity(arr);
-    PreprocessorToken *tok = &arr->data[arr->size++];
-    tok->type = type;
-    tok->text = (char *)calloc(len + 1, sizeof(char));
-    strncpy(tok->text, start, len);
-    tok->text[len] = '\0';
-    tok->int_value = 0;
-}
-
-static bool token_is_whitespace(const PreprocessorToken *tok)
+static void append_tokens(TokenArray *arr, const TokenArray *src)
 {
-    return tok->type == PP_TOKEN_WHITESPACE;
-}
-
-static bool token_is_ident_like(const PreprocessorToken *tok)
-{
-    return tok->type == PP_TOKEN_IDENTIFIER || tok->type == PP_TOKEN_NUMBER;
-}
-
-static bool starts_with_ident_char(const PreprocessorToken *tok)
-{
-    if (!tok->text || tok->text[0] == '\0')
-        return false;
-    return ascii_is_identchar(tok->text[0]);
-}
-
-static bool ends_with_ident_char(const PreprocessorToken *tok)
-{
-    if (!tok->text)
-        return false;
-    int len = strlen(tok->text);
-    if (len == 0)
-        return false;
-    char ch = tok->text[len - 1];
-    return ascii_is_identchar(ch);
+    for (int i = 0; i < src->size; ++i)
+        push_token(arr, &src->data[i]);
 }
 
-static TokenArray tokenize_text(const char *text)
+/* Give a freshly lexed token text of its own, so that it can be kept
+ * after the scanner buffer is reused or the source is popped.  Text is
+ * interned, except strings with NUL bytes, which are copied. */
+static void persist_token(Preprocessor *pp, PreprocessorToken *tok)
 {
-    TokenArray arr = {};
-    const char *p = text ? text : "";
-    while (*p)
+    if (!tok->transient)
+        return;
+    int nul = 0;
+    while (nul < tok->length && tok->text[nul] != '\0')
+        nul++;
+    if (tok->type == STRING_LITERAL && nul < tok->length)
     {
-        if (ascii_is_space(*p))
-        {
-            const char *start = p;
-            while (*p && ascii_is_space(*p))
-                p++;
-            push_token(&arr, PP_TOKEN_WHITESPACE, start, (int)(p - start));
-            continue;
-        }
-        if (*p == '\"')
-        {
-            const char *start = p++;
-            while (*p)
-            {
-                if (*p == '\\' && p[1])
-                {
-                    p += 2;
-                    continue;
-                }
-                if (*p == '\"')
-                {
-                    p++;
-                    break;
-                }
-                p++;
-            }
-            push_token(&arr, PP_TOKEN_STRING, start, (int)(p - start));
-            continue;
-        }
-        if (*p == '\'')
-        {
-            const char *start = p++;
-            while (*p)
-            {
-                if (*p == '\\' && p[1])
-                {
-                    p += 2;
-                    continue;
-                }
-                if (*p == '\'')
-                {
-                    p++;
-                    break;
-                }
-                p++;
-            }
-            push_token(&arr, PP_TOKEN_CHAR, start, (int)(p - start));
-            continue;
-        }
-        if (ascii_is_digit(*p))
-        {
-            const char *start = p;
-            while (*p && (ascii_is_alnum(*p) || *p == '.'))
-                p++;
-            push_token(&arr, PP_TOKEN_NUMBER, start, (int)(p - start));
-            continue;
-        }
-        if (ascii_is_identchar(*p))
-        {
-            const char *start = p;
-            while (*p && ascii_is_identchar(*p))
-                p++;
-            push_token(&arr, PP_TOKEN_IDENTIFIER, start, (int)(p - start));
-            continue;
-        }
-        push_token(&arr, PP_TOKEN_OTHER, p, 1);
-        p++;
+        char *bytes = (char *)calloc(tok->length + 1, sizeof(char));
+        memcpy(bytes, tok->text, tok->length);
+        register_retained_string(pp, bytes);
+        tok->text = bytes;
     }
-    return arr;
-}
-
-static void append_tokens(TokenArray *dest, const PreprocessorToken *src, int count)
-{
-    for (int i = 0; i < count; ++i)
+    else
     {
-        push_token(dest, (PreprocessorTokenType)src[i].type, src[i].text,
-                   strlen(src[i].text));
+        tok->text = cs_intern_span(tok->text, tok->length);
     }
+    tok->transient = false;
 }
 
-static char *tokens_to_text(const TokenArray *tokens)
+/* Macro body text with comments replaced by a space */
+static char *strip_comments(const char *text)
 {
-    char *result = NULL;
-    int len = 0;
-    int cap = 0;
-    for (int i = 0; i < tokens->size; ++i)
+    int len = strlen(text);
+    char *out = (char *)calloc(len + 1, sizeof(char));
+    int n = 0;
+    int i = 0;
+    char quote = '\0';
+    while (i < len)
     {
-        const PreprocessorToken *tok = &tokens->data[i];
-        append_string(&result, &len, &cap, tok->text);
-        if (i + 1 < tokens->size)
+        char ch = text[i];
+        if (quote != '\0')
         {
-            const PreprocessorToken *next = &tokens->data[i + 1];
-            if (!token_is_whitespace(tok) && !token_is_whitespace(next) &&
-                ends_with_ident_char(tok) && starts_with_ident_char(next))
+            out[n++] = ch;
+            if (ch == '\\' && i + 1 < len)
             {
-                append_char(&result, &len, &cap, ' ');
+                out[n++] = text[i + 1];
+                i += 2;
+                continue;
             }
-        }
-    }
-    if (!result)
-        return dup_string("");
-    return result;
-}
-
-static MacroArgument *parse_macro_arguments(Preprocessor *pp)
-{
-    MacroArgument *head = NULL;
-    MacroArgument *last = NULL;
-    int depth = 0;
-    int len = 0;
-    int cap = 0;
-    char *buf = NULL;
-    bool started = false;
-    while (1)
-    {
-        int ch = get_raw_char(pp);
-        if (ch == EOF)
-            break;
-        if (!started && ascii_is_space((unsigned char)ch))
+            if (ch == quote)
+                quote = '\0';
+            i++;
             continue;
-        started = true;
-        if (ch == '(')
-        {
-            depth++;
-            append_char(&buf, &len, &cap, (char)ch);
-            continue;
-        }
-        if (ch == ')')
-        {
-            if (depth == 0)
-            {
-                MacroArgument *arg = (MacroArgument *)calloc(1, sizeof(MacroArgument));
-                arg->text = buf ? buf : dup_string("");
-                TokenArray tokens = tokenize_text(arg->text);
-                arg->tokens = tokens.data;
-                arg->token_count = tokens.size;
-                arg->next = NULL;
-                if (head == NULL)
-                {
-                    head = arg;
-                }
-                else
-                {
-                    last->next = arg;
-                }
-                last = arg;
-                return head;
-            }
-            depth--;
         }
-        if (ch == ',' && depth == 0)
+        if (ch == '/' && text[i + 1] == '/')
+            break;
+        if (ch == '/' && text[i + 1] == '*')
         {
-            MacroArgument *arg = (MacroArgument *)calloc(1, sizeof(MacroArgument));
-            arg->text = buf ? buf : dup_string("");
-            TokenArray tokens = tokenize_text(arg->text);
-            arg->tokens = tokens.data;
-            arg->token_count = tokens.size;
-            arg->next = NULL;
-            if (head == NULL)
-            {
-                head = arg;
-            }
-            else
-            {
-                last->next = arg;
-            }
-            last = arg;
-            buf = NULL;
-            len = cap = 0;
+            i += 2;
+            while (i < len && !(text[i] == '*' && text[i + 1] == '/'))
+                i++;
+            i += 2;
+            out[n++] = ' ';
             continue;
         }
-        append_char(&buf, &len, &cap, (char)ch);
+        if (ch == '"' || ch == '\'')
+            quote = ch;
+        out[n++] = ch;
+        i++;
     }
-    return head;
+    out[n] = '\0';
+    return out;
 }
 
-static void free_macro_arguments(MacroArgument *arg)
+/* PreprocessorToken.param of name in the body of macro */
+static int macro_param(Macro *macro, char **params, const char *name)
 {
-    while (arg)
+    if (!macro->is_function)
+        return 0;
+    for (int i = 0; i < macro->param_count; ++i)
     {
-        MacroArgument *next = arg->next;
-        free(arg->text);
-        free_tokens(arg->tokens, arg->token_count);
-        free(arg);
-        arg = next;
+        if (strcmp(params[i], name) == 0)
+            return i + 1;
     }
+    if (macro->is_variadic && strcmp(name, "__VA_ARGS__") == 0)
+        return macro->param_count + 1;
+    return 0;
 }
 
-static char *substitute_macro_body(Macro *macro, MacroArgument *args, SourceFrame *frame)
+/* Lex the replacement list of macro once, at its #define */
+static void tokenize_macro_body(Preprocessor *pp, Macro *macro, char **params, const char *text)
 {
-    if (macro->builtin_file)
+    char *body = strip_comments(text);
+    TokenArray tokens = {};
+    pp->text_source = body;
+    pp->text_position = 0;
+    PreprocessorToken tok;
+    while (lex_token(pp, &tok) != EOF)
     {
-        const char *logical_path = frame->logical_path ? frame->logical_path : frame->path;
-        TokenArray tokens = {};
-        int len = strlen(logical_path) + 3;
-        char *buf = (char *)calloc(len, sizeof(char));
-        snprintf(buf, len, "\"%s\"", logical_path);
-        push_token(&tokens, PP_TOKEN_STRING, buf, strlen(buf));
-        char *text = tokens_to_text(&tokens);
-        free_token_array(&tokens);
-        return text;
-    }
-    if (macro->builtin_line)
-    {
-        char tmp[32];
-        snprintf(tmp, sizeof tmp, "%d", frame->logical_line);
-        TokenArray tokens = {};
-        push_token(&tokens, PP_TOKEN_NUMBER, tmp, strlen(tmp));
-        char *text = tokens_to_text(&tokens);
-        free_token_array(&tokens);
-        return text;
+        persist_token(pp, &tok);
+        if (tok.type == IDENTIFIER)
+            tok.param = macro_param(macro, params, tok.text);
+        push_token(&tokens, &tok);
     }
-
-    TokenArray body_tokens = tokenize_text(macro->body);
-    TokenArray result_tokens = {};
-    for (int i = 0; i < body_tokens.size; ++i)
-    {
-        PreprocessorToken *tok = &body_tokens.data[i];
-        bool replaced = false;
-        if (macro->is_function && tok->type == PP_TOKEN_IDENTIFIER)
-        {
-            /* Check for __VA_ARGS__ in variadic macro */
-            if (macro->is_variadic && strcmp(tok->text, "__VA_ARGS__") == 0)
-            {
-                /* Skip to variadic arguments (after fixed params) */
-                MacroArgument *arg = args;
-                for (int idx = 0; idx < macro->param_count && arg; ++idx)
-                    arg = arg->next;
-                /* Append all variadic arguments separated by commas */
-                bool first = true;
-                while (arg)
-                {
-                    if (!first)
-                    {
-                        push_token(&result_tokens, PP_TOKEN_OTHER, ",", 1);
-                        push_token(&result_tokens, PP_TOKEN_WHITESPACE, " ", 1);
-                    }
-                    if (arg->tokens)
-                    {
-                        append_tokens(&result_tokens, arg->tokens, arg->token_count);
-                    }
-                    first = false;
-                    arg = arg->next;
-                }
-                replaced = true;
-            }
-            else
-            {
-                for (int p = 0; p < macro->param_count; ++p)
-                {
-                    if (strcmp(macro->params[p], tok->text) == 0)
-                    {
-                        MacroArgument *arg = args;
-                        for (int idx = 0; idx < p && arg; ++idx)
-                            arg = arg->next;
-                        if (arg && arg->tokens)
-                        {
-                            append_tokens(&result_tokens, arg->tokens, arg->token_count);
-                        }
-                        replaced = true;
-                        break;
-                    }
-                }
-            }
-        }
-        if (!replaced)
-        {
-            push_token(&result_tokens, (PreprocessorTokenType)tok->type, tok->text,
-                       strlen(tok->text));
-        }
-    }
-
-    char *text = tokens_to_text(&result_tokens);
-    free_token_array(&body_tokens);
-    free_token_array(&result_tokens);
-    return text;
+    pp->text_source = NULL;
+    free(body);
+    macro->body = tokens.data;
+    macro->body_count = tokens.size;
 }
 
 static void handle_include(Preprocessor *pp, char *arg_line)
@@ -1166,6 +1023,7 @@ static void handle_define(Preprocessor *pp, char *line)
         return;
     Macro *macro = create_macro(name);
     free(name);
+    char **params = NULL;
     if (*cursor == '(')
     {
         macro->is_function = true;
@@ -1192,9 +1050,10 @@ static void handle_define(Preprocessor *pp, char *line)
                 int new_count = macro->param_count + 1;
                 char **new_params = (char **)calloc(new_count, sizeof(char *));
                 for (int i = 0; i < macro->param_count; i++)
-                    new_params[i] = macro->params[i];
-                macro->params = new_params;
-                macro->params[macro->param_count++] = param;
+                    new_params[i] = params[i];
+                free(params);
+                params = new_params;
+                params[macro->param_count++] = param;
             }
             else
             {
@@ -1211,22 +1070,19 @@ static void handle_define(Preprocessor *pp, char *line)
         if (*cursor == ')')
             cursor++;
     }
-    else
+    cursor = trim_leading(cursor);
+    /* Remove trailing newline from macro body */
+    int body_len = strlen(cursor);
+    while (body_len > 0 && (cursor[body_len - 1] == '\n' || cursor[body_len - 1] == '\r'))
     {
-        cursor = trim_leading(cursor);
+        cursor[--body_len] = '\0';
     }
-    cursor = trim_leading(cursor);
-    if (*cursor)
+    tokenize_macro_body(pp, macro, params, cursor);
+    for (int i = 0; i < macro->param_count; ++i)
     {
-        macro->body = dup_string(cursor);
-        /* Remove trailing newline from macro body */
-        int body_len = strlen(macro->body);
-        while (body_len > 0 && (macro->body[body_len - 1] == '\n' ||
-                                macro->body[body_len - 1] == '\r'))
-        {
-            macro->body[--body_len] = '\0';
-        }
+        free(params[i]);
     }
+    free(params);
     add_macro(pp, macro);
 }
 
@@ -1299,7 +1155,7 @@ static void handle_line_directive(Preprocessor *pp, char *line)
 
 static bool macro_defined(Preprocessor *pp, const char *name)
 {
-    return find_macro(pp->macros, name) != NULL;
+    return find_macro(pp, name) != NULL;
 }
 
 static void handle_ifdef(Preprocessor *pp, char *line, bool negate)
@@ -1572,12 +1428,17 @@ static int preprocess_next_char(Preprocessor *pp)
 {
     while (1)
     {
+        bool active = current_block_active(pp);
+        if (!active)
+            skip_inactive_text(pp);
         int ch = get_raw_char(pp);
         if (ch == EOF)
             return EOF;
 
-        if (!current_block_active(pp) && ch != '\n' && !(pp->at_line_start && ch == '#'))
+        if (!active && ch != '\n' && ch != '/' && !(pp->at_line_start && ch == '#'))
         {
+            if (!ascii_is_space((unsigned char)ch))
+                pp->at_line_start = false;
             continue;
         }
 
@@ -1600,6 +1461,7 @@ static int preprocess_next_char(Preprocessor *pp)
             int next = get_raw_char(pp);
             if (next == '/')
             {
+                skip_line_comment_text(pp);
                 while ((ch = get_raw_char(pp)) != EOF && ch != '\n')
                     ;
                 if (ch == '\n')
@@ -1612,8 +1474,8 @@ static int preprocess_next_char(Preprocessor *pp)
             }
             else if (next == '*')
             {
-                int prev = 0;
-                while ((ch = get_raw_char(pp)) != EOF)
+                int prev = skip_block_comment_text(pp);
+                while (prev != EOF && (ch = get_raw_char(pp)) != EOF)
                 {
                     if (prev == '*' && ch == '/')
                         break;
@@ -1637,63 +1499,239 @@ static int preprocess_next_char(Preprocessor *pp)
         {
             pp->at_line_start = false;
         }
+        if (!active)
+            continue;
         return ch;
     }
 }
 
-static int peek_nonspace(Preprocessor *pp, char *buffer, int *len)
+/* Next token in reading order: the token read ahead for a function-like
+ * macro, then the innermost open expansion, then the sources.  Returns
+ * false (with a PP_TOKEN_END token) at the end of an argument that is
+ * being pre-expanded. */
+static bool next_token(Preprocessor *pp, PreprocessorToken *tok)
 {
-    int ch;
-    *len = 0;
-    while ((ch = preprocess_next_char(pp)) != EOF)
+    if (pp->has_pushback)
     {
-        if (!ascii_is_space((unsigned char)ch))
+        *tok = pp->pushback;
+        pp->has_pushback = false;
+        pp->token_line = pp->pushback_line;
+        pp->token_path = pp->pushback_path;
+        return true;
+    }
+    MacroExpansionStack *stack = pp->expansions;
+    while (stack->size > 0)
+    {
+        MacroExpansion *exp = &stack->data[stack->size - 1];
+        if (exp->position < exp->count)
+        {
+            *tok = exp->tokens[exp->position];
+            exp->position = exp->position + 1;
+            mark_token_start(pp);
+            return true;
+        }
+        if (exp->barrier)
         {
+            init_token(tok, PP_TOKEN_END);
+            return false;
+        }
+        pop_expansion(pp);
+    }
+    lex_token(pp, tok);
+    return true;
+}
+
+typedef struct
+{
+    TokenArray *items;
+    int count;
+    int capacity;
+} MacroArguments;
+
+/* Append arg to args, which takes over its tokens */
+static void add_argument(MacroArguments *args, TokenArray *arg)
+{
+    if (args->count == args->capacity)
+    {
+        int new_cap = args->capacity == 0 ? 4 : args->capacity * 2;
+        TokenArray *new_items = (TokenArray *)calloc(new_cap, sizeof(TokenArray));
+        for (int i = 0; i < args->count; i++)
+            new_items[i] = args->items[i];
+        free(args->items);
+        args->items = new_items;
+        args->capacity = new_cap;
+    }
+    args->items[args->count++] = *arg;
+    arg->data = NULL;
+    arg->size = 0;
+    arg->capacity = 0;
+}
+
+/* Read the arguments of a function-like macro invocation up to the ')'
+ * that closes its '(' */
+static void collect_arguments(Preprocessor *pp, MacroArguments *args)
+{
+    TokenArray current = {};
+    int depth = 0;
+    PreprocessorToken tok;
+    while (next_token(pp, &tok) && tok.type != EOF)
+    {
+        if (tok.type == RP && depth == 0)
             break;
+        if (tok.type == COMMA && depth == 0)
+        {
+            add_argument(args, &current);
+            continue;
+        }
+        persist_token(pp, &tok);
+        if (tok.type == LP)
+        {
+            depth++;
         }
-        buffer[(*len)++] = (char)ch;
+        else if (tok.type == RP)
+        {
+            depth--;
+        }
+        else if (tok.type == IDENTIFIER && !tok.no_expand)
+        {
+            /* A name of a macro being expanded stays unexpanded wherever
+             * the argument ends up */
+            Macro *macro = find_macro(pp, tok.text);
+            if (macro && macro->expanding)
+                tok.no_expand = true;
+        }
+        push_token(&current, &tok);
     }
-    return ch;
+    add_argument(args, &current);
 }
 
-static bool try_expand_macro(Preprocessor *pp, const char *ident)
+static bool expand_macro(Preprocessor *pp, PreprocessorToken *tok);
+
+/* Fully macro-expand one argument on its own, as it is substituted for
+ * its parameter.  The argument's tokens are consumed. */
+static void expand_argument(Preprocessor *pp, TokenArray *arg, TokenArray *out)
+{
+    push_expansion(pp, arg->data, arg->size, NULL, true);
+    arg->data = NULL;
+    arg->size = 0;
+    PreprocessorToken tok;
+    while (next_token(pp, &tok))
+    {
+        if (tok.type == IDENTIFIER && expand_macro(pp, &tok))
+            continue;
+        push_token(out, &tok);
+    }
+    pop_expansion(pp);
+}
+
+/* Replacement list of macro with each parameter replaced by its expanded
+ * argument */
+static void substitute_macro(Preprocessor *pp, Macro *macro, MacroArguments *args,
+                             TokenArray *out)
 {
-    Macro *macro = find_macro(pp->macros, ident);
-    if (!macro || macro->expanding)
-        return false;
     SourceFrame *frame = current_frame(pp->sources);
-    if (!frame)
-        return false;
-    if (macro->is_function)
+    if (macro->builtin_file)
+    {
+        const char *logical_path = frame->logical_path ? frame->logical_path : frame->path;
+        PreprocessorToken tok;
+        init_token(&tok, STRING_LITERAL);
+        tok.text = cs_intern(logical_path);
+        tok.length = strlen(logical_path);
+        push_token(out, &tok);
+        return;
+    }
+    if (macro->builtin_line)
     {
-        char consumed_ws[16];
-        int ws_len = 0;
-        int ch = peek_nonspace(pp, consumed_ws, &ws_len);
-        if (ch != '(')
+        PreprocessorToken tok;
+        init_token(&tok, INT_LITERAL);
+        tok.long_value = frame->logical_line;
+        push_token(out, &tok);
+        return;
+    }
+
+    TokenArray *expanded = NULL;
+    if (args->count > 0)
+    {
+        expanded = (TokenArray *)calloc(args->count, sizeof(TokenArray));
+        for (int i = 0; i < args->count; ++i)
+            expand_argument(pp, &args->items[i], &expanded[i]);
+    }
+    for (int i = 0; i < macro->body_count; ++i)
+    {
+        PreprocessorToken *tok = &macro->body[i];
+        if (tok->param == 0)
         {
-            for (int i = 0; i < ws_len; ++i)
+            push_token(out, tok);
+        }
+        else if (tok->param > macro->param_count)
+        {
+            /* __VA_ARGS__: the trailing arguments, separated by commas */
+            for (int j = macro->param_count; j < args->count; ++j)
             {
-                unget_raw_char(pp, consumed_ws[ws_len - 1 - i]);
+                if (j > macro->param_count)
+                {
+                    PreprocessorToken comma;
+                    init_token(&comma, COMMA);
+                    push_token(out, &comma);
+                }
+                append_tokens(out, &expanded[j]);
             }
-            if (ch != EOF)
-                unget_raw_char(pp, ch);
-            return false;
         }
-        MacroArgument *args = parse_macro_arguments(pp);
-        char *expanded = substitute_macro_body(macro, args, frame);
-        free_macro_arguments(args);
-        if (expanded)
+        else if (tok->param <= args->count)
         {
-            push_expansion_text(pp, expanded, macro);
+            append_tokens(out, &expanded[tok->param - 1]);
         }
-        free(expanded);
     }
-    else
+    for (int i = 0; i < args->count; ++i)
+        free(expanded[i].data);
+    free(expanded);
+}
+
+/* Replace the macro named by tok (with its arguments, if function-like)
+ * by its expansion, which next_token returns before the rest of the
+ * input.  Returns false when tok is to be emitted as an identifier. */
+static bool expand_macro(Preprocessor *pp, PreprocessorToken *tok)
+{
+    if (tok->no_expand)
+        return false;
+    Macro *macro = (Macro *)name_map_get_span(pp->macro_table, tok->text, tok->length);
+    if (!macro)
+        return false;
+    if (macro->expanding)
     {
-        char *expanded = substitute_macro_body(macro, NULL, frame);
-        push_expansion_text(pp, expanded, macro);
-        free(expanded);
+        tok->no_expand = true;
+        return false;
     }
+    if (!current_frame(pp->sources))
+        return false;
+
+    MacroArguments args = {};
+    if (macro->is_function)
+    {
+        /* Reading ahead reuses the scanner buffer the name may live in */
+        persist_token(pp, tok);
+        int line = pp->token_line;
+        const char *path = pp->token_path;
+        PreprocessorToken next;
+        if (!next_token(pp, &next))
+            return false;
+        if (next.type != LP)
+        {
+            persist_token(pp, &next);
+            pp->pushback = next;
+            pp->has_pushback = true;
+            pp->pushback_line = pp->token_line;
+            pp->pushback_path = pp->token_path;
+            pp->token_line = line;
+            pp->token_path = path;
+            return false;
+        }
+        collect_arguments(pp, &args);
+    }
+    TokenArray result = {};
+    substitute_macro(pp, macro, &args, &result);
+    free(args.items);
+    push_expansion(pp, result.data, result.size, macro, false);
     return true;
 }
 
@@ -1714,6 +1752,14 @@ static void ensure_initial_source(Preprocessor *pp)
 
 static int read_char(Preprocessor *pp)
 {
+    if (pp->text_source)
+    {
+        char ch = pp->text_source[pp->text_position];
+        if (ch == '\0')
+            return EOF;
+        pp->text_position = pp->text_position + 1;
+        return ch & 0xFF;
+    }
     ensure_initial_source(pp);
     return preprocess_next_char(pp);
 }
@@ -1873,12 +1919,18 @@ static char *read_balanced_attribute(Preprocessor *pp)
 
 static void pushback_char(Preprocessor *pp, int ch)
 {
+    if (pp->text_source)
+    {
+        if (ch != EOF && pp->text_position > 0)
+            pp->text_position = pp->text_position - 1;
+        return;
+    }
     unget_raw_char(pp, ch);
 }
 
-static void error(Scanner *scanner)
+static void error(const char *text)
 {
-    fprintf(stderr, "cannot understand character: %s\n", scanner->yytext);
+    fprintf(stderr, "cannot understand character: %s\n", text);
     exit(1);
 }
 
@@ -1889,6 +1941,7 @@ Preprocessor *pp_create(Scanner *scanner)
     pp->sources = (SourceStack *)calloc(1, sizeof(SourceStack));
     init_source_stack(pp->sources);
     pp->expansions = (MacroExpansionStack *)calloc(1, sizeof(MacroExpansionStack));
+    pp->macro_table = name_map_create();
     pp->at_line_start = true;
     pp->initial_source_path = dup_string("stdin");
     pp->token_line = 1;
@@ -1905,15 +1958,9 @@ Preprocessor *pp_create(Scanner *scanner)
     add_macro(pp, line_macro);
 
     /* va_arg(ap, type) → __builtin_va_arg(ap, sizeof(type)) */
-    Macro *va_arg_macro = (Macro *)calloc(1, sizeof(Macro));
-    va_arg_macro->name = dup_string("va_arg");
-    va_arg_macro->is_function = true;
-    va_arg_macro->param_count = 2;
-    va_arg_macro->params = (char **)calloc(2, sizeof(char *));
-    va_arg_macro->params[0] = dup_string("ap");
-    va_arg_macro->params[1] = dup_string("type");
-    va_arg_macro->body = dup_string("__builtin_va_arg(ap, sizeof(type))");
-    add_macro(pp, va_arg_macro);
+    char *va_arg_definition = dup_string("va_arg(ap, type) __builtin_va_arg(ap, sizeof(type))");
+    handle_define(pp, va_arg_definition);
+    free(va_arg_definition);
 
     return pp;
 }
@@ -1924,9 +1971,10 @@ void pp_destroy(Preprocessor *pp)
         return;
     cleanup_source_stack(pp->sources);
     free_macros(pp->macros);
+    name_map_destroy(pp->macro_table);
     for (int i = 0; i < pp->expansions->size; ++i)
     {
-        free((void *)pp->expansions->data[i].text);
+        free(pp->expansions->data[i].tokens);
     }
     free(pp->expansions->data);
     for (int i = 0; i < pp->include_dir_count; ++i)
@@ -2026,18 +2074,75 @@ const PP_Dependency *pp_get_dependency(Preprocessor *pp, int index)
     return &pp->dependencies[index];
 }
 
-static int scan_token(Preprocessor *pp, YYSTYPE *yylval)
+/* Take an identifier straight from the current source buffer: c, just
+ * read, and the identifier characters after it.  Fails when c did not
+ * come from the buffer as is or a backslash (a possible line continuation)
+ * follows, leaving the character-at-a-time path to read it. */
+static bool scan_identifier_span(Preprocessor *pp, char c, PreprocessorToken *tok)
+{
+    SourceFrame *frame = current_frame(pp->sources);
+    if (pp->text_source || !frame)
+        return false;
+    ByteBuffer *buf = frame->buffer;
+    const char *data = buf->data;
+    int size = buf->size;
+    int start = buf->position - 1;
+    if (start < 0 || data[start] != c)
+        return false;
+    int pos = buf->position;
+    while (pos < size && (ascii_class_table[data[pos] & 0xFF] & ASCII_CLASS_IDENT))
+        pos++;
+    if (pos < size && data[pos] == '\\')
+        return false;
+    buf->position = pos;
+    tok->text = data + start;
+    tok->length = pos - start;
+    tok->transient = true;
+    return true;
+}
+
+/* Take the contents of a string literal, whose opening quote was just
+ * read, straight from the current source buffer.  Fails (reading nothing)
+ * when it has escapes or is not closed on its line. */
+static bool scan_string_span(Preprocessor *pp, PreprocessorToken *tok)
+{
+    SourceFrame *frame = current_frame(pp->sources);
+    if (pp->text_source || !frame)
+        return false;
+    ByteBuffer *buf = frame->buffer;
+    const char *data = buf->data;
+    int size = buf->size;
+    int start = buf->position;
+    if (start == 0 || data[start - 1] != '"')
+        return false;
+    int pos = start;
+    while (pos < size && data[pos] != '"' && data[pos] != '\\' && data[pos] != '\n')
+        pos++;
+    if (pos == size || data[pos] != '"')
+        return false;
+    buf->position = pos + 1;
+    tok->text = data + start;
+    tok->length = pos - start;
+    tok->transient = true;
+    return true;
+}
+
+/* Lex one token from the sources (or from pp->text_source) into tok.
+ * Identifier and string text is left in the source or scanner buffer. */
+static int scan_token(Preprocessor *pp, PreprocessorToken *tok)
 {
     Scanner *scanner = pp->scanner;
     char c;
-    resetText(scanner);
 
 retry:
+    if (!pp->text_source)
+        skip_blank_text(pp);
     c = read_char(pp);
     if (c == ' ' || c == '\t' || c == '\n')
     {
         goto retry;
     }
+    resetText(scanner);
     mark_token_start(pp);
     switch (c)
     {
@@ -2102,12 +2207,12 @@ retry:
 
                 if (is_long)
                 {
-                    yylval->lv = (long)l_value;
+                    tok->long_value = (long)l_value;
                     return is_unsigned ? ULONG_LITERAL : LONG_LITERAL;
                 }
                 else
                 {
-                    yylval->iv = (int)l_value;
+                    tok->long_value = (int)l_value;
                     return is_unsigned ? UINT_LITERAL : INT_LITERAL;
                 }
             }
@@ -2137,20 +2242,20 @@ retry:
                 {
                     float f_value;
                     sscanf(scanner->yytext, "%f", &f_value);
-                    yylval->fv = f_value;
+                    tok->double_value = f_value;
                     return FLOAT_LITERAL;
                 }
                 if (c == 'd' || c == 'D')
                 {
                     double d_value;
                     sscanf(scanner->yytext, "%lf", &d_value);
-                    yylval->dv = d_value;
+                    tok->double_value = d_value;
                     return DOUBLE_LITERAL;
                 }
                 pushback_char(pp, c);
                 double d_value;
                 sscanf(scanner->yytext, "%lf", &d_value);
-                yylval->dv = d_value;
+                tok->double_value = d_value;
                 return DOUBLE_LITERAL;
             }
             else
@@ -2188,7 +2293,7 @@ retry:
 
             if (is_long)
             {
-                yylval->lv = l_value;
+                tok->long_value = l_value;
                 return is_unsigned ? ULONG_LITERAL : LONG_LITERAL;
             }
             else if (is_unsigned)
@@ -2196,13 +2301,13 @@ retry:
                 /* Unsigned int: 0 to 4294967295 */
                 if (l_value >= 0 && l_value <= 4294967295L)
                 {
-                    yylval->iv = (int)l_value;
+                    tok->long_value = (int)l_value;
                     return UINT_LITERAL;
                 }
                 else
                 {
                     /* Promote to unsigned long */
-                    yylval->lv = l_value;
+                    tok->long_value = l_value;
                     return ULONG_LITERAL;
                 }
             }
@@ -2212,13 +2317,13 @@ retry:
                 /* Note: We only see positive values here (minus is parsed separately) */
                 if (l_value <= 2147483647L)
                 {
-                    yylval->iv = (int)l_value;
+                    tok->long_value = (int)l_value;
                     return INT_LITERAL;
                 }
                 else
                 {
                     /* Promote to long (e.g., 2147483648 for -2147483648) */
-                    yylval->lv = l_value;
+                    tok->long_value = l_value;
                     return LONG_LITERAL;
                 }
             }
@@ -2259,9 +2364,9 @@ retry:
         if (c == '[')
         {
             char *attr_text = read_balanced_attribute(pp);
-            if (yylval)
+            if (attr_text)
             {
-                yylval->name = attr_text ? cs_create_identifier(attr_text) : NULL;
+                tok->text = cs_intern(attr_text);
             }
             free(attr_text);
             return ATTRIBUTE;
@@ -2528,11 +2633,13 @@ retry:
             fprintf(stderr, "unterminated character literal\\n");
             exit(1);
         }
-        yylval->iv = value;
+        tok->long_value = value;
         return INT_LITERAL;
     }
     case '"':
     {
+        if (scan_string_span(pp, tok))
+            return STRING_LITERAL;
         while (1)
         {
             c = read_char(pp);
@@ -2603,9 +2710,9 @@ retry:
             }
             if (c == '"')
             {
-                yylval->str.len = scanner->ytp;
-                yylval->str.data = (uint8_t *)calloc(scanner->ytp, sizeof(uint8_t));
-                memcpy(yylval->str.data, scanner->yytext, scanner->ytp);
+                tok->text = scanner->yytext;
+                tok->length = scanner->ytp;
+                tok->transient = true;
                 return STRING_LITERAL;
             }
             addText(scanner, c);
@@ -2620,45 +2727,111 @@ retry:
         if (!ascii_is_identchar(c))
         {
             addText(scanner, c);
-            error(scanner);
+            tok->text = scanner->yytext;
+            tok->length = scanner->ytp;
+            tok->transient = true;
+            return PP_TOKEN_INVALID;
         }
         break;
     }
     }
 
-    while (ascii_is_identchar(c))
+    if (scan_identifier_span(pp, c, tok))
+        return IDENTIFIER;
+
+    while (ascii_class_table[c & 0xFF] & ASCII_CLASS_IDENT)
     {
         addText(scanner, c);
         c = read_char(pp);
     }
     pushback_char(pp, c);
+    tok->text = scanner->yytext;
+    tok->length = scanner->ytp;
+    tok->transient = true;
+    return IDENTIFIER;
+}
 
-    if (try_expand_macro(pp, scanner->yytext))
-    {
-        resetText(scanner);
-        goto retry;
-    }
+static int lex_token(Preprocessor *pp, PreprocessorToken *tok)
+{
+    init_token(tok, 0);
+    tok->type = scan_token(pp, tok);
+    return tok->type;
+}
 
-    struct OPE *op = in_word_set(scanner->yytext, strlen(scanner->yytext));
-    if (op != NULL)
+/* Hand tok to the parser */
+static int emit_token(Preprocessor *pp, PreprocessorToken *tok, YYSTYPE *yylval)
+{
+    pp->current_text = NULL;
+    switch (tok->type)
     {
-        return op->type;
-    }
-
-    yylval->name = cs_create_identifier(scanner->yytext);
+    case IDENTIFIER:
+    {
+        struct OPE *op = in_word_set((char *)tok->text, tok->length);
+        if (op != NULL)
+        {
+            pp->current_text = op->name;
+            return op->type;
+        }
+        /* Only names the parser keeps are interned */
+        persist_token(pp, tok);
+        pp->current_text = tok->text;
+        yylval->name = (char *)tok->text;
 
-    /* All identifiers are now IDENTIFIER - type resolution is done in parser/semantic phase
-     * using side-effect-only expression statements to disambiguate declarations */
-    return IDENTIFIER;
+        /* All identifiers are now IDENTIFIER - type resolution is done in parser/semantic phase
+         * using side-effect-only expression statements to disambiguate declarations */
+        return IDENTIFIER;
+    }
+    case PP_TOKEN_INVALID:
+        persist_token(pp, tok);
+        error(tok->text);
+        break;
+    case INT_LITERAL:
+    case UINT_LITERAL:
+        yylval->iv = (int)tok->long_value;
+        break;
+    case LONG_LITERAL:
+    case ULONG_LITERAL:
+        yylval->lv = tok->long_value;
+        break;
+    case FLOAT_LITERAL:
+        yylval->fv = (float)tok->double_value;
+        break;
+    case DOUBLE_LITERAL:
+        yylval->dv = tok->double_value;
+        break;
+    case STRING_LITERAL:
+        yylval->str.len = tok->length;
+        yylval->str.data = (uint8_t *)calloc(tok->length, sizeof(uint8_t));
+        memcpy(yylval->str.data, tok->text, tok->length);
+        break;
+    case ATTRIBUTE:
+        if (yylval)
+        {
+            yylval->name = tok->text ? cs_create_identifier(tok->text) : NULL;
+        }
+        break;
+    default:
+        break;
+    }
+    return tok->type;
 }
 
 int pp_next_token(Preprocessor *pp, YYSTYPE *yylval)
 {
-    return scan_token(pp, yylval);
+    PreprocessorToken tok;
+    while (1)
+    {
+        next_token(pp, &tok);
+        if (tok.type == IDENTIFIER && expand_macro(pp, &tok))
+            continue;
+        return emit_token(pp, &tok, yylval);
+    }
 }
 
 const char *pp_current_text(Preprocessor *pp)
 {
+    if (pp && pp->current_text)
+        return pp->current_text;
     return pp && pp->scanner ? pp->scanner->yytext : NULL;
 }
 
@@ -3,18 +3,26 @@
 #include <stddef.h>
 
 #include "ast.h"
+#include "name_map.h"
 #include "parser.h"
 
 /* Forward declarations for self-referential types */
 typedef struct Macro Macro;
-typedef struct MacroArgument MacroArgument;
 typedef struct ConditionalFrame ConditionalFrame;
 
+/* PreprocessorToken - One token, already classified as a parser token.
+ * Macro bodies and arguments are kept as arrays of these, so expanding a
+ * macro copies tokens instead of re-scanning text. */
 typedef struct
 {
-    int type;
-    char *text;
-    int int_value;
+    int type;            /* Parser token (IDENTIFIER, INT_LITERAL, LP, ...) */
+    const char *text;    /* IDENTIFIER, STRING_LITERAL: length bytes; ATTRIBUTE: interned */
+    int length;
+    bool transient;      /* text points into a source or scanner buffer (see persist_token) */
+    long long_value;     /* Integer literals */
+    double double_value; /* FLOAT_LITERAL/DOUBLE_LITERAL */
+    int param;           /* Macro body: parameter index + 1 (0 = not a parameter) */
+    bool no_expand;      /* Names a macro that was being expanded; never expand it */
 } PreprocessorToken;
 
 /* Dependency entry: source file to compile (moved here before Preprocessor struct) */
@@ -53,12 +61,15 @@ typedef struct
     int capacity;
 } SourceStack;
 
-/* MacroExpansion - State for expanding a single macro */
+/* MacroExpansion - Tokens produced by one macro expansion, read before
+ * anything that follows the invocation */
 typedef struct
 {
-    const char *text;
+    PreprocessorToken *tokens;
+    int count;
     int position;
-    Macro *macro;
+    Macro *macro;  /* Expanding while this frame is open (NULL for an argument) */
+    bool barrier;  /* Argument being pre-expanded: reading stops at its end */
 } MacroExpansion;
 
 /* MacroExpansionStack - Stack of macro expansions */
@@ -69,28 +80,19 @@ typedef struct
     int capacity;
 } MacroExpansionStack;
 
-/* MacroArgument - Argument for function-like macro */
-struct MacroArgument
-{
-    char *text;
-    PreprocessorToken *tokens;
-    int token_count;
-    MacroArgument *next;
-};
-
 /* Macro - Preprocessor macro definition */
 struct Macro
 {
     char *name;
     bool is_function;
     bool is_variadic;
-    int param_count;
-    char **params;
-    char *body;
+    int param_count; /* Named parameters; __VA_ARGS__ is param_count + 1 */
+    PreprocessorToken *body;
+    int body_count;
     bool expanding;
     bool builtin_file;
     bool builtin_line;
-    Macro *next;
+    Macro *next; /* Every macro ever defined, for pp_destroy */
 };
 
 /* ConditionalFrame - State for #if/#ifdef/#else/#endif */
@@ -107,8 +109,17 @@ typedef struct Preprocessor
 {
     SourceStack *sources;
     Scanner *scanner;
-    Macro *macros;
+    Macro *macros;       /* Owns all macros, including undefined/redefined ones */
+    NameMap *macro_table; /* Name -> current definition (NULL once #undef'd) */
     MacroExpansionStack *expansions;
+    /* Token read ahead while looking for a function-like macro's '(' */
+    PreprocessorToken pushback;
+    bool has_pushback;
+    int pushback_line;
+    const char *pushback_path;
+    /* Text being tokenized instead of the sources (macro bodies) */
+    const char *text_source;
+    int text_position;
     ConditionalFrame *conditionals;
     bool at_line_start;
     char **include_dirs;
@@ -118,6 +129,7 @@ typedef struct Preprocessor
     ByteBuffer *initial_buffer;
     const char *token_path;
     int token_line;
+    const char *current_text; /* Last identifier or keyword returned (NULL: scanner yytext) */
     char **retained_strings;
     int retained_string_count;
     int retained_string_capacity;
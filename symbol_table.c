@@ -0,0 +1,158 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "symbol_table.h"
+
+enum
+{
+    SYMBOL_TABLE_INITIAL_NAMES = 64,
+    SYMBOL_TABLE_INITIAL_BINDINGS = 64,
+    SYMBOL_TABLE_INITIAL_SCOPES = 16
+};
+
+static void grow_names(SymbolTable *table)
+{
+    int capacity = table->name_capacity * 2;
+    int *top = (int *)calloc(capacity, sizeof(int));
+    for (int i = 0; i < table->name_count; ++i)
+    {
+        top[i] = table->name_top[i];
+    }
+    free(table->name_top);
+    table->name_top = top;
+    table->name_capacity = capacity;
+}
+
+static void grow_bindings(SymbolTable *table)
+{
+    int capacity = table->binding_capacity * 2;
+    Declaration **decls = (Declaration **)calloc(capacity, sizeof(Declaration *));
+    int *binding_name = (int *)calloc(capacity, sizeof(int));
+    int *binding_shadowed = (int *)calloc(capacity, sizeof(int));
+    for (int i = 1; i < table->binding_count; ++i)
+    {
+        decls[i] = table->decls[i];
+        binding_name[i] = table->binding_name[i];
+        binding_shadowed[i] = table->binding_shadowed[i];
+    }
+    free(table->decls);
+    free(table->binding_name);
+    free(table->binding_shadowed);
+    table->decls = decls;
+    table->binding_name = binding_name;
+    table->binding_shadowed = binding_shadowed;
+    table->binding_capacity = capacity;
+}
+
+SymbolTable *symbol_table_create()
+{
+    SymbolTable *table = (SymbolTable *)calloc(1, sizeof(SymbolTable));
+
+    table->name_capacity = SYMBOL_TABLE_INITIAL_NAMES;
+    table->name_index = name_map_create();
+    table->name_top = (int *)calloc(table->name_capacity, sizeof(int));
+    table->name_count = 0;
+
+    table->binding_capacity = SYMBOL_TABLE_INITIAL_BINDINGS;
+    table->decls = (Declaration **)calloc(table->binding_capacity, sizeof(Declaration *));
+    table->binding_name = (int *)calloc(table->binding_capacity, sizeof(int));
+    table->binding_shadowed = (int *)calloc(table->binding_capacity, sizeof(int));
+    table->binding_count = 1;
+
+    table->scope_capacity = SYMBOL_TABLE_INITIAL_SCOPES;
+    table->scope_marks = (int *)calloc(table->scope_capacity, sizeof(int));
+    table->depth = 0;
+    return table;
+}
+
+/* Index of name, adding it when create is set; -1 if absent */
+static int find_name(SymbolTable *table, const char *name, bool create)
+{
+    int idx = name_map_rank(table->name_index, name);
+    if (idx >= 0 || !create)
+    {
+        return idx;
+    }
+
+    if (table->name_count == table->name_capacity)
+    {
+        grow_names(table);
+    }
+    idx = table->name_count;
+    table->name_count = table->name_count + 1;
+    table->name_top[idx] = 0;
+    name_map_offer(table->name_index, name, (void *)name, idx, false);
+    return idx;
+}
+
+void symbol_table_push_scope(SymbolTable *table)
+{
+    if (table->depth == table->scope_capacity)
+    {
+        int capacity = table->scope_capacity * 2;
+        int *marks = (int *)calloc(capacity, sizeof(int));
+        for (int i = 0; i < table->depth; ++i)
+        {
+            marks[i] = table->scope_marks[i];
+        }
+        free(table->scope_marks);
+        table->scope_marks = marks;
+        table->scope_capacity = capacity;
+    }
+    table->scope_marks[table->depth] = table->binding_count;
+    table->depth = table->depth + 1;
+}
+
+void symbol_table_pop_scope(SymbolTable *table)
+{
+    if (table->depth == 0)
+    {
+        return;
+    }
+    table->depth = table->depth - 1;
+    int mark = table->scope_marks[table->depth];
+    while (table->binding_count > mark)
+    {
+        int b = table->binding_count - 1;
+        table->name_top[table->binding_name[b]] = table->binding_shadowed[b];
+        table->binding_count = b;
+    }
+}
+
+int symbol_table_depth(SymbolTable *table)
+{
+    return table->depth;
+}
+
+void symbol_table_add(SymbolTable *table, Declaration *decl)
+{
+    if (table->depth == 0 || !decl->name)
+    {
+        return;
+    }
+    int name = find_name(table, decl->name, true);
+    if (table->binding_count == table->binding_capacity)
+    {
+        grow_bindings(table);
+    }
+    int b = table->binding_count;
+    table->binding_count = table->binding_count + 1;
+    table->decls[b] = decl;
+    table->binding_name[b] = name;
+    table->binding_shadowed[b] = table->name_top[name];
+    table->name_top[name] = b;
+}
+
+Declaration *symbol_table_lookup(SymbolTable *table, const char *name)
+{
+    if (!name)
+    {
+        return NULL;
+    }
+    int idx = find_name(table, name, false);
+    if (idx < 0 || table->name_top[idx] == 0)
+    {
+        return NULL;
+    }
+    return table->decls[table->name_top[idx]];
+}
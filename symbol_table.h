@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+ * symbol_table.h - Block-scoped declarations for semantic analysis
+ *
+ * Every name maps to its innermost visible binding; each binding records
+ * the binding of the same name it shadows.  Bindings are kept in
+ * declaration order, and a scope is a mark in that order, so leaving a
+ * scope unwinds only the bindings made inside it.  Lookup is one hash
+ * probe and leaving a scope costs one step per binding it made.
+ */
+
+#include "ast.h"
+#include "name_map.h"
+
+typedef struct SymbolTable_tag
+{
+    /* Distinct names; the rank of each entry is the name's index */
+    NameMap *name_index;
+    int *name_top; /* Innermost binding of each name (0 = not visible) */
+    int name_count;
+    int name_capacity;
+
+    /* Bindings in declaration order; index 0 is unused */
+    Declaration **decls;
+    int *binding_name;     /* Name index of the binding */
+    int *binding_shadowed; /* Binding of the same name it hides (0 = none) */
+    int binding_count;
+    int binding_capacity;
+
+    /* binding_count when each open scope was entered */
+    int *scope_marks;
+    int depth;
+    int scope_capacity;
+} SymbolTable;
+
+SymbolTable *symbol_table_create();
+
+void symbol_table_push_scope(SymbolTable *table);
+void symbol_table_pop_scope(SymbolTable *table);
+
+/* Number of open scopes (0 = file scope) */
+int symbol_table_depth(SymbolTable *table);
+
+/* Bind decl in the innermost scope; ignored when no scope is open */
+void symbol_table_add(SymbolTable *table, Declaration *decl);
+
+/* Innermost visible declaration of name, or NULL */
+Declaration *symbol_table_lookup(SymbolTable *table, const char *name);
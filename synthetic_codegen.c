@@ -13,7 +13,11 @@
 #include "classfile.h"
 #include "classfile_opcode.h"
 
+#ifdef __GNUC__
+__thread PtrUsage *g_ptr_usage;
+#else
 PtrUsage *g_ptr_usage;
+#endif
 
 /* Pointer type definitions - initialized in init_ptr_types() */
 static PtrTypeInfo *PTR_TYPES = NULL;
@@ -116,6 +120,8 @@ static void init_ptr_types()
 
 void ptr_usage_init(PtrUsage *usage)
 {
+    init_ptr_types();
+
     /* Allocate the array if not already allocated */
     if (usage->used == NULL)
     {
@@ -139,6 +145,19 @@ void ptr_usage_mark(PtrTypeIndex type)
     g_ptr_usage->used[type] = true;
 }
 
+void ptr_usage_merge(PtrUsage *into, const PtrUsage *from)
+{
+    if (!from->used)
+        return;
+    for (int i = 0; i < PTR_TYPE_COUNT; i++)
+    {
+        if (from->used[i])
+        {
+            into->used[i] = true;
+        }
+    }
+}
+
 bool ptr_usage_any(const PtrUsage *usage)
 {
     for (int i = 0; i < PTR_TYPE_COUNT; i++)
@@ -44,11 +44,20 @@ typedef struct PtrUsage_tag
     bool *used;
 } PtrUsage;
 
+/* Usage marked by the code generator.  In the native build every thread
+ * has its own, so parallel class generation merges them afterwards. */
+#ifdef __GNUC__
+extern __thread PtrUsage *g_ptr_usage;
+#else
 extern PtrUsage *g_ptr_usage;
+#endif
 
-/* Initialize usage tracking */
+/* Initialize usage tracking (and the pointer type table it refers to) */
 void ptr_usage_init(PtrUsage *usage);
 
+/* Mark in into every pointer type marked in from */
+void ptr_usage_merge(PtrUsage *into, const PtrUsage *from);
+
 /* Mark a pointer type as used (safe, auto-initializes if needed) */
 void ptr_usage_mark(PtrTypeIndex type);
 
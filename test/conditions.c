@@ -0,0 +1,223 @@
+#include <stdio.h>
+
+/*
+ * Differential test for conditions compiled as jumping code: every line
+ * printed must match the output of the same program built with gcc.
+ *
+ *   gcc -o conditions_gcc test/conditions.c && ./conditions_gcc > expected.txt
+ *   ./codegen test/conditions.c && java conditions > actual.txt
+ *   diff expected.txt actual.txt
+ *
+ * Each comparison is used as a branch, negated with !, inside && / || and
+ * as a 0/1 value, so the branch polarity and the NaN variant of the float
+ * compares are checked against the value the comparison should have.
+ */
+
+enum Color
+{
+    RED,
+    GREEN,
+    BLUE
+};
+
+/* One bit per way of using each of the six comparisons */
+#define DEFINE_COMPARE(name, T)                          \
+    int name(T a, T b)                                   \
+    {                                                    \
+        int bits = 0;                                    \
+        if (a < b)                                       \
+            bits = bits | 1;                             \
+        if (a <= b)                                      \
+            bits = bits | 2;                             \
+        if (a > b)                                       \
+            bits = bits | 4;                             \
+        if (a >= b)                                      \
+            bits = bits | 8;                             \
+        if (a == b)                                      \
+            bits = bits | 16;                            \
+        if (a != b)                                      \
+            bits = bits | 32;                            \
+        if (!(a < b))                                    \
+            bits = bits | 64;                            \
+        if (!(a <= b))                                   \
+            bits = bits | 128;                           \
+        if (!(a > b))                                    \
+            bits = bits | 256;                           \
+        if (!(a >= b))                                   \
+            bits = bits | 512;                           \
+        if (!(a == b))                                   \
+            bits = bits | 1024;                          \
+        if (!(a != b))                                   \
+            bits = bits | 2048;                          \
+        int less = (int)(a < b);                         \
+        int not_less = (int)(a >= b);                    \
+        bits = bits | (less << 12) | (not_less << 13);   \
+        bits = bits | ((a > b ? 1 : 0) << 14);           \
+        bits = bits | ((!(a <= b) ? 1 : 0) << 15);       \
+        return bits;                                     \
+    }
+
+DEFINE_COMPARE(compare_int, int)
+DEFINE_COMPARE(compare_char, char)
+DEFINE_COMPARE(compare_unsigned, unsigned int)
+DEFINE_COMPARE(compare_long, long)
+DEFINE_COMPARE(compare_unsigned_long, unsigned long)
+DEFINE_COMPARE(compare_float, float)
+DEFINE_COMPARE(compare_double, double)
+DEFINE_COMPARE(compare_color, enum Color)
+
+void report(const char *name, int bits)
+{
+    printf("%s %d\n", name, bits);
+}
+
+int logic(int a, int b, int c)
+{
+    int bits = 0;
+    if (a && b)
+        bits = bits | 1;
+    if (a || b)
+        bits = bits | 2;
+    if (!a && (b || c))
+        bits = bits | 4;
+    if ((a && !b) || (!a && c))
+        bits = bits | 8;
+    if (!(a || b) || (b && c))
+        bits = bits | 16;
+    if (!(!a || !(b && !c)))
+        bits = bits | 32;
+    int either = (int)(a && b || c);
+    int both = (int)(a || b && c);
+    bits = bits | (either << 6) | (both << 7);
+    bits = bits | ((a < b && b < c ? 1 : 0) << 8);
+    return bits;
+}
+
+int loops(int n)
+{
+    int sum = 0;
+    int i = 0;
+    while (i < n && sum < 1000)
+    {
+        sum = sum + i;
+        i = i + 1;
+    }
+    for (int j = n; !(j <= 0); j = j - 2)
+    {
+        sum = sum + j;
+    }
+    do
+    {
+        sum = sum + 1;
+    } while (sum % 7 != 0 || sum < 50);
+    return sum;
+}
+
+int pointers(int *p, int *q, char *s)
+{
+    int bits = 0;
+    if (p == NULL)
+        bits = bits | 1;
+    if (p != NULL)
+        bits = bits | 2;
+    if (!p)
+        bits = bits | 4;
+    if (p && q)
+        bits = bits | 8;
+    if (p && q && p < q)
+        bits = bits | 16;
+    if (p && q && p >= q)
+        bits = bits | 32;
+    if (p && q && p == q)
+        bits = bits | 64;
+    if (s)
+        bits = bits | 128;
+    return bits;
+}
+
+/* Local pointers that walk an array are scalar-replaced */
+int walk(int *values, int count)
+{
+    int *end = values + count;
+    int *p = values;
+    int found = 0;
+    while (p < end)
+    {
+        if (*p > 2 && p != values)
+            found = found + 1;
+        p = p + 1;
+    }
+    int *q = end - 1;
+    while (q >= values && !(*q == 3))
+    {
+        q = q - 1;
+    }
+    return found * 100 + (int)(q - values);
+}
+
+int main()
+{
+    int ints[] = {-2, -1, 0, 1, 2147483647, -2147483647 - 1};
+    for (int i = 0; i < 6; i++)
+    {
+        for (int j = 0; j < 6; j++)
+        {
+            report("int", compare_int(ints[i], ints[j]));
+            report("unsigned", compare_unsigned((unsigned int)ints[i], (unsigned int)ints[j]));
+            report("long", compare_long((long)ints[i] * 3, (long)ints[j] * 5));
+            report("unsigned long", compare_unsigned_long((unsigned long)ints[i], (unsigned long)ints[j]));
+        }
+    }
+
+    char chars[] = {'a', 'z', 0, -1};
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            report("char", compare_char(chars[i], chars[j]));
+        }
+    }
+
+    double zero = 0.0;
+    double doubles[] = {-1.5, 0.0, 2.25, 1.0 / zero, -1.0 / zero, zero / zero};
+    for (int i = 0; i < 6; i++)
+    {
+        for (int j = 0; j < 6; j++)
+        {
+            report("double", compare_double(doubles[i], doubles[j]));
+            report("float", compare_float((float)doubles[i], (float)doubles[j]));
+        }
+    }
+
+    report("color", compare_color(RED, BLUE));
+    report("color", compare_color(GREEN, GREEN));
+    report("color", compare_color(BLUE, RED));
+
+    for (int a = 0; a < 2; a++)
+    {
+        for (int b = 0; b < 2; b++)
+        {
+            for (int c = 0; c < 2; c++)
+            {
+                report("logic", logic(a, b, c));
+            }
+        }
+    }
+    report("logic", logic(1, 2, 3));
+    report("logic", logic(3, 2, 1));
+
+    report("loops", loops(0));
+    report("loops", loops(5));
+    report("loops", loops(100));
+
+    int values[] = {1, 3, 5, 2, 3, 0};
+    int *v = values;
+    report("pointers", pointers(NULL, NULL, NULL));
+    report("pointers", pointers(values, NULL, "x"));
+    report("pointers", pointers(values, v + 2, NULL));
+    report("pointers", pointers(v + 4, v + 1, "y"));
+    report("pointers", pointers(v + 3, v + 3, "z"));
+    report("walk", walk(values, 6));
+    report("walk", walk(values, 1));
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+
+/*
+ * Differential test for pointer locals kept as (base, offset) local pairs:
+ * every line printed must match the output of the same program built with
+ * gcc.
+ *
+ *   gcc -o pointer_locals_gcc test/pointer_locals.c && ./pointer_locals_gcc > expected.txt
+ *   ./codegen test/pointer_locals.c && java pointer_locals > actual.txt
+ *   diff expected.txt actual.txt
+ *
+ * Pointer parameters and locals are walked with ++, --, += and -=, read and
+ * written through *p, p[i] and *(p + n), compared, subtracted and tested
+ * against NULL.  Some of them also escape into calls, returns and a global,
+ * which needs a wrapper for the current (base, offset) pair.
+ */
+
+int *saved;
+
+void report(const char *name, int value)
+{
+    printf("%s %d\n", name, value);
+}
+
+int peek(int *p)
+{
+    return *p;
+}
+
+/* Parameter walked to the end of the array */
+int sum(int *p, int count)
+{
+    int total = 0;
+    int *end = p + count;
+    while (p < end)
+    {
+        total = total + *p;
+        p++;
+    }
+    return total;
+}
+
+/* Both parameters advance; the result is a pointer difference */
+int copy_string(char *dst, const char *src)
+{
+    char *start = dst;
+    while (*src)
+    {
+        *dst++ = *src++;
+    }
+    *dst = 0;
+    return (int)(dst - start);
+}
+
+/* The found pointer escapes through the return value */
+int *find(int *begin, int *end, int key)
+{
+    for (int *p = begin; p != end; ++p)
+    {
+        if (*p == key)
+            return p;
+    }
+    return NULL;
+}
+
+/* Indexing, offsets and stepping back */
+long indexed(long *values, int count)
+{
+    long *p = values;
+    long result = p[0] + p[count - 1];
+    p += 2;
+    result = result * 10 + *(p + 1);
+    p -= 1;
+    result = result * 10 + *p;
+    --p;
+    result = result * 10 + p[3];
+    p[1] = p[1] + 100;
+    return result + values[1];
+}
+
+/* Escapes inside the loop: a call and a store to a global */
+int escapes(int *values, int count)
+{
+    int *p = values;
+    int *last = values + count - 1;
+    int total = 0;
+    while (p <= last)
+    {
+        total = total * 3 + peek(p);
+        if (*p > 4)
+            saved = p;
+        p = p + 1;
+    }
+    return total + (int)(saved - values);
+}
+
+/* Relational and equality tests between two walking pointers */
+int compares(double *lo, double *hi)
+{
+    int bits = 0;
+    int step = 0;
+    while (lo < hi)
+    {
+        if (*lo < *hi)
+            bits = bits | (1 << step);
+        lo++;
+        hi--;
+        step = step + 1;
+    }
+    if (lo == hi)
+        bits = bits | 256;
+    if (lo > hi)
+        bits = bits | 512;
+    return bits + (int)(hi - lo) * 1000;
+}
+
+/* Null tests as conditions, operands of && and ?: and values */
+int null_tests(int *p, int *q)
+{
+    int bits = 0;
+    if (!p)
+        bits = bits | 1;
+    if (p && *p > 0)
+        bits = bits | 2;
+    if (q == NULL || *q == 0)
+        bits = bits | 4;
+    bits = bits | ((p ? *p : -1) == 7 ? 8 : 0);
+    int present = (int)(q != NULL);
+    bits = bits | (present << 4);
+    while (q && *q > 0)
+    {
+        bits = bits + 32;
+        q++;
+    }
+    return bits;
+}
+
+/* A local that starts NULL and is assigned from other pointers */
+int reassign(int *values, int count)
+{
+    int *best = NULL;
+    int *p = values;
+    while (p < values + count)
+    {
+        if (!best || *p > *best)
+            best = p;
+        p += 1;
+    }
+    if (best)
+        return (int)(best - values) * 100 + *best;
+    return -1;
+}
+
+int main()
+{
+    int values[] = {3, 1, 4, 1, 5, 9, 2, 6, 0};
+    int *v = values;
+    report("sum", sum(values, 8));
+    report("sum", sum(v + 3, 4));
+    report("sum", sum(values, 0));
+
+    char buffer[32];
+    report("copy", copy_string(buffer, "pointer"));
+    printf("copied %s\n", buffer);
+    report("copy", copy_string(buffer, ""));
+
+    int *found = find(values, v + 8, 5);
+    report("find", found ? (int)(found - v) : -1);
+    found = find(values, v + 8, 7);
+    report("find", found ? (int)(found - v) : -1);
+
+    long longs[] = {10L, 20L, 30L, 40L, 50L};
+    printf("indexed %ld %ld\n", indexed(longs, 5), longs[1]);
+
+    report("escapes", escapes(values, 8));
+    report("saved", *saved);
+
+    double doubles[] = {1.5, -2.0, 3.25, 0.0, 9.0, 4.5, -1.0};
+    double *d = doubles;
+    report("compares", compares(doubles, d + 6));
+    report("compares", compares(doubles, d + 5));
+    report("compares", compares(d + 3, d + 3));
+
+    int seven[] = {7, 0};
+    int *s = seven;
+    report("null", null_tests(NULL, NULL));
+    report("null", null_tests(seven, values));
+    report("null", null_tests(s + 1, s + 1));
+
+    report("reassign", reassign(values, 8));
+    report("reassign", reassign(values, 0));
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include "util.h"
 #include "header_store.h"
 #include "header_index.h"
+#include "embedded_data.h"
 
 bool cs_read_file_bytes(const char *path, unsigned char **out_data, int *out_size)
 {
@@ -54,17 +55,25 @@ bool cs_read_file_bytes(const char *path, unsigned char **out_data, int *out_siz
     return true;
 }
 
-static Declaration *search_decls_from_list(DeclarationList *list,
-                                           const char *name)
+/* Bring compiler->decl_map up to date with compiler->decl_list.  The list
+ * only grows at its tail, so only nodes after decl_map_last are added; a
+ * different list (codegen swaps in the aggregated one) starts a new map.
+ * The first declaration of a name wins, as in a front-to-back search. */
+static void sync_decl_map(CS_Compiler *compiler)
 {
+    if (!compiler->decl_map || compiler->decl_map_list != compiler->decl_list)
+    {
+        compiler->decl_map = name_map_create();
+        compiler->decl_map_list = compiler->decl_list;
+        compiler->decl_map_last = NULL;
+    }
+    DeclarationList *list = compiler->decl_map_last ? compiler->decl_map_last->next
+                                                    : compiler->decl_list;
     for (; list; list = list->next)
     {
-        if (!strcmp(list->decl->name, name))
-        {
-            return list->decl;
-        }
+        name_map_offer(compiler->decl_map, list->decl->name, list->decl, 0, false);
+        compiler->decl_map_last = list;
     }
-    return NULL;
 }
 // search from a block temporary
 Declaration *cs_search_decl_in_block() { return NULL; }
@@ -75,7 +84,8 @@ Declaration *cs_search_decl_global(CS_Compiler *compiler, const char *name)
         return NULL;
 
     /* First search in current TU's declarations */
-    Declaration *decl = search_decls_from_list(compiler->decl_list, name);
+    sync_decl_map(compiler);
+    Declaration *decl = (Declaration *)name_map_get(compiler->decl_map, name);
     if (decl)
         return decl;
 
@@ -173,3 +183,41 @@ char *cs_class_name_from_path(const char *path)
 
     return class_name;
 }
+
+static uint32_t hash_bytes(const unsigned char *bytes, int size, uint32_t multiplier)
+{
+    uint32_t h = 0x811C9DC5U;
+    for (int i = 0; i < size; i++)
+    {
+        h = (h ^ (uint32_t)bytes[i]) * multiplier;
+    }
+    return h;
+}
+
+uint32_t cs_content_hash(const unsigned char *bytes, int size)
+{
+    return hash_bytes(bytes, size, 16777619U);
+}
+
+uint32_t cs_content_hash2(const unsigned char *bytes, int size)
+{
+    return hash_bytes(bytes, size, 0x5BD1E995U);
+}
+
+uint32_t cs_compiler_hash()
+{
+    return embedded_compiler_hash;
+}
+
+uint32_t cs_span_hash(const char *str, int len)
+{
+    uint32_t h = 0x811C9DC5U;
+    for (int i = 0; i < len; i++)
+    {
+        h = h * 31U + (uint8_t)str[i];
+    }
+    h = h ^ (h >> 15);
+    h = h * 0x2C1B3C6DU;
+    h = h ^ (h >> 12);
+    return h;
+}
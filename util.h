@@ -7,6 +7,7 @@
  * - Search functions (declarations, functions)
  * - Count functions (parameters, arguments)
  * - File I/O utilities
+ * - Content hashes and compiler identity
  */
 
 #include "cminor_base.h"
@@ -25,3 +26,16 @@ char *cs_class_name_from_path(const char *path);
 
 /* File I/O */
 bool cs_read_file_bytes(const char *path, unsigned char **out_data, int *out_size);
+
+/* Content hashes: FNV-1a and the same scheme with another multiplier, so
+ * that together they tell apart contents that collide in one of them */
+uint32_t cs_content_hash(const unsigned char *bytes, int size);
+uint32_t cs_content_hash2(const unsigned char *bytes, int size);
+
+/* Identity of the running compiler: a hash of the sources it was built
+ * from, the same in the native and the self-hosted build */
+uint32_t cs_compiler_hash();
+
+/* Hash of the len bytes at str (not NUL-terminated), for the hash tables
+ * keyed by names and paths */
+uint32_t cs_span_hash(const char *str, int len);